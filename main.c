@@ -4,14 +4,27 @@
 // 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
 // of this source code package.
 
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
 
+#include "acc_collision_alert.h"
 #include "acc_detector_distance.h"
 #include "acc_hal_definitions.h"
 #include "acc_hal_integration.h"
+#include "acc_latency_histogram.h"
+#include "acc_peak_interpolation.h"
 #include "acc_rss.h"
+#include "acc_target_tracker.h"
 #include "acc_version.h"
 
 /** \example example_detector_distance.c
@@ -24,21 +37,127 @@
  *   - Create a distance detector using the previously updated configuration
  *   - Destroy the distance detector configuration
  *   - Activate the distance detector
- *   - Get the result and print it 5 times
+ *   - Start the pipeline thread, which gets the results, refines the peak distances with the envelope,
+ *     updates the tracks and raises time to collision alerts
+ *   - Print the alerts, the tracks and the alert latency until interrupted
  *   - Deactivate and destroy the distance detector
  *   - Deactivate Radar System Software (RSS)
  */
 
-#define EXAMPLE_START_M  (0.1f) // define minimum detection distance
-#define EXAMPLE_LENGTH_M (2.0f) // define maximum detection distance
-#define EXAMPLE_PROFILE  ACC_SERVICE_PROFILE_2
-#define EXAMPLE_HWAAS    (63) // define sample count averaged for each datapoint; 1 (fastest) --> 63 (most accurate)
+#define EXAMPLE_SENSOR_ID  (1)
+#define EXAMPLE_START_M    (0.1f) // define minimum detection distance
+#define EXAMPLE_LENGTH_M   (2.0f) // define maximum detection distance
+#define EXAMPLE_PROFILE    ACC_SERVICE_PROFILE_2
+#define EXAMPLE_HWAAS      (63) // define sample count averaged for each datapoint; 1 (fastest) --> 63 (most accurate)
+#define EXAMPLE_PEAK_COUNT (5)
+
+// Sub-bin refinement of the peak distances, fitted to the envelope around each peak. Fitting the
+// upper half of the pulse averages the noise, so a lower HWAAS or a downsampled configuration can be
+// used without losing distance resolution
+#define EXAMPLE_INTERPOLATION         ACC_PEAK_INTERPOLATION_PARABOLIC
+#define EXAMPLE_INTERPOLATION_WIDTH_M (0.015f)
+
+#define MAX_ENVELOPE_LENGTH (4400)
+
+// The pipeline from sensor interrupt to alert runs in a SCHED_FIFO thread, printing is done by
+// the main thread. The latency budget is measured from the interrupt edge to the alert emission.
+#define PIPELINE_THREAD_PRIORITY  (80)
+#define ALERT_LATENCY_BUDGET_US   (10000)
+#define ALERT_QUEUE_LENGTH        (64)
+#define TRACK_PRINT_PERIOD_MS     (1000)
+#define LATENCY_PRINT_PERIOD_MS   (10000)
+
+// Tracks link the peaks over frames, a track is reported after three peaks in its gate
+static const acc_target_tracker_parameters_t tracker_parameters =
+{
+	.alpha         = 0.5f,
+	.beta          = 0.1f,
+	.gate_m        = 0.03f,
+	.confirm_hits  = 3,
+	.delete_misses = 5,
+};
+
+// Closing speed is the derivative of the tracked distance, the time to collision is distance over closing speed
+static const acc_collision_alert_parameters_t alert_parameters =
+{
+	.warning_ttc_s         = 2.0f,
+	.critical_ttc_s        = 1.0f,
+	.min_closing_speed_mps = 0.05f,
+	.clear_margin_s        = 0.5f,
+};
+
+
+typedef struct
+{
+	acc_collision_alert_event_t event;
+	uint32_t                    latency_us;
+} alert_record_t;
+
+
+typedef struct
+{
+	acc_detector_distance_handle_t   handle;
+	acc_detector_distance_metadata_t metadata;
+	bool                             success;
+} pipeline_t;
+
+
+static uint16_t              envelope[MAX_ENVELOPE_LENGTH];
+static uint16_t              envelope_length;
+static uint16_t              envelope_sweep_length;
+static acc_target_tracker_t  tracker;
+static acc_collision_alert_t collision_alert;
+
+/* Shared between the pipeline thread and the main thread, protected by shared_mutex */
+static pthread_mutex_t            shared_mutex;
+static pthread_cond_t             shared_cond = PTHREAD_COND_INITIALIZER;
+static alert_record_t             alert_queue[ALERT_QUEUE_LENGTH];
+static uint16_t                   alert_queue_head;
+static uint16_t                   alert_queue_count;
+static uint32_t                   alerts_dropped;
+static acc_target_tracker_track_t shared_tracks[ACC_TARGET_TRACKER_MAX_TRACKS];
+static uint16_t                   shared_track_count;
+static uint32_t                   frame_count;
+static uint32_t                   deadline_miss_count;
+static acc_latency_histogram_t    frame_latency;
+static acc_latency_histogram_t    alert_latency;
+static bool                       pipeline_done;
+
+static volatile sig_atomic_t interrupted = 0;
 
 
 static void set_config(acc_detector_distance_configuration_t distance_configuration);
 
 
-static void print_distances(acc_detector_distance_result_t *result, uint16_t reflection_count);
+static void envelope_callback(const uint16_t *data, uint16_t data_length);
+
+
+static void refine_distances(acc_detector_distance_result_t *result, uint16_t reflection_count,
+                             const acc_detector_distance_metadata_t *metadata);
+
+
+static bool start_pipeline_thread(pthread_t *thread, pipeline_t *pipeline);
+
+
+static void *pipeline_thread_main(void *arg);
+
+
+static void print_alert(const alert_record_t *record);
+
+
+static void print_tracks(const acc_target_tracker_track_t *tracks, uint16_t track_count);
+
+
+static void print_latency(const char *name, const acc_latency_histogram_t *histogram);
+
+
+static void interrupt_handler(int signum)
+{
+	if (signum == SIGINT)
+	{
+		interrupted = 1;
+	}
+}
 
 
 int main(int argc, char *argv[]);
@@ -50,6 +169,14 @@ int main(int argc, char *argv[])
 	(void)argv;
 	printf("Acconeer software version %s\n", acc_version_get());
 
+	signal(SIGINT, interrupt_handler);
+
+	/* Page faults in the pipeline thread would add to the alert latency */
+	if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+	{
+		printf("mlockall() failed, alert latency can include page faults\n");
+	}
+
 	const acc_hal_t *hal = acc_hal_integration_get_implementation();
 
 	if (!acc_rss_activate(hal))
@@ -68,9 +195,12 @@ int main(int argc, char *argv[])
 	}
 
 	set_config(distance_configuration);
-	acc_detector_distance_handle_t distance_handle = acc_detector_distance_create(distance_configuration);
 
-	if (distance_handle == NULL)
+	pipeline_t pipeline = { .success = true };
+
+	pipeline.handle = acc_detector_distance_create(distance_configuration);
+
+	if (pipeline.handle == NULL)
 	{
 		printf("acc_detector_distance_create() failed\n");
 		acc_detector_distance_configuration_destroy(&distance_configuration);
@@ -80,40 +210,148 @@ int main(int argc, char *argv[])
 
 	acc_detector_distance_configuration_destroy(&distance_configuration);
 
-	if (!acc_detector_distance_activate(distance_handle))
+	if (!acc_detector_distance_metadata_get(pipeline.handle, &pipeline.metadata))
+	{
+		printf("acc_detector_distance_metadata_get() failed\n");
+		acc_detector_distance_destroy(&pipeline.handle);
+		acc_rss_deactivate();
+		return EXIT_FAILURE;
+	}
+
+	envelope_sweep_length = pipeline.metadata.background_length;
+
+	if (!acc_target_tracker_init(&tracker, &tracker_parameters) ||
+	    !acc_collision_alert_init(&collision_alert, &alert_parameters))
+	{
+		printf("Invalid tracker or alert parameters\n");
+		acc_detector_distance_destroy(&pipeline.handle);
+		acc_rss_deactivate();
+		return EXIT_FAILURE;
+	}
+
+	if (!acc_detector_distance_activate(pipeline.handle))
 	{
 		printf("acc_detector_distance_activate() failed\n");
-		acc_detector_distance_destroy(&distance_handle);
+		acc_detector_distance_destroy(&pipeline.handle);
 		acc_rss_deactivate();
 		return EXIT_FAILURE;
 	}
 
-	bool                                success         = true;
-	const int                           iterations      = 5;
-	uint16_t                            number_of_peaks = 5;
-	acc_detector_distance_result_t      result[number_of_peaks];
-	acc_detector_distance_result_info_t result_info;
+	pthread_t pipeline_thread;
 
-	for (int i = 0; i < iterations; i++)
+	if (!start_pipeline_thread(&pipeline_thread, &pipeline))
 	{
-		success = acc_detector_distance_get_next(distance_handle, result, number_of_peaks, &result_info);
+		printf("Failed to start the pipeline thread\n");
+		acc_detector_distance_deactivate(pipeline.handle);
+		acc_detector_distance_destroy(&pipeline.handle);
+		acc_rss_deactivate();
+		return EXIT_FAILURE;
+	}
+
+	printf("Running, press Ctrl-C to stop\n");
+
+	struct timespec last_track_print;
+	struct timespec last_latency_print;
 
-		if (!success)
+	clock_gettime(CLOCK_MONOTONIC, &last_track_print);
+	last_latency_print = last_track_print;
+
+	bool done = false;
+
+	while (!done)
+	{
+		alert_record_t             alerts[ALERT_QUEUE_LENGTH];
+		acc_target_tracker_track_t tracks[ACC_TARGET_TRACKER_MAX_TRACKS];
+		acc_latency_histogram_t    frame_latency_copy;
+		acc_latency_histogram_t    alert_latency_copy;
+		uint16_t                   alert_count = 0;
+		uint16_t                   track_count = 0;
+		uint32_t                   frames      = 0;
+		uint32_t                   misses      = 0;
+		uint32_t                   dropped     = 0;
+		struct timespec            now;
+		struct timespec            timeout;
+
+		clock_gettime(CLOCK_REALTIME, &timeout);
+		timeout.tv_nsec += 100 * 1000000;
+
+		if (timeout.tv_nsec >= 1000000000)
 		{
-			printf("acc_detector_distance_get_next() failed\n");
-			break;
+			timeout.tv_sec++;
+			timeout.tv_nsec -= 1000000000;
 		}
 
-		print_distances(result, result_info.number_of_peaks);
+		clock_gettime(CLOCK_MONOTONIC, &now);
+
+		bool print_tracks_now  = (now.tv_sec - last_track_print.tv_sec) * 1000 +
+		                         (now.tv_nsec - last_track_print.tv_nsec) / 1000000 >= TRACK_PRINT_PERIOD_MS;
+		bool print_latency_now = (now.tv_sec - last_latency_print.tv_sec) * 1000 +
+		                         (now.tv_nsec - last_latency_print.tv_nsec) / 1000000 >= LATENCY_PRINT_PERIOD_MS;
+
+		/* Copy everything out under the lock and print without it */
+		pthread_mutex_lock(&shared_mutex);
+
+		if (alert_queue_count == 0 && !pipeline_done)
+		{
+			pthread_cond_timedwait(&shared_cond, &shared_mutex, &timeout);
+		}
+
+		while (alert_queue_count > 0)
+		{
+			alerts[alert_count++] = alert_queue[alert_queue_head];
+			alert_queue_head      = (uint16_t)((alert_queue_head + 1) % ALERT_QUEUE_LENGTH);
+			alert_queue_count--;
+		}
+
+		if (print_tracks_now)
+		{
+			track_count = shared_track_count;
+			memcpy(tracks, shared_tracks, track_count * sizeof(tracks[0]));
+		}
+
+		if (print_latency_now || pipeline_done)
+		{
+			frame_latency_copy = frame_latency;
+			alert_latency_copy = alert_latency;
+			frames             = frame_count;
+			misses             = deadline_miss_count;
+			dropped            = alerts_dropped;
+		}
+
+		done = pipeline_done;
+
+		pthread_mutex_unlock(&shared_mutex);
+
+		for (uint16_t i = 0; i < alert_count; i++)
+		{
+			print_alert(&alerts[i]);
+		}
+
+		if (print_tracks_now)
+		{
+			print_tracks(tracks, track_count);
+			last_track_print = now;
+		}
+
+		if (print_latency_now || done)
+		{
+			printf("%u frames, %u over the %u us budget, %u alerts dropped\n", (unsigned int)frames,
+			       (unsigned int)misses, (unsigned int)ALERT_LATENCY_BUDGET_US, (unsigned int)dropped);
+			print_latency("Frame latency", &frame_latency_copy);
+			print_latency("Alert latency", &alert_latency_copy);
+			last_latency_print = now;
+		}
 	}
 
-	bool deactivated = acc_detector_distance_deactivate(distance_handle);
+	pthread_join(pipeline_thread, NULL);
 
-	acc_detector_distance_destroy(&distance_handle);
+	bool deactivated = acc_detector_distance_deactivate(pipeline.handle);
+
+	acc_detector_distance_destroy(&pipeline.handle);
 
 	acc_rss_deactivate();
 
-	if (deactivated && success)
+	if (deactivated && pipeline.success)
 	{
 		printf("Application finished OK\n");
 		return EXIT_SUCCESS;
@@ -129,16 +367,215 @@ static void set_config(acc_detector_distance_configuration_t distance_configurat
 	acc_detector_distance_configuration_requested_length_set(distance_configuration, EXAMPLE_LENGTH_M);
 	acc_detector_distance_configuration_service_profile_set(distance_configuration, EXAMPLE_PROFILE);
 	acc_detector_distance_configuration_hw_accelerated_average_samples_set(distance_configuration, EXAMPLE_HWAAS);
+	acc_detector_distance_configuration_service_data_callback_set(distance_configuration, envelope_callback);
 }
 
 
-static void print_distances(acc_detector_distance_result_t *result, uint16_t reflection_count)
+static void envelope_callback(const uint16_t *data, uint16_t data_length)
 {
-	printf("Found %u peaks:\n", (unsigned int)reflection_count);
+	/* With sweep averaging the buffer holds several sweeps, refine on their average */
+	uint16_t sweep_length = envelope_sweep_length;
+
+	if (sweep_length == 0 || data_length % sweep_length != 0)
+	{
+		sweep_length = data_length;
+	}
+
+	uint16_t sweep_count = data_length / sweep_length;
+
+	envelope_length = sweep_length <= MAX_ENVELOPE_LENGTH ? sweep_length : 0;
+
+	for (uint16_t i = 0; i < envelope_length; i++)
+	{
+		uint32_t sum = 0;
+
+		for (uint16_t sweep = 0; sweep < sweep_count; sweep++)
+		{
+			sum += data[sweep * sweep_length + i];
+		}
+
+		envelope[i] = (uint16_t)((sum + sweep_count / 2) / sweep_count);
+	}
+}
+
+
+static void refine_distances(acc_detector_distance_result_t *result, uint16_t reflection_count,
+                             const acc_detector_distance_metadata_t *metadata)
+{
+	float    step_length_m = envelope_length > 1 ? metadata->length_m / (float)(envelope_length - 1) : 0.0f;
+	uint16_t half_width    = step_length_m > 0.0f ? (uint16_t)(EXAMPLE_INTERPOLATION_WIDTH_M / step_length_m + 0.5f) : 1;
 
 	for (uint16_t i = 0; i < reflection_count; i++)
 	{
-		printf("Amplitude %u at %u mm\n", (unsigned int)result[i].amplitude,
-		       (unsigned int)(result[i].distance_m * 1000));
+		result[i].distance_m = acc_peak_interpolation_refine_distance(EXAMPLE_INTERPOLATION, envelope, envelope_length,
+		                                                              metadata->start_m, step_length_m,
+		                                                              half_width > 0 ? half_width : 1,
+		                                                              result[i].distance_m);
 	}
 }
+
+
+static bool start_pipeline_thread(pthread_t *thread, pipeline_t *pipeline)
+{
+	/* Priority inheritance, the main thread holds the lock briefly and must not be preempted while holding it */
+	pthread_mutexattr_t mutex_attr;
+
+	pthread_mutexattr_init(&mutex_attr);
+	pthread_mutexattr_setprotocol(&mutex_attr, PTHREAD_PRIO_INHERIT);
+	pthread_mutex_init(&shared_mutex, &mutex_attr);
+	pthread_mutexattr_destroy(&mutex_attr);
+
+	acc_latency_histogram_reset(&frame_latency);
+	acc_latency_histogram_reset(&alert_latency);
+
+	pthread_attr_t     attr;
+	struct sched_param param = { .sched_priority = PIPELINE_THREAD_PRIORITY };
+
+	pthread_attr_init(&attr);
+	pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+	pthread_attr_setschedparam(&attr, &param);
+
+	int result = pthread_create(thread, &attr, pipeline_thread_main, pipeline);
+
+	pthread_attr_destroy(&attr);
+
+	if (result == EPERM)
+	{
+		printf("No permission for SCHED_FIFO, the pipeline runs at normal priority\n");
+		result = pthread_create(thread, NULL, pipeline_thread_main, pipeline);
+	}
+
+	return result == 0;
+}
+
+
+static uint64_t get_time_ns(void)
+{
+	struct timespec time_ts = {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &time_ts);
+	return (uint64_t)time_ts.tv_sec * 1000000000 + (uint64_t)time_ts.tv_nsec;
+}
+
+
+static void *pipeline_thread_main(void *arg)
+{
+	pipeline_t *pipeline = arg;
+
+	acc_detector_distance_result_t      result[EXAMPLE_PEAK_COUNT];
+	acc_detector_distance_result_info_t result_info;
+	acc_target_tracker_track_t          tracks[ACC_TARGET_TRACKER_MAX_TRACKS];
+	acc_collision_alert_event_t         events[2 * ACC_TARGET_TRACKER_MAX_TRACKS];
+
+	while (!interrupted)
+	{
+		if (!acc_detector_distance_get_next(pipeline->handle, result, EXAMPLE_PEAK_COUNT, &result_info))
+		{
+			printf("acc_detector_distance_get_next() failed\n");
+			pipeline->success = false;
+			break;
+		}
+
+		uint64_t interrupt_ns;
+
+		if (!acc_hal_integration_get_interrupt_time_ns(EXAMPLE_SENSOR_ID, &interrupt_ns))
+		{
+			interrupt_ns = get_time_ns();
+		}
+
+		refine_distances(result, result_info.number_of_peaks, &pipeline->metadata);
+		acc_target_tracker_update(&tracker, result, result_info.number_of_peaks, (uint32_t)(interrupt_ns / 1000000));
+
+		uint16_t track_count = acc_target_tracker_get_confirmed(&tracker, tracks, ACC_TARGET_TRACKER_MAX_TRACKS);
+		uint16_t event_count = acc_collision_alert_update(&collision_alert, tracks, track_count, events,
+		                                                  2 * ACC_TARGET_TRACKER_MAX_TRACKS);
+
+		pthread_mutex_lock(&shared_mutex);
+
+		/* Alerts are emitted when they are in the queue, the latency is taken at that point */
+		uint32_t latency_us = (uint32_t)((get_time_ns() - interrupt_ns) / 1000);
+
+		for (uint16_t i = 0; i < event_count; i++)
+		{
+			if (alert_queue_count == ALERT_QUEUE_LENGTH)
+			{
+				alerts_dropped++;
+				continue;
+			}
+
+			alert_record_t *record = &alert_queue[(alert_queue_head + alert_queue_count) % ALERT_QUEUE_LENGTH];
+
+			record->event      = events[i];
+			record->latency_us = latency_us;
+			alert_queue_count++;
+
+			acc_latency_histogram_record(&alert_latency, latency_us);
+		}
+
+		acc_latency_histogram_record(&frame_latency, latency_us);
+		deadline_miss_count += latency_us > ALERT_LATENCY_BUDGET_US ? 1 : 0;
+		frame_count++;
+
+		memcpy(shared_tracks, tracks, track_count * sizeof(tracks[0]));
+		shared_track_count = track_count;
+
+		pthread_mutex_unlock(&shared_mutex);
+
+		if (event_count > 0)
+		{
+			pthread_cond_signal(&shared_cond);
+		}
+	}
+
+	pthread_mutex_lock(&shared_mutex);
+	pipeline_done = true;
+	pthread_mutex_unlock(&shared_mutex);
+	pthread_cond_signal(&shared_cond);
+
+	return NULL;
+}
+
+
+static void print_alert(const alert_record_t *record)
+{
+	static const char *level_names[] = { "clear", "WARNING", "CRITICAL" };
+
+	const acc_collision_alert_event_t *event = &record->event;
+
+	if (event->level == ACC_COLLISION_ALERT_LEVEL_NONE)
+	{
+		printf("Track %u alert %s, %u us after interrupt\n", (unsigned int)event->track_id,
+		       level_names[event->level], (unsigned int)record->latency_us);
+	}
+	else
+	{
+		printf("Track %u alert %s at %.1f mm, closing at %.0f mm/s, %.2f s to collision, %u us after interrupt\n",
+		       (unsigned int)event->track_id, level_names[event->level], (double)(event->distance_m * 1000.0f),
+		       (double)(event->closing_speed_mps * 1000.0f), (double)event->ttc_s,
+		       (unsigned int)record->latency_us);
+	}
+}
+
+
+static void print_tracks(const acc_target_tracker_track_t *tracks, uint16_t track_count)
+{
+	printf("Tracking %u targets:\n", (unsigned int)track_count);
+
+	for (uint16_t i = 0; i < track_count; i++)
+	{
+		printf("Track %u at %.1f mm, %.0f mm/s\n", (unsigned int)tracks[i].id,
+		       (double)(tracks[i].distance_m * 1000.0f), (double)(tracks[i].velocity_mps * 1000.0f));
+	}
+}
+
+
+static void print_latency(const char *name, const acc_latency_histogram_t *histogram)
+{
+	printf("%s: %u samples, p50 %u us, p99 %u us, p99.9 %u us, max %u us\n", name,
+	       (unsigned int)histogram->count,
+	       (unsigned int)acc_latency_histogram_percentile(histogram, 50.0f),
+	       (unsigned int)acc_latency_histogram_percentile(histogram, 99.0f),
+	       (unsigned int)acc_latency_histogram_percentile(histogram, 99.9f),
+	       (unsigned int)histogram->max_us);
+}
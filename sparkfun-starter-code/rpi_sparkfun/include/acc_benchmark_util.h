@@ -0,0 +1,46 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_BENCHMARK_UTIL_H_
+#define ACC_BENCHMARK_UTIL_H_
+
+#include <stdint.h>
+
+
+/**
+ * @brief Get the monotonic time
+ *
+ * @return The time in ns
+ */
+uint64_t acc_benchmark_get_time_ns(void);
+
+
+/**
+ * @brief Get the CPU time of the calling thread, so that preemption is not counted
+ *
+ * @return The CPU time in ns
+ */
+uint64_t acc_benchmark_get_cpu_time_ns(void);
+
+
+/**
+ * @brief Get the next value of a xorshift series, the same series on every platform
+ *
+ * @param[in,out] state The state of the series, not 0
+ *
+ * @return A value from 0 to 1
+ */
+float acc_benchmark_next_uniform(uint32_t *state);
+
+
+/**
+ * @brief Get approximately normal noise with unit variance, the sum of 12 uniform values
+ *
+ * @param[in,out] state The state of the series, not 0
+ *
+ * @return The noise value
+ */
+float acc_benchmark_next_noise(uint32_t *state);
+
+
+#endif
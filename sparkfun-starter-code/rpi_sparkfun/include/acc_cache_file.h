@@ -0,0 +1,60 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_CACHE_FILE_H_
+#define ACC_CACHE_FILE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * @brief Initial value for acc_cache_file_hash
+ */
+#define ACC_CACHE_FILE_HASH_INIT (2166136261u)
+
+
+/**
+ * @brief Write data to a cache file
+ *
+ * The file holds a versioned header with the key and size, the data and a checksum.
+ * The file is replaced atomically, a reader never sees a partly written file.
+ * The data is stored as is, a cache file is only meant to be read on the same platform.
+ *
+ * @param[in] path The path of the cache file
+ * @param[in] key The key of the data, typically a hash of the configuration the data belongs to
+ * @param[in] data The data to store
+ * @param[in] size The size of the data in bytes
+ *
+ * @return true if no error occurred
+ */
+bool acc_cache_file_write(const char *path, uint32_t key, const void *data, size_t size);
+
+
+/**
+ * @brief Read data from a cache file
+ *
+ * @param[in] path The path of the cache file
+ * @param[in] key The expected key
+ * @param[out] data The data read
+ * @param[in] size The expected size of the data in bytes
+ *
+ * @return true if the file exists, has the expected key and size and the checksum is correct
+ */
+bool acc_cache_file_read(const char *path, uint32_t key, void *data, size_t size);
+
+
+/**
+ * @brief Add data to a hash, used to build cache keys
+ *
+ * @param[in] hash The hash so far, ACC_CACHE_FILE_HASH_INIT for a new hash
+ * @param[in] data The data to add
+ * @param[in] size The size of the data in bytes
+ *
+ * @return The updated hash
+ */
+uint32_t acc_cache_file_hash(uint32_t hash, const void *data, size_t size);
+
+
+#endif
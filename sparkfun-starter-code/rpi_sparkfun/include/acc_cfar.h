@@ -0,0 +1,130 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_CFAR_H_
+#define ACC_CFAR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * @brief The noise estimate of a CFAR threshold
+ */
+typedef enum
+{
+	/** Cell averaging, the mean of the training bins */
+	ACC_CFAR_TYPE_CA,
+	/** Ordered statistic, a rank of the sorted training bins */
+	ACC_CFAR_TYPE_OS,
+} acc_cfar_type_t;
+
+
+/**
+ * @brief CFAR threshold parameters
+ *
+ * The training bins of bin i are the bins at offsets guard_bins to guard_bins + window_bins - 1
+ * below i and, unless only_lower is set, above i. The threshold is the noise estimate of the
+ * training bins divided by the sensitivity. Bins without a full set of training bins get no threshold.
+ */
+typedef struct
+{
+	acc_cfar_type_t type;
+	/** The offset of the first training bin, at least 1 */
+	uint16_t        guard_bins;
+	/** The number of training bins on each side */
+	uint16_t        window_bins;
+	/** The sensitivity, a higher sensitivity gives a lower threshold */
+	float           sensitivity;
+	/** Rank of the noise estimate for ACC_CFAR_TYPE_OS, as a fraction from 0 (min) to 1 (max) of the training bins */
+	float           os_rank;
+	/** Only use training bins at lower distances than the bin */
+	bool            only_lower;
+} acc_cfar_parameters_t;
+
+
+/**
+ * @brief CFAR engine handle
+ */
+struct acc_cfar;
+
+typedef struct acc_cfar *acc_cfar_t;
+
+
+/**
+ * @brief Get CFAR parameters from distances, the way the distance detector specifies its CFAR threshold
+ *
+ * @param[in] guard_m The range around the bin that is left out, half of it on each side
+ * @param[in] window_m The range next to the guard the noise estimate is calculated from
+ * @param[in] step_length_m The distance between two bins
+ * @param[in] sensitivity The threshold sensitivity
+ * @param[in] only_lower Only use training bins at lower distances
+ * @param[out] parameters The CA-CFAR parameters
+ */
+void acc_cfar_parameters_from_distance(float guard_m, float window_m, float step_length_m, float sensitivity,
+                                       bool only_lower, acc_cfar_parameters_t *parameters);
+
+
+/**
+ * @brief Create a CFAR engine for a number of parameter sets
+ *
+ * All parameter sets are evaluated on each processed frame, the window sums are shared between them.
+ *
+ * @param[in] parameters The parameter sets, copied
+ * @param[in] parameter_count The number of parameter sets
+ * @param[in] max_length The maximum frame length
+ *
+ * @return The CFAR engine, NULL if the parameters are invalid or memory allocation failed
+ */
+acc_cfar_t acc_cfar_create(const acc_cfar_parameters_t *parameters, uint16_t parameter_count, uint16_t max_length);
+
+
+/**
+ * @brief Destroy a CFAR engine
+ *
+ * @param[in] cfar The CFAR engine to destroy, set to NULL
+ */
+void acc_cfar_destroy(acc_cfar_t *cfar);
+
+
+/**
+ * @brief Calculate the thresholds of all parameter sets for an envelope frame
+ *
+ * The frame is referenced by @ref acc_cfar_get_peaks and must be valid until the next call.
+ *
+ * @param[in] cfar The CFAR engine
+ * @param[in] frame The envelope frame
+ * @param[in] length The frame length, at most the maximum length
+ *
+ * @return True if successful
+ */
+bool acc_cfar_process(acc_cfar_t cfar, const uint16_t *frame, uint16_t length);
+
+
+/**
+ * @brief Get the threshold of a parameter set for the last processed frame
+ *
+ * @param[in] cfar The CFAR engine
+ * @param[in] parameter_index The parameter set
+ *
+ * @return The threshold of each bin, NAN for bins without a threshold
+ */
+const float *acc_cfar_get_threshold(const acc_cfar_t cfar, uint16_t parameter_index);
+
+
+/**
+ * @brief Get the peaks above the threshold of a parameter set for the last processed frame
+ *
+ * A peak is a bin above the threshold that is higher than the bin below and at least as high as the bin above.
+ *
+ * @param[in] cfar The CFAR engine
+ * @param[in] parameter_index The parameter set
+ * @param[out] peaks The bin of each peak, in increasing order
+ * @param[in] max_peak_count The maximum number of peaks to return
+ *
+ * @return The number of peaks
+ */
+uint16_t acc_cfar_get_peaks(const acc_cfar_t cfar, uint16_t parameter_index, uint16_t *peaks, uint16_t max_peak_count);
+
+
+#endif
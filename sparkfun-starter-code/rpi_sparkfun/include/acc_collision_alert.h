@@ -0,0 +1,106 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_COLLISION_ALERT_H_
+#define ACC_COLLISION_ALERT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "acc_target_tracker.h"
+
+
+/**
+ * @brief Alert level of a track
+ */
+typedef enum
+{
+	ACC_COLLISION_ALERT_LEVEL_NONE,
+	ACC_COLLISION_ALERT_LEVEL_WARNING,
+	ACC_COLLISION_ALERT_LEVEL_CRITICAL,
+} acc_collision_alert_level_t;
+
+
+/**
+ * @brief Collision alert parameters
+ */
+typedef struct
+{
+	/** Time to collision below which a track raises a warning */
+	float warning_ttc_s;
+	/** Time to collision below which a track raises a critical alert */
+	float critical_ttc_s;
+	/** Closing speed below which a track has no time to collision */
+	float min_closing_speed_mps;
+	/** An alert level is left when the time to collision exceeds its threshold by this margin */
+	float clear_margin_s;
+} acc_collision_alert_parameters_t;
+
+
+/**
+ * @brief A change of the alert level of a track
+ */
+typedef struct
+{
+	uint32_t                    track_id;
+	acc_collision_alert_level_t level;
+	float                       distance_m;
+	/** Speed toward the sensor, the negated track velocity */
+	float                       closing_speed_mps;
+	/** Time to collision, INFINITY if the track is not closing */
+	float                       ttc_s;
+} acc_collision_alert_event_t;
+
+
+/**
+ * @brief Alert level of a track between updates
+ */
+typedef struct
+{
+	uint32_t                    track_id;
+	acc_collision_alert_level_t level;
+} acc_collision_alert_track_state_t;
+
+
+/**
+ * @brief Time to collision alerts over confirmed tracks
+ *
+ * The time to collision of a track is its distance over its closing speed. An event is
+ * raised when the alert level of a track changes, and when a track with an alert is lost.
+ */
+typedef struct
+{
+	acc_collision_alert_parameters_t  parameters;
+	acc_collision_alert_track_state_t states[ACC_TARGET_TRACKER_MAX_TRACKS];
+	uint16_t                          state_count;
+} acc_collision_alert_t;
+
+
+/**
+ * @brief Initialize collision alerts without alerting tracks
+ *
+ * @param[out] alert The collision alerts to initialize
+ * @param[in] parameters The alert parameters
+ *
+ * @return True if the parameters are valid
+ */
+bool acc_collision_alert_init(acc_collision_alert_t *alert, const acc_collision_alert_parameters_t *parameters);
+
+
+/**
+ * @brief Update the alert levels with the confirmed tracks of a frame
+ *
+ * @param[in] alert The collision alerts
+ * @param[in] tracks The confirmed tracks
+ * @param[in] track_count The number of tracks, at most ACC_TARGET_TRACKER_MAX_TRACKS
+ * @param[out] events The alert level changes
+ * @param[in] max_event_count The maximum number of events, ACC_TARGET_TRACKER_MAX_TRACKS * 2 fits all changes
+ *
+ * @return The number of events
+ */
+uint16_t acc_collision_alert_update(acc_collision_alert_t *alert, const acc_target_tracker_track_t *tracks,
+                                    uint16_t track_count, acc_collision_alert_event_t *events,
+                                    uint16_t max_event_count);
+
+
+#endif
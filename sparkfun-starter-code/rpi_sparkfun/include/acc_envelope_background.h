@@ -0,0 +1,96 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_ENVELOPE_BACKGROUND_H_
+#define ACC_ENVELOPE_BACKGROUND_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * @brief The maximum number of envelope bins
+ */
+#define ACC_ENVELOPE_BACKGROUND_MAX_LENGTH (4096)
+
+/**
+ * @brief The largest deviation from the background in the variance, larger deviations are clamped
+ */
+#define ACC_ENVELOPE_BACKGROUND_MAX_DEVIATION (2047)
+
+
+/**
+ * @brief Envelope background parameters
+ */
+typedef struct
+{
+	/** The weight of the newest frame in the mean and the variance is 2^-shift, 1 to 15 */
+	uint8_t  shift;
+	/** Bins with a z-score magnitude above this are not learnt */
+	float    freeze_z;
+	/** A bin that stays above freeze_z for this many consecutive frames is learnt anyway, 0 for never */
+	uint16_t max_freeze_frames;
+	/** The smallest standard deviation in the z-scores */
+	float    min_std;
+} acc_envelope_background_parameters_t;
+
+
+/**
+ * @brief Online per bin background of an envelope
+ *
+ * Each bin has an exponentially weighted mean and variance in fixed point, the mean in Q12 and
+ * the variance in Q8 of squared envelope counts. A frame gives the foreground, the envelope
+ * above the mean, and the z-score of each bin. Bins with a z-score above freeze_z keep their
+ * background, so that targets are not learnt, and the caller can freeze all bins while it has a
+ * detection. The first 2^shift frames are averaged without freezing while the background is
+ * learnt. All storage is part of the struct, an update does not allocate.
+ */
+typedef struct
+{
+	acc_envelope_background_parameters_t parameters;
+	uint16_t                             data_length;
+	uint32_t                             frame_count;
+	int32_t                              mean[ACC_ENVELOPE_BACKGROUND_MAX_LENGTH];
+	int32_t                              variance[ACC_ENVELOPE_BACKGROUND_MAX_LENGTH];
+	uint16_t                             frozen_frames[ACC_ENVELOPE_BACKGROUND_MAX_LENGTH];
+} acc_envelope_background_t;
+
+
+/**
+ * @brief Initialize an envelope background, it is learnt from the next frames
+ *
+ * @param[out] background The background to initialize
+ * @param[in] parameters The background parameters
+ * @param[in] data_length The number of envelope bins, at most ACC_ENVELOPE_BACKGROUND_MAX_LENGTH
+ *
+ * @return True if the parameters are valid
+ */
+bool acc_envelope_background_init(acc_envelope_background_t *background,
+                                  const acc_envelope_background_parameters_t *parameters, uint16_t data_length);
+
+
+/**
+ * @brief Subtract the background from a frame and learn the frame
+ *
+ * @param[in] background The background
+ * @param[in] data The envelope, data_length bins
+ * @param[in] freeze Keep the background of all bins, for example while the caller has a detection
+ * @param[out] foreground The envelope above the background before this frame, data_length bins
+ * @param[out] z_scores The deviation of each bin from the background in standard deviations,
+ *             data_length values
+ */
+void acc_envelope_background_update(acc_envelope_background_t *background, const uint16_t *data, bool freeze,
+                                    uint16_t *foreground, float *z_scores);
+
+
+/**
+ * @brief Check if the background is still learnt from the first frames
+ *
+ * @param[in] background The background
+ *
+ * @return True during the first 2^shift frames
+ */
+bool acc_envelope_background_is_learning(const acc_envelope_background_t *background);
+
+
+#endif
@@ -4,6 +4,9 @@
 #ifndef ACC_HAL_INTEGRATION_H_
 #define ACC_HAL_INTEGRATION_H_
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "acc_definitions_common.h"
 #include "acc_hal_definitions.h"
 
@@ -14,4 +17,18 @@
 const acc_hal_t *acc_hal_integration_get_implementation(void);
 
 
+/**
+ * @brief Get the time of the last sensor interrupt
+ *
+ * After a get_next call the last interrupt is the one that signalled the data of the call,
+ * so the time can be used to measure latency from the sensor.
+ *
+ * @param[in] sensor_id The sensor
+ * @param[out] time_ns The CLOCK_MONOTONIC time of the interrupt edge in nanoseconds
+ *
+ * @return True if the sensor has had an interrupt
+ */
+bool acc_hal_integration_get_interrupt_time_ns(acc_sensor_id_t sensor_id, uint64_t *time_ns);
+
+
 #endif
@@ -0,0 +1,64 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_INTEGRATION_GAIN_SEARCH_H_
+#define ACC_INTEGRATION_GAIN_SEARCH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * @brief The number of steps the receiver gain can be configured in between 0.0 and 1.0
+ */
+#define ACC_INTEGRATION_GAIN_STEP_COUNT (22)
+
+
+/**
+ * @brief Make one recording at a receiver gain
+ *
+ * @param[in] gain The receiver gain to record with
+ * @param[in] user_data The user data given to @ref acc_integration_gain_search
+ * @param[out] saturated True if the recorded data was saturated
+ *
+ * @return true if the recording was successful
+ */
+typedef bool acc_integration_gain_search_record_func_t(float gain, void *user_data, bool *saturated);
+
+
+/**
+ * @brief The result of a gain search
+ */
+typedef struct
+{
+	/** The selected gain, the last recording was made with this gain */
+	float    gain;
+	/** The number of recordings made by the search */
+	uint32_t recording_count;
+	/** The wall time of the search in ms */
+	uint32_t time_ms;
+} acc_integration_gain_search_result_t;
+
+
+/**
+ * @brief Find the highest receiver gain that does not saturate, minus a margin
+ *
+ * The search assumes that saturation is monotonic in the gain. The maximum gain is tried
+ * first, since it is not saturated in the common case, then the highest non-saturating
+ * gain step is found by bisection. A final recording is made at the selected gain, which
+ * is margin_steps below the highest non-saturating gain, so the data of the last recording
+ * is the data for the selected gain. At most 2 + log2(22) recordings are made.
+ *
+ * @param[in] max_gain The highest gain to consider
+ * @param[in] margin_steps The number of gain steps to back off from the highest non-saturating gain
+ * @param[in] record The function making one recording
+ * @param[in] user_data User data passed to the record function
+ * @param[out] result The result of the search
+ *
+ * @return true if a gain without saturation was found
+ */
+bool acc_integration_gain_search(float max_gain, uint16_t margin_steps, acc_integration_gain_search_record_func_t *record,
+                                 void *user_data, acc_integration_gain_search_result_t *result);
+
+
+#endif
@@ -0,0 +1,85 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_INTEGRATION_PACER_H_
+#define ACC_INTEGRATION_PACER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * @brief Pacer state, frames are paced against absolute deadlines so processing time does not add drift
+ */
+typedef struct
+{
+	uint64_t period_ns;
+	uint64_t deadline_ns;
+	uint64_t start_ns;
+	uint64_t last_ns;
+	uint64_t lateness_sum_ns;
+	uint64_t lateness_max_ns;
+	uint32_t frame_count;
+	uint32_t overrun_count;
+} acc_integration_pacer_t;
+
+
+/**
+ * @brief Pacing statistics since the pacer was initialized or the statistics were reset
+ */
+typedef struct
+{
+	/** The number of paced frames */
+	uint32_t frame_count;
+	/** The number of deadlines that had already passed when the pacer was waited on */
+	uint32_t overrun_count;
+	/** The delivered frame rate */
+	float    rate_hz;
+	/** The mean and max time between a deadline and the wake up, in us */
+	uint32_t jitter_mean_us;
+	uint32_t jitter_max_us;
+} acc_integration_pacer_statistics_t;
+
+
+/**
+ * @brief Initialize a pacer
+ *
+ * @param[out] pacer The pacer to initialize
+ * @param[in] rate_hz The frame rate
+ */
+void acc_integration_pacer_init(acc_integration_pacer_t *pacer, float rate_hz);
+
+
+/**
+ * @brief Wait for the deadline of the next frame
+ *
+ * The first call returns immediately and starts the deadline sequence. If the deadline has
+ * already passed, the call returns immediately and the overrun is counted. Deadlines that were
+ * missed by more than a period are skipped, the pacer does not try to catch up with a burst of frames.
+ *
+ * @param[in] pacer The pacer
+ *
+ * @return true if the deadline was met, false if it was overrun
+ */
+bool acc_integration_pacer_wait(acc_integration_pacer_t *pacer);
+
+
+/**
+ * @brief Get the pacing statistics
+ *
+ * @param[in] pacer The pacer
+ * @param[out] statistics The statistics
+ */
+void acc_integration_pacer_get_statistics(const acc_integration_pacer_t *pacer,
+                                          acc_integration_pacer_statistics_t *statistics);
+
+
+/**
+ * @brief Restart the pacing statistics, the deadline sequence is kept
+ *
+ * @param[in] pacer The pacer
+ */
+void acc_integration_pacer_reset_statistics(acc_integration_pacer_t *pacer);
+
+
+#endif
@@ -0,0 +1,129 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_IQ_VELOCITY_H_
+#define ACC_IQ_VELOCITY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "acc_definitions_common.h"
+
+
+/**
+ * @brief The A111 radar wavelength
+ */
+#define ACC_IQ_VELOCITY_WAVELENGTH_M (0.004955f)
+
+
+/**
+ * @brief IQ velocity estimator parameters
+ */
+typedef struct
+{
+	/** The sweep rate of the IQ service */
+	float sweep_rate_hz;
+	/** The distance of the first bin, from the IQ metadata */
+	float start_m;
+	/** The distance between two bins, from the IQ metadata */
+	float step_length_m;
+	/** The weight of the newest sweep in the smoothed phase differences, 0 to 1 */
+	float smoothing;
+	/** Bins with a power below this fraction of the strongest bin are left out of the velocity and the centroid, 0 to 1 */
+	float min_power_ratio;
+	/** Distance gain of the range rate filter, 0 to 1 */
+	float range_rate_alpha;
+	/** Velocity gain of the range rate filter, 0 to 2 */
+	float range_rate_beta;
+} acc_iq_velocity_parameters_t;
+
+
+/**
+ * @brief Velocity over the bins with signal
+ *
+ * Velocities are positive away from the sensor.
+ */
+typedef struct
+{
+	/** The phase velocity moved to the alias interval of the range rate */
+	float   velocity_mps;
+	/** The velocity from the phase difference, within +-max_unambiguous_mps */
+	float   phase_velocity_mps;
+	/** The coarse velocity from the movement of the power centroid */
+	float   range_rate_mps;
+	/** The highest speed the phase difference measures without aliasing */
+	float   max_unambiguous_mps;
+	/** The distance of the power centroid */
+	float   distance_m;
+	/** The number of alias intervals added to the phase velocity */
+	int16_t alias_count;
+	/** The number of bins in the result */
+	uint16_t bin_count;
+} acc_iq_velocity_result_t;
+
+
+/**
+ * @brief IQ velocity estimator handle
+ *
+ * The radial velocity of each bin is the phase difference between consecutive sweeps, from the
+ * product of a sweep and the complex conjugate of the previous one. The products are calculated
+ * in fixed point and smoothed over sweeps, and summing the products of several bins weights each
+ * bin with its power. The phase difference aliases at a quarter wavelength per sweep, the
+ * result is unwrapped with the range rate from the movement of the power centroid.
+ */
+struct acc_iq_velocity;
+
+typedef struct acc_iq_velocity *acc_iq_velocity_t;
+
+
+/**
+ * @brief Create an IQ velocity estimator
+ *
+ * @param[in] parameters The parameters, copied
+ * @param[in] data_length The number of bins of each sweep
+ *
+ * @return The estimator, NULL if the parameters are invalid or memory allocation failed
+ */
+acc_iq_velocity_t acc_iq_velocity_create(const acc_iq_velocity_parameters_t *parameters, uint16_t data_length);
+
+
+/**
+ * @brief Destroy an IQ velocity estimator
+ *
+ * @param[in] velocity The estimator to destroy, set to NULL
+ */
+void acc_iq_velocity_destroy(acc_iq_velocity_t *velocity);
+
+
+/**
+ * @brief Add a sweep
+ *
+ * @param[in] velocity The estimator
+ * @param[in] data The IQ sweep, data_length bins of acc_int16_complex_t
+ */
+void acc_iq_velocity_process(acc_iq_velocity_t velocity, const acc_int16_complex_t *data);
+
+
+/**
+ * @brief Get the smoothed velocity of each bin
+ *
+ * The velocities are within +-max_unambiguous_mps, they are not unwrapped.
+ *
+ * @param[in] velocity The estimator
+ * @param[out] velocities The velocity of each bin, data_length values
+ */
+void acc_iq_velocity_get_bin_velocities(const acc_iq_velocity_t velocity, float *velocities);
+
+
+/**
+ * @brief Get the velocity over the bins with signal
+ *
+ * @param[in] velocity The estimator
+ * @param[out] result The velocity
+ *
+ * @return True if at least two sweeps have been processed and there is signal
+ */
+bool acc_iq_velocity_get_result(const acc_iq_velocity_t velocity, acc_iq_velocity_result_t *result);
+
+
+#endif
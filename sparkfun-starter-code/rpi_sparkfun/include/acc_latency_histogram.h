@@ -0,0 +1,68 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_LATENCY_HISTOGRAM_H_
+#define ACC_LATENCY_HISTOGRAM_H_
+
+#include <stdint.h>
+
+
+/**
+ * @brief The number of buckets per octave above the exact range, sets the resolution to 1/32
+ */
+#define ACC_LATENCY_HISTOGRAM_SUB_BUCKET_COUNT (32)
+
+/**
+ * @brief The number of buckets, covering all uint32_t microsecond latencies
+ */
+#define ACC_LATENCY_HISTOGRAM_BUCKET_COUNT (28 * ACC_LATENCY_HISTOGRAM_SUB_BUCKET_COUNT)
+
+
+/**
+ * @brief Latency histogram for percentiles
+ *
+ * Latencies below 64 us are counted exactly, above that in log-linear buckets with a relative
+ * width of at most 1/32. Recording is constant time and does not allocate, so it can be done
+ * in a real time thread.
+ */
+typedef struct
+{
+	uint32_t counts[ACC_LATENCY_HISTOGRAM_BUCKET_COUNT];
+	uint64_t count;
+	uint64_t sum_us;
+	uint32_t max_us;
+} acc_latency_histogram_t;
+
+
+/**
+ * @brief Remove all latencies from a histogram, also used to initialize it
+ *
+ * @param[out] histogram The histogram
+ */
+void acc_latency_histogram_reset(acc_latency_histogram_t *histogram);
+
+
+/**
+ * @brief Add a latency to a histogram
+ *
+ * @param[in] histogram The histogram
+ * @param[in] latency_us The latency in microseconds
+ */
+void acc_latency_histogram_record(acc_latency_histogram_t *histogram, uint32_t latency_us);
+
+
+/**
+ * @brief Get a percentile of the latencies
+ *
+ * The value is the upper end of the bucket the percentile falls in, so the percentile is never
+ * underestimated.
+ *
+ * @param[in] histogram The histogram
+ * @param[in] percentile The percentile, 0 to 100
+ *
+ * @return The latency in microseconds, 0 if the histogram is empty
+ */
+uint32_t acc_latency_histogram_percentile(const acc_latency_histogram_t *histogram, float percentile);
+
+
+#endif
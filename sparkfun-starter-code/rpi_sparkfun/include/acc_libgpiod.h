@@ -6,6 +6,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <time.h>
 
 
 typedef enum
@@ -88,4 +89,18 @@ bool acc_libgpiod_set(int pin, gpio_pin_value_t value);
 bool acc_libgpiod_wait_for_interrupt(int pin, uint32_t timeout_ms);
 
 
+/**
+ * Get the time of the interrupt edge of the last successful wait for interrupt
+ *
+ * The time is the kernel timestamp of the rising edge event in CLOCK_MONOTONIC. If the pin
+ * was already high when the wait started, it is the time the wait started.
+ *
+ * @param[in] pin The pin
+ * @param[out] time The CLOCK_MONOTONIC time of the edge
+ *
+ * @return true if an interrupt has been received on the pin
+ */
+bool acc_libgpiod_get_interrupt_time(int pin, struct timespec *time);
+
+
 #endif
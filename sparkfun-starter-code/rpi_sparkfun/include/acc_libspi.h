@@ -10,15 +10,41 @@
 
 #define MAX_SPI_TRANSFER_SIZE 4095
 
+#define ACC_LIBSPI_MAX_DEVICES 2
+
+
+/**
+ * @brief SPI transfer statistics
+ */
+typedef struct
+{
+	uint64_t transfer_count;
+	uint64_t transfer_bytes;
+	uint64_t transfer_time_total_us;
+	uint32_t transfer_time_max_us;
+} acc_libspi_statistics_t;
+
 
 /**
  * Initialize the SPI library.
  *
+ * Opens chip select 0 of the SPI bus.
+ *
  * @return true if successful
  */
 bool acc_libspi_init(void);
 
 
+/**
+ * Open one more chip select on the SPI bus, after acc_libspi_init
+ *
+ * @param[in] cs The chip select, less than ACC_LIBSPI_MAX_DEVICES
+ *
+ * @return true if successful
+ */
+bool acc_libspi_init_device(uint8_t cs);
+
+
 /**
  * Deinitialize the SPI library and free any allocated resources.
  */
@@ -34,4 +60,28 @@ void acc_libspi_deinit(void);
  */
 bool acc_libspi_transfer(uint32_t speed, uint8_t *buffer, size_t buffer_size);
 
+
+/**
+ * Transfer data to a specific chip select over the SPI interface
+ *
+ * spidev serializes the transfers of all chip selects on the bus.
+ *
+ * @param[in] cs The chip select
+ * @param[in] speed The speed in Hz of the SPI clock
+ * @param[in,out] buffer The data to send and receive
+ * @param[in] buffer_size The size of the data to be sent in bytes
+ */
+bool acc_libspi_transfer_device(uint8_t cs, uint32_t speed, uint8_t *buffer, size_t buffer_size);
+
+
+/**
+ * Get the accumulated statistics of all transfers since init
+ *
+ * The statistics are not protected by a lock. Get them from the thread that does the
+ * transfers, or accept a torn read while a transfer is updating them.
+ *
+ * @param[out] statistics The transfer statistics
+ */
+void acc_libspi_get_statistics(acc_libspi_statistics_t *statistics);
+
 #endif
@@ -0,0 +1,69 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_METRICS_SERVER_H_
+#define ACC_METRICS_SERVER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * @brief Runtime counters of a streaming server
+ *
+ * Counters ending in _total only increase, the others are the current value.
+ */
+typedef struct
+{
+	uint64_t frames_produced_total;
+	uint64_t frames_sent_total;
+	uint64_t udp_frames_sent_total;
+	uint64_t bytes_out_total;
+	uint32_t queue_depth_bytes;
+	uint32_t client_count;
+	uint64_t clients_connected_total;
+	uint64_t missed_data_total;
+	uint64_t data_quality_warning_total;
+	uint64_t data_saturated_total;
+	uint64_t loop_iterations_total;
+	uint64_t loop_time_total_us;
+	uint32_t loop_time_max_us;
+	uint64_t spi_transfers_total;
+	uint64_t spi_bytes_total;
+	uint64_t spi_time_total_us;
+	uint32_t spi_time_max_us;
+} acc_metrics_t;
+
+
+/**
+ * @brief Start the metrics server on a specified tcp port
+ *
+ * The server runs in its own thread. A client that sends an HTTP GET request gets the
+ * metrics as a plain text HTTP response, any other client gets the bare text lines.
+ * Each line has the format "<name> <value>".
+ *
+ * @param[in] port The TCP/IP port number
+ *
+ * @return true if no error occurred
+ */
+bool acc_metrics_server_start(int port);
+
+
+/**
+ * @brief Stop the metrics server and wait for its thread to finish
+ */
+void acc_metrics_server_stop(void);
+
+
+/**
+ * @brief Publish a new snapshot of the metrics
+ *
+ * The snapshot is copied, the caller keeps ownership of the metrics.
+ *
+ * @param[in] metrics The current metrics
+ */
+void acc_metrics_server_update(const acc_metrics_t *metrics);
+
+
+#endif
@@ -0,0 +1,118 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_PARKING_DETECTION_H_
+#define ACC_PARKING_DETECTION_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "acc_service_envelope.h"
+#include "acc_sliding_window.h"
+
+
+/**
+ * @brief Per bin tables for parking detection
+ *
+ * Everything in the weight computation that only depends on the envelope metadata
+ * and the leakage positions, set up once per service configuration.
+ */
+typedef struct
+{
+	float    *range;        /**< The distance of each bin in meters */
+	float    *leak_profile; /**< The direct leakage fraction of each bin, 1 at the sample index and 0 from the end index */
+	uint16_t length;        /**< The number of bins */
+} acc_parking_profile_t;
+
+
+/**
+ * @brief Parking detection parameters
+ */
+typedef struct
+{
+	uint16_t background_level;   /**< The expected envelope background level */
+	uint16_t max_leak_amplitude; /**< The sampled direct leakage amplitude is limited to this */
+	float    weight_threshold;   /**< The minimal weight of each observation for a detection */
+	float    weight_ratio_limit; /**< The largest ratio between the highest and lowest weight of the observations */
+	float    displacement_limit; /**< The largest difference between the observed distances in meters */
+} acc_parking_detection_parameters_t;
+
+
+/**
+ * @brief Observation windows of the weight and distance of the latest sweeps
+ *
+ * The windows are created by the application, their capacity is the number of observations.
+ */
+typedef struct
+{
+	acc_sliding_window_t weight;
+	acc_sliding_window_t distance;
+} acc_parking_observations_t;
+
+
+/**
+ * @brief Set up the per bin tables for an envelope service
+ *
+ * The direct leakage is modelled as falling linearly from its sampled amplitude to zero
+ * at the end index.
+ *
+ * @param[out] profile The profile to set up
+ * @param[in] metadata The envelope service metadata
+ * @param[in] leak_sample_index The index where the leakage is sampled
+ * @param[in] leak_end_index The index where the leakage is assumed to end, must be beyond leak_sample_index
+ *
+ * @return True if the tables could be allocated
+ */
+bool acc_parking_profile_setup(acc_parking_profile_t *profile, const acc_service_envelope_metadata_t *metadata,
+                               uint16_t leak_sample_index, uint16_t leak_end_index);
+
+
+/**
+ * @brief Release the tables of a profile
+ *
+ * @param[in] profile The profile to release
+ */
+void acc_parking_profile_release(acc_parking_profile_t *profile);
+
+
+/**
+ * @brief Compute the reflection weight sums of an envelope sweep
+ *
+ * For each bin the background is the background level plus the leak amplitude times
+ * the leak profile. The amplitude above the background gives the weight
+ * min(above / background_level, 1) * above * range.
+ *
+ * @param[in] profile The per bin tables
+ * @param[in] data The envelope sweep, profile->length values
+ * @param[in] background_level The expected envelope background level
+ * @param[in] leak_amplitude The direct leakage amplitude above the background level
+ * @param[out] weight_sum The sum of the weights
+ * @param[out] weight_sum_r The sum of the weights times range
+ */
+void acc_parking_weight_sums(const acc_parking_profile_t *profile, const uint16_t *data, float background_level,
+                             float leak_amplitude, float *weight_sum, float *weight_sum_r);
+
+
+
+/**
+ * @brief Add the observation of an envelope sweep and execute the parking detection
+ *
+ * A car is detected when the observation windows are full, every weight is above the
+ * threshold, the weights are steady and the distance does not move. This excludes transient
+ * reflections from people and items that are near the sensor for short durations.
+ *
+ * @param[in] profile The per bin tables
+ * @param[in] parameters The detection parameters
+ * @param[in] leak_sample_index The index where the leakage is sampled
+ * @param[in] observations The observation windows
+ * @param[in] data The envelope sweep, profile->length values
+ *
+ * @return True if a car is detected
+ */
+bool acc_parking_detection_update(const acc_parking_profile_t *profile,
+                                  const acc_parking_detection_parameters_t *parameters,
+                                  uint16_t leak_sample_index, acc_parking_observations_t *observations,
+                                  const uint16_t *data);
+
+
+#endif
@@ -0,0 +1,64 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_PEAK_INTERPOLATION_H_
+#define ACC_PEAK_INTERPOLATION_H_
+
+#include <stdint.h>
+
+
+/**
+ * @brief The peak model fitted to the envelope around a peak
+ */
+typedef enum
+{
+	/** No interpolation, the peak is at the bin */
+	ACC_PEAK_INTERPOLATION_NONE,
+	/** A parabola fitted to the envelope */
+	ACC_PEAK_INTERPOLATION_PARABOLIC,
+	/** A Gaussian fitted to the envelope, a parabola fitted to the logarithm of the envelope */
+	ACC_PEAK_INTERPOLATION_GAUSSIAN,
+} acc_peak_interpolation_method_t;
+
+
+/**
+ * @brief Get the sub-bin position of a peak
+ *
+ * The model is least squares fitted to the bins index - half_width to index + half_width. With
+ * half_width 1 this is the three point interpolation. A wider fit averages noise on envelopes
+ * where the pulse covers many bins. The fit is narrowed at the ends of the data.
+ *
+ * @param[in] method The peak model
+ * @param[in] data The envelope
+ * @param[in] data_length The number of bins in the envelope
+ * @param[in] index The bin of the peak
+ * @param[in] half_width The number of bins on each side of the peak to fit to
+ *
+ * @return The offset of the peak from index in bins, 0 if no peak could be fitted
+ */
+float acc_peak_interpolation_offset(acc_peak_interpolation_method_t method, const uint16_t *data, uint16_t data_length,
+                                    uint16_t index, uint16_t half_width);
+
+
+/**
+ * @brief Refine a distance at bin resolution with the envelope it was measured on
+ *
+ * The distance is moved to the highest bin next to it before the sub-bin position is fitted, so
+ * peak distances from a detector with a different peak definition can be refined.
+ *
+ * @param[in] method The peak model
+ * @param[in] data The envelope
+ * @param[in] data_length The number of bins in the envelope
+ * @param[in] start_m The distance of the first bin
+ * @param[in] step_length_m The distance between two bins
+ * @param[in] half_width The number of bins on each side of the peak to fit to
+ * @param[in] distance_m The distance to refine
+ *
+ * @return The refined distance
+ */
+float acc_peak_interpolation_refine_distance(acc_peak_interpolation_method_t method, const uint16_t *data,
+                                             uint16_t data_length, float start_m, float step_length_m,
+                                             uint16_t half_width, float distance_m);
+
+
+#endif
@@ -0,0 +1,117 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_RANGE_DOPPLER_H_
+#define ACC_RANGE_DOPPLER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+#define ACC_RANGE_DOPPLER_MIN_SWEEPS (4)
+#define ACC_RANGE_DOPPLER_MAX_SWEEPS (256)
+
+
+/**
+ * @brief The strongest Doppler bin of a range point
+ */
+typedef struct
+{
+	/** The speed of the interpolated peak, sparse data does not give the direction */
+	float velocity_mps;
+	/** The peak magnitude */
+	float magnitude;
+} acc_range_doppler_peak_t;
+
+
+/**
+ * @brief Range-Doppler map engine handle
+ *
+ * Each range point of a sparse frame is transformed along the sweep axis, after removing its
+ * mean over the frame and applying a Hann window. The transform is a fixed point radix-4 FFT,
+ * with a radix-2 stage when the number of sweeps is an odd power of two, and precomputed
+ * twiddles. Two real range points are packed into each complex transform and separated after,
+ * and four transforms run side by side in the NEON lanes.
+ *
+ * The map has sweeps_per_frame / 2 + 1 Doppler rows of sweep_length range points, from zero up
+ * to half the sweep rate. A range point oscillating with amplitude A gives a magnitude A in its
+ * Doppler bin.
+ */
+struct acc_range_doppler;
+
+typedef struct acc_range_doppler *acc_range_doppler_t;
+
+
+/**
+ * @brief Create a range-Doppler map engine
+ *
+ * @param[in] sweeps_per_frame The number of sweeps per frame, a power of two from
+ *            ACC_RANGE_DOPPLER_MIN_SWEEPS to ACC_RANGE_DOPPLER_MAX_SWEEPS
+ * @param[in] sweep_length The number of range points per sweep
+ * @param[in] sweep_rate_hz The sweep rate, from the sparse metadata
+ *
+ * @return The engine, NULL if the parameters are invalid or memory allocation failed
+ */
+acc_range_doppler_t acc_range_doppler_create(uint16_t sweeps_per_frame, uint16_t sweep_length, float sweep_rate_hz);
+
+
+/**
+ * @brief Destroy a range-Doppler map engine
+ *
+ * @param[in] range_doppler The engine to destroy, set to NULL
+ */
+void acc_range_doppler_destroy(acc_range_doppler_t *range_doppler);
+
+
+/**
+ * @brief Calculate the map of a sparse frame
+ *
+ * @param[in] range_doppler The engine
+ * @param[in] frame The sparse frame, sweeps_per_frame sweeps of sweep_length range points
+ */
+void acc_range_doppler_process(acc_range_doppler_t range_doppler, const uint16_t *frame);
+
+
+/**
+ * @brief Get the map of the last frame
+ *
+ * @param[in] range_doppler The engine
+ *
+ * @return The magnitudes, Doppler bin major, valid until the next frame is processed
+ */
+const float *acc_range_doppler_get_map(const acc_range_doppler_t range_doppler);
+
+
+/**
+ * @brief Get the number of Doppler bins of the map
+ *
+ * @param[in] range_doppler The engine
+ *
+ * @return sweeps_per_frame / 2 + 1
+ */
+uint16_t acc_range_doppler_get_doppler_bins(const acc_range_doppler_t range_doppler);
+
+
+/**
+ * @brief Get the speed of a Doppler bin
+ *
+ * @param[in] range_doppler The engine
+ * @param[in] bin The Doppler bin
+ *
+ * @return The speed in m/s
+ */
+float acc_range_doppler_get_bin_velocity(const acc_range_doppler_t range_doppler, float bin);
+
+
+/**
+ * @brief Get the strongest moving Doppler bin of each range point in the last frame
+ *
+ * The zero Doppler bin is left out.
+ *
+ * @param[in] range_doppler The engine
+ * @param[out] peaks The peak of each range point, sweep_length peaks
+ */
+void acc_range_doppler_get_peaks(const acc_range_doppler_t range_doppler, acc_range_doppler_peak_t *peaks);
+
+
+#endif
@@ -0,0 +1,161 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_RATE_CONTROLLER_H_
+#define ACC_RATE_CONTROLLER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "acc_definitions_a111.h"
+
+
+/**
+ * @brief The maximum number of tiers of a rate controller
+ */
+#define ACC_RATE_CONTROLLER_MAX_TIERS (8)
+
+
+/**
+ * @brief A rate and power tier
+ *
+ * Tiers are ordered from the lowest to the highest update rate. The controller steps up
+ * directly to the highest tier whose enter score is reached, and steps down one tier at a
+ * time when the score has been below the exit score of the current tier for a number of frames.
+ * An exit score below the enter score gives hysteresis.
+ */
+typedef struct
+{
+	const char            *name;
+	float                 update_rate_hz;
+	acc_power_save_mode_t power_save_mode;
+	/** Score at or above which the tier is entered from a lower tier, not used for the first tier */
+	float                 enter_score;
+	/** Score below which the frame counts toward leaving the tier, not used for the first tier */
+	float                 exit_score;
+	/** Number of consecutive frames below the exit score before the tier is left */
+	uint16_t              exit_frames;
+} acc_rate_controller_tier_t;
+
+
+/**
+ * @brief The kind of tier transition
+ */
+typedef enum
+{
+	/** The tier did not change */
+	ACC_RATE_CONTROLLER_TRANSITION_NONE,
+	/** The tier changed, but has the same update rate and power save mode, no reconfiguration is needed */
+	ACC_RATE_CONTROLLER_TRANSITION_THRESHOLDS,
+	/** The tier changed and the detector has to be reconfigured */
+	ACC_RATE_CONTROLLER_TRANSITION_RECONFIGURE,
+} acc_rate_controller_transition_t;
+
+
+/**
+ * @brief Rate controller statistics since the controller was initialized or the statistics were reset
+ */
+typedef struct
+{
+	uint32_t time_in_tier_ms[ACC_RATE_CONTROLLER_MAX_TIERS];
+	uint32_t transition_count;
+	uint32_t reconfigure_count;
+	/** Time to apply a reconfiguring transition, as reported with @ref acc_rate_controller_transition_done */
+	uint64_t reconfigure_time_sum_us;
+	uint32_t reconfigure_time_max_us;
+	/** Number of detections after a frame without presence */
+	uint32_t detection_count;
+	/**
+	 * Time from the last frame with a score below the enter score of the second tier to the
+	 * first frame with a detection. This includes the frame period of the tier that was active.
+	 */
+	uint64_t detection_latency_sum_ms;
+	uint32_t detection_latency_max_ms;
+} acc_rate_controller_statistics_t;
+
+
+/**
+ * @brief Rate controller state
+ */
+typedef struct
+{
+	const acc_rate_controller_tier_t *tiers;
+	uint16_t                         tier_count;
+	uint16_t                         tier;
+	uint16_t                         frames_below_exit;
+	bool                             has_quiet_time;
+	bool                             presence_detected;
+	uint32_t                         quiet_time_ms;
+	uint32_t                         tier_start_ms;
+	acc_rate_controller_statistics_t statistics;
+} acc_rate_controller_t;
+
+
+/**
+ * @brief Initialize a rate controller in the first tier
+ *
+ * @param[out] controller The controller to initialize
+ * @param[in] tiers The tiers, must be valid as long as the controller is used
+ * @param[in] tier_count The number of tiers, at most ACC_RATE_CONTROLLER_MAX_TIERS
+ * @param[in] time_ms The current time
+ *
+ * @return true if the tiers are valid
+ */
+bool acc_rate_controller_init(acc_rate_controller_t *controller, const acc_rate_controller_tier_t *tiers,
+                              uint16_t tier_count, uint32_t time_ms);
+
+
+/**
+ * @brief Update the controller with the result of a frame
+ *
+ * @param[in] controller The controller
+ * @param[in] presence_detected True if presence was detected in the frame
+ * @param[in] score The presence score of the frame
+ * @param[in] time_ms The time of the frame
+ *
+ * @return The transition needed before the next frame
+ */
+acc_rate_controller_transition_t acc_rate_controller_update(acc_rate_controller_t *controller, bool presence_detected,
+                                                            float score, uint32_t time_ms);
+
+
+/**
+ * @brief Get the current tier
+ *
+ * @param[in] controller The controller
+ *
+ * @return The current tier
+ */
+const acc_rate_controller_tier_t *acc_rate_controller_get_tier(const acc_rate_controller_t *controller);
+
+
+/**
+ * @brief Report the time it took to apply a reconfiguring transition
+ *
+ * @param[in] controller The controller
+ * @param[in] time_us The time of the reconfiguration
+ */
+void acc_rate_controller_transition_done(acc_rate_controller_t *controller, uint32_t time_us);
+
+
+/**
+ * @brief Get the statistics, including the time spent in the current tier until now
+ *
+ * @param[in] controller The controller
+ * @param[in] time_ms The current time
+ * @param[out] statistics The statistics
+ */
+void acc_rate_controller_get_statistics(const acc_rate_controller_t *controller, uint32_t time_ms,
+                                        acc_rate_controller_statistics_t *statistics);
+
+
+/**
+ * @brief Restart the statistics
+ *
+ * @param[in] controller The controller
+ * @param[in] time_ms The current time
+ */
+void acc_rate_controller_reset_statistics(acc_rate_controller_t *controller, uint32_t time_ms);
+
+
+#endif
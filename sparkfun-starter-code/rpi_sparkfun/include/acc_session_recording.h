@@ -0,0 +1,131 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_SESSION_RECORDING_H_
+#define ACC_SESSION_RECORDING_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+/**
+ * @brief Type of a session record
+ */
+typedef enum
+{
+	ACC_SESSION_RECORD_OUTBOUND = 0, /**< Data written by the server to the client */
+	ACC_SESSION_RECORD_INBOUND,      /**< Data received by the server from the client */
+	ACC_SESSION_RECORD_CONNECT,      /**< A new client connected, starts a new session */
+} acc_session_record_type_t;
+
+
+/**
+ * @brief One record of a session recording
+ */
+typedef struct
+{
+	acc_session_record_type_t type;
+	uint64_t                  timestamp_us; /**< Time since the recording was opened */
+	const uint8_t             *data;
+	uint32_t                  size;
+} acc_session_record_t;
+
+
+/**
+ * @brief The session recorder instance
+ */
+typedef struct
+{
+	FILE     *file;
+	uint64_t start_us;
+	bool     write_failed;
+} acc_session_recorder_t;
+
+
+/**
+ * @brief The session player instance
+ */
+typedef struct
+{
+	FILE    *file;
+	uint8_t *buffer;
+	size_t  buffer_size;
+} acc_session_player_t;
+
+
+/**
+ * @brief Create a session recording file
+ *
+ * @param[in, out] recorder The recorder instance
+ * @param[in] path The path of the file to create
+ *
+ * @return true if no error occurred
+ */
+bool acc_session_recorder_open(acc_session_recorder_t *recorder, const char *path);
+
+
+/**
+ * @brief Close a session recording file
+ *
+ * @param[in] recorder The recorder instance
+ */
+void acc_session_recorder_close(acc_session_recorder_t *recorder);
+
+
+/**
+ * @brief Append one record, timestamped with the current time
+ *
+ * Writes are buffered, a failed write disables the recorder but does not affect the caller.
+ *
+ * @param[in] recorder The recorder instance
+ * @param[in] type The record type
+ * @param[in] data The record data, may be NULL if size is 0
+ * @param[in] size The size of the data in bytes
+ */
+void acc_session_recorder_write(acc_session_recorder_t *recorder, acc_session_record_type_t type,
+                                const void *data, size_t size);
+
+
+/**
+ * @brief Open a session recording file for playback
+ *
+ * @param[in, out] player The player instance
+ * @param[in] path The path of the file to open
+ *
+ * @return true if no error occurred
+ */
+bool acc_session_player_open(acc_session_player_t *player, const char *path);
+
+
+/**
+ * @brief Close a session recording file
+ *
+ * @param[in] player The player instance
+ */
+void acc_session_player_close(acc_session_player_t *player);
+
+
+/**
+ * @brief Restart playback from the first record
+ *
+ * @param[in] player The player instance
+ *
+ * @return true if no error occurred
+ */
+bool acc_session_player_rewind(acc_session_player_t *player);
+
+
+/**
+ * @brief Read the next record
+ *
+ * @param[in] player The player instance
+ * @param[out] record The record, the data is valid until the next call
+ *
+ * @return true if a record was read, false at end of file or on error
+ */
+bool acc_session_player_read(acc_session_player_t *player, acc_session_record_t *record);
+
+
+#endif
@@ -0,0 +1,119 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_SLIDING_WINDOW_H_
+#define ACC_SLIDING_WINDOW_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * @brief Sliding window handle
+ *
+ * A window over the latest values of a series with constant time access to min, max and sum.
+ * Adding a value is amortized constant time independent of the window size.
+ */
+struct acc_sliding_window;
+
+typedef struct acc_sliding_window *acc_sliding_window_t;
+
+
+/**
+ * @brief Create a sliding window
+ *
+ * @param[in] capacity The number of values in a full window
+ *
+ * @return Sliding window handle, NULL if the window could not be created
+ */
+acc_sliding_window_t acc_sliding_window_create(uint32_t capacity);
+
+
+/**
+ * @brief Destroy a sliding window
+ *
+ * The handle is set to NULL after destruction.
+ *
+ * @param[in] window The sliding window handle to destroy, can be NULL
+ */
+void acc_sliding_window_destroy(acc_sliding_window_t *window);
+
+
+/**
+ * @brief Remove all values from a sliding window
+ *
+ * @param[in] window The sliding window handle
+ */
+void acc_sliding_window_reset(acc_sliding_window_t window);
+
+
+/**
+ * @brief Add a value, the oldest value is removed if the window is full
+ *
+ * @param[in] window The sliding window handle
+ * @param[in] value The value to add
+ */
+void acc_sliding_window_add(acc_sliding_window_t window, float value);
+
+
+/**
+ * @brief Get the number of values in the window
+ *
+ * @param[in] window The sliding window handle
+ *
+ * @return The number of values
+ */
+uint32_t acc_sliding_window_get_count(acc_sliding_window_t window);
+
+
+/**
+ * @brief Check if the window holds capacity values
+ *
+ * @param[in] window The sliding window handle
+ *
+ * @return True if the window is full
+ */
+bool acc_sliding_window_is_full(acc_sliding_window_t window);
+
+
+/**
+ * @brief Get the smallest value in the window
+ *
+ * @param[in] window The sliding window handle
+ *
+ * @return The smallest value, 0 if the window is empty
+ */
+float acc_sliding_window_get_min(acc_sliding_window_t window);
+
+
+/**
+ * @brief Get the largest value in the window
+ *
+ * @param[in] window The sliding window handle
+ *
+ * @return The largest value, 0 if the window is empty
+ */
+float acc_sliding_window_get_max(acc_sliding_window_t window);
+
+
+/**
+ * @brief Get the sum of the values in the window
+ *
+ * @param[in] window The sliding window handle
+ *
+ * @return The sum
+ */
+float acc_sliding_window_get_sum(acc_sliding_window_t window);
+
+
+/**
+ * @brief Get the mean of the values in the window
+ *
+ * @param[in] window The sliding window handle
+ *
+ * @return The mean, 0 if the window is empty
+ */
+float acc_sliding_window_get_mean(acc_sliding_window_t window);
+
+
+#endif
@@ -16,19 +16,60 @@
  */
 typedef void (input_data_function_t)(const void *data, size_t size);
 
+/**
+ * @brief Socket options applied to each client socket
+ *
+ * A value of 0 for a size leaves the kernel default.
+ */
+typedef struct
+{
+	int  send_buffer_size;    /**< SO_SNDBUF */
+	int  receive_buffer_size; /**< SO_RCVBUF */
+	int  not_sent_lowat;      /**< TCP_NOTSENT_LOWAT, limits unsent data queued in the kernel, 0 is
+	                               the system default net.ipv4.tcp_notsent_lowat */
+	bool no_delay;            /**< TCP_NODELAY */
+	bool cork;                /**< Use TCP_CORK to coalesce the writes of a frame, see acc_socket_server_cork */
+} acc_socket_server_tuning_t;
+
+
 /**
  * @brief The socket server instance
  */
 typedef struct
 {
-	int                   server_socket;
-	int                   client_socket;
-	struct pollfd         poll_set[1];
-	input_data_function_t *input_data_func;
-	void                  *buffer;
-	size_t                buffer_size;
+	int                        server_socket;
+	int                        client_socket;
+	struct pollfd              poll_set[1];
+	input_data_function_t      *input_data_func;
+	void                       *buffer;
+	size_t                     buffer_size;
+	acc_socket_server_tuning_t tuning;
 } acc_socket_server_t;
 
+/**
+ * @brief Get the default tuning
+ *
+ * A 200000 byte send buffer and TCP_NODELAY, no corking.
+ *
+ * @param[out] tuning The default tuning
+ */
+void acc_socket_server_tuning_default(acc_socket_server_tuning_t *tuning);
+
+
+/**
+ * @brief Get a tuning suited for a stream of frames
+ *
+ * The send buffer holds about 100 ms of frames, the unsent low water mark two frames,
+ * so that a slow link drops into back pressure early instead of building latency.
+ * Frames larger than one segment are corked.
+ *
+ * @param[in] frame_size The size of a frame in bytes
+ * @param[in] frame_rate The number of frames per second
+ * @param[out] tuning The tuning for the stream
+ */
+void acc_socket_server_tuning_for_stream(size_t frame_size, float frame_rate, acc_socket_server_tuning_t *tuning);
+
+
 /**
  * @brief Open a socket server on a specified tcp port
  *
@@ -41,6 +82,29 @@ typedef struct
 bool acc_socket_server_open(acc_socket_server_t *socket_server, int server_port, size_t buffer_size);
 
 
+/**
+ * @brief Set the tuning used for client sockets
+ *
+ * The tuning is applied to the current client, if any, and to all future clients.
+ *
+ * @param[in] socket_server The socket server instance
+ * @param[in] tuning The tuning to use
+ */
+void acc_socket_server_set_tuning(acc_socket_server_t *socket_server, const acc_socket_server_tuning_t *tuning);
+
+
+/**
+ * @brief Start or end a frame on the client socket
+ *
+ * With cork enabled in the tuning, the writes between start and end of a frame are sent
+ * as full segments when the frame ends. Without cork this function does nothing.
+ *
+ * @param[in] socket_server The socket server instance
+ * @param[in] cork true at start of a frame, false at end of a frame
+ */
+void acc_socket_server_cork(acc_socket_server_t *socket_server, bool cork);
+
+
 /**
  * @brief Close a socket server
  *
@@ -102,4 +166,14 @@ void acc_socket_server_set_input_data_func(acc_socket_server_t *socket_server, i
 void acc_socket_server_setup_write_data(acc_socket_server_t *socket_server, const void *data, size_t size);
 
 
+/**
+ * @brief Get the number of bytes written to the client socket but not yet sent
+ *
+ * @param[in] socket_server The socket server instance
+ *
+ * @return The number of bytes in the send queue, 0 if there is no client
+ */
+size_t acc_socket_server_get_send_queue_size(acc_socket_server_t *socket_server);
+
+
 #endif
@@ -0,0 +1,133 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_TARGET_TRACKER_H_
+#define ACC_TARGET_TRACKER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "acc_detector_distance.h"
+
+
+/**
+ * @brief The maximum number of tracks, tentative and confirmed
+ */
+#define ACC_TARGET_TRACKER_MAX_TRACKS (32)
+
+/**
+ * @brief The maximum number of peaks per update, further peaks are ignored
+ */
+#define ACC_TARGET_TRACKER_MAX_PEAKS (64)
+
+
+/**
+ * @brief Target tracker parameters
+ */
+typedef struct
+{
+	/** Distance gain of the alpha-beta filter, 0 to 1 */
+	float    alpha;
+	/** Velocity gain of the alpha-beta filter, 0 to 2 */
+	float    beta;
+	/** The largest distance between the predicted distance of a track and a peak associated to it */
+	float    gate_m;
+	/** The number of associated peaks before a new track is confirmed */
+	uint16_t confirm_hits;
+	/** The number of consecutive updates without a peak before a confirmed track is deleted */
+	uint16_t delete_misses;
+} acc_target_tracker_parameters_t;
+
+
+/**
+ * @brief A track
+ */
+typedef struct
+{
+	/** Identity of the track, unique and kept for the lifetime of the track */
+	uint32_t id;
+	float    distance_m;
+	float    velocity_mps;
+	/** Amplitude of the last associated peak */
+	uint16_t amplitude;
+	/** The number of associated peaks */
+	uint16_t hits;
+	/** The number of consecutive updates without a peak */
+	uint16_t misses;
+	/** Tentative tracks are deleted at the first miss */
+	bool     confirmed;
+} acc_target_tracker_track_t;
+
+
+/**
+ * @brief An association candidate, a track and a peak within the gate
+ */
+typedef struct
+{
+	uint8_t track;
+	uint8_t peak;
+	bool    confirmed;
+	float   cost;
+} acc_target_tracker_pair_t;
+
+
+/**
+ * @brief Multi-target tracker over distance detector peaks
+ *
+ * Peaks are associated to tracks by greedy nearest neighbour, the gated track and peak pairs
+ * are assigned in order of distance with confirmed tracks first. This can differ from an
+ * optimal assignment only when the gates of tracks overlap. Each track is an alpha-beta
+ * filter. Peaks that are not associated start tentative tracks. All storage is part of the
+ * tracker, an update does not allocate.
+ */
+typedef struct
+{
+	acc_target_tracker_parameters_t parameters;
+	acc_target_tracker_track_t      tracks[ACC_TARGET_TRACKER_MAX_TRACKS];
+	uint16_t                        track_count;
+	uint32_t                        next_id;
+	uint32_t                        time_ms;
+	bool                            has_time;
+	acc_target_tracker_pair_t       pairs[ACC_TARGET_TRACKER_MAX_TRACKS * ACC_TARGET_TRACKER_MAX_PEAKS];
+	bool                            track_assigned[ACC_TARGET_TRACKER_MAX_TRACKS];
+	bool                            peak_assigned[ACC_TARGET_TRACKER_MAX_PEAKS];
+} acc_target_tracker_t;
+
+
+/**
+ * @brief Initialize a target tracker without tracks
+ *
+ * @param[out] tracker The tracker to initialize
+ * @param[in] parameters The tracker parameters
+ *
+ * @return True if the parameters are valid
+ */
+bool acc_target_tracker_init(acc_target_tracker_t *tracker, const acc_target_tracker_parameters_t *parameters);
+
+
+/**
+ * @brief Update the tracks with the peaks of a frame
+ *
+ * @param[in] tracker The tracker
+ * @param[in] peaks The peaks of the frame
+ * @param[in] peak_count The number of peaks
+ * @param[in] time_ms The time of the frame
+ */
+void acc_target_tracker_update(acc_target_tracker_t *tracker, const acc_detector_distance_result_t *peaks,
+                               uint16_t peak_count, uint32_t time_ms);
+
+
+/**
+ * @brief Get the confirmed tracks
+ *
+ * @param[in] tracker The tracker
+ * @param[out] tracks The confirmed tracks, in order of distance
+ * @param[in] max_track_count The maximum number of tracks to get
+ *
+ * @return The number of tracks
+ */
+uint16_t acc_target_tracker_get_confirmed(const acc_target_tracker_t *tracker, acc_target_tracker_track_t *tracks,
+                                          uint16_t max_track_count);
+
+
+#endif
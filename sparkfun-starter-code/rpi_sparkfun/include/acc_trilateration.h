@@ -0,0 +1,234 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_TRILATERATION_H_
+#define ACC_TRILATERATION_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "acc_detector_distance.h"
+
+
+/**
+ * @brief The maximum number of sensors
+ */
+#define ACC_TRILATERATION_MAX_SENSORS (4)
+
+/**
+ * @brief The maximum number of peaks per sensor update, further peaks are ignored
+ */
+#define ACC_TRILATERATION_MAX_PEAKS (8)
+
+/**
+ * @brief The maximum number of tracks, tentative and confirmed
+ */
+#define ACC_TRILATERATION_MAX_TRACKS (16)
+
+/**
+ * @brief The maximum number of candidate positions of an update, two per pair of peaks from two sensors
+ */
+#define ACC_TRILATERATION_MAX_CANDIDATES \
+	(2 * (ACC_TRILATERATION_MAX_SENSORS - 1) * ACC_TRILATERATION_MAX_PEAKS * ACC_TRILATERATION_MAX_PEAKS)
+
+
+/**
+ * @brief Trilateration parameters
+ *
+ * Positions are in a plane, with x along the bumper and y ahead of it.
+ */
+typedef struct
+{
+	/** The number of sensors, 2 to ACC_TRILATERATION_MAX_SENSORS */
+	uint8_t  sensor_count;
+	/** The positions of the sensors */
+	float    sensor_x_m[ACC_TRILATERATION_MAX_SENSORS];
+	float    sensor_y_m[ACC_TRILATERATION_MAX_SENSORS];
+	/** Peaks of other sensors older than this are not combined with a new update */
+	uint16_t max_age_ms;
+	/** The highest range rate of a target, used to match peaks between updates of a sensor */
+	float    max_speed_mps;
+	/** The largest difference between a range and the distance from its sensor to a position */
+	float    max_residual_m;
+	/** The largest geometric dilution of precision of a position */
+	float    max_gdop;
+	/** Positions closer to the bumper than this are discarded, this also picks one of two intersections */
+	float    min_y_m;
+	/** The number of sensors with a range to a position, 2 or more */
+	uint8_t  min_sensors;
+	/** Position gain of the track alpha-beta filters, 0 to 1 */
+	float    alpha;
+	/** Velocity gain of the track alpha-beta filters, 0 to 2 */
+	float    beta;
+	/** The largest distance between the predicted position of a track and a position associated to it */
+	float    gate_m;
+	/** The number of associated positions before a new track is confirmed */
+	uint16_t confirm_hits;
+	/** The number of consecutive updates of any sensor without a position before a confirmed track is deleted */
+	uint16_t delete_misses;
+} acc_trilateration_parameters_t;
+
+
+/**
+ * @brief A position from the ranges of two or more sensors
+ */
+typedef struct
+{
+	float   x_m;
+	float   y_m;
+	/** The root mean square difference between the ranges and the distances to the position */
+	float   residual_m;
+	/** The geometric dilution of precision, the position error per range error */
+	float   gdop;
+	/** The number of sensors with a range to the position */
+	uint8_t sensor_count;
+} acc_trilateration_position_t;
+
+
+/**
+ * @brief A position track
+ */
+typedef struct
+{
+	/** Identity of the track, unique and kept for the lifetime of the track */
+	uint32_t id;
+	float    x_m;
+	float    y_m;
+	float    velocity_x_mps;
+	float    velocity_y_mps;
+	/** The number of associated positions */
+	uint16_t hits;
+	/** The number of consecutive updates without a position */
+	uint16_t misses;
+	/** Tentative tracks are deleted after sensor_count consecutive updates without a position */
+	bool     confirmed;
+} acc_trilateration_track_t;
+
+
+/**
+ * @brief The latest peaks of a sensor
+ */
+typedef struct
+{
+	uint32_t time_ms;
+	uint16_t peak_count;
+	bool     valid;
+	float    range_m[ACC_TRILATERATION_MAX_PEAKS];
+	float    range_rate_mps[ACC_TRILATERATION_MAX_PEAKS];
+	bool     has_range_rate[ACC_TRILATERATION_MAX_PEAKS];
+} acc_trilateration_sensor_t;
+
+
+/**
+ * @brief A candidate position, with the peak of each sensor that supports it or -1
+ */
+typedef struct
+{
+	acc_trilateration_position_t position;
+	int8_t                       peak[ACC_TRILATERATION_MAX_SENSORS];
+} acc_trilateration_candidate_t;
+
+
+/**
+ * @brief A track and position association candidate
+ */
+typedef struct
+{
+	uint8_t track;
+	uint8_t position;
+	bool    confirmed;
+	float   cost;
+} acc_trilateration_pair_t;
+
+
+/**
+ * @brief Target localization from the distance detector peaks of several sensors
+ *
+ * The sensors update independently and every update is processed when it arrives, so the
+ * positions follow the combined update rate of all sensors. The peaks of the other sensors are
+ * moved to the time of the update with the range rate of each peak, from its match in the
+ * previous update of its sensor, and peaks older than max_age_ms are not used.
+ *
+ * Each peak of the updating sensor is intersected with each peak of every other sensor. The
+ * intersections get the closest peak of the remaining sensors within max_residual_m and are
+ * refined by least squares. Candidates that fail the residual, the geometry or min_sensors gate
+ * are discarded. The others are selected in order of sensor count and residual, with each peak
+ * in at most one position, which removes most ghosts of two targets when three or more sensors
+ * see them. The positions update alpha-beta tracks in the plane, associated by greedy nearest
+ * neighbour as in the target tracker.
+ *
+ * All storage is part of the struct, an update does not allocate, and the work of an update is
+ * bounded by the maximum number of sensors and peaks.
+ */
+typedef struct
+{
+	acc_trilateration_parameters_t parameters;
+	acc_trilateration_sensor_t     sensors[ACC_TRILATERATION_MAX_SENSORS];
+	acc_trilateration_candidate_t  candidates[ACC_TRILATERATION_MAX_CANDIDATES];
+	acc_trilateration_position_t   positions[ACC_TRILATERATION_MAX_SENSORS * ACC_TRILATERATION_MAX_PEAKS];
+	uint16_t                       position_count;
+	acc_trilateration_track_t      tracks[ACC_TRILATERATION_MAX_TRACKS];
+	uint16_t                       track_count;
+	uint32_t                       next_id;
+	uint32_t                       time_ms;
+	bool                           has_time;
+	acc_trilateration_pair_t       pairs[ACC_TRILATERATION_MAX_TRACKS * ACC_TRILATERATION_MAX_SENSORS *
+	                                     ACC_TRILATERATION_MAX_PEAKS];
+	bool                           track_assigned[ACC_TRILATERATION_MAX_TRACKS];
+	bool                           position_assigned[ACC_TRILATERATION_MAX_SENSORS * ACC_TRILATERATION_MAX_PEAKS];
+} acc_trilateration_t;
+
+
+/**
+ * @brief Initialize trilateration without peaks and tracks
+ *
+ * @param[out] trilateration The trilateration to initialize
+ * @param[in] parameters The trilateration parameters
+ *
+ * @return True if the parameters are valid
+ */
+bool acc_trilateration_init(acc_trilateration_t *trilateration, const acc_trilateration_parameters_t *parameters);
+
+
+/**
+ * @brief Locate targets with the peaks of an update of a sensor and update the tracks
+ *
+ * @param[in] trilateration The trilateration
+ * @param[in] sensor The index of the sensor in the parameters
+ * @param[in] peaks The peaks of the update
+ * @param[in] peak_count The number of peaks
+ * @param[in] time_ms The time of the update
+ *
+ * @return The number of positions, or 0 if the update is older than max_age_ms
+ */
+uint16_t acc_trilateration_update(acc_trilateration_t *trilateration, uint8_t sensor,
+                                  const acc_detector_distance_result_t *peaks, uint16_t peak_count, uint32_t time_ms);
+
+
+/**
+ * @brief Get the positions of the last update
+ *
+ * @param[in] trilateration The trilateration
+ * @param[out] positions The positions
+ * @param[in] max_position_count The maximum number of positions to get
+ *
+ * @return The number of positions
+ */
+uint16_t acc_trilateration_get_positions(const acc_trilateration_t *trilateration,
+                                         acc_trilateration_position_t *positions, uint16_t max_position_count);
+
+
+/**
+ * @brief Get the confirmed tracks
+ *
+ * @param[in] trilateration The trilateration
+ * @param[out] tracks The confirmed tracks, in order of distance from the origin
+ * @param[in] max_track_count The maximum number of tracks to get
+ *
+ * @return The number of tracks
+ */
+uint16_t acc_trilateration_get_confirmed(const acc_trilateration_t *trilateration, acc_trilateration_track_t *tracks,
+                                         uint16_t max_track_count);
+
+
+#endif
@@ -0,0 +1,217 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_UDP_STREAM_H_
+#define ACC_UDP_STREAM_H_
+
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Size of the header that precedes every datagram payload
+ *
+ * All fields are sent in network byte order:
+ *  - magic (uint16)
+ *  - version (uint8)
+ *  - reserved (uint8)
+ *  - frame sequence number (uint32)
+ *  - frame timestamp, us since epoch (uint64)
+ *  - frame size in bytes (uint32)
+ *  - fragment offset in bytes (uint32)
+ *  - fragment index (uint16)
+ *  - fragment count (uint16)
+ */
+#define ACC_UDP_STREAM_HEADER_SIZE 28
+
+/**
+ * @brief Default MTU used to size the datagrams
+ */
+#define ACC_UDP_STREAM_DEFAULT_MTU 1500
+
+/**
+ * @brief Largest frame the stream can carry
+ */
+#define ACC_UDP_STREAM_MAX_FRAME_SIZE (1024 * 1024)
+
+
+/**
+ * @brief Publisher statistics
+ */
+typedef struct
+{
+	uint32_t frames_sent;
+	uint32_t frames_dropped;
+	uint32_t datagrams_sent;
+	uint64_t bytes_sent;
+} acc_udp_stream_publisher_stats_t;
+
+
+/**
+ * @brief The UDP stream publisher instance
+ */
+typedef struct
+{
+	int                              socket;
+	struct sockaddr_in               destination;
+	size_t                           max_payload_size;
+	uint8_t                          *datagram;
+	uint32_t                         sequence_number;
+	acc_udp_stream_publisher_stats_t stats;
+} acc_udp_stream_publisher_t;
+
+
+/**
+ * @brief Information about a received frame
+ */
+typedef struct
+{
+	uint32_t sequence_number;
+	uint64_t timestamp_us;
+	uint16_t fragment_count;
+} acc_udp_stream_frame_info_t;
+
+
+/**
+ * @brief Receiver statistics
+ */
+typedef struct
+{
+	uint32_t frames_received;
+	uint32_t frames_lost;
+	uint32_t frames_incomplete;
+	uint32_t datagrams_received;
+	uint32_t datagrams_stale;
+	uint32_t datagrams_invalid;
+	uint32_t resyncs;
+	uint64_t bytes_received;
+} acc_udp_stream_receiver_stats_t;
+
+
+/**
+ * @brief The UDP stream receiver instance
+ */
+typedef struct
+{
+	int                             socket;
+	uint8_t                         *datagram;
+	size_t                          datagram_size;
+	uint8_t                         *frame;
+	size_t                          max_frame_size;
+	uint8_t                         *fragment_map;
+	bool                            frame_in_progress;
+	bool                            sequence_valid;
+	uint32_t                        next_sequence_number;
+	acc_udp_stream_frame_info_t     frame_info;
+	uint32_t                        frame_size;
+	uint16_t                        fragments_received;
+	acc_udp_stream_receiver_stats_t stats;
+} acc_udp_stream_receiver_t;
+
+
+/**
+ * @brief Open a UDP stream publisher
+ *
+ * If the address is a multicast group the datagrams are sent to the group with the given TTL,
+ * otherwise they are sent as unicast to the address.
+ *
+ * @param[in, out] publisher The publisher instance
+ * @param[in] address The destination IPv4 address (unicast or multicast)
+ * @param[in] port The destination UDP port
+ * @param[in] mtu The path MTU, used to size the datagrams
+ * @param[in] multicast_ttl The multicast TTL, ignored for unicast destinations
+ *
+ * @return true if no error occurred
+ */
+bool acc_udp_stream_publisher_open(acc_udp_stream_publisher_t *publisher, const char *address, int port, size_t mtu,
+                                   int multicast_ttl);
+
+
+/**
+ * @brief Close a UDP stream publisher
+ *
+ * @param[in] publisher The publisher instance
+ */
+void acc_udp_stream_publisher_close(acc_udp_stream_publisher_t *publisher);
+
+
+/**
+ * @brief Send one frame, fragmented into as many datagrams as needed
+ *
+ * The frame is stamped with the next sequence number and the current time. The call never blocks;
+ * if the socket cannot take a datagram the rest of the frame is dropped, a late frame is worthless.
+ *
+ * @param[in] publisher The publisher instance
+ * @param[in] data The frame data
+ * @param[in] size The size of the frame in bytes
+ *
+ * @return true if the whole frame was sent
+ */
+bool acc_udp_stream_publisher_send_frame(acc_udp_stream_publisher_t *publisher, const void *data, size_t size);
+
+
+/**
+ * @brief Count a frame that the caller could not send, for example because it did not fit a frame
+ *
+ * @param[in] publisher The publisher instance
+ */
+void acc_udp_stream_publisher_drop_frame(acc_udp_stream_publisher_t *publisher);
+
+
+/**
+ * @brief Open a UDP stream receiver
+ *
+ * If the address is a multicast group the receiver joins it, otherwise it
+ * listens for unicast datagrams on all interfaces.
+ *
+ * @param[in, out] receiver The receiver instance
+ * @param[in] address The multicast group to join, or NULL for unicast
+ * @param[in] port The UDP port to listen on
+ * @param[in] max_frame_size The largest frame that can be reassembled
+ *
+ * @return true if no error occurred
+ */
+bool acc_udp_stream_receiver_open(acc_udp_stream_receiver_t *receiver, const char *address, int port,
+                                  size_t max_frame_size);
+
+
+/**
+ * @brief Close a UDP stream receiver
+ *
+ * @param[in] receiver The receiver instance
+ */
+void acc_udp_stream_receiver_close(acc_udp_stream_receiver_t *receiver);
+
+
+/**
+ * @brief Wait for the next complete frame
+ *
+ * Fragments are reassembled in any order. When a fragment of a newer frame arrives before the
+ * current frame is complete, the current frame is dropped and counted as incomplete.
+ * Fragments of frames a few frames older than the current frame are discarded. A larger
+ * backward jump of the sequence number, or a new timestamp for the current sequence number,
+ * is a restarted publisher, and the receiver resyncs to it.
+ *
+ * @param[in] receiver The receiver instance
+ * @param[in] timeout_ms The maximum time to wait for a complete frame
+ * @param[out] frame Pointer to the reassembled frame, valid until the next call
+ * @param[out] size The size of the frame in bytes
+ * @param[out] frame_info Information about the frame
+ *
+ * @return true if a complete frame was received, false on timeout or error
+ */
+bool acc_udp_stream_receiver_get_next(acc_udp_stream_receiver_t *receiver, uint32_t timeout_ms,
+                                      const uint8_t **frame, size_t *size,
+                                      acc_udp_stream_frame_info_t *frame_info);
+
+
+/**
+ * @brief Get the current time in the clock used for frame timestamps
+ *
+ * @return Microseconds since epoch
+ */
+uint64_t acc_udp_stream_get_timestamp_us(void);
+
+
+#endif
@@ -0,0 +1,136 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_VEHICLE_PASS_H_
+#define ACC_VEHICLE_PASS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "acc_envelope_background.h"
+
+
+/**
+ * @brief The maximum number of envelope bins
+ */
+#define ACC_VEHICLE_PASS_MAX_LENGTH ACC_ENVELOPE_BACKGROUND_MAX_LENGTH
+
+
+/**
+ * @brief Vehicle pass counter parameters
+ */
+typedef struct
+{
+	/** The distance of the first bin, from the envelope metadata */
+	float                                start_m;
+	/** The distance between two bins, from the envelope metadata */
+	float                                step_length_m;
+	/** The per bin background, learnt while no vehicle is present */
+	acc_envelope_background_parameters_t background;
+	/** A vehicle enters when the highest z-score of a bin exceeds this */
+	float                                enter_threshold;
+	/** A vehicle leaves when the highest z-score of a bin is below this */
+	float                                exit_threshold;
+	/** The number of consecutive frames above the enter threshold before a pass starts */
+	uint16_t                             enter_frames;
+	/** The number of consecutive frames below the exit threshold before a pass ends */
+	uint16_t                             exit_frames;
+	/** A pass that lasts longer ends and the scene becomes the background, for example a parked vehicle */
+	uint32_t                             max_pass_ms;
+} acc_vehicle_pass_parameters_t;
+
+
+/**
+ * @brief A vehicle pass
+ */
+typedef struct
+{
+	/** The time of the first frame above the enter threshold */
+	uint32_t start_ms;
+	/** The time from the start to the last frame above the exit threshold */
+	uint32_t duration_ms;
+	uint32_t frame_count;
+	/** The shortest distance of the strongest foreground bin in frames above the enter threshold */
+	float    closest_m;
+	/** The strongest foreground amplitude */
+	float    peak_amplitude;
+	/** The pass ended at max_pass_ms */
+	bool     timed_out;
+} acc_vehicle_pass_t;
+
+
+/**
+ * @brief Vehicle pass counter over an envelope stream
+ *
+ * Each bin has an acc_envelope_background that follows the envelope while no vehicle is present,
+ * and the z-score of a bin is its foreground in standard deviations of that bin, so bins with
+ * drifting clutter need more foreground than quiet bins. A vehicle is present from enter_frames
+ * consecutive frames with a z-score above the enter threshold until exit_frames consecutive
+ * frames below the exit threshold. The background is frozen while a vehicle is present or about
+ * to enter, so that vehicles are not learnt. No detection is done while the background is learnt,
+ * at start and after a pass that timed out. All storage is part of the counter, an update does
+ * not allocate.
+ */
+typedef struct
+{
+	acc_vehicle_pass_parameters_t parameters;
+	uint16_t                      data_length;
+	acc_envelope_background_t     background;
+	uint16_t                      foreground[ACC_VEHICLE_PASS_MAX_LENGTH];
+	float                         z_scores[ACC_VEHICLE_PASS_MAX_LENGTH];
+	uint32_t                      pass_count;
+	bool                          present;
+	/** Consecutive frames past the threshold of the next state change */
+	uint16_t                      run_frames;
+	acc_vehicle_pass_t            pass;
+} acc_vehicle_pass_counter_t;
+
+
+/**
+ * @brief Initialize a vehicle pass counter, the background is learnt from the first frames
+ *
+ * @param[out] counter The counter to initialize
+ * @param[in] parameters The counter parameters
+ * @param[in] data_length The number of envelope bins, at most ACC_VEHICLE_PASS_MAX_LENGTH
+ *
+ * @return True if the parameters are valid
+ */
+bool acc_vehicle_pass_counter_init(acc_vehicle_pass_counter_t *counter, const acc_vehicle_pass_parameters_t *parameters,
+                                   uint16_t data_length);
+
+
+/**
+ * @brief Add an envelope frame
+ *
+ * @param[in] counter The counter
+ * @param[in] data The envelope, data_length bins
+ * @param[in] time_ms The time of the frame
+ * @param[out] pass The pass that ended with this frame
+ *
+ * @return True if a pass ended
+ */
+bool acc_vehicle_pass_counter_update(acc_vehicle_pass_counter_t *counter, const uint16_t *data, uint32_t time_ms,
+                                     acc_vehicle_pass_t *pass);
+
+
+/**
+ * @brief Check if a vehicle is present
+ *
+ * @param[in] counter The counter
+ *
+ * @return True from the start of a pass until it ends
+ */
+bool acc_vehicle_pass_counter_is_present(const acc_vehicle_pass_counter_t *counter);
+
+
+/**
+ * @brief Get the number of passes that have ended
+ *
+ * @param[in] counter The counter
+ *
+ * @return The number of passes
+ */
+uint32_t acc_vehicle_pass_counter_get_count(const acc_vehicle_pass_counter_t *counter);
+
+
+#endif
@@ -0,0 +1,80 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+
+#ifndef ACC_ZONE_MAP_H_
+#define ACC_ZONE_MAP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * @brief The maximum number of zones in a zone map
+ */
+#define ACC_ZONE_MAP_MAX_ZONES (16)
+
+
+/**
+ * @brief Per zone occupancy from a presence distance point vector
+ *
+ * The score of a zone is the highest point score in the zone. A zone becomes occupied when
+ * its score reaches the enter threshold and vacant when its score falls below the exit threshold.
+ */
+typedef struct
+{
+	float    start_m;                           /**< The start of the first zone */
+	float    zone_length_m;                     /**< The length of each zone */
+	float    range_length_m;                    /**< The length of the range covered by the distance points */
+	float    enter_threshold;                   /**< Score at or above which a zone becomes occupied */
+	float    exit_threshold;                    /**< Score below which a zone becomes vacant */
+	uint16_t zone_count;                        /**< The number of zones */
+	uint16_t point_count;                       /**< The number of distance points the point table is set up for */
+	uint8_t  *point_zone;                       /**< The zone of each distance point */
+	float    score[ACC_ZONE_MAP_MAX_ZONES];     /**< The score of each zone in the last update */
+	bool     occupied[ACC_ZONE_MAP_MAX_ZONES];  /**< The occupancy of each zone */
+} acc_zone_map_t;
+
+
+/**
+ * @brief Initialize a zone map
+ *
+ * The distance points are assumed to be evenly spread over the range, the first point at the
+ * start of the first zone. Points beyond the last zone belong to the last zone.
+ *
+ * @param[out] map The zone map to initialize
+ * @param[in] start_m The start of the range and of the first zone
+ * @param[in] range_length_m The length of the range
+ * @param[in] zone_length_m The length of each zone
+ * @param[in] enter_threshold Score at or above which a zone becomes occupied
+ * @param[in] exit_threshold Score below which a zone becomes vacant, at most the enter threshold
+ *
+ * @return True if the parameters are valid
+ */
+bool acc_zone_map_init(acc_zone_map_t *map, float start_m, float range_length_m, float zone_length_m,
+                       float enter_threshold, float exit_threshold);
+
+
+/**
+ * @brief Update the zone scores and occupancy with a distance point vector
+ *
+ * The point to zone table is set up at the first update and when the number of points changes.
+ *
+ * @param[in] map The zone map
+ * @param[in] points The distance point vector
+ * @param[in] point_count The number of distance points
+ * @param[out] changed True if the occupancy of any zone changed
+ *
+ * @return True if successful, false if the point table could not be allocated
+ */
+bool acc_zone_map_update(acc_zone_map_t *map, const float *points, uint16_t point_count, bool *changed);
+
+
+/**
+ * @brief Release the point table of a zone map
+ *
+ * @param[in] map The zone map
+ */
+void acc_zone_map_release(acc_zone_map_t *map);
+
+
+#endif
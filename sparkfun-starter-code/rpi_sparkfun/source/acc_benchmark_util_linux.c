@@ -0,0 +1,51 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <stdint.h>
+#include <time.h>
+
+#include "acc_benchmark_util.h"
+
+
+uint64_t acc_benchmark_get_time_ns(void)
+{
+	struct timespec time_ts = {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &time_ts);
+	return (uint64_t)time_ts.tv_sec * 1000000000 + (uint64_t)time_ts.tv_nsec;
+}
+
+
+uint64_t acc_benchmark_get_cpu_time_ns(void)
+{
+	struct timespec time_ts = {0};
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time_ts);
+	return (uint64_t)time_ts.tv_sec * 1000000000 + (uint64_t)time_ts.tv_nsec;
+}
+
+
+float acc_benchmark_next_uniform(uint32_t *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+
+	return (float)(*state % 1000000) / 1000000.0f;
+}
+
+
+float acc_benchmark_next_noise(uint32_t *state)
+{
+	float sum = 0.0f;
+
+	for (uint16_t i = 0; i < 12; i++)
+	{
+		sum += acc_benchmark_next_uniform(state);
+	}
+
+	return sum - 6.0f;
+}
@@ -22,8 +22,6 @@
 #include "acc_libspi.h"
 
 
-#define SENSOR_COUNT (1)               /**< @brief The number of sensors available on the board */
-
 #define PIN_SENSOR_INTERRUPT (25)      /**< @brief Gpio Interrupt Sensor BCM:25 J5:22, connect to sensor GPIO 5 */
 #define PIN_SENSOR_ENABLE    (27)      /**< @brief SPI Sensor enable BCM:27 J5:13 */
 
@@ -43,15 +41,33 @@ typedef enum
 } acc_board_sensor_state_t;
 
 
-static acc_board_sensor_state_t sensor_state = SENSOR_DISABLED;
+/**
+ * @brief Pins and chip select of one sensor
+ */
+typedef struct
+{
+	unsigned int interrupt_pin;
+	unsigned int enable_pin;
+	uint8_t      spi_cs;
+} acc_board_sensor_config_t;
+
 
-static const gpio_config_t pin_config[] =
+/**
+ * @brief The sensors of the board, sensor id 1 is the first entry
+ *
+ * More sensors on the same SPI bus are added with one entry each, using
+ * their own interrupt and enable pins and chip select. All sensors are
+ * then served by one RSS activation, spidev serializes their transfers.
+ */
+static const acc_board_sensor_config_t sensor_config[] =
 {
-	{PIN_SENSOR_INTERRUPT, GPIO_DIR_INPUT_INTERRUPT},
-	{PIN_SENSOR_ENABLE, GPIO_DIR_OUTPUT_LOW},
-	{0, GPIO_DIR_UNKNOWN},
+	{PIN_SENSOR_INTERRUPT, PIN_SENSOR_ENABLE, ACC_BOARD_CS},
 };
 
+#define SENSOR_COUNT (sizeof(sensor_config) / sizeof(sensor_config[0])) /**< @brief The number of sensors available on the board */
+
+static acc_board_sensor_state_t sensor_state[SENSOR_COUNT];
+
 static uint32_t spi_speed = ACC_BOARD_SPI_SPEED;
 
 
@@ -72,6 +88,19 @@ static bool acc_board_gpio_init(void)
 		return true;
 	}
 
+	gpio_config_t pin_config[2 * SENSOR_COUNT + 1];
+
+	for (size_t i = 0; i < SENSOR_COUNT; i++)
+	{
+		pin_config[2 * i].pin           = sensor_config[i].interrupt_pin;
+		pin_config[2 * i].direction     = GPIO_DIR_INPUT_INTERRUPT;
+		pin_config[2 * i + 1].pin       = sensor_config[i].enable_pin;
+		pin_config[2 * i + 1].direction = GPIO_DIR_OUTPUT_LOW;
+	}
+
+	pin_config[2 * SENSOR_COUNT].pin       = 0;
+	pin_config[2 * SENSOR_COUNT].direction = GPIO_DIR_UNKNOWN;
+
 	if (!acc_libgpiod_init(pin_config))
 	{
 		fprintf(stderr, "Unable to initialize gpio\n");
@@ -104,6 +133,11 @@ static bool acc_board_init(void)
 		result = acc_libspi_init();
 	}
 
+	for (size_t i = 0; result && i < SENSOR_COUNT; i++)
+	{
+		result = acc_libspi_init_device(sensor_config[i].spi_cs);
+	}
+
 	if (result)
 	{
 		init_done = true;
@@ -115,46 +149,63 @@ static bool acc_board_init(void)
 
 static void acc_board_start_sensor(acc_sensor_id_t sensor)
 {
-	(void)sensor;
+	assert(sensor >= 1 && sensor <= SENSOR_COUNT);
 
-	if (sensor_state != SENSOR_DISABLED)
+	if (sensor_state[sensor - 1] != SENSOR_DISABLED)
 	{
 		return;
 	}
 
-	if (!acc_libgpiod_set(PIN_SENSOR_ENABLE, PIN_HIGH))
+	if (!acc_libgpiod_set(sensor_config[sensor - 1].enable_pin, PIN_HIGH))
 	{
 		fprintf(stderr, "%s: Unable to activate enable_pin for sensor.\n", __func__);
 		assert(false);
 	}
 
 	acc_integration_sleep_ms(5);
-	sensor_state = SENSOR_ENABLED;
+	sensor_state[sensor - 1] = SENSOR_ENABLED;
 }
 
 
 static void acc_board_stop_sensor(acc_sensor_id_t sensor)
 {
-	(void)sensor;
+	assert(sensor >= 1 && sensor <= SENSOR_COUNT);
 
-	if (sensor_state != SENSOR_DISABLED)
+	if (sensor_state[sensor - 1] != SENSOR_DISABLED)
 	{
 		// Disable sensor
-		if (!acc_libgpiod_set(PIN_SENSOR_ENABLE, PIN_LOW))
+		if (!acc_libgpiod_set(sensor_config[sensor - 1].enable_pin, PIN_LOW))
 		{
 			fprintf(stderr, "%s: Unable to deactivate enable_pin for sensor.\n", __func__);
 			assert(false);
 		}
 
-		sensor_state = SENSOR_DISABLED;
+		sensor_state[sensor - 1] = SENSOR_DISABLED;
 	}
 }
 
 
 static bool acc_board_wait_for_sensor_interrupt(acc_sensor_id_t sensor_id, uint32_t timeout_ms)
 {
-	(void)sensor_id;
-	return acc_libgpiod_wait_for_interrupt(PIN_SENSOR_INTERRUPT, timeout_ms);
+	assert(sensor_id >= 1 && sensor_id <= SENSOR_COUNT);
+
+	return acc_libgpiod_wait_for_interrupt(sensor_config[sensor_id - 1].interrupt_pin, timeout_ms);
+}
+
+
+bool acc_hal_integration_get_interrupt_time_ns(acc_sensor_id_t sensor_id, uint64_t *time_ns)
+{
+	assert(sensor_id >= 1 && sensor_id <= SENSOR_COUNT);
+
+	struct timespec time;
+
+	if (!acc_libgpiod_get_interrupt_time(sensor_config[sensor_id - 1].interrupt_pin, &time))
+	{
+		return false;
+	}
+
+	*time_ns = (uint64_t)time.tv_sec * 1000000000 + (uint64_t)time.tv_nsec;
+	return true;
 }
 
 
@@ -166,9 +217,9 @@ static float acc_board_get_ref_freq(void)
 
 static void acc_board_sensor_transfer(acc_sensor_id_t sensor_id, uint8_t *buffer, size_t buffer_length)
 {
-	(void)sensor_id;
+	assert(sensor_id >= 1 && sensor_id <= SENSOR_COUNT);
 
-	bool result = acc_libspi_transfer(spi_speed, buffer, buffer_length);
+	bool result = acc_libspi_transfer_device(sensor_config[sensor_id - 1].spi_cs, spi_speed, buffer, buffer_length);
 	assert(result);
 }
 
@@ -0,0 +1,131 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "acc_cache_file.h"
+
+/*
+ * File format, all integers little endian:
+ *  - header: magic "ACCCACH" + format version (8 bytes), key (uint32), size (uint32), checksum (uint32)
+ *  - data (size bytes)
+ */
+#define FILE_MAGIC       "ACCCACH"
+#define FILE_VERSION     (1)
+#define FILE_HEADER_SIZE (20)
+#define MAX_PATH_LENGTH  (256)
+
+#define FNV_PRIME (16777619u)
+
+
+static void put_le32(uint8_t *buffer, uint32_t value)
+{
+	for (size_t i = 0; i < 4; i++)
+	{
+		buffer[i] = (uint8_t)(value >> (8 * i));
+	}
+}
+
+
+static uint32_t get_le32(const uint8_t *buffer)
+{
+	uint32_t value = 0;
+
+	for (size_t i = 0; i < 4; i++)
+	{
+		value |= (uint32_t)buffer[i] << (8 * i);
+	}
+
+	return value;
+}
+
+
+uint32_t acc_cache_file_hash(uint32_t hash, const void *data, size_t size)
+{
+	const uint8_t *bytes = data;
+
+	/* FNV-1a */
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+
+bool acc_cache_file_write(const char *path, uint32_t key, const void *data, size_t size)
+{
+	char    temporary_path[MAX_PATH_LENGTH];
+	uint8_t header[FILE_HEADER_SIZE];
+
+	if (snprintf(temporary_path, sizeof(temporary_path), "%s.tmp", path) >= (int)sizeof(temporary_path))
+	{
+		fprintf(stderr, "ERROR: Cache file path too long '%s'\n", path);
+		return false;
+	}
+
+	FILE *file = fopen(temporary_path, "wb");
+
+	if (file == NULL)
+	{
+		fprintf(stderr, "ERROR: Could not create '%s': (%u) %s\n", temporary_path, errno, strerror(errno));
+		return false;
+	}
+
+	memcpy(header, FILE_MAGIC, 7);
+	header[7] = FILE_VERSION;
+	put_le32(&header[8], key);
+	put_le32(&header[12], (uint32_t)size);
+	put_le32(&header[16], acc_cache_file_hash(ACC_CACHE_FILE_HASH_INIT, data, size));
+
+	bool status = fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+	              fwrite(data, 1, size, file) == size;
+
+	status = fclose(file) == 0 && status;
+
+	if (status && rename(temporary_path, path) != 0)
+	{
+		status = false;
+	}
+
+	if (!status)
+	{
+		fprintf(stderr, "ERROR: Could not write '%s': (%u) %s\n", path, errno, strerror(errno));
+		remove(temporary_path);
+	}
+
+	return status;
+}
+
+
+bool acc_cache_file_read(const char *path, uint32_t key, void *data, size_t size)
+{
+	uint8_t header[FILE_HEADER_SIZE];
+	FILE    *file = fopen(path, "rb");
+
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	bool status = fread(header, 1, sizeof(header), file) == sizeof(header) &&
+	              memcmp(header, FILE_MAGIC, 7) == 0 &&
+	              header[7] == FILE_VERSION &&
+	              get_le32(&header[8]) == key &&
+	              get_le32(&header[12]) == (uint32_t)size &&
+	              fread(data, 1, size, file) == size &&
+	              get_le32(&header[16]) == acc_cache_file_hash(ACC_CACHE_FILE_HASH_INIT, data, size);
+
+	fclose(file);
+
+	return status;
+}
@@ -0,0 +1,363 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "acc_cfar.h"
+
+
+struct acc_cfar
+{
+	acc_cfar_parameters_t *parameters;
+	uint16_t              parameter_count;
+	uint16_t              max_length;
+	uint16_t              length;
+	const uint16_t        *frame;
+	uint32_t              *prefix;    /**< prefix[i] is the sum of the first i bins */
+	float                 *threshold; /**< max_length thresholds per parameter set */
+	uint16_t              *sorted;    /**< The sorted training bins for OS-CFAR */
+};
+
+
+/**
+ * @brief Calculate the bins that have a full set of training bins, [first, end)
+ */
+static bool valid_bins(const acc_cfar_parameters_t *parameters, uint16_t length, uint16_t *first, uint16_t *end)
+{
+	uint32_t reach = (uint32_t)parameters->guard_bins + parameters->window_bins - 1;
+
+	*first = (uint16_t)reach;
+	*end   = parameters->only_lower ? length : (uint16_t)(length > reach ? length - reach : 0);
+
+	return *first < *end;
+}
+
+
+/**
+ * @brief Cell averaging threshold from the prefix sums, four bins at a time with NEON
+ */
+static void ca_threshold(const struct acc_cfar *cfar, const acc_cfar_parameters_t *parameters, float *threshold,
+                         uint16_t first, uint16_t end)
+{
+	const uint32_t *prefix     = cfar->prefix;
+	uint32_t       guard       = parameters->guard_bins;
+	uint32_t       window      = parameters->window_bins;
+	uint32_t       cells       = parameters->only_lower ? window : 2 * window;
+	float          scale       = 1.0f / (parameters->sensitivity * (float)cells);
+	uint32_t       lower_end   = first - guard + 1;
+	uint32_t       lower_begin = first - guard - window + 1;
+	uint32_t       count       = end - first;
+	uint32_t       i           = 0;
+
+	if (parameters->only_lower)
+	{
+#if defined(__ARM_NEON)
+		float32x4_t scale_vector = vdupq_n_f32(scale);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			uint32x4_t sum = vsubq_u32(vld1q_u32(&prefix[lower_end + i]), vld1q_u32(&prefix[lower_begin + i]));
+
+			vst1q_f32(&threshold[first + i], vmulq_f32(vcvtq_f32_u32(sum), scale_vector));
+		}
+#endif
+		for (; i < count; i++)
+		{
+			threshold[first + i] = (float)(prefix[lower_end + i] - prefix[lower_begin + i]) * scale;
+		}
+	}
+	else
+	{
+		uint32_t upper_end   = first + guard + window;
+		uint32_t upper_begin = first + guard;
+
+#if defined(__ARM_NEON)
+		float32x4_t scale_vector = vdupq_n_f32(scale);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			uint32x4_t lower = vsubq_u32(vld1q_u32(&prefix[lower_end + i]), vld1q_u32(&prefix[lower_begin + i]));
+			uint32x4_t upper = vsubq_u32(vld1q_u32(&prefix[upper_end + i]), vld1q_u32(&prefix[upper_begin + i]));
+
+			vst1q_f32(&threshold[first + i], vmulq_f32(vcvtq_f32_u32(vaddq_u32(lower, upper)), scale_vector));
+		}
+#endif
+		for (; i < count; i++)
+		{
+			uint32_t sum = (prefix[lower_end + i] - prefix[lower_begin + i]) +
+			               (prefix[upper_end + i] - prefix[upper_begin + i]);
+
+			threshold[first + i] = (float)sum * scale;
+		}
+	}
+}
+
+
+/**
+ * @brief Replace a value in a sorted array with another value, keeping it sorted
+ */
+static void sorted_replace(uint16_t *sorted, uint16_t count, uint16_t old_value, uint16_t new_value)
+{
+	uint16_t low  = 0;
+	uint16_t high = count;
+
+	// Find the first position of the old value
+	while (low < high)
+	{
+		uint16_t middle = (uint16_t)((low + high) / 2);
+
+		if (sorted[middle] < old_value)
+		{
+			low = (uint16_t)(middle + 1);
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	uint16_t position = low;
+
+	while (position + 1 < count && sorted[position + 1] < new_value)
+	{
+		sorted[position] = sorted[position + 1];
+		position++;
+	}
+
+	while (position > 0 && sorted[position - 1] > new_value)
+	{
+		sorted[position] = sorted[position - 1];
+		position--;
+	}
+
+	sorted[position] = new_value;
+}
+
+
+static int compare_uint16(const void *a, const void *b)
+{
+	return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+
+/**
+ * @brief Ordered statistic threshold, the training bins are kept sorted while sliding over the frame
+ */
+static void os_threshold(const struct acc_cfar *cfar, const acc_cfar_parameters_t *parameters, float *threshold,
+                         uint16_t first, uint16_t end)
+{
+	const uint16_t *frame  = cfar->frame;
+	uint16_t       *sorted = cfar->sorted;
+	uint16_t       guard   = parameters->guard_bins;
+	uint16_t       window  = parameters->window_bins;
+	uint16_t       cells   = 0;
+	float          scale   = 1.0f / parameters->sensitivity;
+
+	for (uint16_t offset = guard; offset < guard + window; offset++)
+	{
+		sorted[cells++] = frame[first - offset];
+
+		if (!parameters->only_lower)
+		{
+			sorted[cells++] = frame[first + offset];
+		}
+	}
+
+	qsort(sorted, cells, sizeof(*sorted), compare_uint16);
+
+	uint16_t rank = (uint16_t)(parameters->os_rank * (float)(cells - 1) + 0.5f);
+
+	for (uint16_t i = first; i < end; i++)
+	{
+		threshold[i] = (float)sorted[rank] * scale;
+
+		if (i + 1 < end)
+		{
+			sorted_replace(sorted, cells, frame[i + 1 - guard - window], frame[i + 1 - guard]);
+
+			if (!parameters->only_lower)
+			{
+				sorted_replace(sorted, cells, frame[i + guard], frame[i + guard + window]);
+			}
+		}
+	}
+}
+
+
+void acc_cfar_parameters_from_distance(float guard_m, float window_m, float step_length_m, float sensitivity,
+                                       bool only_lower, acc_cfar_parameters_t *parameters)
+{
+	long guard_bins  = lroundf(guard_m / (2.0f * step_length_m));
+	long window_bins = lroundf(window_m / step_length_m);
+
+	parameters->type        = ACC_CFAR_TYPE_CA;
+	parameters->guard_bins  = (uint16_t)(guard_bins < 1 ? 1 : guard_bins);
+	parameters->window_bins = (uint16_t)(window_bins < 1 ? 1 : window_bins);
+	parameters->sensitivity = sensitivity;
+	parameters->os_rank     = 0.75f;
+	parameters->only_lower  = only_lower;
+}
+
+
+acc_cfar_t acc_cfar_create(const acc_cfar_parameters_t *parameters, uint16_t parameter_count, uint16_t max_length)
+{
+	uint16_t max_cells = 0;
+
+	if (parameter_count == 0 || max_length == 0)
+	{
+		return NULL;
+	}
+
+	for (uint16_t i = 0; i < parameter_count; i++)
+	{
+		if (parameters[i].guard_bins < 1 || parameters[i].window_bins < 1 || parameters[i].sensitivity <= 0.0f ||
+		    parameters[i].os_rank < 0.0f || parameters[i].os_rank > 1.0f)
+		{
+			fprintf(stderr, "ERROR: Invalid CFAR parameter set %u\n", (unsigned int)i);
+			return NULL;
+		}
+
+		if (2 * parameters[i].window_bins > max_cells)
+		{
+			max_cells = (uint16_t)(2 * parameters[i].window_bins);
+		}
+	}
+
+	struct acc_cfar *cfar = calloc(1, sizeof(*cfar));
+
+	if (cfar == NULL)
+	{
+		return NULL;
+	}
+
+	cfar->parameters      = malloc(parameter_count * sizeof(*cfar->parameters));
+	cfar->prefix          = malloc(((size_t)max_length + 1) * sizeof(*cfar->prefix));
+	cfar->threshold       = malloc((size_t)parameter_count * max_length * sizeof(*cfar->threshold));
+	cfar->sorted          = malloc(max_cells * sizeof(*cfar->sorted));
+	cfar->parameter_count = parameter_count;
+	cfar->max_length      = max_length;
+
+	if (cfar->parameters == NULL || cfar->prefix == NULL || cfar->threshold == NULL || cfar->sorted == NULL)
+	{
+		acc_cfar_destroy(&cfar);
+		return NULL;
+	}
+
+	memcpy(cfar->parameters, parameters, parameter_count * sizeof(*cfar->parameters));
+
+	return cfar;
+}
+
+
+void acc_cfar_destroy(acc_cfar_t *cfar)
+{
+	if (*cfar == NULL)
+	{
+		return;
+	}
+
+	free((*cfar)->parameters);
+	free((*cfar)->prefix);
+	free((*cfar)->threshold);
+	free((*cfar)->sorted);
+	free(*cfar);
+
+	*cfar = NULL;
+}
+
+
+bool acc_cfar_process(acc_cfar_t cfar, const uint16_t *frame, uint16_t length)
+{
+	if (length > cfar->max_length)
+	{
+		fprintf(stderr, "ERROR: CFAR frame length %u exceeds %u\n", (unsigned int)length, (unsigned int)cfar->max_length);
+		return false;
+	}
+
+	cfar->frame  = frame;
+	cfar->length = length;
+
+	// The window sums of all cell averaging parameter sets come from one prefix sum
+	cfar->prefix[0] = 0;
+
+	for (uint16_t i = 0; i < length; i++)
+	{
+		cfar->prefix[i + 1] = cfar->prefix[i] + frame[i];
+	}
+
+	for (uint16_t p = 0; p < cfar->parameter_count; p++)
+	{
+		const acc_cfar_parameters_t *parameters = &cfar->parameters[p];
+		float                       *threshold  = &cfar->threshold[(size_t)p * cfar->max_length];
+		uint16_t                    first;
+		uint16_t                    end;
+
+		if (!valid_bins(parameters, length, &first, &end))
+		{
+			first = length;
+			end   = length;
+		}
+
+		for (uint16_t i = 0; i < first; i++)
+		{
+			threshold[i] = NAN;
+		}
+
+		for (uint16_t i = end; i < length; i++)
+		{
+			threshold[i] = NAN;
+		}
+
+		if (first == end)
+		{
+			continue;
+		}
+
+		if (parameters->type == ACC_CFAR_TYPE_CA)
+		{
+			ca_threshold(cfar, parameters, threshold, first, end);
+		}
+		else
+		{
+			os_threshold(cfar, parameters, threshold, first, end);
+		}
+	}
+
+	return true;
+}
+
+
+const float *acc_cfar_get_threshold(const acc_cfar_t cfar, uint16_t parameter_index)
+{
+	return &cfar->threshold[(size_t)parameter_index * cfar->max_length];
+}
+
+
+uint16_t acc_cfar_get_peaks(const acc_cfar_t cfar, uint16_t parameter_index, uint16_t *peaks, uint16_t max_peak_count)
+{
+	const uint16_t *frame     = cfar->frame;
+	const float    *threshold = acc_cfar_get_threshold(cfar, parameter_index);
+	uint16_t       count      = 0;
+
+	for (uint16_t i = 1; i + 1 < cfar->length && count < max_peak_count; i++)
+	{
+		if ((float)frame[i] > threshold[i] && frame[i] > frame[i - 1] && frame[i] >= frame[i + 1])
+		{
+			peaks[count++] = i;
+		}
+	}
+
+	return count;
+}
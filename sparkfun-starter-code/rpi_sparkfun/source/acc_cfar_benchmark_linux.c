@@ -0,0 +1,547 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <getopt.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "acc_benchmark_util.h"
+#include "acc_cfar.h"
+#include "acc_detector_distance.h"
+#include "acc_hal_definitions.h"
+#include "acc_hal_integration.h"
+#include "acc_rss.h"
+
+
+#define DEFAULT_FRAME_LENGTH (1200)
+#define DEFAULT_FRAME_COUNT  (2000)
+#define FRAME_SET_SIZE       (16)
+#define MAX_PEAK_COUNT       (64)
+
+// Sensor parity mode, the far range sector of the tank level reference application
+#define SENSOR_ID               1
+#define SENSOR_RANGE_START      0.19f
+#define SENSOR_RANGE_LENGTH     1.3f
+#define SENSOR_PROFILE          ACC_SERVICE_PROFILE_2
+#define SENSOR_DOWNSAMPLING     4
+#define SENSOR_SENSITIVITY      0.4f
+#define SENSOR_CFAR_GUARD       0.12f
+#define SENSOR_CFAR_WINDOW      0.03f
+#define SENSOR_MAX_FRAME_LENGTH (2048)
+
+static const acc_cfar_parameters_t parameter_sets[] =
+{
+	{.type = ACC_CFAR_TYPE_CA, .guard_bins = 4, .window_bins = 16, .sensitivity = 0.5f, .os_rank = 0.75f},
+	{.type = ACC_CFAR_TYPE_CA, .guard_bins = 4, .window_bins = 16, .sensitivity = 0.5f, .os_rank = 0.75f, .only_lower = true},
+	{.type = ACC_CFAR_TYPE_CA, .guard_bins = 12, .window_bins = 48, .sensitivity = 0.4f, .os_rank = 0.75f},
+	{.type = ACC_CFAR_TYPE_OS, .guard_bins = 4, .window_bins = 16, .sensitivity = 0.5f, .os_rank = 0.75f},
+};
+
+#define PARAMETER_SET_COUNT (sizeof(parameter_sets) / sizeof(parameter_sets[0]))
+
+
+static uint16_t sensor_frame[SENSOR_MAX_FRAME_LENGTH];
+static uint16_t sensor_frame_length;
+
+
+/**
+ * @brief Envelope frames with noise and a few moving targets
+ */
+static void generate_frames(uint16_t *frames, uint16_t length)
+{
+	uint32_t state = 1;
+
+	for (uint16_t f = 0; f < FRAME_SET_SIZE; f++)
+	{
+		for (uint16_t i = 0; i < length; i++)
+		{
+			/* xorshift noise */
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+
+			float value = 200.0f + (float)(state % 200);
+
+			for (uint16_t t = 1; t <= 3; t++)
+			{
+				float center = (float)(length * t) / 4.0f + (float)(f * t);
+				float d      = ((float)i - center) / 6.0f;
+
+				value += 3000.0f / (float)t * expf(-d * d);
+			}
+
+			frames[f * length + i] = (uint16_t)value;
+		}
+	}
+}
+
+
+/**
+ * @brief Straightforward threshold calculation, used as reference for timing and correctness
+ */
+static void reference_threshold(const acc_cfar_parameters_t *parameters, const uint16_t *frame, uint16_t length,
+                                float *threshold)
+{
+	uint16_t cells[2 * 256];
+
+	for (uint16_t i = 0; i < length; i++)
+	{
+		int32_t  count = 0;
+		uint32_t sum   = 0;
+		bool     valid = true;
+
+		for (int32_t offset = parameters->guard_bins; offset < parameters->guard_bins + parameters->window_bins; offset++)
+		{
+			int32_t lower = (int32_t)i - offset;
+			int32_t upper = (int32_t)i + offset;
+
+			valid = valid && lower >= 0 && (parameters->only_lower || upper < length);
+
+			if (!valid)
+			{
+				break;
+			}
+
+			cells[count++] = frame[lower];
+			sum           += frame[lower];
+
+			if (!parameters->only_lower)
+			{
+				cells[count++] = frame[upper];
+				sum           += frame[upper];
+			}
+		}
+
+		if (!valid)
+		{
+			threshold[i] = NAN;
+		}
+		else if (parameters->type == ACC_CFAR_TYPE_CA)
+		{
+			threshold[i] = (float)sum / (float)count / parameters->sensitivity;
+		}
+		else
+		{
+			/* Insertion sort of the training bins */
+			for (int32_t a = 1; a < count; a++)
+			{
+				uint16_t value = cells[a];
+				int32_t  b     = a - 1;
+
+				while (b >= 0 && cells[b] > value)
+				{
+					cells[b + 1] = cells[b];
+					b--;
+				}
+
+				cells[b + 1] = value;
+			}
+
+			threshold[i] = (float)cells[(int32_t)(parameters->os_rank * (float)(count - 1) + 0.5f)] / parameters->sensitivity;
+		}
+	}
+}
+
+
+static bool thresholds_equal(const float *a, const float *b, uint16_t length)
+{
+	for (uint16_t i = 0; i < length; i++)
+	{
+		if (isnan(a[i]) != isnan(b[i]) || (!isnan(a[i]) && fabsf(a[i] - b[i]) > 1e-3f * fabsf(b[i])))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+static bool peaks_equal(const uint16_t *frame, const float *threshold, uint16_t length, const uint16_t *peaks,
+                        uint16_t peak_count)
+{
+	uint16_t count = 0;
+
+	for (uint16_t i = 1; i + 1 < length; i++)
+	{
+		if ((float)frame[i] > threshold[i] && frame[i] > frame[i - 1] && frame[i] >= frame[i + 1])
+		{
+			if (count >= peak_count || peaks[count] != i)
+			{
+				return false;
+			}
+
+			count++;
+		}
+	}
+
+	return count == peak_count;
+}
+
+
+static bool run_synthetic(uint16_t length, uint32_t frame_count)
+{
+	uint16_t   *frames    = malloc((size_t)FRAME_SET_SIZE * length * sizeof(*frames));
+	float      *reference = malloc(length * sizeof(*reference));
+	acc_cfar_t cfar_all   = acc_cfar_create(parameter_sets, PARAMETER_SET_COUNT, length);
+	bool       result     = frames != NULL && reference != NULL && cfar_all != NULL;
+	float      checksum   = 0.0f;
+
+	if (!result)
+	{
+		fprintf(stderr, "ERROR: Could not set up benchmark\n");
+	}
+	else
+	{
+		generate_frames(frames, length);
+
+		printf("%u bins per frame, %u frames\n\n", (unsigned int)length, (unsigned int)frame_count);
+		printf("%-4s %-4s %6s %6s %6s %12s %12s %8s %6s\n", "set", "type", "guard", "window", "lower",
+		       "reference", "engine", "speedup", "match");
+	}
+
+	for (uint16_t p = 0; result && p < PARAMETER_SET_COUNT; p++)
+	{
+		const acc_cfar_parameters_t *parameters = &parameter_sets[p];
+		acc_cfar_t                  cfar        = acc_cfar_create(parameters, 1, length);
+
+		if (cfar == NULL)
+		{
+			result = false;
+			break;
+		}
+
+		uint64_t start_ns = acc_benchmark_get_time_ns();
+
+		for (uint32_t n = 0; n < frame_count; n++)
+		{
+			reference_threshold(parameters, &frames[(n % FRAME_SET_SIZE) * length], length, reference);
+			checksum += isnan(reference[length / 2]) ? 0.0f : reference[length / 2];
+		}
+
+		uint64_t reference_ns = acc_benchmark_get_time_ns() - start_ns;
+
+		start_ns = acc_benchmark_get_time_ns();
+
+		for (uint32_t n = 0; n < frame_count; n++)
+		{
+			acc_cfar_process(cfar, &frames[(n % FRAME_SET_SIZE) * length], length);
+
+			float value = acc_cfar_get_threshold(cfar, 0)[length / 2];
+
+			checksum += isnan(value) ? 0.0f : value;
+		}
+
+		uint64_t engine_ns = acc_benchmark_get_time_ns() - start_ns;
+
+		/* Compare thresholds and peaks of every frame in the set */
+		bool match = true;
+
+		for (uint16_t f = 0; f < FRAME_SET_SIZE; f++)
+		{
+			uint16_t peaks[MAX_PEAK_COUNT];
+
+			reference_threshold(parameters, &frames[f * length], length, reference);
+			acc_cfar_process(cfar, &frames[f * length], length);
+
+			uint16_t peak_count = acc_cfar_get_peaks(cfar, 0, peaks, MAX_PEAK_COUNT);
+
+			match = match && thresholds_equal(acc_cfar_get_threshold(cfar, 0), reference, length) &&
+			        peaks_equal(&frames[f * length], reference, length, peaks, peak_count);
+		}
+
+		double bins = (double)frame_count * length;
+
+		printf("%-4u %-4s %6u %6u %6s %9.2f ns %9.2f ns %7.1fx %6s\n", (unsigned int)p,
+		       parameters->type == ACC_CFAR_TYPE_CA ? "CA" : "OS",
+		       (unsigned int)parameters->guard_bins, (unsigned int)parameters->window_bins,
+		       parameters->only_lower ? "yes" : "no",
+		       (double)reference_ns / bins, (double)engine_ns / bins,
+		       (double)reference_ns / (double)engine_ns, match ? "yes" : "NO");
+
+		result = result && match;
+
+		acc_cfar_destroy(&cfar);
+	}
+
+	if (result)
+	{
+		uint64_t start_ns = acc_benchmark_get_time_ns();
+
+		for (uint32_t n = 0; n < frame_count; n++)
+		{
+			acc_cfar_process(cfar_all, &frames[(n % FRAME_SET_SIZE) * length], length);
+
+			float value = acc_cfar_get_threshold(cfar_all, 0)[length / 2];
+
+			checksum += isnan(value) ? 0.0f : value;
+		}
+
+		uint64_t all_ns = acc_benchmark_get_time_ns() - start_ns;
+
+		printf("\nAll %u sets in one pass: %.2f ns per bin (checksum %.0f)\n", (unsigned int)PARAMETER_SET_COUNT,
+		       (double)all_ns / ((double)frame_count * length), (double)checksum);
+	}
+
+	acc_cfar_destroy(&cfar_all);
+	free(reference);
+	free(frames);
+
+	return result;
+}
+
+
+static void sensor_data_callback(const uint16_t *data, uint16_t data_length)
+{
+	sensor_frame_length = data_length < SENSOR_MAX_FRAME_LENGTH ? data_length : SENSOR_MAX_FRAME_LENGTH;
+	memcpy(sensor_frame, data, sensor_frame_length * sizeof(*data));
+}
+
+
+/**
+ * @brief Run the distance detector with its CFAR threshold and the CFAR engine on the same envelope frames
+ *
+ * Peaks of the engine closer than the peak merge limit are merged to the highest one, like the
+ * detector does, and each detector peak must have an engine peak within one bin and vice versa.
+ */
+static bool run_sensor_parity(uint32_t frame_count)
+{
+	const acc_hal_t *hal = acc_hal_integration_get_implementation();
+
+	if (!acc_rss_activate(hal))
+	{
+		fprintf(stderr, "ERROR: Failed to activate RSS\n");
+		return false;
+	}
+
+	acc_detector_distance_configuration_t configuration = acc_detector_distance_configuration_create();
+	acc_detector_distance_handle_t        handle        = NULL;
+	acc_detector_distance_metadata_t      metadata;
+	acc_cfar_t                            cfar          = NULL;
+	bool                                  result        = configuration != NULL;
+
+	if (result)
+	{
+		acc_detector_distance_configuration_sensor_set(configuration, SENSOR_ID);
+		acc_detector_distance_configuration_requested_start_set(configuration, SENSOR_RANGE_START);
+		acc_detector_distance_configuration_requested_length_set(configuration, SENSOR_RANGE_LENGTH);
+		acc_detector_distance_configuration_service_profile_set(configuration, SENSOR_PROFILE);
+		acc_detector_distance_configuration_downsampling_factor_set(configuration, SENSOR_DOWNSAMPLING);
+		acc_detector_distance_configuration_sweep_averaging_set(configuration, 1);
+		acc_detector_distance_configuration_threshold_type_set(configuration, ACC_DETECTOR_DISTANCE_THRESHOLD_TYPE_CFAR);
+		acc_detector_distance_configuration_threshold_sensitivity_set(configuration, SENSOR_SENSITIVITY);
+		acc_detector_distance_configuration_cfar_threshold_guard_set(configuration, SENSOR_CFAR_GUARD);
+		acc_detector_distance_configuration_cfar_threshold_window_set(configuration, SENSOR_CFAR_WINDOW);
+		acc_detector_distance_configuration_service_data_callback_set(configuration, sensor_data_callback);
+
+		handle = acc_detector_distance_create(configuration);
+		result = handle != NULL && acc_detector_distance_metadata_get(handle, &metadata) &&
+		         acc_detector_distance_activate(handle);
+	}
+
+	if (!result)
+	{
+		fprintf(stderr, "ERROR: Failed to start distance detector\n");
+	}
+
+	float    merge_limit_m   = result ? acc_detector_distance_configuration_peak_merge_limit_get(configuration) : 0.0f;
+	uint32_t matched_frames  = 0;
+	uint32_t detector_only   = 0;
+	uint32_t engine_only     = 0;
+	uint32_t measured_frames = 0;
+
+	for (uint32_t n = 0; result && n < frame_count; n++)
+	{
+		acc_detector_distance_result_t      detector_peaks[MAX_PEAK_COUNT];
+		acc_detector_distance_result_info_t result_info;
+		uint16_t                            engine_peaks[MAX_PEAK_COUNT];
+
+		result = acc_detector_distance_get_next(handle, detector_peaks, MAX_PEAK_COUNT, &result_info);
+
+		if (!result || sensor_frame_length < 2)
+		{
+			break;
+		}
+
+		float step_m = metadata.length_m / (float)(sensor_frame_length - 1);
+
+		if (cfar == NULL)
+		{
+			acc_cfar_parameters_t parameters;
+
+			acc_cfar_parameters_from_distance(SENSOR_CFAR_GUARD, SENSOR_CFAR_WINDOW, step_m, SENSOR_SENSITIVITY,
+			                                  false, &parameters);
+			cfar   = acc_cfar_create(&parameters, 1, SENSOR_MAX_FRAME_LENGTH);
+			result = cfar != NULL;
+		}
+
+		result = result && acc_cfar_process(cfar, sensor_frame, sensor_frame_length);
+
+		if (!result)
+		{
+			break;
+		}
+
+		uint16_t engine_count = acc_cfar_get_peaks(cfar, 0, engine_peaks, MAX_PEAK_COUNT);
+		uint16_t merged_count = 0;
+
+		for (uint16_t i = 0; i < engine_count; i++)
+		{
+			uint16_t bin = engine_peaks[i];
+
+			if (merged_count > 0 && (float)(bin - engine_peaks[merged_count - 1]) * step_m < merge_limit_m)
+			{
+				if (sensor_frame[bin] > sensor_frame[engine_peaks[merged_count - 1]])
+				{
+					engine_peaks[merged_count - 1] = bin;
+				}
+			}
+			else
+			{
+				engine_peaks[merged_count++] = bin;
+			}
+		}
+
+		bool match = true;
+
+		for (uint16_t d = 0; d < result_info.number_of_peaks; d++)
+		{
+			bool found = false;
+
+			for (uint16_t e = 0; e < merged_count && !found; e++)
+			{
+				found = fabsf(metadata.start_m + (float)engine_peaks[e] * step_m - detector_peaks[d].distance_m) <= step_m;
+			}
+
+			detector_only += found ? 0 : 1;
+			match          = match && found;
+		}
+
+		for (uint16_t e = 0; e < merged_count; e++)
+		{
+			bool found = false;
+
+			for (uint16_t d = 0; d < result_info.number_of_peaks && !found; d++)
+			{
+				found = fabsf(metadata.start_m + (float)engine_peaks[e] * step_m - detector_peaks[d].distance_m) <= step_m;
+			}
+
+			engine_only += found ? 0 : 1;
+			match        = match && found;
+		}
+
+		matched_frames += match ? 1 : 0;
+		measured_frames++;
+	}
+
+	if (measured_frames > 0)
+	{
+		printf("%u frames of %u bins: %u with identical peaks (%.1f %%), %u peaks only from the detector, %u only from the engine\n",
+		       (unsigned int)measured_frames, (unsigned int)sensor_frame_length, (unsigned int)matched_frames,
+		       100.0 * (double)matched_frames / (double)measured_frames,
+		       (unsigned int)detector_only, (unsigned int)engine_only);
+	}
+
+	if (handle != NULL)
+	{
+		acc_detector_distance_deactivate(handle);
+		acc_detector_distance_destroy(&handle);
+	}
+
+	if (configuration != NULL)
+	{
+		acc_detector_distance_configuration_destroy(&configuration);
+	}
+
+	acc_cfar_destroy(&cfar);
+	acc_rss_deactivate();
+
+	return result;
+}
+
+
+static void print_usage(char *application_name)
+{
+	fprintf(stderr, "Usage: %s [OPTION]...\n", application_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Measure the CFAR engine in ns per bin against a straightforward implementation and\n");
+	fprintf(stderr, "verify that the thresholds are the same. With --sensor, compare the peaks of the engine\n");
+	fprintf(stderr, "with the peaks of the distance detector CFAR threshold on the same envelope frames.\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "-h, --help                      this help\n");
+	fprintf(stderr, "-l, --length                    the frame length in bins\n");
+	fprintf(stderr, "-n, --frames                    the number of frames\n");
+	fprintf(stderr, "-s, --sensor                    compare with the distance detector on sensor %u\n", (unsigned int)SENSOR_ID);
+}
+
+
+int main(int argc, char *argv[])
+{
+	static struct option long_options[] =
+	{
+		{"help",             no_argument,       0,      'h'},
+		{"length",           required_argument, 0,      'l'},
+		{"frames",           required_argument, 0,      'n'},
+		{"sensor",           no_argument,       0,      's'},
+		{NULL,               0,                 NULL,   0}
+	};
+
+	int character_code;
+	int option_index = 0;
+
+	uint16_t length      = DEFAULT_FRAME_LENGTH;
+	uint32_t frame_count = DEFAULT_FRAME_COUNT;
+	bool     sensor      = false;
+
+	while ((character_code = getopt_long(argc, argv, "h?l:n:s", long_options, &option_index)) != -1)
+	{
+		int value = optarg != NULL ? atoi(optarg) : 0;
+
+		switch (character_code)
+		{
+			case 'l':
+			{
+				if (value < 2 || value > UINT16_MAX)
+				{
+					fprintf(stderr, "ERROR: Invalid value '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				length = (uint16_t)value;
+				break;
+			}
+			case 'n':
+			{
+				if (value <= 0)
+				{
+					fprintf(stderr, "ERROR: Invalid value '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				frame_count = (uint32_t)value;
+				break;
+			}
+			case 's':
+			{
+				sensor = true;
+				break;
+			}
+			default:
+			{
+				print_usage(basename(argv[0]));
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	bool result = sensor ? run_sensor_parity(frame_count) : run_synthetic(length, frame_count);
+
+	return result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
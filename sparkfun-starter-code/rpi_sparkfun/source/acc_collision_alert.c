@@ -0,0 +1,137 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "acc_collision_alert.h"
+
+
+static acc_collision_alert_level_t next_level(const acc_collision_alert_parameters_t *parameters,
+                                              acc_collision_alert_level_t level, float ttc_s)
+{
+	if (ttc_s < parameters->critical_ttc_s)
+	{
+		return ACC_COLLISION_ALERT_LEVEL_CRITICAL;
+	}
+
+	if (level == ACC_COLLISION_ALERT_LEVEL_CRITICAL && ttc_s < parameters->critical_ttc_s + parameters->clear_margin_s)
+	{
+		return ACC_COLLISION_ALERT_LEVEL_CRITICAL;
+	}
+
+	if (ttc_s < parameters->warning_ttc_s)
+	{
+		return ACC_COLLISION_ALERT_LEVEL_WARNING;
+	}
+
+	if (level != ACC_COLLISION_ALERT_LEVEL_NONE && ttc_s < parameters->warning_ttc_s + parameters->clear_margin_s)
+	{
+		return ACC_COLLISION_ALERT_LEVEL_WARNING;
+	}
+
+	return ACC_COLLISION_ALERT_LEVEL_NONE;
+}
+
+
+bool acc_collision_alert_init(acc_collision_alert_t *alert, const acc_collision_alert_parameters_t *parameters)
+{
+	if (parameters->critical_ttc_s <= 0.0f || parameters->warning_ttc_s < parameters->critical_ttc_s ||
+	    parameters->min_closing_speed_mps <= 0.0f || parameters->clear_margin_s < 0.0f)
+	{
+		return false;
+	}
+
+	alert->parameters  = *parameters;
+	alert->state_count = 0;
+
+	return true;
+}
+
+
+uint16_t acc_collision_alert_update(acc_collision_alert_t *alert, const acc_target_tracker_track_t *tracks,
+                                    uint16_t track_count, acc_collision_alert_event_t *events,
+                                    uint16_t max_event_count)
+{
+	acc_collision_alert_track_state_t states[ACC_TARGET_TRACKER_MAX_TRACKS];
+	bool                              kept[ACC_TARGET_TRACKER_MAX_TRACKS] = { false };
+	uint16_t                          state_count = 0;
+	uint16_t                          event_count = 0;
+
+	if (track_count > ACC_TARGET_TRACKER_MAX_TRACKS)
+	{
+		track_count = ACC_TARGET_TRACKER_MAX_TRACKS;
+	}
+
+	for (uint16_t t = 0; t < track_count; t++)
+	{
+		const acc_target_tracker_track_t *track = &tracks[t];
+		acc_collision_alert_level_t      level  = ACC_COLLISION_ALERT_LEVEL_NONE;
+
+		for (uint16_t s = 0; s < alert->state_count; s++)
+		{
+			if (alert->states[s].track_id == track->id)
+			{
+				level   = alert->states[s].level;
+				kept[s] = true;
+				break;
+			}
+		}
+
+		float closing_speed_mps = -track->velocity_mps;
+		float ttc_s             = INFINITY;
+
+		if (closing_speed_mps >= alert->parameters.min_closing_speed_mps)
+		{
+			ttc_s = track->distance_m / closing_speed_mps;
+		}
+
+		acc_collision_alert_level_t new_level = next_level(&alert->parameters, level, ttc_s);
+
+		if (new_level != level && event_count < max_event_count)
+		{
+			acc_collision_alert_event_t *event = &events[event_count++];
+
+			event->track_id          = track->id;
+			event->level             = new_level;
+			event->distance_m        = track->distance_m;
+			event->closing_speed_mps = closing_speed_mps;
+			event->ttc_s             = ttc_s;
+		}
+
+		if (new_level != ACC_COLLISION_ALERT_LEVEL_NONE)
+		{
+			states[state_count].track_id = track->id;
+			states[state_count].level    = new_level;
+			state_count++;
+		}
+	}
+
+	/* Alerting tracks that are no longer confirmed are cleared */
+	for (uint16_t s = 0; s < alert->state_count; s++)
+	{
+		if (!kept[s] && event_count < max_event_count)
+		{
+			acc_collision_alert_event_t *event = &events[event_count++];
+
+			event->track_id          = alert->states[s].track_id;
+			event->level             = ACC_COLLISION_ALERT_LEVEL_NONE;
+			event->distance_m        = NAN;
+			event->closing_speed_mps = NAN;
+			event->ttc_s             = INFINITY;
+		}
+	}
+
+	for (uint16_t s = 0; s < state_count; s++)
+	{
+		alert->states[s] = states[s];
+	}
+
+	alert->state_count = state_count;
+
+	return event_count;
+}
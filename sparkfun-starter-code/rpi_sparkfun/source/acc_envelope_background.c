@@ -0,0 +1,199 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "acc_envelope_background.h"
+
+
+#define MEAN_FRACTION_BITS      (12)
+#define DEVIATION_FRACTION_BITS (4)
+#define VARIANCE_FRACTION_BITS  (2 * DEVIATION_FRACTION_BITS)
+
+#define MAX_DEVIATION_Q ((ACC_ENVELOPE_BACKGROUND_MAX_DEVIATION << DEVIATION_FRACTION_BITS) | ((1 << DEVIATION_FRACTION_BITS) - 1))
+
+
+static int32_t rounding_shift(int32_t value, uint8_t shift)
+{
+	return shift > 0 ? (value + (1 << (shift - 1))) >> shift : value;
+}
+
+
+/**
+ * @brief The shift of a running mean of the frames so far while learning, then the configured shift
+ */
+static uint8_t get_shift(const acc_envelope_background_t *background)
+{
+	uint8_t shift = 0;
+
+	while (shift < background->parameters.shift && (2u << shift) <= background->frame_count)
+	{
+		shift++;
+	}
+
+	return shift;
+}
+
+
+bool acc_envelope_background_init(acc_envelope_background_t *background,
+                                  const acc_envelope_background_parameters_t *parameters, uint16_t data_length)
+{
+	if (data_length == 0 || data_length > ACC_ENVELOPE_BACKGROUND_MAX_LENGTH || parameters->shift < 1 ||
+	    parameters->shift > 15 || parameters->freeze_z <= 0.0f || parameters->min_std <= 0.0f)
+	{
+		return false;
+	}
+
+	memset(background, 0, sizeof(*background));
+
+	background->parameters  = *parameters;
+	background->data_length = data_length;
+
+	return true;
+}
+
+
+void acc_envelope_background_update(acc_envelope_background_t *background, const uint16_t *data, bool freeze,
+                                    uint16_t *foreground, float *z_scores)
+{
+	const acc_envelope_background_parameters_t *parameters = &background->parameters;
+
+	if (background->frame_count == 0)
+	{
+		for (uint16_t i = 0; i < background->data_length; i++)
+		{
+			background->mean[i]          = (int32_t)data[i] << MEAN_FRACTION_BITS;
+			background->variance[i]      = 0;
+			background->frozen_frames[i] = 0;
+			foreground[i]                = 0;
+			z_scores[i]                  = 0.0f;
+		}
+
+		background->frame_count = 1;
+		return;
+	}
+
+	if (background->frame_count < UINT32_MAX)
+	{
+		background->frame_count++;
+	}
+
+	bool     learning     = acc_envelope_background_is_learning(background);
+	bool     update       = !freeze || learning;
+	uint8_t  shift        = get_shift(background);
+	float    min_variance = parameters->min_std * parameters->min_std;
+	float    freeze_z     = learning ? INFINITY : parameters->freeze_z;
+	uint16_t max_frozen   = parameters->max_freeze_frames > 0 ? parameters->max_freeze_frames : UINT16_MAX;
+	uint16_t i            = 0;
+
+#if defined(__ARM_NEON)
+	int32x4_t   shift_vector        = vdupq_n_s32(-(int32_t)shift);
+	int32x4_t   max_deviation       = vdupq_n_s32(MAX_DEVIATION_Q);
+	int32x4_t   min_deviation       = vdupq_n_s32(-MAX_DEVIATION_Q);
+	float32x4_t min_variance_vector = vdupq_n_f32(min_variance);
+	float32x4_t freeze_z_vector     = vdupq_n_f32(freeze_z);
+	uint16x4_t  max_frozen_vector   = vdup_n_u16(max_frozen);
+
+	for (; i + 4 <= background->data_length; i += 4)
+	{
+		int32x4_t x        = vreinterpretq_s32_u32(vshll_n_u16(vld1_u16(&data[i]), MEAN_FRACTION_BITS));
+		int32x4_t mean     = vld1q_s32(&background->mean[i]);
+		int32x4_t variance = vld1q_s32(&background->variance[i]);
+		int32x4_t diff     = vsubq_s32(x, mean);
+
+		vst1_u16(&foreground[i], vqmovun_s32(vrshrq_n_s32(diff, MEAN_FRACTION_BITS)));
+
+		/* z = diff / sqrt(variance), with the reciprocal square root refined by two Newton steps */
+		float32x4_t variance_f = vmaxq_f32(vcvtq_n_f32_s32(variance, VARIANCE_FRACTION_BITS), min_variance_vector);
+		float32x4_t estimate   = vrsqrteq_f32(variance_f);
+
+		estimate = vmulq_f32(estimate, vrsqrtsq_f32(vmulq_f32(variance_f, estimate), estimate));
+		estimate = vmulq_f32(estimate, vrsqrtsq_f32(vmulq_f32(variance_f, estimate), estimate));
+
+		float32x4_t z = vmulq_f32(vcvtq_n_f32_s32(diff, MEAN_FRACTION_BITS), estimate);
+
+		vst1q_f32(&z_scores[i], z);
+
+		if (update)
+		{
+			uint16x4_t frozen_frames = vld1_u16(&background->frozen_frames[i]);
+			uint32x4_t above         = vcagtq_f32(z, freeze_z_vector);
+			uint16x4_t expired       = vcge_u16(frozen_frames, max_frozen_vector);
+
+			/* Sign extension widens the mask to all ones */
+			uint32x4_t learn = vorrq_u32(vmvnq_u32(above),
+			                             vreinterpretq_u32_s32(vmovl_s16(vreinterpret_s16_u16(expired))));
+
+			int32x4_t deviation = vminq_s32(vmaxq_s32(vrshrq_n_s32(diff, MEAN_FRACTION_BITS - DEVIATION_FRACTION_BITS),
+			                                          min_deviation), max_deviation);
+			int32x4_t square    = vmulq_s32(deviation, deviation);
+
+			mean     = vbslq_s32(learn, vaddq_s32(mean, vrshlq_s32(diff, shift_vector)), mean);
+			variance = vbslq_s32(learn, vaddq_s32(variance, vrshlq_s32(vsubq_s32(square, variance), shift_vector)),
+			                     variance);
+
+			vst1q_s32(&background->mean[i], mean);
+			vst1q_s32(&background->variance[i], variance);
+			vst1_u16(&background->frozen_frames[i],
+			         vbsl_u16(vmovn_u32(above), vqadd_u16(frozen_frames, vdup_n_u16(1)), vdup_n_u16(0)));
+		}
+	}
+#endif
+
+	for (; i < background->data_length; i++)
+	{
+		int32_t diff     = ((int32_t)data[i] << MEAN_FRACTION_BITS) - background->mean[i];
+		int32_t rounded  = rounding_shift(diff, MEAN_FRACTION_BITS);
+		float   variance = fmaxf((float)background->variance[i] / (float)(1 << VARIANCE_FRACTION_BITS), min_variance);
+		float   z        = (float)diff / (float)(1 << MEAN_FRACTION_BITS) / sqrtf(variance);
+
+		foreground[i] = rounded > 0 ? (uint16_t)rounded : 0;
+		z_scores[i]   = z;
+
+		if (!update)
+		{
+			continue;
+		}
+
+		/* A bin that stays above freeze_z for max_frozen frames is learnt until it is back below */
+		if (fabsf(z) > freeze_z)
+		{
+			uint16_t frozen_frames = background->frozen_frames[i];
+
+			background->frozen_frames[i] = frozen_frames < UINT16_MAX ? frozen_frames + 1 : UINT16_MAX;
+
+			if (frozen_frames < max_frozen)
+			{
+				continue;
+			}
+		}
+		else
+		{
+			background->frozen_frames[i] = 0;
+		}
+
+		int32_t deviation = rounding_shift(diff, MEAN_FRACTION_BITS - DEVIATION_FRACTION_BITS);
+
+		deviation = deviation > MAX_DEVIATION_Q ? MAX_DEVIATION_Q : deviation;
+		deviation = deviation < -MAX_DEVIATION_Q ? -MAX_DEVIATION_Q : deviation;
+
+		background->mean[i]     += rounding_shift(diff, shift);
+		background->variance[i] += rounding_shift(deviation * deviation - background->variance[i], shift);
+	}
+}
+
+
+bool acc_envelope_background_is_learning(const acc_envelope_background_t *background)
+{
+	return background->frame_count < (1u << background->parameters.shift);
+}
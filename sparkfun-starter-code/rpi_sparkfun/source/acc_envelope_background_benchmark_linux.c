@@ -0,0 +1,397 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <getopt.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "acc_benchmark_util.h"
+#include "acc_envelope_background.h"
+
+
+#define DEFAULT_FRAMES     (2000)
+#define DEFAULT_SHIFT      (6)
+#define NOISE_LEVEL        (100.0f)
+#define NOISE_STD          (15.0f)
+#define CLUTTER_COUNT      (8)
+#define TARGET_AMPLITUDE   (1000.0f)
+#define TARGET_FRAMES      (500)
+#define TARGET_BIN         (300)
+#define MAX_FREEZE_FRAMES  (400)
+#define STATISTICS_LENGTH  (1024)
+
+#define LENGTH_COUNT (sizeof(lengths) / sizeof(lengths[0]))
+
+
+/**
+ * @brief A float background with the same update rule, as a reference for time and accuracy
+ */
+typedef struct
+{
+	float    alpha;
+	float    freeze_z;
+	float    min_variance;
+	uint16_t data_length;
+	float    mean[ACC_ENVELOPE_BACKGROUND_MAX_LENGTH];
+	float    variance[ACC_ENVELOPE_BACKGROUND_MAX_LENGTH];
+} float_background_t;
+
+
+static const uint16_t lengths[] = {256, 1024, 4096};
+
+static acc_envelope_background_t background;
+static float_background_t        reference;
+static uint16_t                  frame[ACC_ENVELOPE_BACKGROUND_MAX_LENGTH];
+static uint16_t                  foreground[ACC_ENVELOPE_BACKGROUND_MAX_LENGTH];
+static float                     z_scores[ACC_ENVELOPE_BACKGROUND_MAX_LENGTH];
+static float                     clutter[ACC_ENVELOPE_BACKGROUND_MAX_LENGTH];
+
+
+static void float_background_update(float_background_t *self, const uint16_t *data, uint16_t *out_foreground,
+                                    float *out_z_scores)
+{
+	for (uint16_t i = 0; i < self->data_length; i++)
+	{
+		float diff = (float)data[i] - self->mean[i];
+		float z    = diff / sqrtf(fmaxf(self->variance[i], self->min_variance));
+
+		out_foreground[i] = diff > 0.0f ? (uint16_t)(diff + 0.5f) : 0;
+		out_z_scores[i]   = z;
+
+		if (fabsf(z) <= self->freeze_z)
+		{
+			self->mean[i]     += self->alpha * diff;
+			self->variance[i] += self->alpha * (diff * diff - self->variance[i]);
+		}
+	}
+}
+
+
+static void setup_clutter(uint16_t data_length, uint32_t *state)
+{
+	memset(clutter, 0, sizeof(clutter));
+
+	for (uint16_t c = 0; c < CLUTTER_COUNT; c++)
+	{
+		float center    = data_length * acc_benchmark_next_uniform(state);
+		float amplitude = 200.0f + 2000.0f * acc_benchmark_next_uniform(state);
+
+		for (uint16_t i = 0; i < data_length; i++)
+		{
+			float offset = ((float)i - center) / 15.0f;
+
+			clutter[i] += amplitude * expf(-offset * offset);
+		}
+	}
+}
+
+
+/**
+ * @brief Clutter with noise in proportion to the square root of the level, and an optional target
+ */
+static void generate_frame(uint16_t data_length, float target_amplitude, uint32_t *state)
+{
+	for (uint16_t i = 0; i < data_length; i++)
+	{
+		float level  = NOISE_LEVEL + clutter[i];
+		float offset = ((float)i - TARGET_BIN) / 10.0f;
+		float value  = level + NOISE_STD * sqrtf(level / NOISE_LEVEL) * acc_benchmark_next_noise(state);
+
+		value += target_amplitude * expf(-offset * offset);
+
+		frame[i] = (uint16_t)(value < 0.0f ? 0.0f : value);
+	}
+}
+
+
+static bool init_backgrounds(const acc_envelope_background_parameters_t *parameters, uint16_t data_length)
+{
+	if (!acc_envelope_background_init(&background, parameters, data_length))
+	{
+		fprintf(stderr, "ERROR: Invalid parameters\n");
+		return false;
+	}
+
+	reference.alpha        = 1.0f / (float)(1 << parameters->shift);
+	reference.freeze_z     = parameters->freeze_z;
+	reference.min_variance = parameters->min_std * parameters->min_std;
+	reference.data_length  = data_length;
+
+	return true;
+}
+
+
+static void run_timing(const acc_envelope_background_parameters_t *parameters, uint32_t frames)
+{
+	printf("Update time\n\n");
+	printf("%8s %14s %14s %10s\n", "Bins", "Fixed [us]", "Float [us]", "Speedup");
+
+	for (uint16_t l = 0; l < LENGTH_COUNT; l++)
+	{
+		uint16_t data_length = lengths[l];
+		uint32_t state       = 1;
+
+		if (!init_backgrounds(parameters, data_length))
+		{
+			return;
+		}
+
+		setup_clutter(data_length, &state);
+		generate_frame(data_length, 0.0f, &state);
+
+		for (uint16_t i = 0; i < data_length; i++)
+		{
+			reference.mean[i]     = frame[i];
+			reference.variance[i] = NOISE_STD * NOISE_STD;
+		}
+
+		uint64_t fixed_ns = 0;
+		uint64_t float_ns = 0;
+
+		for (uint32_t n = 0; n < frames; n++)
+		{
+			generate_frame(data_length, 0.0f, &state);
+
+			uint64_t start_ns = acc_benchmark_get_time_ns();
+
+			acc_envelope_background_update(&background, frame, false, foreground, z_scores);
+
+			uint64_t middle_ns = acc_benchmark_get_time_ns();
+
+			float_background_update(&reference, frame, foreground, z_scores);
+
+			fixed_ns += middle_ns - start_ns;
+			float_ns += acc_benchmark_get_time_ns() - middle_ns;
+		}
+
+		printf("%8u %14.2f %14.2f %9.2fx\n", (unsigned int)data_length, (double)fixed_ns / frames / 1000.0,
+		       (double)float_ns / frames / 1000.0, (double)float_ns / (double)fixed_ns);
+	}
+
+	printf("\n");
+}
+
+
+/**
+ * @brief The z-scores of noise should have zero mean and unit standard deviation once learnt
+ */
+static void run_statistics(const acc_envelope_background_parameters_t *parameters, uint32_t frames)
+{
+	uint32_t state = 2;
+
+	if (!init_backgrounds(parameters, STATISTICS_LENGTH))
+	{
+		return;
+	}
+
+	setup_clutter(STATISTICS_LENGTH, &state);
+
+	double   z_sum        = 0.0;
+	double   z_square_sum = 0.0;
+	double   mean_error   = 0.0;
+	uint64_t outliers     = 0;
+	uint64_t count        = 0;
+	uint32_t learn_frames = 0;
+
+	for (uint32_t n = 0; n < frames + (8u << parameters->shift); n++)
+	{
+		generate_frame(STATISTICS_LENGTH, 0.0f, &state);
+		acc_envelope_background_update(&background, frame, false, foreground, z_scores);
+
+		if (acc_envelope_background_is_learning(&background))
+		{
+			learn_frames = n + 1;
+		}
+
+		/* Let the mean settle for a few time constants before it is measured */
+		if (n < (8u << parameters->shift))
+		{
+			continue;
+		}
+
+		for (uint16_t i = 0; i < STATISTICS_LENGTH; i++)
+		{
+			float true_mean = NOISE_LEVEL + clutter[i];
+
+			z_sum        += (double)z_scores[i];
+			z_square_sum += (double)z_scores[i] * (double)z_scores[i];
+			outliers     += fabsf(z_scores[i]) > parameters->freeze_z ? 1 : 0;
+			mean_error   += fabs((double)background.mean[i] / 4096.0 - (double)true_mean);
+			count++;
+		}
+	}
+
+	double z_mean = z_sum / count;
+
+	printf("Noise statistics, %u bins, %u frames\n\n", (unsigned int)STATISTICS_LENGTH, (unsigned int)frames);
+	printf("Learning frames:     %u\n", (unsigned int)learn_frames);
+	printf("z-score mean:        %.3f\n", z_mean);
+	printf("z-score std:         %.3f\n", sqrt(z_square_sum / count - z_mean * z_mean));
+	printf("Frozen bins:         %.3f %%\n", 100.0 * (double)outliers / count);
+	printf("Mean error:          %.2f counts mean absolute\n\n", mean_error / count);
+}
+
+
+/**
+ * @brief A target that appears after learning is not learnt until max_freeze_frames have passed
+ */
+static void run_freeze(const acc_envelope_background_parameters_t *parameters)
+{
+	uint32_t state = 3;
+
+	if (!init_backgrounds(parameters, STATISTICS_LENGTH))
+	{
+		return;
+	}
+
+	setup_clutter(STATISTICS_LENGTH, &state);
+
+	for (uint32_t n = 0; n < (8u << parameters->shift); n++)
+	{
+		generate_frame(STATISTICS_LENGTH, 0.0f, &state);
+		acc_envelope_background_update(&background, frame, false, foreground, z_scores);
+	}
+
+	uint32_t detected_frames = 0;
+	uint32_t first_learnt    = 0;
+	float    min_foreground  = INFINITY;
+
+	for (uint32_t n = 0; n < TARGET_FRAMES + MAX_FREEZE_FRAMES; n++)
+	{
+		generate_frame(STATISTICS_LENGTH, TARGET_AMPLITUDE, &state);
+		acc_envelope_background_update(&background, frame, false, foreground, z_scores);
+
+		if (z_scores[TARGET_BIN] > parameters->freeze_z)
+		{
+			detected_frames++;
+
+			if (n < parameters->max_freeze_frames)
+			{
+				min_foreground = fminf(min_foreground, foreground[TARGET_BIN]);
+			}
+		}
+		else if (first_learnt == 0)
+		{
+			first_learnt = n + 1;
+		}
+	}
+
+	/* A global freeze keeps the background while the caller has a detection */
+	uint32_t global_detected = 0;
+
+	if (!init_backgrounds(parameters, STATISTICS_LENGTH))
+	{
+		return;
+	}
+
+	for (uint32_t n = 0; n < (8u << parameters->shift); n++)
+	{
+		generate_frame(STATISTICS_LENGTH, 0.0f, &state);
+		acc_envelope_background_update(&background, frame, false, foreground, z_scores);
+	}
+
+	for (uint32_t n = 0; n < TARGET_FRAMES + MAX_FREEZE_FRAMES; n++)
+	{
+		generate_frame(STATISTICS_LENGTH, TARGET_AMPLITUDE, &state);
+		acc_envelope_background_update(&background, frame, true, foreground, z_scores);
+
+		global_detected += z_scores[TARGET_BIN] > parameters->freeze_z ? 1 : 0;
+	}
+
+	printf("Target of %.0f counts for %u frames, max freeze %u frames\n\n", (double)TARGET_AMPLITUDE,
+	       (unsigned int)(TARGET_FRAMES + MAX_FREEZE_FRAMES), (unsigned int)parameters->max_freeze_frames);
+	printf("Detected frames:     %u\n", (unsigned int)detected_frames);
+	printf("Relearnt after:      %u frames\n", (unsigned int)first_learnt);
+	printf("Foreground while frozen: %.0f counts min\n", (double)min_foreground);
+	printf("Detected frames with global freeze: %u\n\n", (unsigned int)global_detected);
+}
+
+
+static void print_usage(char *application_name)
+{
+	fprintf(stderr, "Usage: %s [OPTION]...\n", application_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Time the fixed point envelope background against a float reference, check the z-score\n");
+	fprintf(stderr, "statistics of noise and check that a target is not learnt while it is frozen.\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "-h, --help                      this help\n");
+	fprintf(stderr, "-n, --frames                    the number of frames, default %u\n", (unsigned int)DEFAULT_FRAMES);
+	fprintf(stderr, "-s, --shift                     the background shift, 1 to 15, default %u\n",
+	        (unsigned int)DEFAULT_SHIFT);
+}
+
+
+int main(int argc, char *argv[])
+{
+	static struct option long_options[] =
+	{
+		{"help",             no_argument,       0,      'h'},
+		{"frames",           required_argument, 0,      'n'},
+		{"shift",            required_argument, 0,      's'},
+		{NULL,               0,                 NULL,   0}
+	};
+
+	int character_code;
+	int option_index = 0;
+
+	uint32_t frames = DEFAULT_FRAMES;
+
+	acc_envelope_background_parameters_t parameters =
+	{
+		.shift             = DEFAULT_SHIFT,
+		.freeze_z          = 4.0f,
+		.max_freeze_frames = MAX_FREEZE_FRAMES,
+		.min_std           = 2.0f,
+	};
+
+	while ((character_code = getopt_long(argc, argv, "h?n:s:", long_options, &option_index)) != -1)
+	{
+		switch (character_code)
+		{
+			case 'n':
+			{
+				int value = atoi(optarg);
+
+				if (value <= 0 || value > 1000000)
+				{
+					fprintf(stderr, "ERROR: Invalid number of frames '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				frames = (uint32_t)value;
+				break;
+			}
+			case 's':
+			{
+				int value = atoi(optarg);
+
+				if (value < 1 || value > 15)
+				{
+					fprintf(stderr, "ERROR: Invalid shift '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				parameters.shift = (uint8_t)value;
+				break;
+			}
+			default:
+			{
+				print_usage(basename(argv[0]));
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	run_timing(&parameters, frames);
+	run_statistics(&parameters, frames);
+	run_freeze(&parameters);
+
+	return EXIT_SUCCESS;
+}
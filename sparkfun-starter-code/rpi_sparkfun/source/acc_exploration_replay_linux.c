@@ -0,0 +1,367 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <getopt.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "acc_session_recording.h"
+#include "acc_socket_server.h"
+
+
+#define DEFAULT_TCP_IP_PORT (6110)
+#define DEFAULT_SESSION     (1)
+#define MAX_COMMAND_SIZE    (10*1024)
+
+volatile bool replay_shutdown = false;
+
+static acc_socket_server_t socket_server = { 0 };
+
+/* Number of complete commands received from the current client */
+static uint32_t received_commands;
+
+
+static uint32_t count_commands(const void *data, size_t size)
+{
+	const char *text = data;
+	uint32_t   count = 0;
+
+	/* Commands from the client are newline terminated json */
+	for (size_t i = 0; i < size; i++)
+	{
+		if (text[i] == '\n')
+		{
+			count++;
+		}
+	}
+
+	return count;
+}
+
+
+static void input_data_function(const void *data, size_t size)
+{
+	received_commands += count_commands(data, size);
+}
+
+
+static uint64_t get_time_us(void)
+{
+	struct timespec time_ts = {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &time_ts);
+	return (uint64_t)time_ts.tv_sec * 1000000 + (uint64_t)time_ts.tv_nsec / 1000;
+}
+
+
+static void main_sig_handler(int sig)
+{
+	printf("\nMain thread interrupted [%d]\n", sig);
+	signal(sig, SIG_IGN);
+	replay_shutdown = true;
+}
+
+
+/**
+ * @brief Handle client input until a point in time
+ *
+ * @param[in] time_us The time to wait for
+ *
+ * @return false if the client disconnected or shutdown was requested
+ */
+static bool wait_until(uint64_t time_us)
+{
+	uint64_t now_us = get_time_us();
+
+	while (now_us < time_us && !replay_shutdown)
+	{
+		if (!acc_socket_server_poll_events(&socket_server, false, time_us - now_us))
+		{
+			return false;
+		}
+
+		now_us = get_time_us();
+	}
+
+	return !replay_shutdown;
+}
+
+
+/**
+ * @brief Handle client input until the client has sent a number of commands
+ *
+ * @param[in] command_count The number of commands to wait for
+ *
+ * @return false if the client disconnected or shutdown was requested
+ */
+static bool wait_for_commands(uint32_t command_count)
+{
+	while (received_commands < command_count && !replay_shutdown)
+	{
+		if (!acc_socket_server_poll_events(&socket_server, true, 0))
+		{
+			return false;
+		}
+	}
+
+	return !replay_shutdown;
+}
+
+
+/**
+ * @brief Skip forward to the start of a session
+ *
+ * @param[in] player The player instance
+ * @param[in] session The session to find, the first session is 1
+ * @param[out] start_us The timestamp of the session start
+ *
+ * @return true if the session was found
+ */
+static bool find_session(acc_session_player_t *player, uint32_t session, uint64_t *start_us)
+{
+	acc_session_record_t record;
+	uint32_t             session_count = 0;
+
+	if (!acc_session_player_rewind(player))
+	{
+		return false;
+	}
+
+	while (acc_session_player_read(player, &record))
+	{
+		if (record.type == ACC_SESSION_RECORD_CONNECT && ++session_count == session)
+		{
+			*start_us = record.timestamp_us;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+/**
+ * @brief Replay one recorded session to the connected client
+ *
+ * The outbound data is sent with the recorded timing, or as fast as possible. Each recorded
+ * inbound command is a synchronization point: replay does not continue past it until the client
+ * has sent the same number of commands, and the timing restarts from there.
+ *
+ * @param[in] player The player instance
+ * @param[in] session The session to replay
+ * @param[in] fast Send as fast as possible instead of with the recorded timing
+ *
+ * @return true if the whole session was replayed
+ */
+static bool replay_session(acc_session_player_t *player, uint32_t session, bool fast)
+{
+	acc_session_record_t record;
+	uint64_t             sync_record_us;
+	uint64_t             sync_time_us      = get_time_us();
+	uint64_t             bytes_sent        = 0;
+	uint32_t             expected_commands = 0;
+
+	if (!find_session(player, session, &sync_record_us))
+	{
+		fprintf(stderr, "ERROR: Session %u not found in recording\n", (unsigned int)session);
+		return false;
+	}
+
+	uint64_t replay_start_us = sync_time_us;
+
+	while (acc_session_player_read(player, &record) && record.type != ACC_SESSION_RECORD_CONNECT)
+	{
+		if (record.type == ACC_SESSION_RECORD_INBOUND)
+		{
+			expected_commands += count_commands(record.data, record.size);
+
+			if (!wait_for_commands(expected_commands))
+			{
+				return false;
+			}
+
+			sync_record_us = record.timestamp_us;
+			sync_time_us   = get_time_us();
+			continue;
+		}
+
+		if (!fast && !wait_until(sync_time_us + (record.timestamp_us - sync_record_us)))
+		{
+			return false;
+		}
+
+		acc_socket_server_setup_write_data(&socket_server, record.data, record.size);
+
+		if (socket_server.client_socket < 0)
+		{
+			return false;
+		}
+
+		bytes_sent += record.size;
+	}
+
+	uint64_t duration_us = get_time_us() - replay_start_us;
+
+	printf("Session replayed, %llu bytes in %llu ms (%llu kB/s)\n", (unsigned long long)bytes_sent,
+	       (unsigned long long)(duration_us / 1000),
+	       (unsigned long long)(duration_us > 0 ? bytes_sent * 1000 / duration_us : 0));
+
+	return true;
+}
+
+
+static void print_usage(char *application_name)
+{
+	fprintf(stderr, "Usage: %s [OPTION]... FILE\n", application_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Serve a session recorded with acc_exploration_server_a111 --record\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "-h, --help                      this help\n");
+	fprintf(stderr, "-p, --port                      the TCP/IP port to use\n");
+	fprintf(stderr, "-s, --session                   the recorded session to replay, the first is 1\n");
+	fprintf(stderr, "-f, --fast                      send as fast as possible instead of with recorded timing\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+	static struct option long_options[] =
+	{
+		{"help",             no_argument,       0,      'h'},
+		{"port",             required_argument, 0,      'p'},
+		{"session",          required_argument, 0,      's'},
+		{"fast",             no_argument,       0,      'f'},
+		{NULL,               0,                 NULL,   0}
+	};
+
+	int character_code;
+	int option_index = 0;
+
+	int      tcp_ip_port = DEFAULT_TCP_IP_PORT;
+	uint32_t session     = DEFAULT_SESSION;
+	bool     fast        = false;
+
+	while ((character_code = getopt_long(argc, argv, "h?p:s:f", long_options, &option_index)) != -1)
+	{
+		switch (character_code)
+		{
+			case 'h':
+			case '?':
+			{
+				print_usage(basename(argv[0]));
+				return EXIT_FAILURE;
+			}
+			case 'p':
+			{
+				int value = atoi(optarg);
+				if (value <= 0)
+				{
+					fprintf(stderr, "ERROR: Invalid tcp/ip port '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				tcp_ip_port = value;
+				break;
+			}
+			case 's':
+			{
+				int value = atoi(optarg);
+				if (value <= 0)
+				{
+					fprintf(stderr, "ERROR: Invalid session '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				session = (uint32_t)value;
+				break;
+			}
+			case 'f':
+			{
+				fast = true;
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	if (optind >= argc)
+	{
+		print_usage(basename(argv[0]));
+		return EXIT_FAILURE;
+	}
+
+	acc_session_player_t player;
+
+	if (!acc_session_player_open(&player, argv[optind]))
+	{
+		return EXIT_FAILURE;
+	}
+
+	struct sigaction sa = { 0 };
+
+	sa.sa_handler = main_sig_handler;
+	if (sigaction(SIGINT, &sa, NULL) < 0)
+	{
+		fprintf(stderr, "ERROR: sigaction\n");
+		acc_session_player_close(&player);
+		return EXIT_FAILURE;
+	}
+
+	/* Ignore broken pipe shutdown, default behavior is to close application */
+	signal(SIGPIPE, SIG_IGN);
+
+	printf("Starting replay server (port=%d, session=%u, %s)\n", tcp_ip_port, (unsigned int)session,
+	       fast ? "fast" : "recorded timing");
+
+	if (!acc_socket_server_open(&socket_server, tcp_ip_port, MAX_COMMAND_SIZE))
+	{
+		fprintf(stderr, "ERROR: Could not create socket server\n");
+		acc_session_player_close(&player);
+		return EXIT_FAILURE;
+	}
+
+	acc_socket_server_set_input_data_func(&socket_server, input_data_function);
+
+	while (!replay_shutdown)
+	{
+		printf("Waiting for new connections...\n");
+		fflush(stdout);
+
+		acc_socket_server_client_close(&socket_server);
+
+		if (!acc_socket_server_wait_for_client(&socket_server))
+		{
+			continue;
+		}
+
+		printf("Got new connection.\n");
+
+		received_commands = 0;
+
+		if (replay_session(&player, session, fast))
+		{
+			/* Keep the connection until the client closes it */
+			while (!replay_shutdown && acc_socket_server_poll_events(&socket_server, true, 0))
+			{
+			}
+		}
+	}
+
+	acc_socket_server_client_close(&socket_server);
+	acc_socket_server_close(&socket_server);
+	acc_session_player_close(&player);
+
+	printf("Shutdown complete.\n");
+
+	return EXIT_SUCCESS;
+}
@@ -19,7 +19,11 @@
 #include "acc_definitions_common.h"
 #include "acc_exploration_server_base.h"
 #include "acc_integration_log.h"
+#include "acc_libspi.h"
+#include "acc_metrics_server.h"
+#include "acc_session_recording.h"
 #include "acc_socket_server.h"
+#include "acc_udp_stream.h"
 
 #include "acc_exploration_server_system_a111.h"
 
@@ -29,12 +33,35 @@
 #define NS_PER_TICKS              (1000)
 #define MAIN_THREAD_IDLE_SLEEP_US (200000)
 #define MAX_COMMAND_SIZE          (10*1024)
+#define DEFAULT_UDP_PORT          (6111)
+#define DEFAULT_UDP_MULTICAST_TTL (1)
+#define SOCKET_TUNING_MEASURE_US  (1000000)
 
 static char   command_buffer[MAX_COMMAND_SIZE];
 volatile bool exploration_server_shutdown = false;
 
 acc_socket_server_t socket_server = { 0 };
 
+/* Everything written during one streaming iteration is published as one UDP frame */
+static acc_udp_stream_publisher_t udp_publisher;
+static bool                       udp_enabled = false;
+static uint8_t                    *udp_frame;
+static size_t                     udp_frame_size;
+static bool                       udp_frame_overflow;
+
+static acc_metrics_t metrics;
+static uint32_t      iteration_bytes_produced;
+static uint32_t      iteration_bytes_out;
+
+static acc_session_recorder_t session_recorder;
+
+/* The socket is tuned from the frame size and rate measured at the start of a stream */
+static bool     socket_tuning_enabled = false;
+static bool     socket_tuning_applied;
+static uint32_t socket_tuning_start_us;
+static uint32_t socket_tuning_frames;
+static uint64_t socket_tuning_bytes;
+
 /**
  * @brief Write data to socket
  *
@@ -84,14 +111,237 @@ static void cleanup(void)
 }
 
 
+/**
+ * @brief Count the occurrences of a json key with the value true
+ *
+ * @param[in] json The json text, not necessarily null terminated
+ * @param[in] size The size of the json text
+ * @param[in] key The quoted key to look for
+ *
+ * @return The number of occurrences with the value true
+ */
+static uint32_t count_true_flags(const char *json, size_t size, const char *key)
+{
+	uint32_t   count   = 0;
+	size_t     key_len = strlen(key);
+	const char *end    = json + size;
+	const char *p      = json;
+
+	while ((p = memmem(p, end - p, key, key_len)) != NULL)
+	{
+		p += key_len;
+
+		while (p < end && (*p == ':' || *p == ' ' || *p == '\t'))
+		{
+			p++;
+		}
+
+		if (end - p >= 4 && strncmp(p, "true", 4) == 0)
+		{
+			count++;
+		}
+	}
+
+	return count;
+}
+
+
+static void update_write_metrics(const void *data, uint32_t size)
+{
+	const char *text = data;
+
+	/* Produced whether or not a client is there to take it */
+	iteration_bytes_produced += size;
+
+	if (socket_server.client_socket > 0)
+	{
+		metrics.bytes_out_total += size;
+		iteration_bytes_out     += size;
+	}
+
+	/* Frame headers are json, result info flags are counted from there */
+	if (size > 0 && text[0] == '{')
+	{
+		metrics.missed_data_total          += count_true_flags(text, size, "\"missed_data\"");
+		metrics.data_quality_warning_total += count_true_flags(text, size, "\"data_quality_warning\"");
+		metrics.data_saturated_total       += count_true_flags(text, size, "\"data_saturated\"");
+	}
+}
+
+
+/**
+ * @brief Update the metrics after one process iteration and publish them
+ *
+ * @param[in] state The state returned by the process iteration
+ * @param[in] loop_time_us The time spent in the process iteration
+ */
+static void update_iteration_metrics(acc_exploration_server_state_t state, uint32_t loop_time_us)
+{
+	acc_libspi_statistics_t spi_statistics;
+
+	if (state == ACC_EXPLORATION_SERVER_STREAMING && iteration_bytes_produced > 0)
+	{
+		metrics.frames_produced_total++;
+
+		if (iteration_bytes_out > 0)
+		{
+			metrics.frames_sent_total++;
+		}
+	}
+
+	iteration_bytes_produced = 0;
+	iteration_bytes_out      = 0;
+
+	metrics.loop_iterations_total++;
+	metrics.loop_time_total_us += loop_time_us;
+	if (loop_time_us > metrics.loop_time_max_us)
+	{
+		metrics.loop_time_max_us = loop_time_us;
+	}
+
+	acc_libspi_get_statistics(&spi_statistics);
+	metrics.spi_transfers_total   = spi_statistics.transfer_count;
+	metrics.spi_bytes_total       = spi_statistics.transfer_bytes;
+	metrics.spi_time_total_us     = spi_statistics.transfer_time_total_us;
+	metrics.spi_time_max_us       = spi_statistics.transfer_time_max_us;
+	metrics.queue_depth_bytes     = (uint32_t)acc_socket_server_get_send_queue_size(&socket_server);
+	metrics.client_count          = socket_server.client_socket > 0 ? 1 : 0;
+	metrics.udp_frames_sent_total = udp_publisher.stats.frames_sent;
+
+	acc_metrics_server_update(&metrics);
+}
+
+
+/**
+ * @brief Restart the socket tuning with the default tuning
+ */
+static void reset_socket_tuning(void)
+{
+	acc_socket_server_tuning_t tuning;
+
+	if (socket_tuning_applied)
+	{
+		acc_socket_server_tuning_default(&tuning);
+		acc_socket_server_set_tuning(&socket_server, &tuning);
+	}
+
+	socket_tuning_applied = false;
+	socket_tuning_frames  = 0;
+	socket_tuning_bytes   = 0;
+}
+
+
+/**
+ * @brief Measure the stream and tune the client socket when enough frames are seen
+ *
+ * @param[in] state The state returned by the last process iteration
+ * @param[in] frame_bytes The number of bytes written during the last process iteration
+ */
+static void adapt_socket_tuning(acc_exploration_server_state_t state, uint32_t frame_bytes)
+{
+	if (state != ACC_EXPLORATION_SERVER_STREAMING)
+	{
+		/* A new stream may have another configuration, measure again */
+		reset_socket_tuning();
+		return;
+	}
+
+	if (socket_tuning_applied || frame_bytes == 0)
+	{
+		return;
+	}
+
+	if (socket_tuning_frames == 0)
+	{
+		socket_tuning_start_us = get_tick();
+	}
+
+	socket_tuning_frames++;
+	socket_tuning_bytes += frame_bytes;
+
+	uint32_t elapsed_us = get_tick() - socket_tuning_start_us;
+
+	if (elapsed_us >= SOCKET_TUNING_MEASURE_US)
+	{
+		acc_socket_server_tuning_t tuning;
+		size_t                     frame_size = (size_t)(socket_tuning_bytes / socket_tuning_frames);
+		float                      frame_rate = (float)(socket_tuning_frames - 1) * (float)US_TICKS_PER_SECOND / (float)elapsed_us;
+
+		acc_socket_server_tuning_for_stream(frame_size, frame_rate, &tuning);
+		acc_socket_server_set_tuning(&socket_server, &tuning);
+		socket_tuning_applied = true;
+
+		printf("Socket tuned for %zu byte frames at %.1f Hz (sndbuf=%d, notsent_lowat=%d, cork=%s)\n",
+		       frame_size, (double)frame_rate, tuning.send_buffer_size, tuning.not_sent_lowat,
+		       tuning.cork ? "on" : "off");
+	}
+}
+
+
 static void write_data_func(const void *data, uint32_t size)
 {
+	update_write_metrics(data, size);
+
+	acc_session_recorder_write(&session_recorder, ACC_SESSION_RECORD_OUTBOUND, data, size);
+
 	acc_socket_server_setup_write_data(&socket_server, data, size);
+
+	if (udp_enabled)
+	{
+		if (udp_frame_size + size <= ACC_UDP_STREAM_MAX_FRAME_SIZE)
+		{
+			memcpy(udp_frame + udp_frame_size, data, size);
+			udp_frame_size += size;
+		}
+		else
+		{
+			udp_frame_overflow = true;
+		}
+	}
+}
+
+
+/**
+ * @brief Publish the data written during the last process iteration as one UDP frame
+ *
+ * @param[in] state The state returned by the last process iteration
+ */
+static void udp_publish_frame(acc_exploration_server_state_t state)
+{
+	if (udp_frame_size > 0 && state == ACC_EXPLORATION_SERVER_STREAMING && !udp_frame_overflow)
+	{
+		acc_udp_stream_publisher_send_frame(&udp_publisher, udp_frame, udp_frame_size);
+	}
+	else if (udp_frame_overflow)
+	{
+		acc_udp_stream_publisher_drop_frame(&udp_publisher);
+	}
+
+	udp_frame_size     = 0;
+	udp_frame_overflow = false;
+}
+
+
+/**
+ * @brief Close the UDP publisher and release its frame buffer, if it was opened
+ */
+static void udp_close(void)
+{
+	if (udp_enabled)
+	{
+		acc_udp_stream_publisher_close(&udp_publisher);
+		udp_enabled = false;
+	}
+
+	free(udp_frame);
+	udp_frame = NULL;
 }
 
 
 static void input_data_function(const void *data, size_t size)
 {
+	acc_session_recorder_write(&session_recorder, ACC_SESSION_RECORD_INBOUND, data, size);
+
 	/* Put data from socket */
 	acc_exploration_server_put_buffer_from_client(data, size);
 }
@@ -128,6 +378,12 @@ static void print_usage(char *application_name)
 	fprintf(stderr, "-h, --help                      this help\n");
 	fprintf(stderr, "-l, --log-level                 the log level (debug/warning/info/verbose/error)\n");
 	fprintf(stderr, "-p, --port                      the TCP/IP port to use\n");
+	fprintf(stderr, "-u, --udp-address               also publish streamed frames over UDP to this unicast/multicast address\n");
+	fprintf(stderr, "-U, --udp-port                  the UDP port to publish to\n");
+	fprintf(stderr, "-m, --udp-mtu                   the MTU used to fragment UDP frames\n");
+	fprintf(stderr, "-M, --metrics-port              serve runtime metrics as plain text (HTTP) on this TCP/IP port\n");
+	fprintf(stderr, "-r, --record                    record all client sessions with timing to this file\n");
+	fprintf(stderr, "-t, --tune-socket               tune socket buffers and corking from the measured frame size and rate\n");
 }
 
 
@@ -138,16 +394,27 @@ int main(int argc, char *argv[])
 		{"help",             no_argument,       0,      'h'},
 		{"log-level",        required_argument, 0,      'l'},
 		{"port",             required_argument, 0,      'p'},
+		{"udp-address",      required_argument, 0,      'u'},
+		{"udp-port",         required_argument, 0,      'U'},
+		{"udp-mtu",          required_argument, 0,      'm'},
+		{"metrics-port",     required_argument, 0,      'M'},
+		{"record",           required_argument, 0,      'r'},
+		{"tune-socket",      no_argument,       0,      't'},
 		{NULL,               0,                 NULL,   0}
 	};
 
 	int character_code;
 	int option_index = 0;
 
-	acc_log_level_t log_level   = ACC_LOG_LEVEL_INFO;
-	int             tcp_ip_port = DEFAULT_TCP_IP_PORT;
+	acc_log_level_t log_level    = ACC_LOG_LEVEL_INFO;
+	int             tcp_ip_port  = DEFAULT_TCP_IP_PORT;
+	char            *udp_address = NULL;
+	int             udp_port     = DEFAULT_UDP_PORT;
+	size_t          udp_mtu      = ACC_UDP_STREAM_DEFAULT_MTU;
+	int             metrics_port = 0;
+	char            *record_path = NULL;
 
-	while ((character_code = getopt_long(argc, argv, "h?l:p:", long_options, &option_index)) != -1)
+	while ((character_code = getopt_long(argc, argv, "h?l:p:u:U:m:M:r:t", long_options, &option_index)) != -1)
 	{
 		switch (character_code)
 		{
@@ -200,6 +467,59 @@ int main(int argc, char *argv[])
 					fprintf(stderr, "ERROR: Invalid tcp/ip port '%s'\n", optarg);
 					return EXIT_FAILURE;
 				}
+
+				break;
+			}
+			case 'u':
+			{
+				udp_address = optarg;
+				break;
+			}
+			case 'U':
+			{
+				int value = atoi(optarg);
+				if (value <= 0)
+				{
+					fprintf(stderr, "ERROR: Invalid udp port '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				udp_port = value;
+				break;
+			}
+			case 'm':
+			{
+				int value = atoi(optarg);
+				if (value <= 0)
+				{
+					fprintf(stderr, "ERROR: Invalid udp mtu '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				udp_mtu = (size_t)value;
+				break;
+			}
+			case 'M':
+			{
+				int value = atoi(optarg);
+				if (value <= 0)
+				{
+					fprintf(stderr, "ERROR: Invalid metrics port '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				metrics_port = value;
+				break;
+			}
+			case 'r':
+			{
+				record_path = optarg;
+				break;
+			}
+			case 't':
+			{
+				socket_tuning_enabled = true;
+				break;
 			}
 			default:
 				break;
@@ -238,6 +558,52 @@ int main(int argc, char *argv[])
 
 	acc_socket_server_set_input_data_func(&socket_server, input_data_function);
 
+	if (udp_address != NULL)
+	{
+		udp_frame = malloc(ACC_UDP_STREAM_MAX_FRAME_SIZE);
+
+		if (udp_frame == NULL ||
+		    !acc_udp_stream_publisher_open(&udp_publisher, udp_address, udp_port, udp_mtu, DEFAULT_UDP_MULTICAST_TTL))
+		{
+			fprintf(stderr, "ERROR: Could not create udp publisher\n");
+			free(udp_frame);
+			acc_socket_server_close(&socket_server);
+			cleanup();
+			return EXIT_FAILURE;
+		}
+
+		udp_enabled = true;
+		printf("Publishing frames on udp (%s:%d, mtu=%zu)\n", udp_address, udp_port, udp_mtu);
+	}
+
+	if (metrics_port > 0)
+	{
+		if (!acc_metrics_server_start(metrics_port))
+		{
+			fprintf(stderr, "ERROR: Could not create metrics server\n");
+			udp_close();
+			acc_socket_server_close(&socket_server);
+			cleanup();
+			return EXIT_FAILURE;
+		}
+
+		printf("Serving metrics (port=%d)\n", metrics_port);
+	}
+
+	if (record_path != NULL)
+	{
+		if (!acc_session_recorder_open(&session_recorder, record_path))
+		{
+			acc_metrics_server_stop();
+			udp_close();
+			acc_socket_server_close(&socket_server);
+			cleanup();
+			return EXIT_FAILURE;
+		}
+
+		printf("Recording sessions to '%s'\n", record_path);
+	}
+
 	while (!do_shutdown())
 	{
 		printf("Waiting for new connections...\n");
@@ -256,6 +622,12 @@ int main(int argc, char *argv[])
 			continue;
 		}
 
+		metrics.clients_connected_total++;
+
+		acc_session_recorder_write(&session_recorder, ACC_SESSION_RECORD_CONNECT, NULL, 0);
+
+		reset_socket_tuning();
+
 		printf("Got new connection.\n");
 		printf("Listening for command...\n");
 
@@ -268,7 +640,25 @@ int main(int argc, char *argv[])
 			int32_t ticks_until_next = 0;
 			bool    blocking_poll    = false;
 
-			bool success = acc_exploration_server_process(&server_if, &state, &ticks_until_next);
+			/* All writes of one iteration form a frame, sent as full segments when corked */
+			acc_socket_server_cork(&socket_server, true);
+
+			uint32_t loop_start_us = get_tick();
+			bool     success       = acc_exploration_server_process(&server_if, &state, &ticks_until_next);
+
+			acc_socket_server_cork(&socket_server, false);
+
+			if (udp_enabled)
+			{
+				udp_publish_frame(state);
+			}
+
+			if (socket_tuning_enabled)
+			{
+				adapt_socket_tuning(state, iteration_bytes_out);
+			}
+
+			update_iteration_metrics(state, get_tick() - loop_start_us);
 
 			if (!success)
 			{
@@ -303,6 +693,19 @@ int main(int argc, char *argv[])
 
 	acc_socket_server_close(&socket_server);
 
+	acc_metrics_server_stop();
+
+	/* Flushes the buffered records of the last session */
+	acc_session_recorder_close(&session_recorder);
+
+	if (udp_enabled)
+	{
+		printf("UDP frames sent: %u, dropped: %u\n", (unsigned int)udp_publisher.stats.frames_sent,
+		       (unsigned int)udp_publisher.stats.frames_dropped);
+	}
+
+	udp_close();
+
 	cleanup();
 	printf("Shutdown complete.\n");
 
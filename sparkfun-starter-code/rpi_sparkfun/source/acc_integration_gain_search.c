@@ -0,0 +1,107 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "acc_integration.h"
+#include "acc_integration_gain_search.h"
+
+
+static float step_to_gain(uint16_t step)
+{
+	return (float)step / (float)ACC_INTEGRATION_GAIN_STEP_COUNT;
+}
+
+
+static bool record_step(acc_integration_gain_search_record_func_t *record, void *user_data, uint16_t step,
+                        acc_integration_gain_search_result_t *result, bool *saturated)
+{
+	result->recording_count++;
+	result->gain = step_to_gain(step);
+
+	return record(result->gain, user_data, saturated);
+}
+
+
+bool acc_integration_gain_search(float max_gain, uint16_t margin_steps, acc_integration_gain_search_record_func_t *record,
+                                 void *user_data, acc_integration_gain_search_result_t *result)
+{
+	uint32_t start_ms = acc_integration_get_time();
+	uint16_t max_step = (uint16_t)(max_gain * (float)ACC_INTEGRATION_GAIN_STEP_COUNT + 0.5f);
+	bool     status   = true;
+	bool     saturated;
+
+	if (max_step > ACC_INTEGRATION_GAIN_STEP_COUNT)
+	{
+		max_step = ACC_INTEGRATION_GAIN_STEP_COUNT;
+	}
+
+	result->gain            = 0.0f;
+	result->recording_count = 0;
+
+	/*
+	 * Bisection invariant: low is the highest step known not to saturate, 0 if none
+	 * is known, and high is the lowest step known to saturate.
+	 */
+	uint16_t low       = 0;
+	uint16_t high      = max_step + 1;
+	uint16_t last_step = 0;
+
+	if (max_step > 0)
+	{
+		status    = record_step(record, user_data, max_step, result, &saturated);
+		last_step = max_step;
+
+		if (saturated)
+		{
+			high = max_step;
+		}
+		else
+		{
+			low = max_step;
+		}
+	}
+
+	while (status && high - low > 1)
+	{
+		uint16_t middle = (uint16_t)((low + high) / 2);
+
+		status    = record_step(record, user_data, middle, result, &saturated);
+		last_step = middle;
+
+		if (saturated)
+		{
+			high = middle;
+		}
+		else
+		{
+			low = middle;
+		}
+	}
+
+	bool found = status && low > 0;
+
+	if (found)
+	{
+		uint16_t step = low > margin_steps ? (uint16_t)(low - margin_steps) : 1;
+
+		/* The data of the last recording must be the data of the selected gain */
+		saturated = step != last_step;
+
+		while (status && saturated && step > 0)
+		{
+			status = record_step(record, user_data, step, result, &saturated);
+			step--;
+		}
+
+		found = status && !saturated;
+	}
+
+	result->time_ms = acc_integration_get_time() - start_ms;
+
+	return found;
+}
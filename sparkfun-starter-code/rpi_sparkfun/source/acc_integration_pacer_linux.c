@@ -0,0 +1,127 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "acc_integration_pacer.h"
+
+#define NS_PER_S (1000000000ULL)
+
+
+static uint64_t get_time_ns(void)
+{
+	struct timespec time_ts = {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &time_ts);
+	return (uint64_t)time_ts.tv_sec * NS_PER_S + (uint64_t)time_ts.tv_nsec;
+}
+
+
+static void sleep_until_ns(uint64_t deadline_ns)
+{
+	struct timespec deadline_ts;
+
+	deadline_ts.tv_sec  = (time_t)(deadline_ns / NS_PER_S);
+	deadline_ts.tv_nsec = (long)(deadline_ns % NS_PER_S);
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline_ts, NULL) == EINTR)
+	{
+	}
+}
+
+
+void acc_integration_pacer_init(acc_integration_pacer_t *pacer, float rate_hz)
+{
+	memset(pacer, 0, sizeof(*pacer));
+
+	pacer->period_ns = (uint64_t)((double)NS_PER_S / (double)rate_hz + 0.5);
+}
+
+
+bool acc_integration_pacer_wait(acc_integration_pacer_t *pacer)
+{
+	uint64_t now_ns = get_time_ns();
+	bool     met    = true;
+
+	if (pacer->deadline_ns == 0)
+	{
+		pacer->deadline_ns = now_ns;
+		pacer->start_ns    = now_ns;
+	}
+	else
+	{
+		pacer->deadline_ns += pacer->period_ns;
+	}
+
+	if (now_ns > pacer->deadline_ns)
+	{
+		uint64_t missed_periods = (now_ns - pacer->deadline_ns) / pacer->period_ns;
+
+		pacer->deadline_ns += missed_periods * pacer->period_ns;
+		pacer->overrun_count++;
+		met = false;
+	}
+	else
+	{
+		sleep_until_ns(pacer->deadline_ns);
+		now_ns = get_time_ns();
+	}
+
+	uint64_t lateness_ns = now_ns - pacer->deadline_ns;
+
+	pacer->lateness_sum_ns += lateness_ns;
+
+	if (lateness_ns > pacer->lateness_max_ns)
+	{
+		pacer->lateness_max_ns = lateness_ns;
+	}
+
+	if (pacer->frame_count == 0)
+	{
+		pacer->start_ns = now_ns;
+	}
+
+	pacer->last_ns = now_ns;
+	pacer->frame_count++;
+
+	return met;
+}
+
+
+void acc_integration_pacer_get_statistics(const acc_integration_pacer_t *pacer,
+                                          acc_integration_pacer_statistics_t *statistics)
+{
+	uint64_t elapsed_ns = pacer->last_ns - pacer->start_ns;
+
+	memset(statistics, 0, sizeof(*statistics));
+
+	statistics->frame_count   = pacer->frame_count;
+	statistics->overrun_count = pacer->overrun_count;
+
+	if (pacer->frame_count > 0)
+	{
+		statistics->jitter_mean_us = (uint32_t)(pacer->lateness_sum_ns / pacer->frame_count / 1000);
+		statistics->jitter_max_us  = (uint32_t)(pacer->lateness_max_ns / 1000);
+	}
+
+	if (pacer->frame_count > 1 && elapsed_ns > 0)
+	{
+		statistics->rate_hz = (float)((double)(pacer->frame_count - 1) * (double)NS_PER_S / (double)elapsed_ns);
+	}
+}
+
+
+void acc_integration_pacer_reset_statistics(acc_integration_pacer_t *pacer)
+{
+	pacer->lateness_sum_ns = 0;
+	pacer->lateness_max_ns = 0;
+	pacer->frame_count     = 0;
+	pacer->overrun_count   = 0;
+}
@@ -0,0 +1,279 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "acc_iq_velocity.h"
+
+
+// The IQ phase of a reflection decreases with distance
+#define PHASE_SIGN (-1.0f)
+
+#ifndef M_PI
+#define M_PI (3.14159265358979323846)
+#endif
+
+
+struct acc_iq_velocity
+{
+	acc_iq_velocity_parameters_t parameters;
+	uint16_t                     data_length;
+	uint32_t                     sweep_count;
+	acc_int16_complex_t          *previous;
+	float                        *lag_real;  /**< Smoothed real part of sweep times conjugate of previous sweep */
+	float                        *lag_imag;  /**< Smoothed imaginary part */
+	float                        *power;     /**< Smoothed power */
+	float                        *sweep_power;
+	bool                         has_centroid;
+	float                        centroid_m; /**< Filtered power centroid */
+	float                        range_rate_mps;
+};
+
+
+/**
+ * @brief Smooth the lag products and the power of a sweep, returns the highest power of the sweep
+ *
+ * The products are halved in fixed point, x * conj(y) of two int16 complex values does not fit
+ * in int32 otherwise. The factor is the same for all bins and does not change any phase.
+ */
+static float lag_products(struct acc_iq_velocity *velocity, const acc_int16_complex_t *data)
+{
+	const acc_int16_complex_t *previous = velocity->previous;
+	float                     alpha     = velocity->parameters.smoothing;
+	uint16_t                  i         = 0;
+	float                     max_power = 0.0f;
+
+#if defined(__ARM_NEON)
+	float32x4_t alpha_vector = vdupq_n_f32(alpha);
+	float32x4_t max_vector   = vdupq_n_f32(0.0f);
+
+	for (; i + 4 <= velocity->data_length; i += 4)
+	{
+		int16x4x2_t x = vld2_s16((const int16_t *)&data[i]);
+		int16x4x2_t y = vld2_s16((const int16_t *)&previous[i]);
+
+		int32x4_t real  = vhaddq_s32(vmull_s16(x.val[0], y.val[0]), vmull_s16(x.val[1], y.val[1]));
+		int32x4_t imag  = vhsubq_s32(vmull_s16(x.val[1], y.val[0]), vmull_s16(x.val[0], y.val[1]));
+		int32x4_t power = vhaddq_s32(vmull_s16(x.val[0], x.val[0]), vmull_s16(x.val[1], x.val[1]));
+
+		float32x4_t real_f  = vcvtq_f32_s32(real);
+		float32x4_t imag_f  = vcvtq_f32_s32(imag);
+		float32x4_t power_f = vcvtq_f32_s32(power);
+
+		float32x4_t lag_real = vld1q_f32(&velocity->lag_real[i]);
+		float32x4_t lag_imag = vld1q_f32(&velocity->lag_imag[i]);
+		float32x4_t smoothed = vld1q_f32(&velocity->power[i]);
+
+		vst1q_f32(&velocity->lag_real[i], vmlaq_f32(lag_real, vsubq_f32(real_f, lag_real), alpha_vector));
+		vst1q_f32(&velocity->lag_imag[i], vmlaq_f32(lag_imag, vsubq_f32(imag_f, lag_imag), alpha_vector));
+		vst1q_f32(&velocity->power[i], vmlaq_f32(smoothed, vsubq_f32(power_f, smoothed), alpha_vector));
+
+		vst1q_f32(&velocity->sweep_power[i], power_f);
+		max_vector = vmaxq_f32(max_vector, power_f);
+	}
+
+	float32x2_t max_pair = vpmax_f32(vget_low_f32(max_vector), vget_high_f32(max_vector));
+
+	max_power = vget_lane_f32(vpmax_f32(max_pair, max_pair), 0);
+#endif
+
+	for (; i < velocity->data_length; i++)
+	{
+		int32_t a = data[i].real;
+		int32_t b = data[i].imag;
+		int32_t c = previous[i].real;
+		int32_t d = previous[i].imag;
+
+		float real  = (float)(int32_t)(((int64_t)a * c + (int64_t)b * d) >> 1);
+		float imag  = (float)(int32_t)(((int64_t)b * c - (int64_t)a * d) >> 1);
+		float power = (float)(int32_t)(((int64_t)a * a + (int64_t)b * b) >> 1);
+
+		velocity->lag_real[i] += alpha * (real - velocity->lag_real[i]);
+		velocity->lag_imag[i] += alpha * (imag - velocity->lag_imag[i]);
+		velocity->power[i]    += alpha * (power - velocity->power[i]);
+
+		velocity->sweep_power[i] = power;
+		max_power                = power > max_power ? power : max_power;
+	}
+
+	return max_power;
+}
+
+
+static float phase_to_velocity(const acc_iq_velocity_parameters_t *parameters, float phase)
+{
+	return PHASE_SIGN * phase * ACC_IQ_VELOCITY_WAVELENGTH_M * parameters->sweep_rate_hz / (4.0f * (float)M_PI);
+}
+
+
+acc_iq_velocity_t acc_iq_velocity_create(const acc_iq_velocity_parameters_t *parameters, uint16_t data_length)
+{
+	if (data_length == 0 || parameters->sweep_rate_hz <= 0.0f || parameters->step_length_m <= 0.0f ||
+	    parameters->smoothing <= 0.0f || parameters->smoothing > 1.0f ||
+	    parameters->min_power_ratio < 0.0f || parameters->min_power_ratio > 1.0f ||
+	    parameters->range_rate_alpha <= 0.0f || parameters->range_rate_alpha > 1.0f ||
+	    parameters->range_rate_beta < 0.0f || parameters->range_rate_beta > 2.0f)
+	{
+		return NULL;
+	}
+
+	struct acc_iq_velocity *velocity = calloc(1, sizeof(*velocity));
+
+	if (velocity == NULL)
+	{
+		return NULL;
+	}
+
+	velocity->parameters  = *parameters;
+	velocity->data_length = data_length;
+	velocity->previous    = calloc(data_length, sizeof(*velocity->previous));
+	velocity->lag_real    = calloc(data_length, sizeof(*velocity->lag_real));
+	velocity->lag_imag    = calloc(data_length, sizeof(*velocity->lag_imag));
+	velocity->power       = calloc(data_length, sizeof(*velocity->power));
+	velocity->sweep_power = calloc(data_length, sizeof(*velocity->sweep_power));
+
+	if (velocity->previous == NULL || velocity->lag_real == NULL || velocity->lag_imag == NULL || velocity->power == NULL ||
+	    velocity->sweep_power == NULL)
+	{
+		acc_iq_velocity_destroy(&velocity);
+	}
+
+	return velocity;
+}
+
+
+void acc_iq_velocity_destroy(acc_iq_velocity_t *velocity)
+{
+	if (*velocity == NULL)
+	{
+		return;
+	}
+
+	free((*velocity)->previous);
+	free((*velocity)->lag_real);
+	free((*velocity)->lag_imag);
+	free((*velocity)->power);
+	free((*velocity)->sweep_power);
+	free(*velocity);
+	*velocity = NULL;
+}
+
+
+void acc_iq_velocity_process(acc_iq_velocity_t velocity, const acc_int16_complex_t *data)
+{
+	const acc_iq_velocity_parameters_t *parameters = &velocity->parameters;
+
+	if (velocity->sweep_count > 0)
+	{
+		float max_power    = lag_products(velocity, data);
+		float threshold    = parameters->min_power_ratio * max_power;
+		float power_sum    = 0.0f;
+		float weighted_sum = 0.0f;
+
+		/* The noise floor would pull the centroid, and its rate, towards the middle of the range */
+		for (uint16_t i = 0; i < velocity->data_length; i++)
+		{
+			if (velocity->sweep_power[i] >= threshold)
+			{
+				power_sum    += velocity->sweep_power[i];
+				weighted_sum += velocity->sweep_power[i] * (float)i;
+			}
+		}
+
+		/* Without power above the threshold there is no centroid to track */
+		if (power_sum > 0.0f)
+		{
+			float centroid_m = parameters->start_m + weighted_sum / power_sum * parameters->step_length_m;
+			float dt_s       = 1.0f / parameters->sweep_rate_hz;
+
+			if (!velocity->has_centroid)
+			{
+				velocity->centroid_m   = centroid_m;
+				velocity->has_centroid = true;
+			}
+			else
+			{
+				float predicted = velocity->centroid_m + velocity->range_rate_mps * dt_s;
+				float residual  = centroid_m - predicted;
+
+				velocity->centroid_m      = predicted + parameters->range_rate_alpha * residual;
+				velocity->range_rate_mps += parameters->range_rate_beta * residual / dt_s;
+			}
+		}
+	}
+
+	memcpy(velocity->previous, data, velocity->data_length * sizeof(*data));
+
+	if (velocity->sweep_count < UINT32_MAX)
+	{
+		velocity->sweep_count++;
+	}
+}
+
+
+void acc_iq_velocity_get_bin_velocities(const acc_iq_velocity_t velocity, float *velocities)
+{
+	for (uint16_t i = 0; i < velocity->data_length; i++)
+	{
+		velocities[i] = phase_to_velocity(&velocity->parameters, atan2f(velocity->lag_imag[i], velocity->lag_real[i]));
+	}
+}
+
+
+bool acc_iq_velocity_get_result(const acc_iq_velocity_t velocity, acc_iq_velocity_result_t *result)
+{
+	const acc_iq_velocity_parameters_t *parameters = &velocity->parameters;
+
+	float max_power = 0.0f;
+
+	for (uint16_t i = 0; i < velocity->data_length; i++)
+	{
+		max_power = velocity->power[i] > max_power ? velocity->power[i] : max_power;
+	}
+
+	if (velocity->sweep_count < 2 || max_power <= 0.0f)
+	{
+		return false;
+	}
+
+	/* The sum of the products weights each bin with its power */
+	float    threshold = parameters->min_power_ratio * max_power;
+	float    real      = 0.0f;
+	float    imag      = 0.0f;
+	uint16_t bin_count = 0;
+
+	for (uint16_t i = 0; i < velocity->data_length; i++)
+	{
+		if (velocity->power[i] >= threshold)
+		{
+			real += velocity->lag_real[i];
+			imag += velocity->lag_imag[i];
+			bin_count++;
+		}
+	}
+
+	float max_unambiguous_mps = ACC_IQ_VELOCITY_WAVELENGTH_M * parameters->sweep_rate_hz / 4.0f;
+	float phase_velocity_mps  = phase_to_velocity(parameters, atan2f(imag, real));
+	float alias_count         = roundf((velocity->range_rate_mps - phase_velocity_mps) / (2.0f * max_unambiguous_mps));
+
+	result->velocity_mps        = phase_velocity_mps + alias_count * 2.0f * max_unambiguous_mps;
+	result->phase_velocity_mps  = phase_velocity_mps;
+	result->range_rate_mps      = velocity->range_rate_mps;
+	result->max_unambiguous_mps = max_unambiguous_mps;
+	result->distance_m          = velocity->centroid_m;
+	result->alias_count         = (int16_t)alias_count;
+	result->bin_count           = bin_count;
+
+	return true;
+}
@@ -0,0 +1,316 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <getopt.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "acc_benchmark_util.h"
+#include "acc_iq_velocity.h"
+
+
+#define DEFAULT_SWEEP_COUNT (2000)
+#define SWEEP_RATE_HZ       (1000.0f)
+#define RANGE_START_M       (0.4f)
+#define STEP_LENGTH_M       (0.00194f)
+#define SIMULATED_LENGTH    (2048)
+#define ACCURACY_SWEEPS     (600)
+#define PULSE_WIDTH_M       (0.025f)
+#define AMPLITUDE           (2000.0f)
+#define NOISE_STD           (50.0f)
+#define RESULT_INTERVAL     (10)
+
+#ifndef M_PI
+#define M_PI (3.14159265358979323846)
+#endif
+
+static const uint16_t data_lengths[] = { 64, 128, 256, 512, 1024, 2048 };
+
+#define DATA_LENGTH_COUNT (sizeof(data_lengths) / sizeof(data_lengths[0]))
+
+static const float speeds_mps[] = { 0.1f, 0.5f, -1.0f, 2.0f, -3.0f, 5.0f };
+
+#define SPEED_COUNT (sizeof(speeds_mps) / sizeof(speeds_mps[0]))
+
+static const acc_iq_velocity_parameters_t default_parameters =
+{
+	.sweep_rate_hz    = SWEEP_RATE_HZ,
+	.start_m          = RANGE_START_M,
+	.step_length_m    = STEP_LENGTH_M,
+	.smoothing        = 0.1f,
+	.min_power_ratio  = 0.1f,
+	.range_rate_alpha = 0.05f,
+	.range_rate_beta  = 0.001f,
+};
+
+
+static int16_t saturate(float value)
+{
+	value = value > 32767.0f ? 32767.0f : value;
+	value = value < -32768.0f ? -32768.0f : value;
+
+	return (int16_t)lrintf(value);
+}
+
+
+/**
+ * @brief One sweep with a reflection at distance_m, the phase turns a full cycle for every half wavelength
+ */
+static void simulate_sweep(acc_int16_complex_t *data, uint16_t data_length, float distance_m, uint32_t *state)
+{
+	float phase = -4.0f * (float)M_PI * fmodf(distance_m, ACC_IQ_VELOCITY_WAVELENGTH_M) / ACC_IQ_VELOCITY_WAVELENGTH_M;
+	float c     = cosf(phase);
+	float s     = sinf(phase);
+
+	for (uint16_t i = 0; i < data_length; i++)
+	{
+		float offset    = (RANGE_START_M + i * STEP_LENGTH_M - distance_m) / PULSE_WIDTH_M;
+		float amplitude = AMPLITUDE * expf(-0.5f * offset * offset);
+
+		data[i].real = saturate(amplitude * c + NOISE_STD * acc_benchmark_next_noise(state));
+		data[i].imag = saturate(amplitude * s + NOISE_STD * acc_benchmark_next_noise(state));
+	}
+}
+
+
+/**
+ * @brief Reference with a float phase difference of every bin and sweep
+ */
+static void reference_process(const acc_int16_complex_t *data, acc_int16_complex_t *previous, float *velocities,
+                              uint16_t data_length)
+{
+	const float scale = -ACC_IQ_VELOCITY_WAVELENGTH_M * SWEEP_RATE_HZ / (4.0f * (float)M_PI);
+
+	for (uint16_t i = 0; i < data_length; i++)
+	{
+		float a = data[i].real;
+		float b = data[i].imag;
+		float c = previous[i].real;
+		float d = previous[i].imag;
+
+		velocities[i] += default_parameters.smoothing * (scale * atan2f(b * c - a * d, a * c + b * d) - velocities[i]);
+	}
+
+	memcpy(previous, data, data_length * sizeof(*data));
+}
+
+
+static bool run_timing(uint16_t data_length, uint32_t sweep_count)
+{
+	acc_int16_complex_t *sweeps     = malloc(2 * (size_t)data_length * sizeof(*sweeps));
+	acc_int16_complex_t *previous   = calloc(data_length, sizeof(*previous));
+	float               *velocities = calloc(data_length, sizeof(*velocities));
+	acc_iq_velocity_t   velocity    = acc_iq_velocity_create(&default_parameters, data_length);
+	uint32_t            state       = 1;
+
+	if (sweeps == NULL || previous == NULL || velocities == NULL || velocity == NULL)
+	{
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		free(sweeps);
+		free(previous);
+		free(velocities);
+		acc_iq_velocity_destroy(&velocity);
+		return false;
+	}
+
+	simulate_sweep(&sweeps[0], data_length, RANGE_START_M + data_length * STEP_LENGTH_M / 2.0f, &state);
+	simulate_sweep(&sweeps[data_length], data_length, RANGE_START_M + data_length * STEP_LENGTH_M / 2.0f + 0.0005f,
+	               &state);
+
+	uint64_t start_ns = acc_benchmark_get_time_ns();
+
+	for (uint32_t n = 0; n < sweep_count; n++)
+	{
+		acc_iq_velocity_process(velocity, &sweeps[(n % 2) * data_length]);
+	}
+
+	uint64_t process_ns = acc_benchmark_get_time_ns() - start_ns;
+
+	acc_iq_velocity_result_t result;
+	float                    checksum = 0.0f;
+
+	start_ns = acc_benchmark_get_time_ns();
+
+	for (uint32_t n = 0; n < sweep_count / RESULT_INTERVAL; n++)
+	{
+		if (acc_iq_velocity_get_result(velocity, &result))
+		{
+			checksum += result.velocity_mps;
+		}
+	}
+
+	uint64_t result_ns = acc_benchmark_get_time_ns() - start_ns;
+
+	start_ns = acc_benchmark_get_time_ns();
+
+	for (uint32_t n = 0; n < sweep_count; n++)
+	{
+		reference_process(&sweeps[(n % 2) * data_length], previous, velocities, data_length);
+	}
+
+	uint64_t reference_ns = acc_benchmark_get_time_ns() - start_ns;
+
+	checksum += velocities[data_length / 2];
+
+	double sweep_ns     = (double)process_ns / sweep_count;
+	double reference_sw = (double)reference_ns / sweep_count;
+	double result_call  = (double)result_ns / (sweep_count / RESULT_INTERVAL);
+
+	printf("%7u %10.2f us %8.2f ns %10.2f us %10.2f us %8.1fx %7.1f %% (%g)\n", (unsigned int)data_length,
+	       sweep_ns / 1000.0, sweep_ns / data_length, result_call / 1000.0, reference_sw / 1000.0,
+	       reference_sw / sweep_ns, 100.0 * (sweep_ns + result_call / RESULT_INTERVAL) * (double)SWEEP_RATE_HZ / 1.0e9,
+	       (double)checksum);
+
+	free(sweeps);
+	free(previous);
+	free(velocities);
+	acc_iq_velocity_destroy(&velocity);
+
+	return true;
+}
+
+
+static bool run_accuracy(float speed_mps)
+{
+	const uint32_t      sweep_count = ACCURACY_SWEEPS;
+	acc_int16_complex_t *data     = malloc(SIMULATED_LENGTH * sizeof(*data));
+	acc_iq_velocity_t   velocity  = acc_iq_velocity_create(&default_parameters, SIMULATED_LENGTH);
+	uint32_t            state     = 1;
+	float               dt_s      = 1.0f / SWEEP_RATE_HZ;
+	float               center_m  = RANGE_START_M + SIMULATED_LENGTH * STEP_LENGTH_M / 2.0f;
+	float               distance  = center_m - speed_mps * sweep_count * dt_s / 2.0f;
+	double              sum_error = 0.0;
+	double              sum_sq    = 0.0;
+	double              sum_phase = 0.0;
+	uint32_t            results   = 0;
+	uint32_t            correct   = 0;
+
+	if (data == NULL || velocity == NULL)
+	{
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		free(data);
+		acc_iq_velocity_destroy(&velocity);
+		return false;
+	}
+
+	for (uint32_t n = 0; n < sweep_count; n++)
+	{
+		simulate_sweep(data, SIMULATED_LENGTH, distance, &state);
+		acc_iq_velocity_process(velocity, data);
+		distance += speed_mps * dt_s;
+
+		acc_iq_velocity_result_t result;
+
+		/* Skip the first half while the range rate settles */
+		if (n >= sweep_count / 2 && n % RESULT_INTERVAL == 0 && acc_iq_velocity_get_result(velocity, &result))
+		{
+			double error = (double)(result.velocity_mps - speed_mps);
+
+			sum_error += error;
+			sum_sq    += error * error;
+			sum_phase += (double)result.phase_velocity_mps;
+			correct   += fabs(error) < (double)result.max_unambiguous_mps ? 1 : 0;
+			results++;
+		}
+	}
+
+	if (results > 0)
+	{
+		printf("%8.2f %8.2f %10.3f %10.2f mm/s %8.2f mm/s %8.1f %%\n", (double)speed_mps,
+		       (double)(ACC_IQ_VELOCITY_WAVELENGTH_M * SWEEP_RATE_HZ / 4.0f), sum_phase / results,
+		       sum_error / results * 1000.0, sqrt(sum_sq / results) * 1000.0, 100.0 * correct / results);
+	}
+
+	free(data);
+	acc_iq_velocity_destroy(&velocity);
+
+	return true;
+}
+
+
+static void print_usage(char *application_name)
+{
+	fprintf(stderr, "Usage: %s [OPTION]...\n", application_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Measure the processing time per sweep of the IQ velocity estimator against a float phase\n");
+	fprintf(stderr, "difference of every bin, and its accuracy on a simulated reflection moving at constant\n");
+	fprintf(stderr, "speed, also faster than the phase difference measures without aliasing.\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "-h, --help                      this help\n");
+	fprintf(stderr, "-n, --sweeps                    the number of sweeps per timing measurement\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+	static struct option long_options[] =
+	{
+		{"help",             no_argument,       0,      'h'},
+		{"sweeps",           required_argument, 0,      'n'},
+		{NULL,               0,                 NULL,   0}
+	};
+
+	int character_code;
+	int option_index = 0;
+
+	uint32_t sweep_count = DEFAULT_SWEEP_COUNT;
+
+	while ((character_code = getopt_long(argc, argv, "h?n:", long_options, &option_index)) != -1)
+	{
+		switch (character_code)
+		{
+			case 'n':
+			{
+				int value = atoi(optarg);
+
+				if (value < 2 * RESULT_INTERVAL)
+				{
+					fprintf(stderr, "ERROR: Invalid value '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				sweep_count = (uint32_t)value;
+				break;
+			}
+			default:
+			{
+				print_usage(basename(argv[0]));
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	printf("%u sweeps per timing measurement, sweep rate %.0f Hz, result every %u sweeps\n\n", (unsigned int)sweep_count,
+	       (double)SWEEP_RATE_HZ, (unsigned int)RESULT_INTERVAL);
+	printf("%7s %13s %11s %13s %13s %9s %9s\n", "length", "sweep", "per bin", "result", "reference", "speedup",
+	       "load");
+
+	for (uint16_t i = 0; i < DATA_LENGTH_COUNT; i++)
+	{
+		if (!run_timing(data_lengths[i], sweep_count))
+		{
+			return EXIT_FAILURE;
+		}
+	}
+
+	printf("\n%u sweeps, %u bins, step %.2f mm, noise %.0f of amplitude %.0f\n\n", (unsigned int)ACCURACY_SWEEPS,
+	       (unsigned int)SIMULATED_LENGTH, (double)(STEP_LENGTH_M * 1000.0f), (double)NOISE_STD, (double)AMPLITUDE);
+	printf("%8s %8s %10s %15s %13s %10s\n", "speed", "max", "phase", "bias", "rms", "unaliased");
+
+	for (uint16_t i = 0; i < SPEED_COUNT; i++)
+	{
+		if (!run_accuracy(speeds_mps[i]))
+		{
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,92 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <stdint.h>
+#include <string.h>
+
+#include "acc_latency_histogram.h"
+
+
+#define SUB_BUCKET_COUNT ACC_LATENCY_HISTOGRAM_SUB_BUCKET_COUNT
+
+
+/*
+ * Latencies below 2 * SUB_BUCKET_COUNT have a bucket each. Above that the latency is shifted
+ * down to the range SUB_BUCKET_COUNT to 2 * SUB_BUCKET_COUNT - 1, and the shift selects the octave.
+ */
+static uint32_t bucket_index(uint32_t latency_us)
+{
+	uint32_t shift = 0;
+
+	while ((latency_us >> shift) >= 2 * SUB_BUCKET_COUNT)
+	{
+		shift++;
+	}
+
+	return shift * SUB_BUCKET_COUNT + (latency_us >> shift);
+}
+
+
+static uint32_t bucket_upper_limit(uint32_t index)
+{
+	if (index < 2 * SUB_BUCKET_COUNT)
+	{
+		return index;
+	}
+
+	uint32_t shift = index / SUB_BUCKET_COUNT - 1;
+	uint64_t limit = (((uint64_t)(index - shift * SUB_BUCKET_COUNT) + 1) << shift) - 1;
+
+	return limit > UINT32_MAX ? UINT32_MAX : (uint32_t)limit;
+}
+
+
+void acc_latency_histogram_reset(acc_latency_histogram_t *histogram)
+{
+	memset(histogram, 0, sizeof(*histogram));
+}
+
+
+void acc_latency_histogram_record(acc_latency_histogram_t *histogram, uint32_t latency_us)
+{
+	histogram->counts[bucket_index(latency_us)]++;
+	histogram->count++;
+	histogram->sum_us += latency_us;
+
+	if (latency_us > histogram->max_us)
+	{
+		histogram->max_us = latency_us;
+	}
+}
+
+
+uint32_t acc_latency_histogram_percentile(const acc_latency_histogram_t *histogram, float percentile)
+{
+	if (histogram->count == 0)
+	{
+		return 0;
+	}
+
+	/* The rank of the percentile, at least the first latency */
+	uint64_t rank = (uint64_t)((double)percentile / 100.0 * (double)histogram->count + 0.5);
+	uint64_t seen = 0;
+
+	rank = rank < 1 ? 1 : rank;
+
+	for (uint32_t i = 0; i < ACC_LATENCY_HISTOGRAM_BUCKET_COUNT; i++)
+	{
+		seen += histogram->counts[i];
+
+		if (seen >= rank)
+		{
+			uint32_t limit = bucket_upper_limit(i);
+
+			return limit < histogram->max_us ? limit : histogram->max_us;
+		}
+	}
+
+	return histogram->max_us;
+}
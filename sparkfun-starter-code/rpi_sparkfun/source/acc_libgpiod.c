@@ -5,6 +5,7 @@
 // of this source code package.
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <time.h>
 
 #include "gpiod.h"
@@ -21,6 +22,10 @@
 static gpio_pin_t        gpios[GPIO_PIN_COUNT];
 static struct gpiod_chip *chip;
 
+/* CLOCK_MONOTONIC time of the last interrupt edge of each pin */
+static struct timespec interrupt_times[GPIO_PIN_COUNT];
+static bool            interrupt_time_valid[GPIO_PIN_COUNT];
+
 
 static bool gpio_open(int pin, gpio_direction_t direction)
 {
@@ -68,7 +73,8 @@ bool acc_libgpiod_init(const gpio_config_t *pin_config)
 
 	for (pin = 0; pin < GPIO_PIN_COUNT; pin++)
 	{
-		gpios[pin].direction = GPIO_DIR_UNKNOWN;
+		gpios[pin].direction      = GPIO_DIR_UNKNOWN;
+		interrupt_time_valid[pin] = false;
 	}
 
 	chip = gpiod_chip_open_by_name(RPI_GPIO_CHIPNAME);
@@ -139,6 +145,43 @@ static unsigned int get_elapsed_ms(struct timespec *start)
 }
 
 
+static int64_t timespec_diff_ns(const struct timespec *a, const struct timespec *b)
+{
+	return ((int64_t)a->tv_sec - (int64_t)b->tv_sec) * 1000000000 + (a->tv_nsec - b->tv_nsec);
+}
+
+
+/**
+ * Convert an event timestamp to CLOCK_MONOTONIC
+ *
+ * Kernels before 5.7 stamp line events with CLOCK_REALTIME, later kernels with CLOCK_MONOTONIC.
+ * The clock is the one closest to the event.
+ */
+static void event_time_to_monotonic(const struct timespec *event_time, struct timespec *monotonic_time)
+{
+	struct timespec now_monotonic;
+	struct timespec now_realtime;
+
+	clock_gettime(CLOCK_MONOTONIC, &now_monotonic);
+	clock_gettime(CLOCK_REALTIME, &now_realtime);
+
+	int64_t since_monotonic_ns = timespec_diff_ns(&now_monotonic, event_time);
+	int64_t since_realtime_ns  = timespec_diff_ns(&now_realtime, event_time);
+
+	if (llabs(since_realtime_ns) < llabs(since_monotonic_ns))
+	{
+		int64_t time_ns = (int64_t)now_monotonic.tv_sec * 1000000000 + now_monotonic.tv_nsec - since_realtime_ns;
+
+		monotonic_time->tv_sec  = (time_t)(time_ns / 1000000000);
+		monotonic_time->tv_nsec = (long)(time_ns % 1000000000);
+	}
+	else
+	{
+		*monotonic_time = *event_time;
+	}
+}
+
+
 bool acc_libgpiod_wait_for_interrupt(int pin, uint32_t timeout_ms)
 {
 	assert(gpios[pin].direction == GPIO_DIR_INPUT_INTERRUPT);
@@ -149,6 +192,9 @@ bool acc_libgpiod_wait_for_interrupt(int pin, uint32_t timeout_ms)
 	int pin_value = gpiod_line_get_value(gpios[pin].line);
 	assert(pin_value >= 0);
 
+	/* If the pin is already high the edge was before the wait, the start is the closest known time */
+	struct timespec interrupt_time = start;
+
 	unsigned int elapsed_ms = get_elapsed_ms(&start);
 
 	while ((pin_value != PIN_HIGH) && (elapsed_ms < timeout_ms))
@@ -188,6 +234,8 @@ bool acc_libgpiod_wait_for_interrupt(int pin, uint32_t timeout_ms)
 				assert(true);
 			}
 
+			event_time_to_monotonic(&event.ts, &interrupt_time);
+
 			pin_value = gpiod_line_get_value(gpios[pin].line);
 			if (pin_value < 0)
 			{
@@ -198,5 +246,24 @@ bool acc_libgpiod_wait_for_interrupt(int pin, uint32_t timeout_ms)
 
 		elapsed_ms = get_elapsed_ms(&start);
 	}
+
+	if (pin_value == PIN_HIGH)
+	{
+		interrupt_times[pin]      = interrupt_time;
+		interrupt_time_valid[pin] = true;
+	}
+
 	return pin_value == PIN_HIGH;
 }
+
+
+bool acc_libgpiod_get_interrupt_time(int pin, struct timespec *time)
+{
+	if (!interrupt_time_valid[pin])
+	{
+		return false;
+	}
+
+	*time = interrupt_times[pin];
+	return true;
+}
@@ -14,6 +14,7 @@
 #include <linux/spi/spidev.h>
 #include <stdio.h>
 #include <sys/ioctl.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "acc_libspi.h"
@@ -22,28 +23,64 @@
 #define SPIDEV_PATH      "/dev/spidev%u.%u"
 #define ACC_BOARD_SPI_CS 0
 
-static int spi_fd = -1;
+static int  spi_fd[ACC_LIBSPI_MAX_DEVICES];
+static bool spi_initialized = false;
+
+static acc_libspi_statistics_t transfer_statistics;
+
+
+static uint64_t get_time_us(void)
+{
+	struct timespec time_ts = {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &time_ts);
+	return (uint64_t)time_ts.tv_sec * 1000000 + (uint64_t)time_ts.tv_nsec / 1000;
+}
 
 
 bool acc_libspi_init(void)
+{
+	for (uint8_t cs = 0; cs < ACC_LIBSPI_MAX_DEVICES; cs++)
+	{
+		spi_fd[cs] = -1;
+	}
+
+	spi_initialized = true;
+
+	return acc_libspi_init_device(ACC_BOARD_SPI_CS);
+}
+
+
+bool acc_libspi_init_device(uint8_t cs)
 {
 	uint32_t mode   = SPI_MODE_0;
 	bool     result = true;
 	char     spidev[sizeof(SPIDEV_PATH) + 2];
 
-	snprintf(spidev, sizeof(spidev), SPIDEV_PATH, ACC_BOARD_SPI_BUS, ACC_BOARD_SPI_CS);
+	if (!spi_initialized || cs >= ACC_LIBSPI_MAX_DEVICES)
+	{
+		printf("Invalid SPI chip select %u\n", cs);
+		return false;
+	}
+
+	if (spi_fd[cs] >= 0)
+	{
+		return true;
+	}
+
+	snprintf(spidev, sizeof(spidev), SPIDEV_PATH, ACC_BOARD_SPI_BUS, cs);
 
-	spi_fd = open(spidev, O_RDWR);
+	spi_fd[cs] = open(spidev, O_RDWR);
 
-	if (spi_fd < 0)
+	if (spi_fd[cs] < 0)
 	{
-		printf("Unable to open SPI (%u, %u): %s\n", ACC_BOARD_SPI_BUS, ACC_BOARD_SPI_CS, strerror(errno));
+		printf("Unable to open SPI (%u, %u): %s\n", ACC_BOARD_SPI_BUS, cs, strerror(errno));
 		result = false;
 	}
 
 	if (result)
 	{
-		if (ioctl(spi_fd, SPI_IOC_RD_MODE32, &mode) < 0)
+		if (ioctl(spi_fd[cs], SPI_IOC_RD_MODE32, &mode) < 0)
 		{
 			printf("Could not set SPI (read) mode %u\n", mode);
 			result = false;
@@ -52,28 +89,46 @@ bool acc_libspi_init(void)
 
 	if (result)
 	{
-		if (ioctl(spi_fd, SPI_IOC_WR_MODE32, &mode) < 0)
+		if (ioctl(spi_fd[cs], SPI_IOC_WR_MODE32, &mode) < 0)
 		{
 			printf("Could not set SPI (write) mode %u\n", mode);
 			result = false;
 		}
 	}
 
+	/* A half configured chip select is closed, so that the next init opens it again */
+	if (!result && spi_fd[cs] >= 0)
+	{
+		close(spi_fd[cs]);
+		spi_fd[cs] = -1;
+	}
+
 	return result;
 }
 
 
 void acc_libspi_deinit(void)
 {
-	if (spi_fd >= 0)
+	for (uint8_t cs = 0; cs < ACC_LIBSPI_MAX_DEVICES; cs++)
 	{
-		close(spi_fd);
-		spi_fd = -1;
+		if (spi_fd[cs] >= 0)
+		{
+			close(spi_fd[cs]);
+			spi_fd[cs] = -1;
+		}
 	}
+
+	spi_initialized = false;
 }
 
 
 bool acc_libspi_transfer(uint32_t speed, uint8_t *buffer, size_t buffer_size)
+{
+	return acc_libspi_transfer_device(ACC_BOARD_SPI_CS, speed, buffer, buffer_size);
+}
+
+
+bool acc_libspi_transfer_device(uint8_t cs, uint32_t speed, uint8_t *buffer, size_t buffer_size)
 {
 	bool                    result       = true;
 	struct spi_ioc_transfer spi_transfer = {
@@ -87,7 +142,23 @@ bool acc_libspi_transfer(uint32_t speed, uint8_t *buffer, size_t buffer_size)
 		.pad           = 0,
 	};
 
-	int ret_val = ioctl(spi_fd, SPI_IOC_MESSAGE(1), &spi_transfer);
+	if (!spi_initialized || cs >= ACC_LIBSPI_MAX_DEVICES || spi_fd[cs] < 0)
+	{
+		printf("SPI chip select %u not initialized\n", cs);
+		return false;
+	}
+
+	uint64_t start_us = get_time_us();
+	int      ret_val  = ioctl(spi_fd[cs], SPI_IOC_MESSAGE(1), &spi_transfer);
+	uint32_t time_us  = (uint32_t)(get_time_us() - start_us);
+
+	transfer_statistics.transfer_count++;
+	transfer_statistics.transfer_bytes         += buffer_size;
+	transfer_statistics.transfer_time_total_us += time_us;
+	if (time_us > transfer_statistics.transfer_time_max_us)
+	{
+		transfer_statistics.transfer_time_max_us = time_us;
+	}
 
 	if (ret_val < 0)
 	{
@@ -97,3 +168,9 @@ bool acc_libspi_transfer(uint32_t speed, uint8_t *buffer, size_t buffer_size)
 
 	return result;
 }
+
+
+void acc_libspi_get_statistics(acc_libspi_statistics_t *statistics)
+{
+	*statistics = transfer_statistics;
+}
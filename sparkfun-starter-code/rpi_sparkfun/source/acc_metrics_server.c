@@ -0,0 +1,288 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <errno.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "acc_metrics_server.h"
+
+#define RATE_INTERVAL_MS   (1000)
+#define REQUEST_TIMEOUT_MS (100)
+#define REQUEST_MAX_SIZE   (1024)
+#define RESPONSE_MAX_SIZE  (4096)
+
+
+static pthread_t       metrics_thread;
+static pthread_mutex_t metrics_mutex = PTHREAD_MUTEX_INITIALIZER;
+static acc_metrics_t   metrics_snapshot;
+static int             metrics_socket  = -1;
+static volatile bool   metrics_running = false;
+
+/* Per second rates, only touched by the metrics thread */
+static acc_metrics_t rate_previous;
+static uint64_t      frames_produced_per_second;
+static uint64_t      frames_sent_per_second;
+static uint64_t      bytes_out_per_second;
+static uint64_t      loop_time_avg_us;
+static uint64_t      spi_time_avg_us;
+
+
+static uint64_t get_time_ms(void)
+{
+	struct timespec time_ts = {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &time_ts);
+	return (uint64_t)time_ts.tv_sec * 1000 + (uint64_t)time_ts.tv_nsec / 1000000;
+}
+
+
+static void get_snapshot(acc_metrics_t *metrics)
+{
+	pthread_mutex_lock(&metrics_mutex);
+	*metrics = metrics_snapshot;
+	pthread_mutex_unlock(&metrics_mutex);
+}
+
+
+static uint64_t average(uint64_t total, uint64_t previous_total, uint64_t count, uint64_t previous_count)
+{
+	return count > previous_count ? (total - previous_total) / (count - previous_count) : 0;
+}
+
+
+static void update_rates(uint64_t interval_ms)
+{
+	acc_metrics_t current;
+
+	get_snapshot(&current);
+
+	frames_produced_per_second = (current.frames_produced_total - rate_previous.frames_produced_total) * 1000 / interval_ms;
+	frames_sent_per_second     = (current.frames_sent_total - rate_previous.frames_sent_total) * 1000 / interval_ms;
+	bytes_out_per_second       = (current.bytes_out_total - rate_previous.bytes_out_total) * 1000 / interval_ms;
+	loop_time_avg_us           = average(current.loop_time_total_us, rate_previous.loop_time_total_us,
+	                                     current.loop_iterations_total, rate_previous.loop_iterations_total);
+	spi_time_avg_us            = average(current.spi_time_total_us, rate_previous.spi_time_total_us,
+	                                     current.spi_transfers_total, rate_previous.spi_transfers_total);
+
+	rate_previous = current;
+}
+
+
+static size_t format_metrics(char *buffer, size_t buffer_size)
+{
+	acc_metrics_t m;
+
+	get_snapshot(&m);
+
+	int length = snprintf(buffer, buffer_size,
+	                      "frames_produced_total %" PRIu64 "\n"
+	                      "frames_produced_per_second %" PRIu64 "\n"
+	                      "frames_sent_total %" PRIu64 "\n"
+	                      "frames_sent_per_second %" PRIu64 "\n"
+	                      "udp_frames_sent_total %" PRIu64 "\n"
+	                      "bytes_out_total %" PRIu64 "\n"
+	                      "bytes_out_per_second %" PRIu64 "\n"
+	                      "queue_depth_bytes %" PRIu32 "\n"
+	                      "client_count %" PRIu32 "\n"
+	                      "clients_connected_total %" PRIu64 "\n"
+	                      "missed_data_total %" PRIu64 "\n"
+	                      "data_quality_warning_total %" PRIu64 "\n"
+	                      "data_saturated_total %" PRIu64 "\n"
+	                      "loop_iterations_total %" PRIu64 "\n"
+	                      "loop_time_avg_us %" PRIu64 "\n"
+	                      "loop_time_max_us %" PRIu32 "\n"
+	                      "spi_transfers_total %" PRIu64 "\n"
+	                      "spi_bytes_total %" PRIu64 "\n"
+	                      "spi_time_total_us %" PRIu64 "\n"
+	                      "spi_time_avg_us %" PRIu64 "\n"
+	                      "spi_time_max_us %" PRIu32 "\n",
+	                      m.frames_produced_total, frames_produced_per_second,
+	                      m.frames_sent_total, frames_sent_per_second,
+	                      m.udp_frames_sent_total,
+	                      m.bytes_out_total, bytes_out_per_second,
+	                      m.queue_depth_bytes,
+	                      m.client_count, m.clients_connected_total,
+	                      m.missed_data_total, m.data_quality_warning_total, m.data_saturated_total,
+	                      m.loop_iterations_total, loop_time_avg_us, m.loop_time_max_us,
+	                      m.spi_transfers_total, m.spi_bytes_total, m.spi_time_total_us, spi_time_avg_us,
+	                      m.spi_time_max_us);
+
+	if (length < 0)
+	{
+		return 0;
+	}
+
+	return (size_t)length < buffer_size ? (size_t)length : buffer_size - 1;
+}
+
+
+static void write_all(int socket_fd, const char *data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t written = write(socket_fd, data, size);
+
+		if (written <= 0)
+		{
+			return;
+		}
+
+		data += written;
+		size -= (size_t)written;
+	}
+}
+
+
+static void serve_client(int client_socket)
+{
+	char          request[REQUEST_MAX_SIZE];
+	char          body[RESPONSE_MAX_SIZE];
+	char          header[128];
+	ssize_t       request_length = 0;
+	struct pollfd poll_set       = {
+		.fd     = client_socket,
+		.events = POLLIN,
+	};
+
+	/* A line protocol client may not send anything, only wait a short while for a request */
+	if (poll(&poll_set, 1, REQUEST_TIMEOUT_MS) > 0)
+	{
+		request_length = read(client_socket, request, sizeof(request) - 1);
+	}
+
+	size_t body_length = format_metrics(body, sizeof(body));
+
+	if (request_length >= 4 && strncmp(request, "GET ", 4) == 0)
+	{
+		int header_length = snprintf(header, sizeof(header),
+		                             "HTTP/1.0 200 OK\r\n"
+		                             "Content-Type: text/plain; version=0.0.4\r\n"
+		                             "Content-Length: %zu\r\n"
+		                             "Connection: close\r\n"
+		                             "\r\n", body_length);
+
+		write_all(client_socket, header, (size_t)header_length);
+	}
+
+	write_all(client_socket, body, body_length);
+}
+
+
+static void *metrics_thread_main(void *arg)
+{
+	(void)arg;
+
+	uint64_t      last_rate_ms = get_time_ms();
+	struct pollfd poll_set     = {
+		.fd     = metrics_socket,
+		.events = POLLIN,
+	};
+
+	while (metrics_running)
+	{
+		uint64_t now_ms  = get_time_ms();
+		uint64_t wait_ms = now_ms - last_rate_ms < RATE_INTERVAL_MS ? RATE_INTERVAL_MS - (now_ms - last_rate_ms) : 0;
+
+		int nof_events = poll(&poll_set, 1, (int)wait_ms);
+
+		now_ms = get_time_ms();
+		if (now_ms - last_rate_ms >= RATE_INTERVAL_MS)
+		{
+			update_rates(now_ms - last_rate_ms);
+			last_rate_ms = now_ms;
+		}
+
+		if (nof_events > 0 && (poll_set.revents & POLLIN))
+		{
+			int client_socket = accept(metrics_socket, NULL, NULL);
+
+			if (client_socket >= 0)
+			{
+				serve_client(client_socket);
+				close(client_socket);
+			}
+		}
+	}
+
+	return NULL;
+}
+
+
+bool acc_metrics_server_start(int port)
+{
+	struct sockaddr_in addr;
+
+	if ((metrics_socket = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+	{
+		fprintf(stderr, "ERROR: socket(AF_INET, SOCK_STREAM, 0): (%u) %s\n", errno, strerror(errno));
+		return false;
+	}
+
+	if (setsockopt(metrics_socket, SOL_SOCKET, SO_REUSEADDR, &(int){1 }, sizeof(int)) < 0)
+	{
+		fprintf(stderr, "ERROR: setsockopt(SO_REUSEADDR): (%u) %s\n", errno, strerror(errno));
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family      = AF_INET;
+	addr.sin_addr.s_addr = INADDR_ANY;
+	addr.sin_port        = htons(port);
+
+	if (bind(metrics_socket, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(metrics_socket, 4) < 0)
+	{
+		fprintf(stderr, "ERROR: bind()/listen(): (%u) %s\n", errno, strerror(errno));
+		close(metrics_socket);
+		metrics_socket = -1;
+		return false;
+	}
+
+	metrics_running = true;
+
+	if (pthread_create(&metrics_thread, NULL, metrics_thread_main, NULL) != 0)
+	{
+		fprintf(stderr, "ERROR: Could not create metrics thread\n");
+		metrics_running = false;
+		close(metrics_socket);
+		metrics_socket = -1;
+		return false;
+	}
+
+	return true;
+}
+
+
+void acc_metrics_server_stop(void)
+{
+	if (metrics_running)
+	{
+		metrics_running = false;
+		pthread_join(metrics_thread, NULL);
+	}
+
+	if (metrics_socket >= 0)
+	{
+		close(metrics_socket);
+		metrics_socket = -1;
+	}
+}
+
+
+void acc_metrics_server_update(const acc_metrics_t *metrics)
+{
+	pthread_mutex_lock(&metrics_mutex);
+	metrics_snapshot = *metrics;
+	pthread_mutex_unlock(&metrics_mutex);
+}
@@ -0,0 +1,165 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "acc_parking_detection.h"
+#include "acc_service_envelope.h"
+#include "acc_sliding_window.h"
+
+
+bool acc_parking_profile_setup(acc_parking_profile_t *profile, const acc_service_envelope_metadata_t *metadata,
+                               uint16_t leak_sample_index, uint16_t leak_end_index)
+{
+	profile->length       = metadata->data_length;
+	profile->range        = malloc(profile->length * sizeof(*profile->range));
+	profile->leak_profile = malloc(profile->length * sizeof(*profile->leak_profile));
+
+	if (profile->range == NULL || profile->leak_profile == NULL)
+	{
+		acc_parking_profile_release(profile);
+		return false;
+	}
+
+	float leak_length = (float)(leak_end_index - leak_sample_index);
+
+	for (uint16_t i = 0; i < profile->length; i++)
+	{
+		profile->range[i]        = metadata->start_m + i * metadata->step_length_m;
+		profile->leak_profile[i] = i <= leak_end_index ? (float)(leak_end_index - i) / leak_length : 0.0f;
+	}
+
+	return true;
+}
+
+
+void acc_parking_profile_release(acc_parking_profile_t *profile)
+{
+	free(profile->range);
+	free(profile->leak_profile);
+	profile->range        = NULL;
+	profile->leak_profile = NULL;
+	profile->length       = 0;
+}
+
+
+void acc_parking_weight_sums(const acc_parking_profile_t *profile, const uint16_t *data, float background_level,
+                             float leak_amplitude, float *weight_sum, float *weight_sum_r)
+{
+	float    inverse_level = 1.0f / background_level;
+	float    sum           = 0.0f;
+	float    sum_r         = 0.0f;
+	uint16_t i             = 0;
+
+#if defined(__ARM_NEON)
+	float32x4_t level_v   = vdupq_n_f32(background_level);
+	float32x4_t inverse_v = vdupq_n_f32(inverse_level);
+	float32x4_t leak_v    = vdupq_n_f32(leak_amplitude);
+	float32x4_t zero_v    = vdupq_n_f32(0.0f);
+	float32x4_t one_v     = vdupq_n_f32(1.0f);
+	float32x4_t sum_v     = zero_v;
+	float32x4_t sum_r_v   = zero_v;
+
+	for (; i + 4 <= profile->length; i += 4)
+	{
+		float32x4_t amplitude = vcvtq_f32_u32(vmovl_u16(vld1_u16(&data[i])));
+		float32x4_t range     = vld1q_f32(&profile->range[i]);
+		float32x4_t bg        = vmlaq_f32(level_v, leak_v, vld1q_f32(&profile->leak_profile[i]));
+		float32x4_t above_bg  = vmaxq_f32(vsubq_f32(amplitude, bg), zero_v);
+		float32x4_t weight    = vminq_f32(vmulq_f32(above_bg, inverse_v), one_v);
+
+		weight  = vmulq_f32(vmulq_f32(weight, above_bg), range);
+		sum_v   = vaddq_f32(sum_v, weight);
+		sum_r_v = vmlaq_f32(sum_r_v, weight, range);
+	}
+
+	float32x2_t sum_pair   = vadd_f32(vget_low_f32(sum_v), vget_high_f32(sum_v));
+	float32x2_t sum_r_pair = vadd_f32(vget_low_f32(sum_r_v), vget_high_f32(sum_r_v));
+
+	sum   = vget_lane_f32(vpadd_f32(sum_pair, sum_pair), 0);
+	sum_r = vget_lane_f32(vpadd_f32(sum_r_pair, sum_r_pair), 0);
+#else
+	/* Four independent sums, the same lanes as the NEON version, lets the compiler vectorize */
+	float lane_sum[4]   = { 0.0f };
+	float lane_sum_r[4] = { 0.0f };
+
+	for (; i + 4 <= profile->length; i += 4)
+	{
+		for (uint16_t lane = 0; lane < 4; lane++)
+		{
+			float r        = profile->range[i + lane];
+			float above_bg = (float)data[i + lane] - (background_level + leak_amplitude * profile->leak_profile[i + lane]);
+
+			above_bg = above_bg > 0.0f ? above_bg : 0.0f;
+
+			float weight = above_bg * inverse_level;
+
+			weight = weight < 1.0f ? weight : 1.0f;
+			weight = weight * above_bg * r;
+
+			lane_sum[lane]   += weight;
+			lane_sum_r[lane] += weight * r;
+		}
+	}
+
+	sum   = (lane_sum[0] + lane_sum[1]) + (lane_sum[2] + lane_sum[3]);
+	sum_r = (lane_sum_r[0] + lane_sum_r[1]) + (lane_sum_r[2] + lane_sum_r[3]);
+#endif
+
+	/* Remaining bins */
+	for (; i < profile->length; i++)
+	{
+		float r        = profile->range[i];
+		float above_bg = (float)data[i] - (background_level + leak_amplitude * profile->leak_profile[i]);
+
+		above_bg = above_bg > 0.0f ? above_bg : 0.0f;
+
+		float weight = above_bg * inverse_level;
+
+		weight = weight < 1.0f ? weight : 1.0f;
+		weight = weight * above_bg * r;
+
+		sum   += weight;
+		sum_r += weight * r;
+	}
+
+	*weight_sum   = sum;
+	*weight_sum_r = sum_r;
+}
+
+
+bool acc_parking_detection_update(const acc_parking_profile_t *profile,
+                                  const acc_parking_detection_parameters_t *parameters,
+                                  uint16_t leak_sample_index, acc_parking_observations_t *observations,
+                                  const uint16_t *data)
+{
+	float    weight_sum     = 0.0f;
+	float    weight_sum_r   = 0.0f;
+	uint16_t leak_amplitude = parameters->max_leak_amplitude < data[leak_sample_index] ?
+	                          parameters->max_leak_amplitude : data[leak_sample_index];
+	uint16_t a_leak = leak_amplitude < parameters->background_level ? 0 : leak_amplitude - parameters->background_level;
+
+	acc_parking_weight_sums(profile, data, parameters->background_level, a_leak, &weight_sum, &weight_sum_r);
+
+	acc_sliding_window_add(observations->weight, weight_sum / profile->length);
+	acc_sliding_window_add(observations->distance, weight_sum_r / weight_sum);
+
+	float weight_min   = acc_sliding_window_get_min(observations->weight);
+	float weight_max   = acc_sliding_window_get_max(observations->weight);
+	float distance_min = acc_sliding_window_get_min(observations->distance);
+	float distance_max = acc_sliding_window_get_max(observations->distance);
+
+	return acc_sliding_window_is_full(observations->weight) &&
+	       weight_min >= parameters->weight_threshold &&
+	       weight_max / weight_min <= parameters->weight_ratio_limit &&
+	       distance_max - distance_min <= parameters->displacement_limit;
+}
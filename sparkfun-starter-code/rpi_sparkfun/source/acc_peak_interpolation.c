@@ -0,0 +1,134 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <math.h>
+#include <stdint.h>
+
+#include "acc_peak_interpolation.h"
+
+
+// The number of bins a distance is moved to find the highest bin next to it
+#define MAX_CLIMB_BINS 2
+
+
+static float sample_value(acc_peak_interpolation_method_t method, uint16_t value)
+{
+	if (method == ACC_PEAK_INTERPOLATION_GAUSSIAN)
+	{
+		return logf(value > 0 ? (float)value : 1.0f);
+	}
+
+	return (float)value;
+}
+
+
+float acc_peak_interpolation_offset(acc_peak_interpolation_method_t method, const uint16_t *data, uint16_t data_length,
+                                    uint16_t index, uint16_t half_width)
+{
+	int32_t k = half_width;
+
+	if (method == ACC_PEAK_INTERPOLATION_NONE || index >= data_length)
+	{
+		return 0.0f;
+	}
+
+	if (k > index)
+	{
+		k = index;
+	}
+
+	if (k > data_length - 1 - index)
+	{
+		k = data_length - 1 - index;
+	}
+
+	if (k < 1)
+	{
+		return 0.0f;
+	}
+
+	/*
+	 * Least squares fit of y = b0 + b1 * x + b2 * (x^2 - mean(x^2)) over x = -k..k, the odd and even
+	 * terms are orthogonal on the symmetric span so each coefficient is a single projection.
+	 */
+	float count    = (float)(2 * k + 1);
+	float sum_x2   = (float)(k * (k + 1) * (2 * k + 1)) / 3.0f;
+	float sum_x4   = (float)(k * (k + 1) * (2 * k + 1) * (3 * k * k + 3 * k - 1)) / 15.0f;
+	float mean_x2  = sum_x2 / count;
+	float odd_sum  = 0.0f;
+	float even_sum = 0.0f;
+	float center   = sample_value(method, data[index]);
+
+	for (int32_t x = 1; x <= k; x++)
+	{
+		float lower = sample_value(method, data[index - x]) - center;
+		float upper = sample_value(method, data[index + x]) - center;
+
+		odd_sum  += (float)x * (upper - lower);
+		even_sum += ((float)(x * x) - mean_x2) * (upper + lower);
+	}
+
+	float b1 = odd_sum / sum_x2;
+	float b2 = even_sum / (sum_x4 - count * mean_x2 * mean_x2);
+
+	if (b2 >= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	float offset = -b1 / (2.0f * b2);
+
+	if (offset > (float)k)
+	{
+		offset = (float)k;
+	}
+	else if (offset < -(float)k)
+	{
+		offset = -(float)k;
+	}
+
+	return offset;
+}
+
+
+float acc_peak_interpolation_refine_distance(acc_peak_interpolation_method_t method, const uint16_t *data,
+                                             uint16_t data_length, float start_m, float step_length_m,
+                                             uint16_t half_width, float distance_m)
+{
+	if (data_length == 0 || step_length_m <= 0.0f)
+	{
+		return distance_m;
+	}
+
+	float position = (distance_m - start_m) / step_length_m + 0.5f;
+
+	if (position < 0.0f || position >= (float)data_length)
+	{
+		return distance_m;
+	}
+
+	uint16_t index = (uint16_t)position;
+
+	for (uint16_t i = 0; i < MAX_CLIMB_BINS; i++)
+	{
+		if (index > 0 && data[index - 1] > data[index])
+		{
+			index--;
+		}
+		else if (index + 1 < data_length && data[index + 1] > data[index])
+		{
+			index++;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	float offset = acc_peak_interpolation_offset(method, data, data_length, index, half_width);
+
+	return start_m + ((float)index + offset) * step_length_m;
+}
@@ -0,0 +1,460 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <getopt.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "acc_benchmark_util.h"
+#include "acc_peak_interpolation.h"
+
+
+// The envelope step length without downsampling
+#define BASE_STEP_LENGTH_M (0.000484f)
+
+// Synthetic envelopes, a pulse on the noise normalized background level
+#define DEFAULT_PULSE_WIDTH_M (0.06f)
+#define DEFAULT_AMPLITUDE     (2000.0f)
+#define DEFAULT_NOISE         (20.0f)
+#define BACKGROUND_LEVEL      (100.0f)
+#define SYNTHETIC_START_M     (0.2f)
+#define SYNTHETIC_LENGTH_M    (0.6f)
+#define SYNTHETIC_PEAK_COUNT  (20000)
+
+#define MAX_DATA_LENGTH    (4096)
+#define MAX_RECORDED_COUNT (10000)
+
+static const uint16_t downsampling_factors[] = { 1, 2, 4 };
+
+#define DOWNSAMPLING_COUNT (sizeof(downsampling_factors) / sizeof(downsampling_factors[0]))
+
+typedef struct
+{
+	acc_peak_interpolation_method_t method;
+	const char                      *name;
+	bool                            wide;
+} variant_t;
+
+static const variant_t variants[] =
+{
+	{ACC_PEAK_INTERPOLATION_NONE,      "bin",       false},
+	{ACC_PEAK_INTERPOLATION_PARABOLIC, "parabolic", false},
+	{ACC_PEAK_INTERPOLATION_GAUSSIAN,  "gaussian",  false},
+	{ACC_PEAK_INTERPOLATION_PARABOLIC, "parabolic", true},
+	{ACC_PEAK_INTERPOLATION_GAUSSIAN,  "gaussian",  true},
+};
+
+#define VARIANT_COUNT (sizeof(variants) / sizeof(variants[0]))
+
+
+/**
+ * @brief The fit half width covering the upper half of the pulse, the three point fit for narrow pulses
+ */
+static uint16_t wide_half_width(float pulse_width_m, float step_length_m)
+{
+	uint16_t half_width = (uint16_t)(pulse_width_m / 4.0f / step_length_m + 0.5f);
+
+	return half_width < 1 ? 1 : half_width;
+}
+
+
+static void print_header(void)
+{
+	printf("%-12s %-10s %5s %10s %10s %10s\n", "step", "method", "width", "rms", "max", "time");
+}
+
+
+static void print_row(float step_length_m, const variant_t *variant, uint16_t half_width, double sum_squares,
+                      double max_error, uint32_t count, uint64_t time_ns)
+{
+	printf("%7.3f mm   %-10s %5u %7.3f mm %7.3f mm %7.1f ns\n", (double)step_length_m * 1000.0, variant->name,
+	       (unsigned int)half_width, sqrt(sum_squares / count) * 1000.0, max_error * 1000.0,
+	       (double)time_ns / count);
+}
+
+
+static bool run_synthetic(float pulse_width_m, float amplitude, float noise)
+{
+	float    *distances = malloc(SYNTHETIC_PEAK_COUNT * sizeof(*distances));
+	float    *refined   = malloc(SYNTHETIC_PEAK_COUNT * sizeof(*refined));
+	uint16_t *frames    = NULL;
+
+	if (distances == NULL || refined == NULL)
+	{
+		fprintf(stderr, "ERROR: Could not allocate data\n");
+		free(refined);
+		free(distances);
+		return false;
+	}
+
+	printf("Pulse width %.3f m, amplitude %.0f, noise %.1f, %u peaks\n\n", (double)pulse_width_m, (double)amplitude,
+	       (double)noise, (unsigned int)SYNTHETIC_PEAK_COUNT);
+	print_header();
+
+	bool  result = true;
+	float sigma  = pulse_width_m / 2.3548f;
+
+	for (uint16_t d = 0; result && d < DOWNSAMPLING_COUNT; d++)
+	{
+		float    step_length_m = BASE_STEP_LENGTH_M * (float)downsampling_factors[d];
+		uint16_t data_length   = (uint16_t)(SYNTHETIC_LENGTH_M / step_length_m) + 1;
+		uint32_t state         = 1;
+
+		/* One envelope per peak, generated before timing */
+		free(frames);
+		frames = malloc((size_t)SYNTHETIC_PEAK_COUNT * data_length * sizeof(*frames));
+
+		if (frames == NULL)
+		{
+			fprintf(stderr, "ERROR: Could not allocate data\n");
+			result = false;
+			break;
+		}
+
+		for (uint32_t n = 0; n < SYNTHETIC_PEAK_COUNT; n++)
+		{
+			float     distance_m = SYNTHETIC_START_M +
+			                       SYNTHETIC_LENGTH_M * (0.25f + 0.5f * acc_benchmark_next_uniform(&state));
+			uint16_t *frame      = &frames[(size_t)n * data_length];
+
+			distances[n] = distance_m;
+
+			for (uint16_t i = 0; i < data_length; i++)
+			{
+				float x     = (SYNTHETIC_START_M + (float)i * step_length_m - distance_m) / sigma;
+				float value = BACKGROUND_LEVEL + amplitude * expf(-0.5f * x * x) + noise * acc_benchmark_next_noise(&state);
+
+				frame[i] = value < 0.0f ? 0 : (uint16_t)(value + 0.5f);
+			}
+		}
+
+		for (uint16_t v = 0; v < VARIANT_COUNT; v++)
+		{
+			const variant_t *variant    = &variants[v];
+			uint16_t        half_width  = variant->wide ? wide_half_width(pulse_width_m, step_length_m) : 1;
+			double          sum_squares = 0.0;
+			double          max_error   = 0.0;
+
+			if (variant->wide && half_width == 1)
+			{
+				continue;
+			}
+
+			/* The detector reports the highest bin, refinement is timed separately */
+			for (uint32_t n = 0; n < SYNTHETIC_PEAK_COUNT; n++)
+			{
+				const uint16_t *frame = &frames[(size_t)n * data_length];
+				uint16_t       peak   = 0;
+
+				for (uint16_t i = 1; i < data_length; i++)
+				{
+					peak = frame[i] > frame[peak] ? i : peak;
+				}
+
+				refined[n] = SYNTHETIC_START_M + (float)peak * step_length_m;
+			}
+
+			uint64_t start_ns = acc_benchmark_get_time_ns();
+
+			for (uint32_t n = 0; n < SYNTHETIC_PEAK_COUNT; n++)
+			{
+				refined[n] = acc_peak_interpolation_refine_distance(variant->method, &frames[(size_t)n * data_length],
+				                                                    data_length, SYNTHETIC_START_M, step_length_m,
+				                                                    half_width, refined[n]);
+			}
+
+			uint64_t elapsed_ns = acc_benchmark_get_time_ns() - start_ns;
+
+			for (uint32_t n = 0; n < SYNTHETIC_PEAK_COUNT; n++)
+			{
+				double error = fabs((double)refined[n] - (double)distances[n]);
+
+				sum_squares += error * error;
+				max_error    = error > max_error ? error : max_error;
+			}
+
+			print_row(step_length_m, variant, half_width, sum_squares, max_error, SYNTHETIC_PEAK_COUNT, elapsed_ns);
+		}
+	}
+
+	free(frames);
+	free(refined);
+	free(distances);
+
+	return result;
+}
+
+
+static uint32_t read_recording(const char *path, uint16_t *frames, uint16_t *data_length)
+{
+	FILE *file = fopen(path, "r");
+
+	if (file == NULL)
+	{
+		fprintf(stderr, "ERROR: Could not open '%s'\n", path);
+		return 0;
+	}
+
+	static char line[MAX_DATA_LENGTH * 7];
+	uint32_t    count = 0;
+
+	*data_length = 0;
+
+	while (count < MAX_RECORDED_COUNT && fgets(line, sizeof(line), file) != NULL)
+	{
+		uint16_t length = 0;
+		char     *next  = line;
+		char     *end;
+
+		for (long value = strtol(next, &end, 10); end != next && length < MAX_DATA_LENGTH;
+		     value = strtol(next, &end, 10))
+		{
+			frames[(size_t)count * MAX_DATA_LENGTH + length++] = value < 0 ? 0 : (value > UINT16_MAX ? UINT16_MAX : (uint16_t)value);
+			next = end;
+		}
+
+		if (length == 0)
+		{
+			continue;
+		}
+
+		if (*data_length != 0 && length != *data_length)
+		{
+			fprintf(stderr, "ERROR: Frame %u has %u bins, expected %u\n", (unsigned int)count,
+			        (unsigned int)length, (unsigned int)*data_length);
+			count = 0;
+			break;
+		}
+
+		*data_length = length;
+		count++;
+	}
+
+	fclose(file);
+
+	return count;
+}
+
+
+/**
+ * @brief Evaluate interpolation on recorded envelope frames
+ *
+ * The recording has no ground truth. The reference is the wide Gaussian fit at full resolution
+ * and every second or fourth bin is used to simulate a coarser configuration. The jitter is the
+ * standard deviation of the refined distance over the recording, for a static scene it is the
+ * noise of the distance.
+ */
+static bool run_recorded(const char *path, uint16_t recorded_downsampling, float pulse_width_m)
+{
+	uint16_t *frames       = malloc((size_t)MAX_RECORDED_COUNT * MAX_DATA_LENGTH * sizeof(*frames));
+	uint16_t *coarse       = malloc((size_t)MAX_RECORDED_COUNT * MAX_DATA_LENGTH * sizeof(*coarse));
+	float    *references   = malloc(MAX_RECORDED_COUNT * sizeof(*references));
+	float    *refined      = malloc(MAX_RECORDED_COUNT * sizeof(*refined));
+	uint16_t data_length   = 0;
+	uint32_t frame_count   = 0;
+	float    step_length_m = BASE_STEP_LENGTH_M * (float)recorded_downsampling;
+
+	if (frames == NULL || coarse == NULL || references == NULL || refined == NULL)
+	{
+		fprintf(stderr, "ERROR: Could not allocate data\n");
+	}
+	else
+	{
+		frame_count = read_recording(path, frames, &data_length);
+	}
+
+	if (frame_count == 0 || data_length < 3)
+	{
+		fprintf(stderr, "ERROR: No envelope frames in '%s'\n", path);
+		free(refined);
+		free(references);
+		free(coarse);
+		free(frames);
+		return false;
+	}
+
+	printf("%u frames of %u bins, distances relative to the first bin\n\n", (unsigned int)frame_count,
+	       (unsigned int)data_length);
+	printf("%-12s %-10s %5s %10s %10s %10s %10s\n", "step", "method", "width", "rms", "max", "jitter", "time");
+
+	for (uint32_t n = 0; n < frame_count; n++)
+	{
+		const uint16_t *frame = &frames[(size_t)n * MAX_DATA_LENGTH];
+		uint16_t       peak   = 0;
+
+		for (uint16_t i = 1; i < data_length; i++)
+		{
+			peak = frame[i] > frame[peak] ? i : peak;
+		}
+
+		references[n] = acc_peak_interpolation_refine_distance(ACC_PEAK_INTERPOLATION_GAUSSIAN, frame, data_length, 0.0f,
+		                                                       step_length_m, wide_half_width(pulse_width_m, step_length_m),
+		                                                       (float)peak * step_length_m);
+	}
+
+	for (uint16_t factor = 1; factor <= 4; factor *= 2)
+	{
+		float    coarse_step_m = step_length_m * (float)factor;
+		uint16_t coarse_length = (uint16_t)((data_length - 1) / factor + 1);
+
+		for (uint16_t v = 0; v < VARIANT_COUNT; v++)
+		{
+			const variant_t *variant    = &variants[v];
+			uint16_t        half_width  = variant->wide ? wide_half_width(pulse_width_m, coarse_step_m) : 1;
+			double          sum_squares = 0.0;
+			double          max_error   = 0.0;
+			double          sum         = 0.0;
+			double          sum_refined = 0.0;
+
+			if (variant->wide && half_width == 1)
+			{
+				continue;
+			}
+
+			for (uint32_t n = 0; n < frame_count; n++)
+			{
+				const uint16_t *frame  = &frames[(size_t)n * MAX_DATA_LENGTH];
+				uint16_t       *target = &coarse[(size_t)n * coarse_length];
+				uint16_t       peak    = 0;
+
+				for (uint16_t i = 0; i < coarse_length; i++)
+				{
+					target[i] = frame[i * factor];
+					peak      = target[i] > target[peak] ? i : peak;
+				}
+
+				refined[n] = (float)peak * coarse_step_m;
+			}
+
+			uint64_t start_ns = acc_benchmark_get_time_ns();
+
+			for (uint32_t n = 0; n < frame_count; n++)
+			{
+				refined[n] = acc_peak_interpolation_refine_distance(variant->method, &coarse[(size_t)n * coarse_length],
+				                                                    coarse_length, 0.0f, coarse_step_m, half_width,
+				                                                    refined[n]);
+			}
+
+			uint64_t elapsed_ns = acc_benchmark_get_time_ns() - start_ns;
+
+			for (uint32_t n = 0; n < frame_count; n++)
+			{
+				double error = fabs((double)refined[n] - (double)references[n]);
+
+				sum_squares += error * error;
+				max_error    = error > max_error ? error : max_error;
+				sum         += (double)refined[n];
+				sum_refined += (double)refined[n] * (double)refined[n];
+			}
+
+			double mean   = sum / frame_count;
+			double jitter = sqrt(fmax(sum_refined / frame_count - mean * mean, 0.0));
+
+			printf("%7.3f mm   %-10s %5u %7.3f mm %7.3f mm %7.3f mm %7.1f ns\n", (double)coarse_step_m * 1000.0,
+			       variant->name, (unsigned int)half_width, sqrt(sum_squares / frame_count) * 1000.0,
+			       max_error * 1000.0, jitter * 1000.0, (double)elapsed_ns / frame_count);
+		}
+	}
+
+	free(refined);
+	free(references);
+	free(coarse);
+	free(frames);
+
+	return true;
+}
+
+
+static void print_usage(char *application_name)
+{
+	fprintf(stderr, "Usage: %s [OPTION]...\n", application_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Measure accuracy and time of sub-bin peak interpolation on synthetic envelopes, or on\n");
+	fprintf(stderr, "envelope frames recorded with acc_service_data_logger -t envelope -f <file>.\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "-h, --help                      this help\n");
+	fprintf(stderr, "-w, --pulse-width               the envelope pulse width in meters, default %.2f\n", (double)DEFAULT_PULSE_WIDTH_M);
+	fprintf(stderr, "-a, --amplitude                 the synthetic pulse amplitude, default %.0f\n", (double)DEFAULT_AMPLITUDE);
+	fprintf(stderr, "-n, --noise                     the synthetic noise standard deviation, default %.0f\n", (double)DEFAULT_NOISE);
+	fprintf(stderr, "-r, --recording                 a recorded envelope file\n");
+	fprintf(stderr, "-d, --downsampling              the downsampling factor of the recording, default 1\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+	static struct option long_options[] =
+	{
+		{"help",             no_argument,       0,      'h'},
+		{"pulse-width",      required_argument, 0,      'w'},
+		{"amplitude",        required_argument, 0,      'a'},
+		{"noise",            required_argument, 0,      'n'},
+		{"recording",        required_argument, 0,      'r'},
+		{"downsampling",     required_argument, 0,      'd'},
+		{NULL,               0,                 NULL,   0}
+	};
+
+	int character_code;
+	int option_index = 0;
+
+	float      pulse_width_m = DEFAULT_PULSE_WIDTH_M;
+	float      amplitude     = DEFAULT_AMPLITUDE;
+	float      noise         = DEFAULT_NOISE;
+	const char *recording    = NULL;
+	int        downsampling  = 1;
+
+	while ((character_code = getopt_long(argc, argv, "h?w:a:n:r:d:", long_options, &option_index)) != -1)
+	{
+		switch (character_code)
+		{
+			case 'w':
+			{
+				pulse_width_m = strtof(optarg, NULL);
+				break;
+			}
+			case 'a':
+			{
+				amplitude = strtof(optarg, NULL);
+				break;
+			}
+			case 'n':
+			{
+				noise = strtof(optarg, NULL);
+				break;
+			}
+			case 'r':
+			{
+				recording = optarg;
+				break;
+			}
+			case 'd':
+			{
+				downsampling = atoi(optarg);
+				break;
+			}
+			default:
+			{
+				print_usage(basename(argv[0]));
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	if (pulse_width_m <= 0.0f || amplitude <= 0.0f || noise < 0.0f || (downsampling != 1 && downsampling != 2 && downsampling != 4))
+	{
+		fprintf(stderr, "ERROR: Invalid options\n");
+		return EXIT_FAILURE;
+	}
+
+	bool result = recording != NULL ? run_recorded(recording, (uint16_t)downsampling, pulse_width_m) :
+	              run_synthetic(pulse_width_m, amplitude, noise);
+
+	return result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
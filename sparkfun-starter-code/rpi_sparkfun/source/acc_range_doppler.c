@@ -0,0 +1,559 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "acc_range_doppler.h"
+
+
+// The A111 radar wavelength
+#define WAVELENGTH_M (0.004955f)
+
+#define MAX_STAGES (8)
+
+#define Q15_ONE (32767)
+#define Q31_ONE (2147483647.0)
+
+#ifndef M_PI
+#define M_PI (3.14159265358979323846)
+#endif
+
+
+struct acc_range_doppler
+{
+	uint16_t sweeps;
+	uint16_t sweep_length;
+	uint16_t lanes;         /**< Transforms side by side, each packs range points j and j + lanes */
+	uint16_t doppler_bins;
+	uint8_t  sweeps_shift;
+	uint8_t  stage_count;
+	uint8_t  stage_radix[MAX_STAGES];
+	float    sweep_rate_hz;
+	float    magnitude_scale;
+	int16_t  *window;       /**< Hann window in Q15 */
+	int32_t  *twiddle_real; /**< exp(-2 pi j k / sweeps) in Q31 */
+	int32_t  *twiddle_imag;
+	uint16_t *order;        /**< The row of each frequency after the transform */
+	int32_t  *mean;
+	int32_t  *real;         /**< sweeps rows of lanes transforms */
+	int32_t  *imag;
+	float    *map;
+};
+
+
+static int32_t q31_multiply(int32_t a, int32_t b)
+{
+	return (int32_t)(((int64_t)a * b) >> 31);
+}
+
+
+/**
+ * @brief Remove the mean of each range point, apply the window and pack the range points in the transforms
+ */
+static void load_frame(struct acc_range_doppler *range_doppler, const uint16_t *frame)
+{
+	uint16_t sweep_length = range_doppler->sweep_length;
+	uint16_t lanes        = range_doppler->lanes;
+	int32_t  *mean        = range_doppler->mean;
+
+	for (uint16_t r = 0; r < sweep_length; r++)
+	{
+		mean[r] = 0;
+	}
+
+	for (uint16_t n = 0; n < range_doppler->sweeps; n++)
+	{
+		const uint16_t *sweep = &frame[n * sweep_length];
+
+		for (uint16_t r = 0; r < sweep_length; r++)
+		{
+			mean[r] += sweep[r];
+		}
+	}
+
+	for (uint16_t r = 0; r < sweep_length; r++)
+	{
+		mean[r] = (mean[r] + (1 << (range_doppler->sweeps_shift - 1))) >> range_doppler->sweeps_shift;
+	}
+
+	for (uint16_t n = 0; n < range_doppler->sweeps; n++)
+	{
+		const uint16_t *sweep = &frame[n * sweep_length];
+		int32_t        window = range_doppler->window[n];
+		int32_t        *real  = &range_doppler->real[n * lanes];
+		int32_t        *imag  = &range_doppler->imag[n * lanes];
+
+		for (uint16_t j = 0; j < lanes; j++)
+		{
+			uint16_t r0 = j;
+			uint16_t r1 = j + lanes;
+
+			real[j] = r0 < sweep_length ? ((sweep[r0] - mean[r0]) * window + (1 << 14)) >> 15 : 0;
+			imag[j] = r1 < sweep_length ? ((sweep[r1] - mean[r1]) * window + (1 << 14)) >> 15 : 0;
+		}
+	}
+}
+
+
+static void radix4_butterfly(struct acc_range_doppler *range_doppler, uint16_t row, uint16_t quarter,
+                             uint16_t twiddle_index)
+{
+	uint16_t lanes = range_doppler->lanes;
+	int32_t  *r0   = &range_doppler->real[row * lanes];
+	int32_t  *r1   = &range_doppler->real[(row + quarter) * lanes];
+	int32_t  *r2   = &range_doppler->real[(row + 2 * quarter) * lanes];
+	int32_t  *r3   = &range_doppler->real[(row + 3 * quarter) * lanes];
+	int32_t  *i0   = &range_doppler->imag[row * lanes];
+	int32_t  *i1   = &range_doppler->imag[(row + quarter) * lanes];
+	int32_t  *i2   = &range_doppler->imag[(row + 2 * quarter) * lanes];
+	int32_t  *i3   = &range_doppler->imag[(row + 3 * quarter) * lanes];
+	int32_t  w1r   = range_doppler->twiddle_real[twiddle_index];
+	int32_t  w1i   = range_doppler->twiddle_imag[twiddle_index];
+	int32_t  w2r   = range_doppler->twiddle_real[2 * twiddle_index];
+	int32_t  w2i   = range_doppler->twiddle_imag[2 * twiddle_index];
+	int32_t  w3r   = range_doppler->twiddle_real[3 * twiddle_index];
+	int32_t  w3i   = range_doppler->twiddle_imag[3 * twiddle_index];
+	bool     twiddle = twiddle_index != 0;
+	uint16_t j       = 0;
+
+#if defined(__ARM_NEON)
+	for (; j + 4 <= lanes; j += 4)
+	{
+		int32x4_t a0r = vld1q_s32(&r0[j]);
+		int32x4_t a1r = vld1q_s32(&r1[j]);
+		int32x4_t a2r = vld1q_s32(&r2[j]);
+		int32x4_t a3r = vld1q_s32(&r3[j]);
+		int32x4_t a0i = vld1q_s32(&i0[j]);
+		int32x4_t a1i = vld1q_s32(&i1[j]);
+		int32x4_t a2i = vld1q_s32(&i2[j]);
+		int32x4_t a3i = vld1q_s32(&i3[j]);
+
+		int32x4_t t0r = vaddq_s32(a0r, a2r);
+		int32x4_t t0i = vaddq_s32(a0i, a2i);
+		int32x4_t t1r = vsubq_s32(a0r, a2r);
+		int32x4_t t1i = vsubq_s32(a0i, a2i);
+		int32x4_t t2r = vaddq_s32(a1r, a3r);
+		int32x4_t t2i = vaddq_s32(a1i, a3i);
+		int32x4_t t3r = vsubq_s32(a1i, a3i);
+		int32x4_t t3i = vsubq_s32(a3r, a1r);
+
+		int32x4_t y1r = vaddq_s32(t1r, t3r);
+		int32x4_t y1i = vaddq_s32(t1i, t3i);
+		int32x4_t y2r = vsubq_s32(t0r, t2r);
+		int32x4_t y2i = vsubq_s32(t0i, t2i);
+		int32x4_t y3r = vsubq_s32(t1r, t3r);
+		int32x4_t y3i = vsubq_s32(t1i, t3i);
+
+		vst1q_s32(&r0[j], vaddq_s32(t0r, t2r));
+		vst1q_s32(&i0[j], vaddq_s32(t0i, t2i));
+
+		if (twiddle)
+		{
+			vst1q_s32(&r1[j], vsubq_s32(vqdmulhq_n_s32(y1r, w1r), vqdmulhq_n_s32(y1i, w1i)));
+			vst1q_s32(&i1[j], vaddq_s32(vqdmulhq_n_s32(y1r, w1i), vqdmulhq_n_s32(y1i, w1r)));
+			vst1q_s32(&r2[j], vsubq_s32(vqdmulhq_n_s32(y2r, w2r), vqdmulhq_n_s32(y2i, w2i)));
+			vst1q_s32(&i2[j], vaddq_s32(vqdmulhq_n_s32(y2r, w2i), vqdmulhq_n_s32(y2i, w2r)));
+			vst1q_s32(&r3[j], vsubq_s32(vqdmulhq_n_s32(y3r, w3r), vqdmulhq_n_s32(y3i, w3i)));
+			vst1q_s32(&i3[j], vaddq_s32(vqdmulhq_n_s32(y3r, w3i), vqdmulhq_n_s32(y3i, w3r)));
+		}
+		else
+		{
+			vst1q_s32(&r1[j], y1r);
+			vst1q_s32(&i1[j], y1i);
+			vst1q_s32(&r2[j], y2r);
+			vst1q_s32(&i2[j], y2i);
+			vst1q_s32(&r3[j], y3r);
+			vst1q_s32(&i3[j], y3i);
+		}
+	}
+#endif
+
+	for (; j < lanes; j++)
+	{
+		int32_t t0r = r0[j] + r2[j];
+		int32_t t0i = i0[j] + i2[j];
+		int32_t t1r = r0[j] - r2[j];
+		int32_t t1i = i0[j] - i2[j];
+		int32_t t2r = r1[j] + r3[j];
+		int32_t t2i = i1[j] + i3[j];
+		int32_t t3r = i1[j] - i3[j];
+		int32_t t3i = r3[j] - r1[j];
+
+		int32_t y1r = t1r + t3r;
+		int32_t y1i = t1i + t3i;
+		int32_t y2r = t0r - t2r;
+		int32_t y2i = t0i - t2i;
+		int32_t y3r = t1r - t3r;
+		int32_t y3i = t1i - t3i;
+
+		r0[j] = t0r + t2r;
+		i0[j] = t0i + t2i;
+
+		if (twiddle)
+		{
+			r1[j] = q31_multiply(y1r, w1r) - q31_multiply(y1i, w1i);
+			i1[j] = q31_multiply(y1r, w1i) + q31_multiply(y1i, w1r);
+			r2[j] = q31_multiply(y2r, w2r) - q31_multiply(y2i, w2i);
+			i2[j] = q31_multiply(y2r, w2i) + q31_multiply(y2i, w2r);
+			r3[j] = q31_multiply(y3r, w3r) - q31_multiply(y3i, w3i);
+			i3[j] = q31_multiply(y3r, w3i) + q31_multiply(y3i, w3r);
+		}
+		else
+		{
+			r1[j] = y1r;
+			i1[j] = y1i;
+			r2[j] = y2r;
+			i2[j] = y2i;
+			r3[j] = y3r;
+			i3[j] = y3i;
+		}
+	}
+}
+
+
+/**
+ * @brief The radix-2 stage is always the last one, where all twiddles are one
+ */
+static void radix2_butterfly(struct acc_range_doppler *range_doppler, uint16_t row)
+{
+	uint16_t lanes = range_doppler->lanes;
+	int32_t  *r0   = &range_doppler->real[row * lanes];
+	int32_t  *r1   = &range_doppler->real[(row + 1) * lanes];
+	int32_t  *i0   = &range_doppler->imag[row * lanes];
+	int32_t  *i1   = &range_doppler->imag[(row + 1) * lanes];
+	uint16_t j     = 0;
+
+#if defined(__ARM_NEON)
+	for (; j + 4 <= lanes; j += 4)
+	{
+		int32x4_t a0r = vld1q_s32(&r0[j]);
+		int32x4_t a1r = vld1q_s32(&r1[j]);
+		int32x4_t a0i = vld1q_s32(&i0[j]);
+		int32x4_t a1i = vld1q_s32(&i1[j]);
+
+		vst1q_s32(&r0[j], vaddq_s32(a0r, a1r));
+		vst1q_s32(&r1[j], vsubq_s32(a0r, a1r));
+		vst1q_s32(&i0[j], vaddq_s32(a0i, a1i));
+		vst1q_s32(&i1[j], vsubq_s32(a0i, a1i));
+	}
+#endif
+
+	for (; j < lanes; j++)
+	{
+		int32_t a0r = r0[j];
+		int32_t a0i = i0[j];
+
+		r0[j] = a0r + r1[j];
+		r1[j] = a0r - r1[j];
+		i0[j] = a0i + i1[j];
+		i1[j] = a0i - i1[j];
+	}
+}
+
+
+/**
+ * @brief Decimation in frequency, the output rows are in digit reversed order
+ */
+static void transform(struct acc_range_doppler *range_doppler)
+{
+	uint16_t block = range_doppler->sweeps;
+
+	for (uint8_t s = 0; s < range_doppler->stage_count; s++)
+	{
+		uint16_t quarter = block / range_doppler->stage_radix[s];
+		uint16_t step    = range_doppler->sweeps / block;
+
+		for (uint16_t start = 0; start < range_doppler->sweeps; start += block)
+		{
+			for (uint16_t n = 0; n < quarter; n++)
+			{
+				if (range_doppler->stage_radix[s] == 4)
+				{
+					radix4_butterfly(range_doppler, start + n, quarter, n * step);
+				}
+				else
+				{
+					radix2_butterfly(range_doppler, start + n);
+				}
+			}
+		}
+
+		block = quarter;
+	}
+}
+
+
+#if defined(__ARM_NEON)
+static void store_range_points(float *row, uint16_t start, uint16_t sweep_length, const float *magnitudes)
+{
+	for (uint16_t j = 0; j < 4 && start + j < sweep_length; j++)
+	{
+		row[start + j] = magnitudes[j];
+	}
+}
+#endif
+
+
+/**
+ * @brief Separate the two real range points of each transform and calculate the magnitudes
+ *
+ * With z = x + jy, X[k] = (Z[k] + conj(Z[N - k])) / 2 and Y[k] = (Z[k] - conj(Z[N - k])) / 2j.
+ */
+static void calculate_map(struct acc_range_doppler *range_doppler)
+{
+	uint16_t lanes        = range_doppler->lanes;
+	uint16_t sweep_length = range_doppler->sweep_length;
+	float    scale        = range_doppler->magnitude_scale;
+
+	for (uint16_t k = 0; k < range_doppler->doppler_bins; k++)
+	{
+		uint16_t      mirror = (uint16_t)((range_doppler->sweeps - k) & (range_doppler->sweeps - 1));
+		const int32_t *zr    = &range_doppler->real[range_doppler->order[k] * lanes];
+		const int32_t *zi    = &range_doppler->imag[range_doppler->order[k] * lanes];
+		const int32_t *mr    = &range_doppler->real[range_doppler->order[mirror] * lanes];
+		const int32_t *mi    = &range_doppler->imag[range_doppler->order[mirror] * lanes];
+		float         *row   = &range_doppler->map[k * sweep_length];
+		uint16_t      j      = 0;
+
+#if defined(__ARM_NEON)
+		float32x4_t scale_vector = vdupq_n_f32(scale);
+		float32x4_t min_vector   = vdupq_n_f32(FLT_MIN);
+
+		for (; j + 4 <= lanes; j += 4)
+		{
+			int32x4_t z_real   = vld1q_s32(&zr[j]);
+			int32x4_t z_imag   = vld1q_s32(&zi[j]);
+			int32x4_t m_real   = vld1q_s32(&mr[j]);
+			int32x4_t m_imag   = vld1q_s32(&mi[j]);
+			float32x4_t x_real = vcvtq_f32_s32(vaddq_s32(z_real, m_real));
+			float32x4_t x_imag = vcvtq_f32_s32(vsubq_s32(z_imag, m_imag));
+			float32x4_t y_real = vcvtq_f32_s32(vaddq_s32(z_imag, m_imag));
+			float32x4_t y_imag = vcvtq_f32_s32(vsubq_s32(m_real, z_real));
+
+			float32x4_t power[2] = {
+				vmlaq_f32(vmulq_f32(x_real, x_real), x_imag, x_imag),
+				vmlaq_f32(vmulq_f32(y_real, y_real), y_imag, y_imag),
+			};
+
+			for (uint16_t h = 0; h < 2; h++)
+			{
+				/* sqrt(p) = p / sqrt(p), the reciprocal square root refined with two Newton steps */
+				float32x4_t clamped  = vmaxq_f32(power[h], min_vector);
+				float32x4_t estimate = vrsqrteq_f32(clamped);
+
+				estimate = vmulq_f32(estimate, vrsqrtsq_f32(vmulq_f32(clamped, estimate), estimate));
+				estimate = vmulq_f32(estimate, vrsqrtsq_f32(vmulq_f32(clamped, estimate), estimate));
+
+				float magnitudes[4];
+
+				vst1q_f32(magnitudes, vmulq_f32(vmulq_f32(power[h], estimate), scale_vector));
+				store_range_points(row, (uint16_t)(j + h * lanes), sweep_length, magnitudes);
+			}
+		}
+#endif
+
+		for (; j < lanes; j++)
+		{
+			float x_real = (float)(zr[j] + mr[j]);
+			float x_imag = (float)(zi[j] - mi[j]);
+			float y_real = (float)(zi[j] + mi[j]);
+			float y_imag = (float)(mr[j] - zr[j]);
+
+			if (j < sweep_length)
+			{
+				row[j] = sqrtf(x_real * x_real + x_imag * x_imag) * scale;
+			}
+
+			if (j + lanes < sweep_length)
+			{
+				row[j + lanes] = sqrtf(y_real * y_real + y_imag * y_imag) * scale;
+			}
+		}
+	}
+}
+
+
+acc_range_doppler_t acc_range_doppler_create(uint16_t sweeps_per_frame, uint16_t sweep_length, float sweep_rate_hz)
+{
+	if (sweeps_per_frame < ACC_RANGE_DOPPLER_MIN_SWEEPS || sweeps_per_frame > ACC_RANGE_DOPPLER_MAX_SWEEPS ||
+	    (sweeps_per_frame & (sweeps_per_frame - 1)) != 0 || sweep_length == 0 || sweep_rate_hz <= 0.0f)
+	{
+		return NULL;
+	}
+
+	struct acc_range_doppler *range_doppler = calloc(1, sizeof(*range_doppler));
+
+	if (range_doppler == NULL)
+	{
+		return NULL;
+	}
+
+	uint16_t half = (uint16_t)((sweep_length + 1) / 2);
+
+	range_doppler->sweeps        = sweeps_per_frame;
+	range_doppler->sweep_length  = sweep_length;
+	range_doppler->lanes         = (uint16_t)((half + 3) & ~3);
+	range_doppler->doppler_bins  = (uint16_t)(sweeps_per_frame / 2 + 1);
+	range_doppler->sweep_rate_hz = sweep_rate_hz;
+
+	while ((1 << range_doppler->sweeps_shift) < sweeps_per_frame)
+	{
+		range_doppler->sweeps_shift++;
+	}
+
+	for (uint16_t block = sweeps_per_frame; block > 1; block /= 4)
+	{
+		range_doppler->stage_radix[range_doppler->stage_count++] = block >= 4 ? 4 : 2;
+	}
+
+	range_doppler->window       = calloc(sweeps_per_frame, sizeof(*range_doppler->window));
+	range_doppler->twiddle_real = calloc(sweeps_per_frame, sizeof(*range_doppler->twiddle_real));
+	range_doppler->twiddle_imag = calloc(sweeps_per_frame, sizeof(*range_doppler->twiddle_imag));
+	range_doppler->order        = calloc(sweeps_per_frame, sizeof(*range_doppler->order));
+	range_doppler->mean         = calloc(sweep_length, sizeof(*range_doppler->mean));
+	range_doppler->real         = calloc((size_t)sweeps_per_frame * range_doppler->lanes, sizeof(*range_doppler->real));
+	range_doppler->imag         = calloc((size_t)sweeps_per_frame * range_doppler->lanes, sizeof(*range_doppler->imag));
+	range_doppler->map          = calloc((size_t)range_doppler->doppler_bins * sweep_length, sizeof(*range_doppler->map));
+
+	if (range_doppler->window == NULL || range_doppler->twiddle_real == NULL || range_doppler->twiddle_imag == NULL ||
+	    range_doppler->order == NULL || range_doppler->mean == NULL || range_doppler->real == NULL ||
+	    range_doppler->imag == NULL || range_doppler->map == NULL)
+	{
+		acc_range_doppler_destroy(&range_doppler);
+		return NULL;
+	}
+
+	int32_t window_sum = 0;
+
+	for (uint16_t n = 0; n < sweeps_per_frame; n++)
+	{
+		double angle = 2.0 * M_PI * n / sweeps_per_frame;
+
+		range_doppler->window[n]       = (int16_t)lrint(Q15_ONE * (0.5 - 0.5 * cos(angle)));
+		range_doppler->twiddle_real[n] = (int32_t)lrint(Q31_ONE * cos(angle));
+		range_doppler->twiddle_imag[n] = (int32_t)lrint(-Q31_ONE * sin(angle));
+		window_sum                    += range_doppler->window[n];
+	}
+
+	/* The separation gives 2 X[k], an oscillation of amplitude A gives |X[k]| = A / 2 * sum(window) */
+	range_doppler->magnitude_scale = 32768.0f / (float)window_sum;
+
+	/* A stage of radix r leaves frequency r * k + q in row q * block / r + k of the next stage */
+	for (uint16_t k = 0; k < sweeps_per_frame; k++)
+	{
+		uint16_t frequency = k;
+		uint16_t block     = sweeps_per_frame;
+		uint16_t row       = 0;
+
+		for (uint8_t s = 0; s < range_doppler->stage_count; s++)
+		{
+			block     /= range_doppler->stage_radix[s];
+			row       += (uint16_t)((frequency % range_doppler->stage_radix[s]) * block);
+			frequency /= range_doppler->stage_radix[s];
+		}
+
+		range_doppler->order[k] = row;
+	}
+
+	return range_doppler;
+}
+
+
+void acc_range_doppler_destroy(acc_range_doppler_t *range_doppler)
+{
+	if (*range_doppler == NULL)
+	{
+		return;
+	}
+
+	free((*range_doppler)->window);
+	free((*range_doppler)->twiddle_real);
+	free((*range_doppler)->twiddle_imag);
+	free((*range_doppler)->order);
+	free((*range_doppler)->mean);
+	free((*range_doppler)->real);
+	free((*range_doppler)->imag);
+	free((*range_doppler)->map);
+	free(*range_doppler);
+	*range_doppler = NULL;
+}
+
+
+void acc_range_doppler_process(acc_range_doppler_t range_doppler, const uint16_t *frame)
+{
+	load_frame(range_doppler, frame);
+	transform(range_doppler);
+	calculate_map(range_doppler);
+}
+
+
+const float *acc_range_doppler_get_map(const acc_range_doppler_t range_doppler)
+{
+	return range_doppler->map;
+}
+
+
+uint16_t acc_range_doppler_get_doppler_bins(const acc_range_doppler_t range_doppler)
+{
+	return range_doppler->doppler_bins;
+}
+
+
+float acc_range_doppler_get_bin_velocity(const acc_range_doppler_t range_doppler, float bin)
+{
+	return bin * range_doppler->sweep_rate_hz / range_doppler->sweeps * WAVELENGTH_M / 2.0f;
+}
+
+
+void acc_range_doppler_get_peaks(const acc_range_doppler_t range_doppler, acc_range_doppler_peak_t *peaks)
+{
+	uint16_t    sweep_length = range_doppler->sweep_length;
+	uint16_t    last_bin     = (uint16_t)(range_doppler->doppler_bins - 1);
+	const float *map         = range_doppler->map;
+
+	/* The peak bin is kept in velocity_mps during the search, bin by bin over all range points */
+	for (uint16_t r = 0; r < sweep_length; r++)
+	{
+		peaks[r].velocity_mps = 1.0f;
+		peaks[r].magnitude    = map[sweep_length + r];
+	}
+
+	for (uint16_t k = 2; k <= last_bin; k++)
+	{
+		const float *row = &map[k * sweep_length];
+
+		for (uint16_t r = 0; r < sweep_length; r++)
+		{
+			if (row[r] > peaks[r].magnitude)
+			{
+				peaks[r].velocity_mps = (float)k;
+				peaks[r].magnitude    = row[r];
+			}
+		}
+	}
+
+	for (uint16_t r = 0; r < sweep_length; r++)
+	{
+		uint16_t k      = (uint16_t)peaks[r].velocity_mps;
+		float    left   = map[(k - 1) * sweep_length + r];
+		float    center = peaks[r].magnitude;
+		float    right  = k < last_bin ? map[(k + 1) * sweep_length + r] : left;
+		float    denominator = left - 2.0f * center + right;
+		float    offset      = denominator < 0.0f ? 0.5f * (left - right) / denominator : 0.0f;
+
+		offset = offset > 0.5f ? 0.5f : (offset < -0.5f ? -0.5f : offset);
+
+		peaks[r].velocity_mps = acc_range_doppler_get_bin_velocity(range_doppler, (float)k + offset);
+	}
+}
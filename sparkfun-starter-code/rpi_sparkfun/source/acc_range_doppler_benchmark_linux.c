@@ -0,0 +1,490 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <getopt.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "acc_benchmark_util.h"
+#include "acc_hal_definitions.h"
+#include "acc_hal_integration.h"
+#include "acc_range_doppler.h"
+#include "acc_rss.h"
+#include "acc_service.h"
+#include "acc_service_sparse.h"
+
+
+#define DEFAULT_FRAME_COUNT (2000)
+#define DEFAULT_SWEEP_RATE  (3000.0f)
+#define FRAME_SET_SIZE      (4)
+#define SPARSE_LEVEL        (32768.0f)
+#define CLUTTER_LEVEL       (3000.0f)
+#define AMPLITUDE           (1000.0f)
+#define NOISE_STD           (20.0f)
+
+// Sensor settings for --sensor
+#define SENSOR_ID           1
+#define SENSOR_RANGE_START  0.30f
+#define SENSOR_RANGE_LENGTH 1.20f
+
+#ifndef M_PI
+#define M_PI (3.14159265358979323846)
+#endif
+
+static const uint16_t sweeps_per_frame_list[] = { 16, 32, 64 };
+
+#define SWEEPS_COUNT (sizeof(sweeps_per_frame_list) / sizeof(sweeps_per_frame_list[0]))
+
+static const uint16_t sweep_length_list[] = { 16, 40, 100 };
+
+#define SWEEP_LENGTH_COUNT (sizeof(sweep_length_list) / sizeof(sweep_length_list[0]))
+
+
+/**
+ * @brief Frames where each range point oscillates in its own Doppler bin, given in bins
+ */
+static void generate_frames(uint16_t *frames, uint16_t sweeps, uint16_t sweep_length, float *bins)
+{
+	uint32_t state = 1;
+
+	for (uint16_t r = 0; r < sweep_length; r++)
+	{
+		bins[r] = 1.5f + (sweeps / 2 - 3) * acc_benchmark_next_uniform(&state);
+	}
+
+	for (uint16_t f = 0; f < FRAME_SET_SIZE; f++)
+	{
+		for (uint16_t r = 0; r < sweep_length; r++)
+		{
+			float clutter = CLUTTER_LEVEL * acc_benchmark_next_uniform(&state);
+			float phase   = 2.0f * (float)M_PI * acc_benchmark_next_uniform(&state);
+
+			for (uint16_t n = 0; n < sweeps; n++)
+			{
+				float value = SPARSE_LEVEL + clutter + NOISE_STD * acc_benchmark_next_noise(&state) +
+				              AMPLITUDE * cosf(2.0f * (float)M_PI * bins[r] * n / sweeps + phase);
+
+				frames[(f * sweeps + n) * sweep_length + r] = (uint16_t)lrintf(value);
+			}
+		}
+	}
+}
+
+
+/**
+ * @brief Reference with a float radix-2 FFT of one range point at a time
+ */
+static void reference_map(const uint16_t *frame, uint16_t sweeps, uint16_t sweep_length, const float *window,
+                          const float *cos_table, const float *sin_table, float *real, float *imag, float *map)
+{
+	float window_sum = 0.0f;
+
+	for (uint16_t n = 0; n < sweeps; n++)
+	{
+		window_sum += window[n];
+	}
+
+	for (uint16_t r = 0; r < sweep_length; r++)
+	{
+		float mean = 0.0f;
+
+		for (uint16_t n = 0; n < sweeps; n++)
+		{
+			mean += frame[n * sweep_length + r];
+		}
+
+		mean /= sweeps;
+
+		for (uint16_t n = 0, reversed = 0; n < sweeps; n++)
+		{
+			real[reversed] = (frame[n * sweep_length + r] - mean) * window[n];
+			imag[reversed] = 0.0f;
+
+			uint16_t bit = sweeps >> 1;
+
+			while (reversed & bit)
+			{
+				reversed ^= bit;
+				bit     >>= 1;
+			}
+
+			reversed |= bit;
+		}
+
+		for (uint16_t size = 2; size <= sweeps; size *= 2)
+		{
+			for (uint16_t start = 0; start < sweeps; start += size)
+			{
+				for (uint16_t n = 0; n < size / 2; n++)
+				{
+					uint16_t t  = (uint16_t)(n * (sweeps / size));
+					uint16_t a  = start + n;
+					uint16_t b  = a + size / 2;
+					float    br = real[b] * cos_table[t] + imag[b] * sin_table[t];
+					float    bi = imag[b] * cos_table[t] - real[b] * sin_table[t];
+
+					real[b]  = real[a] - br;
+					imag[b]  = imag[a] - bi;
+					real[a] += br;
+					imag[a] += bi;
+				}
+			}
+		}
+
+		for (uint16_t k = 0; k <= sweeps / 2; k++)
+		{
+			map[k * sweep_length + r] = 2.0f * sqrtf(real[k] * real[k] + imag[k] * imag[k]) / window_sum;
+		}
+	}
+}
+
+
+static bool run_synthetic(uint16_t sweeps, uint16_t sweep_length, uint32_t frame_count, float sweep_rate_hz)
+{
+	size_t              frame_size = (size_t)sweeps * sweep_length;
+	uint16_t            *frames    = malloc(FRAME_SET_SIZE * frame_size * sizeof(*frames));
+	float               *bins      = malloc(sweep_length * sizeof(*bins));
+	float               *tables    = malloc(5 * (size_t)sweeps * sizeof(*tables));
+	float               *ref_map   = malloc(frame_size * sizeof(*ref_map));
+	acc_range_doppler_t range_doppler = acc_range_doppler_create(sweeps, sweep_length, sweep_rate_hz);
+	acc_range_doppler_peak_t *peaks   = malloc(sweep_length * sizeof(*peaks));
+
+	if (frames == NULL || bins == NULL || tables == NULL || ref_map == NULL || range_doppler == NULL || peaks == NULL)
+	{
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		free(frames);
+		free(bins);
+		free(tables);
+		free(ref_map);
+		free(peaks);
+		acc_range_doppler_destroy(&range_doppler);
+		return false;
+	}
+
+	float *window    = tables;
+	float *cos_table = &tables[sweeps];
+	float *sin_table = &tables[2 * sweeps];
+	float *real      = &tables[3 * sweeps];
+	float *imag      = &tables[4 * sweeps];
+
+	for (uint16_t n = 0; n < sweeps; n++)
+	{
+		window[n]    = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * n / sweeps);
+		cos_table[n] = cosf(2.0f * (float)M_PI * n / sweeps);
+		sin_table[n] = sinf(2.0f * (float)M_PI * n / sweeps);
+	}
+
+	generate_frames(frames, sweeps, sweep_length, bins);
+
+	/* Accuracy against the float reference and the simulated Doppler bins */
+	uint16_t doppler_bins = acc_range_doppler_get_doppler_bins(range_doppler);
+	float    max_error    = 0.0f;
+	double   sum_squares  = 0.0;
+
+	for (uint16_t f = 0; f < FRAME_SET_SIZE; f++)
+	{
+		acc_range_doppler_process(range_doppler, &frames[f * frame_size]);
+		reference_map(&frames[f * frame_size], sweeps, sweep_length, window, cos_table, sin_table, real, imag, ref_map);
+
+		const float *map = acc_range_doppler_get_map(range_doppler);
+
+		for (uint32_t i = 0; i < (uint32_t)doppler_bins * sweep_length; i++)
+		{
+			float error = fabsf(map[i] - ref_map[i]) / AMPLITUDE;
+
+			max_error = error > max_error ? error : max_error;
+		}
+
+		acc_range_doppler_get_peaks(range_doppler, peaks);
+
+		for (uint16_t r = 0; r < sweep_length; r++)
+		{
+			double error = (double)(peaks[r].velocity_mps / acc_range_doppler_get_bin_velocity(range_doppler, 1.0f) -
+			                        bins[r]);
+
+			sum_squares += error * error;
+		}
+	}
+
+	uint64_t start_ns = acc_benchmark_get_time_ns();
+
+	for (uint32_t n = 0; n < frame_count; n++)
+	{
+		acc_range_doppler_process(range_doppler, &frames[(n % FRAME_SET_SIZE) * frame_size]);
+		acc_range_doppler_get_peaks(range_doppler, peaks);
+	}
+
+	uint64_t engine_ns = acc_benchmark_get_time_ns() - start_ns;
+
+	start_ns = acc_benchmark_get_time_ns();
+
+	for (uint32_t n = 0; n < frame_count; n++)
+	{
+		reference_map(&frames[(n % FRAME_SET_SIZE) * frame_size], sweeps, sweep_length, window, cos_table, sin_table,
+		              real, imag, ref_map);
+	}
+
+	uint64_t reference_ns = acc_benchmark_get_time_ns() - start_ns;
+
+	double frame_us     = (double)engine_ns / frame_count / 1000.0;
+	double reference_us = (double)reference_ns / frame_count / 1000.0;
+	double period_us    = sweeps / (double)sweep_rate_hz * 1.0e6;
+
+	printf("%6u %6u %10.2f us %10.2f us %7.1fx %9.0f Hz %6.1f %% %9.2f %% %7.3f\n", (unsigned int)sweeps,
+	       (unsigned int)sweep_length, frame_us, reference_us, reference_us / frame_us, 1.0e6 / frame_us,
+	       100.0 * frame_us / period_us, 100.0 * (double)max_error, sqrt(sum_squares / (FRAME_SET_SIZE * sweep_length)));
+
+	free(frames);
+	free(bins);
+	free(tables);
+	free(ref_map);
+	free(peaks);
+	acc_range_doppler_destroy(&range_doppler);
+
+	return true;
+}
+
+
+/**
+ * @brief Frames per second of a sparse service at its maximum sweep rate, optionally with the map of each frame
+ */
+static bool run_sparse_service(acc_service_handle_t handle, acc_range_doppler_t range_doppler,
+                               acc_range_doppler_peak_t *peaks, uint32_t frame_count, double *frame_rate,
+                               uint64_t *max_process_ns, uint32_t *missed_count)
+{
+	uint16_t                         *data = NULL;
+	acc_service_sparse_result_info_t result_info;
+
+	*max_process_ns = 0;
+	*missed_count   = 0;
+
+	if (!acc_service_activate(handle))
+	{
+		return false;
+	}
+
+	uint64_t start_ns = acc_benchmark_get_time_ns();
+	bool     result   = true;
+
+	for (uint32_t n = 0; result && n < frame_count; n++)
+	{
+		result = acc_service_sparse_get_next_by_reference(handle, &data, &result_info) &&
+		         !result_info.sensor_communication_error;
+
+		if (result && range_doppler != NULL)
+		{
+			uint64_t process_ns = acc_benchmark_get_time_ns();
+
+			acc_range_doppler_process(range_doppler, data);
+			acc_range_doppler_get_peaks(range_doppler, peaks);
+
+			process_ns      = acc_benchmark_get_time_ns() - process_ns;
+			*max_process_ns = process_ns > *max_process_ns ? process_ns : *max_process_ns;
+		}
+
+		*missed_count += result && result_info.missed_data ? 1 : 0;
+	}
+
+	*frame_rate = frame_count * 1.0e9 / (double)(acc_benchmark_get_time_ns() - start_ns);
+
+	return acc_service_deactivate(handle) && result;
+}
+
+
+static bool run_sensor(uint32_t frame_count)
+{
+	const acc_hal_t *hal = acc_hal_integration_get_implementation();
+
+	if (!acc_rss_activate(hal))
+	{
+		fprintf(stderr, "ERROR: Failed to activate RSS\n");
+		return false;
+	}
+
+	bool result = true;
+
+	printf("%6s %6s %10s %12s %12s %12s %7s\n", "sweeps", "length", "sweep rate", "sensor only", "with map",
+	       "max process", "missed");
+
+	for (uint16_t s = 0; result && s < SWEEPS_COUNT; s++)
+	{
+		uint16_t                    sweeps        = sweeps_per_frame_list[s];
+		acc_service_configuration_t configuration = acc_service_sparse_configuration_create();
+		acc_service_handle_t        handle        = NULL;
+		acc_range_doppler_t         range_doppler = NULL;
+		acc_range_doppler_peak_t    *peaks        = NULL;
+
+		result = configuration != NULL;
+
+		if (result)
+		{
+			/* A sweep rate of zero is the maximum rate */
+			acc_service_sensor_set(configuration, SENSOR_ID);
+			acc_service_requested_start_set(configuration, SENSOR_RANGE_START);
+			acc_service_requested_length_set(configuration, SENSOR_RANGE_LENGTH);
+			acc_service_sparse_configuration_sweeps_per_frame_set(configuration, sweeps);
+			acc_service_sparse_configuration_sweep_rate_set(configuration, 0.0f);
+
+			handle = acc_service_create(configuration);
+			result = handle != NULL;
+		}
+
+		acc_service_sparse_metadata_t metadata = { 0 };
+
+		if (result)
+		{
+			acc_service_sparse_get_metadata(handle, &metadata);
+
+			uint16_t sweep_length = (uint16_t)(metadata.data_length / sweeps);
+
+			range_doppler = acc_range_doppler_create(sweeps, sweep_length, metadata.sweep_rate);
+			peaks         = malloc(sweep_length * sizeof(*peaks));
+			result        = range_doppler != NULL && peaks != NULL;
+		}
+
+		double   sensor_rate = 0.0;
+		double   map_rate    = 0.0;
+		uint64_t max_ns      = 0;
+		uint32_t missed      = 0;
+
+		result = result && run_sparse_service(handle, NULL, NULL, frame_count, &sensor_rate, &max_ns, &missed);
+		result = result && run_sparse_service(handle, range_doppler, peaks, frame_count, &map_rate, &max_ns, &missed);
+
+		if (result)
+		{
+			printf("%6u %6u %7.0f Hz %9.1f Hz %9.1f Hz %9.1f us %7u\n", (unsigned int)sweeps,
+			       (unsigned int)(metadata.data_length / sweeps), (double)metadata.sweep_rate, sensor_rate, map_rate,
+			       (double)max_ns / 1000.0, (unsigned int)missed);
+		}
+		else
+		{
+			fprintf(stderr, "ERROR: Failed to run the sparse service with %u sweeps per frame\n", (unsigned int)sweeps);
+		}
+
+		free(peaks);
+		acc_range_doppler_destroy(&range_doppler);
+
+		if (handle != NULL)
+		{
+			acc_service_destroy(&handle);
+		}
+
+		if (configuration != NULL)
+		{
+			acc_service_sparse_configuration_destroy(&configuration);
+		}
+	}
+
+	acc_rss_deactivate();
+
+	return result;
+}
+
+
+static void print_usage(char *application_name)
+{
+	fprintf(stderr, "Usage: %s [OPTION]...\n", application_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Measure the time per frame of the range-Doppler map engine against a float FFT of one range\n");
+	fprintf(stderr, "point at a time, the map error and the peak bin error on simulated sparse frames, and the\n");
+	fprintf(stderr, "load at a sweep rate. With --sensor, compare the frame rate of the sparse service at its\n");
+	fprintf(stderr, "maximum sweep rate with and without the map of each frame.\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "-h, --help                      this help\n");
+	fprintf(stderr, "-n, --frames                    the number of frames per measurement\n");
+	fprintf(stderr, "-r, --sweep-rate                the sweep rate for the load, default %.0f Hz\n",
+	        (double)DEFAULT_SWEEP_RATE);
+	fprintf(stderr, "-s, --sensor                    measure on sensor %u\n", (unsigned int)SENSOR_ID);
+}
+
+
+int main(int argc, char *argv[])
+{
+	static struct option long_options[] =
+	{
+		{"help",             no_argument,       0,      'h'},
+		{"frames",           required_argument, 0,      'n'},
+		{"sweep-rate",       required_argument, 0,      'r'},
+		{"sensor",           no_argument,       0,      's'},
+		{NULL,               0,                 NULL,   0}
+	};
+
+	int character_code;
+	int option_index = 0;
+
+	uint32_t frame_count   = DEFAULT_FRAME_COUNT;
+	float    sweep_rate_hz = DEFAULT_SWEEP_RATE;
+	bool     sensor        = false;
+
+	while ((character_code = getopt_long(argc, argv, "h?n:r:s", long_options, &option_index)) != -1)
+	{
+		switch (character_code)
+		{
+			case 'n':
+			{
+				int value = atoi(optarg);
+
+				if (value <= 0)
+				{
+					fprintf(stderr, "ERROR: Invalid value '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				frame_count = (uint32_t)value;
+				break;
+			}
+			case 'r':
+			{
+				sweep_rate_hz = strtof(optarg, NULL);
+
+				if (sweep_rate_hz <= 0.0f)
+				{
+					fprintf(stderr, "ERROR: Invalid value '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				break;
+			}
+			case 's':
+			{
+				sensor = true;
+				break;
+			}
+			default:
+			{
+				print_usage(basename(argv[0]));
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	if (sensor)
+	{
+		return run_sensor(frame_count) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	printf("%u frames per measurement, load at %.0f Hz sweep rate\n\n", (unsigned int)frame_count,
+	       (double)sweep_rate_hz);
+	printf("%6s %6s %13s %13s %8s %12s %8s %11s %7s\n", "sweeps", "length", "frame", "reference", "speedup",
+	       "max rate", "load", "map error", "bin rms");
+
+	for (uint16_t s = 0; s < SWEEPS_COUNT; s++)
+	{
+		for (uint16_t l = 0; l < SWEEP_LENGTH_COUNT; l++)
+		{
+			if (!run_synthetic(sweeps_per_frame_list[s], sweep_length_list[l], frame_count, sweep_rate_hz))
+			{
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,153 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "acc_rate_controller.h"
+
+
+static void enter_tier(acc_rate_controller_t *controller, uint16_t tier, uint32_t time_ms)
+{
+	controller->statistics.time_in_tier_ms[controller->tier] += time_ms - controller->tier_start_ms;
+	controller->statistics.transition_count++;
+
+	controller->tier              = tier;
+	controller->tier_start_ms     = time_ms;
+	controller->frames_below_exit = 0;
+}
+
+
+bool acc_rate_controller_init(acc_rate_controller_t *controller, const acc_rate_controller_tier_t *tiers,
+                              uint16_t tier_count, uint32_t time_ms)
+{
+	if (tier_count == 0 || tier_count > ACC_RATE_CONTROLLER_MAX_TIERS)
+	{
+		fprintf(stderr, "ERROR: Invalid number of rate controller tiers %u\n", (unsigned int)tier_count);
+		return false;
+	}
+
+	for (uint16_t i = 1; i < tier_count; i++)
+	{
+		if (tiers[i].enter_score < tiers[i - 1].enter_score || tiers[i].exit_score > tiers[i].enter_score)
+		{
+			fprintf(stderr, "ERROR: Invalid scores for rate controller tier '%s'\n", tiers[i].name);
+			return false;
+		}
+	}
+
+	memset(controller, 0, sizeof(*controller));
+
+	controller->tiers         = tiers;
+	controller->tier_count    = tier_count;
+	controller->tier_start_ms = time_ms;
+
+	return true;
+}
+
+
+acc_rate_controller_transition_t acc_rate_controller_update(acc_rate_controller_t *controller, bool presence_detected,
+                                                            float score, uint32_t time_ms)
+{
+	const acc_rate_controller_tier_t *tiers    = controller->tiers;
+	uint16_t                         previous = controller->tier;
+	uint16_t                         target   = previous;
+
+	if (controller->tier_count > 1 && score < tiers[1].enter_score)
+	{
+		controller->quiet_time_ms  = time_ms;
+		controller->has_quiet_time = true;
+	}
+
+	if (presence_detected && !controller->presence_detected && controller->has_quiet_time)
+	{
+		uint32_t latency_ms = time_ms - controller->quiet_time_ms;
+
+		controller->statistics.detection_count++;
+		controller->statistics.detection_latency_sum_ms += latency_ms;
+
+		if (latency_ms > controller->statistics.detection_latency_max_ms)
+		{
+			controller->statistics.detection_latency_max_ms = latency_ms;
+		}
+	}
+
+	controller->presence_detected = presence_detected;
+
+	// Step up directly to the highest tier that the score reaches
+	while (target + 1 < controller->tier_count && score >= tiers[target + 1].enter_score)
+	{
+		target++;
+	}
+
+	if (target > previous)
+	{
+		enter_tier(controller, target, time_ms);
+	}
+	else if (previous > 0 && score < tiers[previous].exit_score)
+	{
+		if (++controller->frames_below_exit >= tiers[previous].exit_frames)
+		{
+			enter_tier(controller, (uint16_t)(previous - 1), time_ms);
+		}
+	}
+	else
+	{
+		controller->frames_below_exit = 0;
+	}
+
+	if (controller->tier == previous)
+	{
+		return ACC_RATE_CONTROLLER_TRANSITION_NONE;
+	}
+
+	const acc_rate_controller_tier_t *from = &tiers[previous];
+	const acc_rate_controller_tier_t *to   = &tiers[controller->tier];
+
+	if (from->update_rate_hz == to->update_rate_hz && from->power_save_mode == to->power_save_mode)
+	{
+		return ACC_RATE_CONTROLLER_TRANSITION_THRESHOLDS;
+	}
+
+	return ACC_RATE_CONTROLLER_TRANSITION_RECONFIGURE;
+}
+
+
+const acc_rate_controller_tier_t *acc_rate_controller_get_tier(const acc_rate_controller_t *controller)
+{
+	return &controller->tiers[controller->tier];
+}
+
+
+void acc_rate_controller_transition_done(acc_rate_controller_t *controller, uint32_t time_us)
+{
+	controller->statistics.reconfigure_count++;
+	controller->statistics.reconfigure_time_sum_us += time_us;
+
+	if (time_us > controller->statistics.reconfigure_time_max_us)
+	{
+		controller->statistics.reconfigure_time_max_us = time_us;
+	}
+}
+
+
+void acc_rate_controller_get_statistics(const acc_rate_controller_t *controller, uint32_t time_ms,
+                                        acc_rate_controller_statistics_t *statistics)
+{
+	*statistics = controller->statistics;
+
+	statistics->time_in_tier_ms[controller->tier] += time_ms - controller->tier_start_ms;
+}
+
+
+void acc_rate_controller_reset_statistics(acc_rate_controller_t *controller, uint32_t time_ms)
+{
+	memset(&controller->statistics, 0, sizeof(controller->statistics));
+
+	controller->tier_start_ms = time_ms;
+}
@@ -0,0 +1,222 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "acc_session_recording.h"
+
+/*
+ * File format, all integers little endian:
+ *  - file header: magic "ACCSREC" + version (8 bytes)
+ *  - records: type (uint8), timestamp in us (uint64), size (uint32), data (size bytes)
+ */
+#define FILE_MAGIC         "ACCSREC"
+#define FILE_VERSION       (1)
+#define FILE_HEADER_SIZE   (8)
+#define RECORD_HEADER_SIZE (13)
+
+#define FILE_BUFFER_SIZE (256 * 1024)
+#define MAX_RECORD_SIZE  (16 * 1024 * 1024)
+
+
+static uint64_t get_time_us(void)
+{
+	struct timespec time_ts = {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &time_ts);
+	return (uint64_t)time_ts.tv_sec * 1000000 + (uint64_t)time_ts.tv_nsec / 1000;
+}
+
+
+static void put_le(uint8_t *buffer, uint64_t value, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		buffer[i] = (uint8_t)(value >> (8 * i));
+	}
+}
+
+
+static uint64_t get_le(const uint8_t *buffer, size_t size)
+{
+	uint64_t value = 0;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		value |= (uint64_t)buffer[i] << (8 * i);
+	}
+
+	return value;
+}
+
+
+bool acc_session_recorder_open(acc_session_recorder_t *recorder, const char *path)
+{
+	uint8_t header[FILE_HEADER_SIZE];
+
+	recorder->write_failed = false;
+	recorder->file         = fopen(path, "wb");
+
+	if (recorder->file == NULL)
+	{
+		fprintf(stderr, "ERROR: Could not create '%s': (%u) %s\n", path, errno, strerror(errno));
+		return false;
+	}
+
+	/* Large buffer, the streaming loop waits for the disk only once per 256 KiB when it is flushed */
+	setvbuf(recorder->file, NULL, _IOFBF, FILE_BUFFER_SIZE);
+
+	memcpy(header, FILE_MAGIC, FILE_HEADER_SIZE - 1);
+	header[FILE_HEADER_SIZE - 1] = FILE_VERSION;
+
+	if (fwrite(header, 1, sizeof(header), recorder->file) != sizeof(header))
+	{
+		fprintf(stderr, "ERROR: Could not write '%s'\n", path);
+		fclose(recorder->file);
+		recorder->file = NULL;
+		return false;
+	}
+
+	recorder->start_us = get_time_us();
+
+	return true;
+}
+
+
+void acc_session_recorder_close(acc_session_recorder_t *recorder)
+{
+	if (recorder->file != NULL)
+	{
+		fclose(recorder->file);
+		recorder->file = NULL;
+	}
+}
+
+
+void acc_session_recorder_write(acc_session_recorder_t *recorder, acc_session_record_type_t type,
+                                const void *data, size_t size)
+{
+	uint8_t header[RECORD_HEADER_SIZE];
+
+	if (recorder->file == NULL || recorder->write_failed)
+	{
+		return;
+	}
+
+	header[0] = (uint8_t)type;
+	put_le(&header[1], get_time_us() - recorder->start_us, 8);
+	put_le(&header[9], size, 4);
+
+	if (fwrite(header, 1, sizeof(header), recorder->file) != sizeof(header) ||
+	    (size > 0 && fwrite(data, 1, size, recorder->file) != size))
+	{
+		fprintf(stderr, "ERROR: Session recording write failed, recording stopped\n");
+		recorder->write_failed = true;
+	}
+}
+
+
+bool acc_session_player_open(acc_session_player_t *player, const char *path)
+{
+	player->buffer      = NULL;
+	player->buffer_size = 0;
+	player->file        = fopen(path, "rb");
+
+	if (player->file == NULL)
+	{
+		fprintf(stderr, "ERROR: Could not open '%s': (%u) %s\n", path, errno, strerror(errno));
+		return false;
+	}
+
+	if (!acc_session_player_rewind(player))
+	{
+		fprintf(stderr, "ERROR: '%s' is not a session recording\n", path);
+		acc_session_player_close(player);
+		return false;
+	}
+
+	return true;
+}
+
+
+void acc_session_player_close(acc_session_player_t *player)
+{
+	if (player->file != NULL)
+	{
+		fclose(player->file);
+		player->file = NULL;
+	}
+
+	free(player->buffer);
+	player->buffer      = NULL;
+	player->buffer_size = 0;
+}
+
+
+bool acc_session_player_rewind(acc_session_player_t *player)
+{
+	uint8_t header[FILE_HEADER_SIZE];
+
+	rewind(player->file);
+
+	if (fread(header, 1, sizeof(header), player->file) != sizeof(header))
+	{
+		return false;
+	}
+
+	return memcmp(header, FILE_MAGIC, FILE_HEADER_SIZE - 1) == 0 && header[FILE_HEADER_SIZE - 1] == FILE_VERSION;
+}
+
+
+bool acc_session_player_read(acc_session_player_t *player, acc_session_record_t *record)
+{
+	uint8_t header[RECORD_HEADER_SIZE];
+
+	if (fread(header, 1, sizeof(header), player->file) != sizeof(header))
+	{
+		return false;
+	}
+
+	uint32_t size = (uint32_t)get_le(&header[9], 4);
+
+	if (header[0] > ACC_SESSION_RECORD_CONNECT || size > MAX_RECORD_SIZE)
+	{
+		fprintf(stderr, "ERROR: Corrupt session recording\n");
+		return false;
+	}
+
+	if (size > player->buffer_size)
+	{
+		uint8_t *buffer = realloc(player->buffer, size);
+
+		if (buffer == NULL)
+		{
+			fprintf(stderr, "ERROR: Memory allocation error\n");
+			return false;
+		}
+
+		player->buffer      = buffer;
+		player->buffer_size = size;
+	}
+
+	if (size > 0 && fread(player->buffer, 1, size, player->file) != size)
+	{
+		return false;
+	}
+
+	record->type         = (acc_session_record_type_t)header[0];
+	record->timestamp_us = get_le(&header[1], 8);
+	record->data         = player->buffer;
+	record->size         = size;
+
+	return true;
+}
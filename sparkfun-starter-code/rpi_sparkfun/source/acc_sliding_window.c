@@ -0,0 +1,217 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "acc_sliding_window.h"
+
+
+/*
+ * Values are kept in a ring of capacity slots. The min and max deques hold the
+ * slots of the values that can still become the min or max of the window, the
+ * values along each deque are monotonic so the front is always the current min
+ * or max. Every value enters and leaves each deque at most once.
+ */
+typedef struct
+{
+	uint32_t *slot;
+	uint32_t head;
+	uint32_t count;
+} slot_deque_t;
+
+
+struct acc_sliding_window
+{
+	float        *values;
+	uint32_t     capacity;
+	uint32_t     next_slot;
+	uint32_t     count;
+	double       sum;
+	slot_deque_t min_deque;
+	slot_deque_t max_deque;
+};
+
+
+static uint32_t wrap(const struct acc_sliding_window *window, uint32_t position)
+{
+	/* Positions are at most twice the capacity, avoid the division of a modulo */
+	return position < window->capacity ? position : position - window->capacity;
+}
+
+
+static uint32_t deque_front(const slot_deque_t *deque)
+{
+	return deque->slot[deque->head];
+}
+
+
+static uint32_t deque_back(const struct acc_sliding_window *window, const slot_deque_t *deque)
+{
+	return deque->slot[wrap(window, deque->head + deque->count - 1)];
+}
+
+
+static void deque_push_back(const struct acc_sliding_window *window, slot_deque_t *deque, uint32_t slot)
+{
+	deque->slot[wrap(window, deque->head + deque->count)] = slot;
+	deque->count++;
+}
+
+
+static void deque_pop_front(const struct acc_sliding_window *window, slot_deque_t *deque)
+{
+	deque->head = wrap(window, deque->head + 1);
+	deque->count--;
+}
+
+
+/**
+ * @brief Add the slot of a new value to a monotonic deque
+ *
+ * Must be called before the new value is written to the slot.
+ *
+ * @param[in] window The sliding window
+ * @param[in] deque The deque to add to
+ * @param[in] slot The slot of the new value
+ * @param[in] value The new value
+ * @param[in] keep_max True for the max deque, false for the min deque
+ */
+static void deque_add(const struct acc_sliding_window *window, slot_deque_t *deque, uint32_t slot, float value,
+                      bool keep_max)
+{
+	if (deque->count > 0 && deque_front(deque) == slot)
+	{
+		/* The front value is the one leaving the window */
+		deque_pop_front(window, deque);
+	}
+
+	while (deque->count > 0)
+	{
+		float back_value = window->values[deque_back(window, deque)];
+
+		if (keep_max ? back_value > value : back_value < value)
+		{
+			break;
+		}
+
+		deque->count--;
+	}
+
+	deque_push_back(window, deque, slot);
+}
+
+
+acc_sliding_window_t acc_sliding_window_create(uint32_t capacity)
+{
+	if (capacity == 0)
+	{
+		return NULL;
+	}
+
+	struct acc_sliding_window *window = calloc(1, sizeof(*window));
+
+	if (window == NULL)
+	{
+		return NULL;
+	}
+
+	window->capacity           = capacity;
+	window->values             = malloc(capacity * sizeof(*window->values));
+	window->min_deque.slot     = malloc(capacity * sizeof(*window->min_deque.slot));
+	window->max_deque.slot     = malloc(capacity * sizeof(*window->max_deque.slot));
+
+	if (window->values == NULL || window->min_deque.slot == NULL || window->max_deque.slot == NULL)
+	{
+		acc_sliding_window_destroy(&window);
+	}
+
+	return window;
+}
+
+
+void acc_sliding_window_destroy(acc_sliding_window_t *window)
+{
+	if (window != NULL && *window != NULL)
+	{
+		free((*window)->values);
+		free((*window)->min_deque.slot);
+		free((*window)->max_deque.slot);
+		free(*window);
+		*window = NULL;
+	}
+}
+
+
+void acc_sliding_window_reset(acc_sliding_window_t window)
+{
+	window->next_slot       = 0;
+	window->count           = 0;
+	window->sum             = 0.0;
+	window->min_deque.head  = 0;
+	window->min_deque.count = 0;
+	window->max_deque.head  = 0;
+	window->max_deque.count = 0;
+}
+
+
+void acc_sliding_window_add(acc_sliding_window_t window, float value)
+{
+	uint32_t slot = window->next_slot;
+
+	if (window->count == window->capacity)
+	{
+		window->sum -= (double)window->values[slot];
+	}
+	else
+	{
+		window->count++;
+	}
+
+	deque_add(window, &window->min_deque, slot, value, false);
+	deque_add(window, &window->max_deque, slot, value, true);
+
+	window->values[slot] = value;
+	window->sum         += (double)value;
+	window->next_slot    = wrap(window, slot + 1);
+}
+
+
+uint32_t acc_sliding_window_get_count(acc_sliding_window_t window)
+{
+	return window->count;
+}
+
+
+bool acc_sliding_window_is_full(acc_sliding_window_t window)
+{
+	return window->count == window->capacity;
+}
+
+
+float acc_sliding_window_get_min(acc_sliding_window_t window)
+{
+	return window->count > 0 ? window->values[deque_front(&window->min_deque)] : 0.0f;
+}
+
+
+float acc_sliding_window_get_max(acc_sliding_window_t window)
+{
+	return window->count > 0 ? window->values[deque_front(&window->max_deque)] : 0.0f;
+}
+
+
+float acc_sliding_window_get_sum(acc_sliding_window_t window)
+{
+	return (float)window->sum;
+}
+
+
+float acc_sliding_window_get_mean(acc_sliding_window_t window)
+{
+	return window->count > 0 ? (float)(window->sum / window->count) : 0.0f;
+}
@@ -0,0 +1,145 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "acc_benchmark_util.h"
+#include "acc_sliding_window.h"
+
+
+#define DEFAULT_UPDATE_COUNT (200000)
+
+static const uint32_t window_sizes[] = { 3, 16, 64, 256, 1024, 4096 };
+
+
+static float next_value(uint32_t *state)
+{
+	/* xorshift, the same series is used for both implementations */
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+
+	return (float)(*state % 100000) / 100.0f;
+}
+
+
+/**
+ * @brief Shift the array and rescan it on every update, the way the parking reference application used to
+ */
+static float run_shift_and_scan(float *values, uint32_t size, uint32_t update_count)
+{
+	uint32_t state    = 1;
+	uint32_t count    = 0;
+	float    checksum = 0.0f;
+
+	for (uint32_t n = 0; n < update_count; n++)
+	{
+		if (count == size)
+		{
+			memmove(&values[0], &values[1], (size - 1) * sizeof(float));
+		}
+		else
+		{
+			count++;
+		}
+
+		values[count - 1] = next_value(&state);
+
+		float min = __FLT_MAX__;
+		float max = 0.0f;
+		float sum = 0.0f;
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			min  = values[i] < min ? values[i] : min;
+			max  = values[i] > max ? values[i] : max;
+			sum += values[i];
+		}
+
+		checksum += max - min + sum / (float)count;
+	}
+
+	return checksum;
+}
+
+
+static float run_sliding_window(acc_sliding_window_t window, uint32_t update_count)
+{
+	uint32_t state    = 1;
+	float    checksum = 0.0f;
+
+	for (uint32_t n = 0; n < update_count; n++)
+	{
+		acc_sliding_window_add(window, next_value(&state));
+
+		checksum += acc_sliding_window_get_max(window) - acc_sliding_window_get_min(window) +
+		            acc_sliding_window_get_mean(window);
+	}
+
+	return checksum;
+}
+
+
+int main(int argc, char *argv[])
+{
+	uint32_t update_count = DEFAULT_UPDATE_COUNT;
+
+	if (argc > 1)
+	{
+		int value = atoi(argv[1]);
+
+		if (value <= 0)
+		{
+			fprintf(stderr, "Usage: %s [UPDATE_COUNT]\n", basename(argv[0]));
+			return EXIT_FAILURE;
+		}
+
+		update_count = (uint32_t)value;
+	}
+
+	printf("%u updates, min/max/mean after each update\n\n", (unsigned int)update_count);
+	printf("%8s %16s %16s %10s %14s\n", "window", "scan ns/update", "window ns/update", "speedup", "checksum diff");
+
+	for (size_t i = 0; i < sizeof(window_sizes) / sizeof(window_sizes[0]); i++)
+	{
+		uint32_t             size   = window_sizes[i];
+		float                *array = malloc(size * sizeof(float));
+		acc_sliding_window_t window = acc_sliding_window_create(size);
+
+		if (array == NULL || window == NULL)
+		{
+			fprintf(stderr, "ERROR: Memory allocation error\n");
+			free(array);
+			acc_sliding_window_destroy(&window);
+			return EXIT_FAILURE;
+		}
+
+		uint64_t start_ns      = acc_benchmark_get_time_ns();
+		float    scan_checksum = run_shift_and_scan(array, size, update_count);
+		uint64_t scan_ns       = acc_benchmark_get_time_ns() - start_ns;
+
+		start_ns = acc_benchmark_get_time_ns();
+
+		float    window_checksum = run_sliding_window(window, update_count);
+		uint64_t window_ns       = acc_benchmark_get_time_ns() - start_ns;
+
+		/* The checksums keep the work from being optimized away, they only differ in rounding */
+		printf("%8u %16.1f %16.1f %9.1fx %14.1f\n", (unsigned int)size,
+		       (double)scan_ns / update_count, (double)window_ns / update_count,
+		       window_ns > 0 ? (double)scan_ns / (double)window_ns : 0.0,
+		       (double)(scan_checksum - window_checksum));
+
+		free(array);
+		acc_sliding_window_destroy(&window);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,378 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "acc_socket_server.h"
+
+
+#define DEFAULT_TCP_IP_PORT (6112)
+#define DEFAULT_FRAME_SIZE  (8192)
+#define DEFAULT_FRAME_RATE  (100)
+#define DEFAULT_DURATION_S  (5)
+#define DEFAULT_HOST        "127.0.0.1"
+#define MAX_COMMAND_SIZE    (1024)
+#define FRAME_HEADER_SIZE   (64)
+
+/*
+ * A frame is written as a header followed by the payload, like the exploration
+ * server does. The header starts with the sequence number and the send time.
+ */
+typedef struct
+{
+	const char *host;
+	int        port;
+	size_t     frame_size;
+	uint32_t   frame_count;
+	uint32_t   *latency_us;
+	uint32_t   frames_received;
+	uint64_t   bytes_received;
+	uint64_t   receive_time_us;
+} benchmark_client_t;
+
+
+static uint64_t get_time_us(void)
+{
+	struct timespec time_ts = {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &time_ts);
+	return (uint64_t)time_ts.tv_sec * 1000000 + (uint64_t)time_ts.tv_nsec / 1000;
+}
+
+
+static bool read_all(int socket_fd, void *data, size_t size)
+{
+	uint8_t *buffer = data;
+
+	while (size > 0)
+	{
+		ssize_t received = read(socket_fd, buffer, size);
+
+		if (received <= 0)
+		{
+			return false;
+		}
+
+		buffer += received;
+		size   -= (size_t)received;
+	}
+
+	return true;
+}
+
+
+static void *client_thread_main(void *arg)
+{
+	benchmark_client_t *client = arg;
+	struct sockaddr_in addr;
+	uint8_t            *frame = malloc(client->frame_size);
+	int                s      = socket(AF_INET, SOCK_STREAM, 0);
+
+	if (frame == NULL || s < 0)
+	{
+		fprintf(stderr, "ERROR: Could not create client\n");
+		goto exit;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port   = htons(client->port);
+
+	if (inet_pton(AF_INET, client->host, &addr.sin_addr) != 1 ||
+	    connect(s, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+	{
+		fprintf(stderr, "ERROR: connect(%s:%d): (%u) %s\n", client->host, client->port, errno, strerror(errno));
+		goto exit;
+	}
+
+	uint64_t start_us = get_time_us();
+
+	while (client->frames_received < client->frame_count && read_all(s, frame, client->frame_size))
+	{
+		uint64_t sent_us;
+
+		memcpy(&sent_us, frame + sizeof(uint32_t), sizeof(sent_us));
+
+		client->latency_us[client->frames_received++] = (uint32_t)(get_time_us() - sent_us);
+		client->bytes_received                       += client->frame_size;
+	}
+
+	client->receive_time_us = get_time_us() - start_us;
+
+exit:
+	if (s >= 0)
+	{
+		close(s);
+	}
+
+	free(frame);
+
+	return NULL;
+}
+
+
+static int compare_uint32(const void *a, const void *b)
+{
+	uint32_t value_a = *(const uint32_t *)a;
+	uint32_t value_b = *(const uint32_t *)b;
+
+	return (value_a > value_b) - (value_a < value_b);
+}
+
+
+static uint32_t percentile(const uint32_t *sorted, uint32_t count, uint32_t per_mille)
+{
+	uint32_t index = (uint32_t)(((uint64_t)count * per_mille) / 1000);
+
+	return sorted[index < count ? index : count - 1];
+}
+
+
+/**
+ * @brief Stream frames at a fixed rate to a client thread and print the result
+ *
+ * @param[in] name The name of the tuning
+ * @param[in] tuning The tuning to use for the server socket
+ * @param[in] client The client configuration, the results are written here
+ * @param[in] frame_rate The frame rate in Hz
+ *
+ * @return true if no error occurred
+ */
+static bool run_benchmark(const char *name, const acc_socket_server_tuning_t *tuning, benchmark_client_t *client,
+                          uint32_t frame_rate)
+{
+	acc_socket_server_t socket_server = { 0 };
+	pthread_t           client_thread;
+	uint8_t             *frame        = calloc(1, client->frame_size);
+	bool                result        = false;
+
+	client->frames_received = 0;
+	client->bytes_received  = 0;
+	client->receive_time_us = 0;
+
+	if (frame == NULL || !acc_socket_server_open(&socket_server, client->port, MAX_COMMAND_SIZE))
+	{
+		fprintf(stderr, "ERROR: Could not create socket server\n");
+		free(frame);
+		return false;
+	}
+
+	acc_socket_server_set_tuning(&socket_server, tuning);
+
+	if (pthread_create(&client_thread, NULL, client_thread_main, client) != 0)
+	{
+		fprintf(stderr, "ERROR: Could not create client thread\n");
+		acc_socket_server_close(&socket_server);
+		free(frame);
+		return false;
+	}
+
+	if (acc_socket_server_wait_for_client(&socket_server))
+	{
+		struct timespec next        = {0};
+		uint64_t        period_ns   = 1000000000 / frame_rate;
+		size_t          header_size = client->frame_size < FRAME_HEADER_SIZE ? client->frame_size : FRAME_HEADER_SIZE;
+
+		clock_gettime(CLOCK_MONOTONIC, &next);
+
+		for (uint32_t i = 0; i < client->frame_count && socket_server.client_socket > 0; i++)
+		{
+			uint64_t now_us = get_time_us();
+
+			memcpy(frame, &i, sizeof(i));
+			memcpy(frame + sizeof(i), &now_us, sizeof(now_us));
+
+			acc_socket_server_cork(&socket_server, true);
+			acc_socket_server_setup_write_data(&socket_server, frame, header_size);
+			acc_socket_server_setup_write_data(&socket_server, frame + header_size, client->frame_size - header_size);
+			acc_socket_server_cork(&socket_server, false);
+
+			uint64_t next_ns = (uint64_t)next.tv_nsec + period_ns;
+
+			next.tv_sec  += (time_t)(next_ns / 1000000000);
+			next.tv_nsec  = (long)(next_ns % 1000000000);
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+		}
+	}
+
+	pthread_join(client_thread, NULL);
+
+	acc_socket_server_client_close(&socket_server);
+	acc_socket_server_close(&socket_server);
+	free(frame);
+
+	if (client->frames_received > 0)
+	{
+		uint32_t count      = client->frames_received;
+		double   duration_s = (double)client->receive_time_us / 1000000.0;
+		double   throughput = duration_s > 0.0 ? (double)client->bytes_received / duration_s / 1000000.0 : 0.0;
+
+		qsort(client->latency_us, count, sizeof(uint32_t), compare_uint32);
+
+		printf("%-8s %8u %10.2f %10u %10u %10u %10u\n", name, (unsigned int)count, throughput,
+		       (unsigned int)percentile(client->latency_us, count, 500),
+		       (unsigned int)percentile(client->latency_us, count, 990),
+		       (unsigned int)percentile(client->latency_us, count, 999),
+		       (unsigned int)client->latency_us[count - 1]);
+
+		result = count == client->frame_count;
+	}
+	else
+	{
+		printf("%-8s no frames received\n", name);
+	}
+
+	return result;
+}
+
+
+static void print_usage(char *application_name)
+{
+	fprintf(stderr, "Usage: %s [OPTION]...\n", application_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Stream frames through the socket server to a local client and measure throughput and latency,\n");
+	fprintf(stderr, "with the default socket tuning and with the tuning for the frame size and rate.\n");
+	fprintf(stderr, "To measure on a shaped link, apply netem to the loopback device first, for example\n");
+	fprintf(stderr, "  tc qdisc add dev lo root netem delay 5ms rate 20mbit\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "-h, --help                      this help\n");
+	fprintf(stderr, "-p, --port                      the TCP/IP port to use\n");
+	fprintf(stderr, "-H, --host                      the address the client connects to\n");
+	fprintf(stderr, "-s, --frame-size                the frame size in bytes\n");
+	fprintf(stderr, "-r, --frame-rate                the frame rate in Hz\n");
+	fprintf(stderr, "-d, --duration                  the duration of each run in seconds\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+	static struct option long_options[] =
+	{
+		{"help",             no_argument,       0,      'h'},
+		{"port",             required_argument, 0,      'p'},
+		{"host",             required_argument, 0,      'H'},
+		{"frame-size",       required_argument, 0,      's'},
+		{"frame-rate",       required_argument, 0,      'r'},
+		{"duration",         required_argument, 0,      'd'},
+		{NULL,               0,                 NULL,   0}
+	};
+
+	int character_code;
+	int option_index = 0;
+
+	uint32_t           frame_rate = DEFAULT_FRAME_RATE;
+	uint32_t           duration_s = DEFAULT_DURATION_S;
+	benchmark_client_t client     = {
+		.host       = DEFAULT_HOST,
+		.port       = DEFAULT_TCP_IP_PORT,
+		.frame_size = DEFAULT_FRAME_SIZE,
+	};
+
+	while ((character_code = getopt_long(argc, argv, "h?p:H:s:r:d:", long_options, &option_index)) != -1)
+	{
+		int value = optarg != NULL ? atoi(optarg) : 0;
+
+		switch (character_code)
+		{
+			case 'p':
+			case 's':
+			case 'r':
+			case 'd':
+			{
+				if (value <= 0)
+				{
+					fprintf(stderr, "ERROR: Invalid value '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				break;
+			}
+			default:
+				break;
+		}
+
+		switch (character_code)
+		{
+			case 'h':
+			case '?':
+			{
+				print_usage(basename(argv[0]));
+				return EXIT_FAILURE;
+			}
+			case 'p':
+			{
+				client.port = value;
+				break;
+			}
+			case 'H':
+			{
+				client.host = optarg;
+				break;
+			}
+			case 's':
+			{
+				client.frame_size = (size_t)value < FRAME_HEADER_SIZE ? FRAME_HEADER_SIZE : (size_t)value;
+				break;
+			}
+			case 'r':
+			{
+				frame_rate = (uint32_t)value;
+				break;
+			}
+			case 'd':
+			{
+				duration_s = (uint32_t)value;
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	/* Ignore broken pipe shutdown, default behavior is to close application */
+	signal(SIGPIPE, SIG_IGN);
+
+	client.frame_count = frame_rate * duration_s;
+	client.latency_us  = malloc(client.frame_count * sizeof(uint32_t));
+
+	if (client.latency_us == NULL)
+	{
+		fprintf(stderr, "ERROR: Memory allocation error\n");
+		return EXIT_FAILURE;
+	}
+
+	acc_socket_server_tuning_t default_tuning;
+	acc_socket_server_tuning_t stream_tuning;
+
+	acc_socket_server_tuning_default(&default_tuning);
+	acc_socket_server_tuning_for_stream(client.frame_size, (float)frame_rate, &stream_tuning);
+
+	printf("%zu byte frames at %u Hz for %u s\n", client.frame_size, (unsigned int)frame_rate, (unsigned int)duration_s);
+	printf("stream tuning: sndbuf=%d notsent_lowat=%d cork=%s\n", stream_tuning.send_buffer_size,
+	       stream_tuning.not_sent_lowat, stream_tuning.cork ? "on" : "off");
+	printf("\n");
+	printf("%-8s %8s %10s %10s %10s %10s %10s\n", "tuning", "frames", "MB/s", "p50 us", "p99 us", "p99.9 us", "max us");
+
+	bool result = run_benchmark("default", &default_tuning, &client, frame_rate) &&
+	              run_benchmark("stream", &stream_tuning, &client, frame_rate);
+
+	free(client.latency_us);
+
+	return result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
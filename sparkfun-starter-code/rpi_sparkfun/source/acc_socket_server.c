@@ -6,6 +6,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <linux/sockios.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <poll.h>
@@ -14,6 +15,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <time.h>
 #include <unistd.h>
@@ -23,6 +25,78 @@
 #define US_TICKS_PER_SECOND (1000000)
 #define NS_PER_TICKS        (1000)
 
+#define DEFAULT_SEND_BUFFER_SIZE (200000)
+#define MIN_SEND_BUFFER_SIZE     (65536)
+#define MAX_SEND_BUFFER_SIZE     (4 * 1024 * 1024)
+#define SEND_BUFFER_TIME_S       (0.1f)
+#define TCP_SEGMENT_SIZE         (1448)
+
+
+void acc_socket_server_tuning_default(acc_socket_server_tuning_t *tuning)
+{
+	tuning->send_buffer_size    = DEFAULT_SEND_BUFFER_SIZE;
+	tuning->receive_buffer_size = 0;
+	tuning->not_sent_lowat      = 0;
+	tuning->no_delay            = true;
+	tuning->cork                = false;
+}
+
+
+void acc_socket_server_tuning_for_stream(size_t frame_size, float frame_rate, acc_socket_server_tuning_t *tuning)
+{
+	float buffered_frames = frame_rate * SEND_BUFFER_TIME_S;
+
+	if (buffered_frames < 4.0f)
+	{
+		buffered_frames = 4.0f;
+	}
+
+	float send_buffer_size = (float)frame_size * buffered_frames;
+
+	if (send_buffer_size < MIN_SEND_BUFFER_SIZE)
+	{
+		send_buffer_size = MIN_SEND_BUFFER_SIZE;
+	}
+
+	if (send_buffer_size > MAX_SEND_BUFFER_SIZE)
+	{
+		send_buffer_size = MAX_SEND_BUFFER_SIZE;
+	}
+
+	tuning->send_buffer_size    = (int)send_buffer_size;
+	tuning->receive_buffer_size = 0;
+	tuning->not_sent_lowat      = (int)(2 * frame_size);
+	tuning->no_delay            = true;
+	tuning->cork                = frame_size > TCP_SEGMENT_SIZE;
+}
+
+
+static void apply_tuning(int client_socket, const acc_socket_server_tuning_t *tuning)
+{
+	if (setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &(int){tuning->no_delay ? 1 : 0 }, sizeof(int)) < 0)
+	{
+		fprintf(stderr, "ERROR:setsockopt(TCP_NODELAY): (%u) %s\n", errno, strerror(errno));
+	}
+
+	if (tuning->send_buffer_size > 0 &&
+	    setsockopt(client_socket, SOL_SOCKET, SO_SNDBUF, &tuning->send_buffer_size, sizeof(int)) < 0)
+	{
+		fprintf(stderr, "ERROR:setsockopt(SO_SNDBUF): (%u) %s\n", errno, strerror(errno));
+	}
+
+	if (tuning->receive_buffer_size > 0 &&
+	    setsockopt(client_socket, SOL_SOCKET, SO_RCVBUF, &tuning->receive_buffer_size, sizeof(int)) < 0)
+	{
+		fprintf(stderr, "ERROR:setsockopt(SO_RCVBUF): (%u) %s\n", errno, strerror(errno));
+	}
+
+	/* Always set, 0 returns to the system default after an earlier tuning */
+	if (setsockopt(client_socket, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &tuning->not_sent_lowat, sizeof(int)) < 0)
+	{
+		fprintf(stderr, "ERROR:setsockopt(TCP_NOTSENT_LOWAT): (%u) %s\n", errno, strerror(errno));
+	}
+}
+
 
 bool acc_socket_server_open(acc_socket_server_t *socket_server, int server_port, size_t buffer_size)
 {
@@ -77,6 +151,8 @@ bool acc_socket_server_open(acc_socket_server_t *socket_server, int server_port,
 	socket_server->server_socket = s;
 	socket_server->client_socket = -1;
 
+	acc_socket_server_tuning_default(&socket_server->tuning);
+
 	return true;
 }
 
@@ -108,15 +184,7 @@ bool acc_socket_server_wait_for_client(acc_socket_server_t *socket_server)
 		fprintf(stderr, "ERROR:setsockopt(SO_KEEPALIVE): (%u) %s\n", errno, strerror(errno));
 	}
 
-	if (setsockopt(socket_server->client_socket, IPPROTO_TCP, TCP_NODELAY, &(int){1 }, sizeof(int)) < 0)
-	{
-		fprintf(stderr, "ERROR:setsockopt(TCP_NODELAY): (%u) %s\n", errno, strerror(errno));
-	}
-
-	if (setsockopt(socket_server->client_socket, SOL_SOCKET, SO_SNDBUF, &(int){200000 }, sizeof(int)) < 0)
-	{
-		fprintf(stderr, "ERROR:setsockopt(SO_SNDBUF): (%u) %s\n", errno, strerror(errno));
-	}
+	apply_tuning(socket_server->client_socket, &socket_server->tuning);
 
 	socket_server->poll_set[0].fd     = socket_server->client_socket;
 	socket_server->poll_set[0].events = POLLIN;
@@ -125,6 +193,29 @@ bool acc_socket_server_wait_for_client(acc_socket_server_t *socket_server)
 }
 
 
+void acc_socket_server_set_tuning(acc_socket_server_t *socket_server, const acc_socket_server_tuning_t *tuning)
+{
+	socket_server->tuning = *tuning;
+
+	if (socket_server->client_socket > 0)
+	{
+		apply_tuning(socket_server->client_socket, tuning);
+	}
+}
+
+
+void acc_socket_server_cork(acc_socket_server_t *socket_server, bool cork)
+{
+	if (socket_server->tuning.cork && socket_server->client_socket > 0)
+	{
+		if (setsockopt(socket_server->client_socket, IPPROTO_TCP, TCP_CORK, &(int){cork ? 1 : 0 }, sizeof(int)) < 0)
+		{
+			fprintf(stderr, "ERROR:setsockopt(TCP_CORK): (%u) %s\n", errno, strerror(errno));
+		}
+	}
+}
+
+
 void acc_socket_server_client_close(acc_socket_server_t *socket_server)
 {
 	/* Close client socket if there was any */
@@ -224,3 +315,19 @@ void acc_socket_server_setup_write_data(acc_socket_server_t *socket_server, cons
 		}
 	}
 }
+
+
+size_t acc_socket_server_get_send_queue_size(acc_socket_server_t *socket_server)
+{
+	int queue_size = 0;
+
+	if (socket_server->client_socket > 0)
+	{
+		if (ioctl(socket_server->client_socket, SIOCOUTQ, &queue_size) < 0)
+		{
+			queue_size = 0;
+		}
+	}
+
+	return (size_t)queue_size;
+}
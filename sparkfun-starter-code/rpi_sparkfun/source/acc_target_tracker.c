@@ -0,0 +1,222 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "acc_target_tracker.h"
+
+
+static int compare_pairs(const void *a, const void *b)
+{
+	const acc_target_tracker_pair_t *pair_a = a;
+	const acc_target_tracker_pair_t *pair_b = b;
+
+	if (pair_a->confirmed != pair_b->confirmed)
+	{
+		return pair_a->confirmed ? -1 : 1;
+	}
+
+	return (pair_a->cost > pair_b->cost) - (pair_a->cost < pair_b->cost);
+}
+
+
+static void track_update(acc_target_tracker_track_t *track, const acc_target_tracker_parameters_t *parameters,
+                         const acc_detector_distance_result_t *peak, float dt_s)
+{
+	float residual = peak->distance_m - track->distance_m;
+
+	if (track->hits == 1)
+	{
+		/* The second peak gives the first velocity estimate */
+		track->velocity_mps = dt_s > 0.0f ? residual / dt_s : 0.0f;
+		track->distance_m   = peak->distance_m;
+	}
+	else
+	{
+		track->distance_m += parameters->alpha * residual;
+
+		if (dt_s > 0.0f)
+		{
+			track->velocity_mps += parameters->beta * residual / dt_s;
+		}
+	}
+
+	track->amplitude = peak->amplitude;
+	track->misses    = 0;
+
+	if (track->hits < UINT16_MAX)
+	{
+		track->hits++;
+	}
+
+	if (track->hits >= parameters->confirm_hits)
+	{
+		track->confirmed = true;
+	}
+}
+
+
+bool acc_target_tracker_init(acc_target_tracker_t *tracker, const acc_target_tracker_parameters_t *parameters)
+{
+	if (parameters->alpha <= 0.0f || parameters->alpha > 1.0f || parameters->beta < 0.0f || parameters->beta > 2.0f ||
+	    parameters->gate_m <= 0.0f || parameters->confirm_hits == 0)
+	{
+		return false;
+	}
+
+	tracker->parameters  = *parameters;
+	tracker->track_count = 0;
+	tracker->next_id     = 1;
+	tracker->time_ms     = 0;
+	tracker->has_time    = false;
+
+	return true;
+}
+
+
+void acc_target_tracker_update(acc_target_tracker_t *tracker, const acc_detector_distance_result_t *peaks,
+                               uint16_t peak_count, uint32_t time_ms)
+{
+	const acc_target_tracker_parameters_t *parameters = &tracker->parameters;
+
+	float dt_s = tracker->has_time ? (float)(time_ms - tracker->time_ms) / 1000.0f : 0.0f;
+
+	tracker->time_ms  = time_ms;
+	tracker->has_time = true;
+
+	if (peak_count > ACC_TARGET_TRACKER_MAX_PEAKS)
+	{
+		peak_count = ACC_TARGET_TRACKER_MAX_PEAKS;
+	}
+
+	/* Predict and collect the gated pairs */
+	uint32_t pair_count = 0;
+
+	for (uint16_t t = 0; t < tracker->track_count; t++)
+	{
+		acc_target_tracker_track_t *track = &tracker->tracks[t];
+
+		track->distance_m         += track->velocity_mps * dt_s;
+		tracker->track_assigned[t] = false;
+
+		for (uint16_t p = 0; p < peak_count; p++)
+		{
+			float cost = fabsf(peaks[p].distance_m - track->distance_m);
+
+			if (cost <= parameters->gate_m)
+			{
+				acc_target_tracker_pair_t *pair = &tracker->pairs[pair_count++];
+
+				pair->track     = (uint8_t)t;
+				pair->peak      = (uint8_t)p;
+				pair->confirmed = track->confirmed;
+				pair->cost      = cost;
+			}
+		}
+	}
+
+	for (uint16_t p = 0; p < peak_count; p++)
+	{
+		tracker->peak_assigned[p] = false;
+	}
+
+	/* Assign the closest pairs first, each track and peak at most once */
+	qsort(tracker->pairs, pair_count, sizeof(tracker->pairs[0]), compare_pairs);
+
+	for (uint32_t i = 0; i < pair_count; i++)
+	{
+		const acc_target_tracker_pair_t *pair = &tracker->pairs[i];
+
+		if (!tracker->track_assigned[pair->track] && !tracker->peak_assigned[pair->peak])
+		{
+			tracker->track_assigned[pair->track] = true;
+			tracker->peak_assigned[pair->peak]   = true;
+
+			track_update(&tracker->tracks[pair->track], parameters, &peaks[pair->peak], dt_s);
+		}
+	}
+
+	/* Delete tracks that missed too many updates, the last track takes the place of a deleted one */
+	uint16_t t = 0;
+
+	while (t < tracker->track_count)
+	{
+		acc_target_tracker_track_t *track = &tracker->tracks[t];
+
+		if (!tracker->track_assigned[t])
+		{
+			track->misses++;
+		}
+
+		if (!tracker->track_assigned[t] && (!track->confirmed || track->misses > parameters->delete_misses))
+		{
+			tracker->track_count--;
+			*track                     = tracker->tracks[tracker->track_count];
+			tracker->track_assigned[t] = tracker->track_assigned[tracker->track_count];
+		}
+		else
+		{
+			t++;
+		}
+	}
+
+	/* Peaks without a track start tentative tracks, in the order of the detector */
+	for (uint16_t p = 0; p < peak_count && tracker->track_count < ACC_TARGET_TRACKER_MAX_TRACKS; p++)
+	{
+		if (!tracker->peak_assigned[p])
+		{
+			acc_target_tracker_track_t *track = &tracker->tracks[tracker->track_count++];
+
+			track->id           = tracker->next_id++;
+			track->distance_m   = peaks[p].distance_m;
+			track->velocity_mps = 0.0f;
+			track->amplitude    = peaks[p].amplitude;
+			track->hits         = 1;
+			track->misses       = 0;
+			track->confirmed    = parameters->confirm_hits <= 1;
+		}
+	}
+}
+
+
+uint16_t acc_target_tracker_get_confirmed(const acc_target_tracker_t *tracker, acc_target_tracker_track_t *tracks,
+                                          uint16_t max_track_count)
+{
+	uint16_t count = 0;
+
+	for (uint16_t t = 0; t < tracker->track_count; t++)
+	{
+		const acc_target_tracker_track_t *track = &tracker->tracks[t];
+
+		if (!track->confirmed)
+		{
+			continue;
+		}
+
+		/* Insert in order of distance, the farthest track is dropped when the array is full */
+		uint16_t i = count < max_track_count ? count++ : max_track_count;
+
+		while (i > 0 && tracks[i - 1].distance_m > track->distance_m)
+		{
+			if (i < max_track_count)
+			{
+				tracks[i] = tracks[i - 1];
+			}
+
+			i--;
+		}
+
+		if (i < max_track_count)
+		{
+			tracks[i] = *track;
+		}
+	}
+
+	return count;
+}
@@ -0,0 +1,254 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <getopt.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "acc_benchmark_util.h"
+#include "acc_detector_distance.h"
+#include "acc_target_tracker.h"
+
+
+#define DEFAULT_FRAME_COUNT (5000)
+#define UPDATE_PERIOD_MS    (20)
+#define RANGE_START_M       (0.3f)
+#define RANGE_END_M         (5.0f)
+#define MAX_SPEED_MPS       (0.3f)
+#define NOISE_M             (0.003f)
+#define DETECTION_RATE      (0.9f)
+
+typedef struct
+{
+	uint16_t target_count;
+	uint16_t clutter_count;
+} scenario_t;
+
+static const scenario_t scenarios[] =
+{
+	{4,  2},
+	{8,  4},
+	{16, 8},
+	{24, 16},
+	{24, 40},
+};
+
+#define SCENARIO_COUNT (sizeof(scenarios) / sizeof(scenarios[0]))
+
+static const acc_target_tracker_parameters_t tracker_parameters =
+{
+	.alpha         = 0.5f,
+	.beta          = 0.1f,
+	.gate_m        = 0.03f,
+	.confirm_hits  = 3,
+	.delete_misses = 5,
+};
+
+typedef struct
+{
+	float    distance_m;
+	float    velocity_mps;
+	uint32_t track_id;
+} target_t;
+
+
+static acc_target_tracker_t tracker;
+
+
+static void run_scenario(const scenario_t *scenario, uint32_t frame_count)
+{
+	target_t                       targets[ACC_TARGET_TRACKER_MAX_PEAKS];
+	acc_detector_distance_result_t peaks[ACC_TARGET_TRACKER_MAX_PEAKS];
+	acc_target_tracker_track_t     tracks[ACC_TARGET_TRACKER_MAX_TRACKS];
+	uint32_t                       state         = 1;
+	uint64_t                       total_ns      = 0;
+	uint64_t                       max_ns        = 0;
+	uint64_t                       peak_total    = 0;
+	double                         sum_squares   = 0.0;
+	uint32_t                       matched       = 0;
+	uint32_t                       id_switches   = 0;
+	uint32_t                       false_tracks  = 0;
+	uint32_t                       target_frames = 0;
+
+	acc_target_tracker_init(&tracker, &tracker_parameters);
+
+	for (uint16_t i = 0; i < scenario->target_count; i++)
+	{
+		targets[i].distance_m   = RANGE_START_M + (RANGE_END_M - RANGE_START_M) * acc_benchmark_next_uniform(&state);
+		targets[i].velocity_mps = MAX_SPEED_MPS * (2.0f * acc_benchmark_next_uniform(&state) - 1.0f);
+		targets[i].track_id     = 0;
+	}
+
+	for (uint32_t n = 0; n < frame_count; n++)
+	{
+		uint16_t peak_count = 0;
+
+		for (uint16_t i = 0; i < scenario->target_count; i++)
+		{
+			target_t *target = &targets[i];
+
+			target->distance_m += target->velocity_mps * (float)UPDATE_PERIOD_MS / 1000.0f;
+
+			if (target->distance_m < RANGE_START_M || target->distance_m > RANGE_END_M)
+			{
+				target->velocity_mps = -target->velocity_mps;
+			}
+
+			if (acc_benchmark_next_uniform(&state) < DETECTION_RATE)
+			{
+				peaks[peak_count].distance_m  = target->distance_m + NOISE_M * acc_benchmark_next_noise(&state);
+				peaks[peak_count].amplitude   = 1000;
+				peak_count++;
+			}
+		}
+
+		for (uint16_t i = 0; i < scenario->clutter_count && peak_count < ACC_TARGET_TRACKER_MAX_PEAKS; i++)
+		{
+			peaks[peak_count].distance_m = RANGE_START_M + (RANGE_END_M - RANGE_START_M) * acc_benchmark_next_uniform(&state);
+			peaks[peak_count].amplitude  = 300;
+			peak_count++;
+		}
+
+		uint64_t start_ns = acc_benchmark_get_time_ns();
+
+		acc_target_tracker_update(&tracker, peaks, peak_count, n * UPDATE_PERIOD_MS);
+
+		uint64_t elapsed_ns = acc_benchmark_get_time_ns() - start_ns;
+
+		total_ns   += elapsed_ns;
+		max_ns      = elapsed_ns > max_ns ? elapsed_ns : max_ns;
+		peak_total += peak_count;
+
+		/* Match each target to a confirmed track within the gate, a change of track is an identity switch */
+		uint16_t track_count = acc_target_tracker_get_confirmed(&tracker, tracks, ACC_TARGET_TRACKER_MAX_TRACKS);
+		bool     track_used[ACC_TARGET_TRACKER_MAX_TRACKS] = { false };
+
+		for (uint16_t i = 0; i < scenario->target_count; i++)
+		{
+			target_t *target = &targets[i];
+			int32_t  best    = -1;
+			float    best_m  = tracker_parameters.gate_m;
+
+			for (uint16_t t = 0; t < track_count; t++)
+			{
+				float error = fabsf(tracks[t].distance_m - target->distance_m);
+
+				/* The track that followed the target keeps it while within the gate, also when targets cross */
+				if (tracks[t].id == target->track_id && error <= tracker_parameters.gate_m)
+				{
+					best   = t;
+					best_m = error;
+					break;
+				}
+
+				if (error <= best_m)
+				{
+					best   = t;
+					best_m = error;
+				}
+			}
+
+			target_frames++;
+
+			if (best < 0)
+			{
+				continue;
+			}
+
+			track_used[best] = true;
+			matched++;
+			sum_squares += (double)best_m * (double)best_m;
+
+			if (target->track_id != 0 && target->track_id != tracks[best].id)
+			{
+				id_switches++;
+			}
+
+			target->track_id = tracks[best].id;
+		}
+
+		for (uint16_t t = 0; t < track_count; t++)
+		{
+			false_tracks += track_used[t] ? 0 : 1;
+		}
+	}
+
+	printf("%7u %7u %7.1f %9.2f us %9.2f us %8.1f %% %7.2f mm %7u %9.2f\n", (unsigned int)scenario->target_count,
+	       (unsigned int)scenario->clutter_count, (double)peak_total / frame_count,
+	       (double)total_ns / frame_count / 1000.0, (double)max_ns / 1000.0,
+	       100.0 * matched / target_frames, matched > 0 ? sqrt(sum_squares / matched) * 1000.0 : 0.0,
+	       (unsigned int)id_switches, (double)false_tracks / frame_count);
+}
+
+
+static void print_usage(char *application_name)
+{
+	fprintf(stderr, "Usage: %s [OPTION]...\n", application_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Measure the update time and track quality of the target tracker on simulated targets\n");
+	fprintf(stderr, "with missed detections, distance noise and clutter peaks, updated every %u ms.\n",
+	        (unsigned int)UPDATE_PERIOD_MS);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "-h, --help                      this help\n");
+	fprintf(stderr, "-n, --frames                    the number of frames per scenario\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+	static struct option long_options[] =
+	{
+		{"help",             no_argument,       0,      'h'},
+		{"frames",           required_argument, 0,      'n'},
+		{NULL,               0,                 NULL,   0}
+	};
+
+	int character_code;
+	int option_index = 0;
+
+	uint32_t frame_count = DEFAULT_FRAME_COUNT;
+
+	while ((character_code = getopt_long(argc, argv, "h?n:", long_options, &option_index)) != -1)
+	{
+		switch (character_code)
+		{
+			case 'n':
+			{
+				int value = atoi(optarg);
+
+				if (value <= 0)
+				{
+					fprintf(stderr, "ERROR: Invalid value '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				frame_count = (uint32_t)value;
+				break;
+			}
+			default:
+			{
+				print_usage(basename(argv[0]));
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	printf("%u frames per scenario, detection rate %.0f %%, noise %.1f mm\n\n", (unsigned int)frame_count,
+	       (double)(DETECTION_RATE * 100.0f), (double)(NOISE_M * 1000.0f));
+	printf("%7s %7s %7s %12s %12s %10s %10s %7s %9s\n", "targets", "clutter", "peaks", "mean", "max",
+	       "tracked", "rms", "id sw", "false");
+
+	for (uint16_t s = 0; s < SCENARIO_COUNT; s++)
+	{
+		run_scenario(&scenarios[s], frame_count);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,616 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "acc_trilateration.h"
+
+
+/**
+ * @brief The weight of a new range rate of a peak, the range rates of the matched peaks are averaged
+ */
+#define RANGE_RATE_SMOOTHING (0.5f)
+
+/**
+ * @brief Least squares iterations for positions with three or more ranges
+ */
+#define REFINE_ITERATIONS (3)
+
+#define MAX_POSITIONS (ACC_TRILATERATION_MAX_SENSORS * ACC_TRILATERATION_MAX_PEAKS)
+
+
+static int compare_candidates(const void *a, const void *b)
+{
+	const acc_trilateration_position_t *position_a = &((const acc_trilateration_candidate_t *)a)->position;
+	const acc_trilateration_position_t *position_b = &((const acc_trilateration_candidate_t *)b)->position;
+
+	if (position_a->sensor_count != position_b->sensor_count)
+	{
+		return position_a->sensor_count > position_b->sensor_count ? -1 : 1;
+	}
+
+	return (position_a->residual_m > position_b->residual_m) - (position_a->residual_m < position_b->residual_m);
+}
+
+
+static int compare_pairs(const void *a, const void *b)
+{
+	const acc_trilateration_pair_t *pair_a = a;
+	const acc_trilateration_pair_t *pair_b = b;
+
+	if (pair_a->confirmed != pair_b->confirmed)
+	{
+		return pair_a->confirmed ? -1 : 1;
+	}
+
+	return (pair_a->cost > pair_b->cost) - (pair_a->cost < pair_b->cost);
+}
+
+
+/**
+ * @brief Store the peaks of a sensor with the range rate of the peaks that match a previous peak
+ */
+static void sensor_update(acc_trilateration_sensor_t *sensor, const acc_trilateration_parameters_t *parameters,
+                          const acc_detector_distance_result_t *peaks, uint16_t peak_count, uint32_t time_ms)
+{
+	acc_trilateration_sensor_t previous = *sensor;
+	int32_t                    dt_ms    = (int32_t)(time_ms - previous.time_ms);
+	float                      dt_s     = (float)dt_ms / 1000.0f;
+	float                      gate_m   = parameters->max_speed_mps * dt_s + parameters->max_residual_m;
+	bool                       match    = previous.valid && dt_ms > 0 && dt_ms <= parameters->max_age_ms;
+
+	sensor->time_ms    = time_ms;
+	sensor->peak_count = peak_count;
+	sensor->valid      = true;
+
+	for (uint16_t p = 0; p < peak_count; p++)
+	{
+		float   range_m = peaks[p].distance_m;
+		int16_t matched = -1;
+		float   best_m  = gate_m;
+
+		for (uint16_t q = 0; match && q < previous.peak_count; q++)
+		{
+			float difference_m = fabsf(range_m - previous.range_m[q]);
+
+			if (difference_m <= best_m)
+			{
+				best_m  = difference_m;
+				matched = (int16_t)q;
+			}
+		}
+
+		sensor->range_m[p]        = range_m;
+		sensor->range_rate_mps[p] = 0.0f;
+		sensor->has_range_rate[p] = false;
+
+		if (matched >= 0)
+		{
+			float range_rate_mps = (range_m - previous.range_m[matched]) / dt_s;
+
+			if (previous.has_range_rate[matched])
+			{
+				range_rate_mps = previous.range_rate_mps[matched] +
+				                 RANGE_RATE_SMOOTHING * (range_rate_mps - previous.range_rate_mps[matched]);
+			}
+
+			sensor->range_rate_mps[p] = range_rate_mps;
+			sensor->has_range_rate[p] = true;
+		}
+	}
+}
+
+
+/**
+ * @brief Refine a position by least squares over its ranges, and get its residual and geometry
+ *
+ * @return False if the ranges do not determine a position
+ */
+static bool refine_position(acc_trilateration_position_t *position, const acc_trilateration_parameters_t *parameters,
+                            const float ranges_m[ACC_TRILATERATION_MAX_SENSORS],
+                            const int8_t peak[ACC_TRILATERATION_MAX_SENSORS])
+{
+	float x_m = position->x_m;
+	float y_m = position->y_m;
+
+	for (uint16_t iteration = 0; iteration <= REFINE_ITERATIONS; iteration++)
+	{
+		float   a_xx        = 0.0f;
+		float   a_xy        = 0.0f;
+		float   a_yy        = 0.0f;
+		float   b_x         = 0.0f;
+		float   b_y         = 0.0f;
+		float   square_sum  = 0.0f;
+		uint8_t range_count = 0;
+
+		for (uint8_t s = 0; s < parameters->sensor_count; s++)
+		{
+			if (peak[s] < 0)
+			{
+				continue;
+			}
+
+			float dx_m       = x_m - parameters->sensor_x_m[s];
+			float dy_m       = y_m - parameters->sensor_y_m[s];
+			float distance_m = sqrtf(dx_m * dx_m + dy_m * dy_m);
+
+			if (distance_m <= 0.0f)
+			{
+				return false;
+			}
+
+			float u_x     = dx_m / distance_m;
+			float u_y     = dy_m / distance_m;
+			float error_m = distance_m - ranges_m[s];
+
+			a_xx       += u_x * u_x;
+			a_xy       += u_x * u_y;
+			a_yy       += u_y * u_y;
+			b_x        += u_x * error_m;
+			b_y        += u_y * error_m;
+			square_sum += error_m * error_m;
+			range_count++;
+		}
+
+		float determinant = a_xx * a_yy - a_xy * a_xy;
+
+		if (determinant <= 1.0e-6f)
+		{
+			return false;
+		}
+
+		/* The last pass only measures the position, two ranges intersect exactly and need no steps */
+		if (iteration == REFINE_ITERATIONS || range_count <= 2)
+		{
+			position->x_m          = x_m;
+			position->y_m          = y_m;
+			position->residual_m   = sqrtf(square_sum / range_count);
+			position->gdop         = sqrtf((a_xx + a_yy) / determinant);
+			position->sensor_count = range_count;
+			return true;
+		}
+
+		x_m -= (a_yy * b_x - a_xy * b_y) / determinant;
+		y_m -= (a_xx * b_y - a_xy * b_x) / determinant;
+	}
+
+	return false;
+}
+
+
+/**
+ * @brief Intersect the range circles of two sensors and add the gated candidates
+ */
+static uint16_t add_candidates(acc_trilateration_t *trilateration, uint8_t sensor_a, int8_t peak_a, uint8_t sensor_b,
+                               int8_t peak_b, float ranges_m[][ACC_TRILATERATION_MAX_PEAKS], const bool *usable,
+                               uint16_t candidate_count)
+{
+	const acc_trilateration_parameters_t *parameters = &trilateration->parameters;
+
+	float x_a_m        = parameters->sensor_x_m[sensor_a];
+	float y_a_m        = parameters->sensor_y_m[sensor_a];
+	float baseline_x_m = parameters->sensor_x_m[sensor_b] - x_a_m;
+	float baseline_y_m = parameters->sensor_y_m[sensor_b] - y_a_m;
+	float baseline_m   = sqrtf(baseline_x_m * baseline_x_m + baseline_y_m * baseline_y_m);
+	float range_a_m    = ranges_m[sensor_a][peak_a];
+	float range_b_m    = ranges_m[sensor_b][peak_b];
+
+	if (range_a_m + range_b_m < baseline_m - parameters->max_residual_m ||
+	    fabsf(range_a_m - range_b_m) > baseline_m + parameters->max_residual_m)
+	{
+		return candidate_count;
+	}
+
+	/* Circles that miss each other by less than the residual gate touch at the closest point */
+	float along_m       = (range_a_m * range_a_m - range_b_m * range_b_m + baseline_m * baseline_m) / (2.0f * baseline_m);
+	float across_square = range_a_m * range_a_m - along_m * along_m;
+	float across_m      = across_square > 0.0f ? sqrtf(across_square) : 0.0f;
+
+	for (int8_t side = -1; side <= 1; side += 2)
+	{
+		if (across_m == 0.0f && side < 0)
+		{
+			continue;
+		}
+
+		acc_trilateration_candidate_t *candidate = &trilateration->candidates[candidate_count];
+		float                          candidate_ranges_m[ACC_TRILATERATION_MAX_SENSORS] = { 0.0f };
+
+		candidate->position.x_m = x_a_m + (along_m * baseline_x_m - side * across_m * baseline_y_m) / baseline_m;
+		candidate->position.y_m = y_a_m + (along_m * baseline_y_m + side * across_m * baseline_x_m) / baseline_m;
+
+		if (candidate->position.y_m < parameters->min_y_m)
+		{
+			continue;
+		}
+
+		/* The other sensors support the position with their closest range within the residual gate */
+		for (uint8_t s = 0; s < parameters->sensor_count; s++)
+		{
+			candidate->peak[s] = -1;
+
+			if (s == sensor_a || s == sensor_b)
+			{
+				candidate->peak[s]    = s == sensor_a ? peak_a : peak_b;
+				candidate_ranges_m[s] = ranges_m[s][candidate->peak[s]];
+				continue;
+			}
+
+			if (!usable[s])
+			{
+				continue;
+			}
+
+			float dx_m       = candidate->position.x_m - parameters->sensor_x_m[s];
+			float dy_m       = candidate->position.y_m - parameters->sensor_y_m[s];
+			float distance_m = sqrtf(dx_m * dx_m + dy_m * dy_m);
+			float best_m     = parameters->max_residual_m;
+
+			for (uint16_t p = 0; p < trilateration->sensors[s].peak_count; p++)
+			{
+				float error_m = fabsf(ranges_m[s][p] - distance_m);
+
+				if (error_m <= best_m)
+				{
+					best_m                = error_m;
+					candidate->peak[s]    = (int8_t)p;
+					candidate_ranges_m[s] = ranges_m[s][p];
+				}
+			}
+		}
+
+		if (refine_position(&candidate->position, parameters, candidate_ranges_m, candidate->peak) &&
+		    candidate->position.sensor_count >= parameters->min_sensors &&
+		    candidate->position.residual_m <= parameters->max_residual_m &&
+		    candidate->position.gdop <= parameters->max_gdop &&
+		    candidate->position.y_m >= parameters->min_y_m)
+		{
+			candidate_count++;
+		}
+	}
+
+	return candidate_count;
+}
+
+
+static void track_update(acc_trilateration_track_t *track, const acc_trilateration_parameters_t *parameters,
+                         const acc_trilateration_position_t *position, float dt_s)
+{
+	float residual_x_m = position->x_m - track->x_m;
+	float residual_y_m = position->y_m - track->y_m;
+
+	if (track->hits == 1)
+	{
+		/* The second position gives the first velocity estimate */
+		track->velocity_x_mps = dt_s > 0.0f ? residual_x_m / dt_s : 0.0f;
+		track->velocity_y_mps = dt_s > 0.0f ? residual_y_m / dt_s : 0.0f;
+		track->x_m            = position->x_m;
+		track->y_m            = position->y_m;
+	}
+	else
+	{
+		track->x_m += parameters->alpha * residual_x_m;
+		track->y_m += parameters->alpha * residual_y_m;
+
+		if (dt_s > 0.0f)
+		{
+			track->velocity_x_mps += parameters->beta * residual_x_m / dt_s;
+			track->velocity_y_mps += parameters->beta * residual_y_m / dt_s;
+		}
+	}
+
+	track->misses = 0;
+
+	if (track->hits < UINT16_MAX)
+	{
+		track->hits++;
+	}
+
+	if (track->hits >= parameters->confirm_hits)
+	{
+		track->confirmed = true;
+	}
+}
+
+
+static void tracks_update(acc_trilateration_t *trilateration, float dt_s)
+{
+	const acc_trilateration_parameters_t *parameters = &trilateration->parameters;
+
+	/* Predict and collect the gated pairs */
+	uint16_t pair_count = 0;
+
+	for (uint16_t t = 0; t < trilateration->track_count; t++)
+	{
+		acc_trilateration_track_t *track = &trilateration->tracks[t];
+
+		track->x_m                       += track->velocity_x_mps * dt_s;
+		track->y_m                       += track->velocity_y_mps * dt_s;
+		trilateration->track_assigned[t]  = false;
+
+		for (uint16_t p = 0; p < trilateration->position_count; p++)
+		{
+			float dx_m = trilateration->positions[p].x_m - track->x_m;
+			float dy_m = trilateration->positions[p].y_m - track->y_m;
+			float cost = sqrtf(dx_m * dx_m + dy_m * dy_m);
+
+			if (cost <= parameters->gate_m)
+			{
+				acc_trilateration_pair_t *pair = &trilateration->pairs[pair_count++];
+
+				pair->track     = (uint8_t)t;
+				pair->position  = (uint8_t)p;
+				pair->confirmed = track->confirmed;
+				pair->cost      = cost;
+			}
+		}
+	}
+
+	for (uint16_t p = 0; p < trilateration->position_count; p++)
+	{
+		trilateration->position_assigned[p] = false;
+	}
+
+	/* Assign the closest pairs first, each track and position at most once */
+	qsort(trilateration->pairs, pair_count, sizeof(trilateration->pairs[0]), compare_pairs);
+
+	for (uint16_t i = 0; i < pair_count; i++)
+	{
+		const acc_trilateration_pair_t *pair = &trilateration->pairs[i];
+
+		if (!trilateration->track_assigned[pair->track] && !trilateration->position_assigned[pair->position])
+		{
+			trilateration->track_assigned[pair->track]       = true;
+			trilateration->position_assigned[pair->position] = true;
+
+			track_update(&trilateration->tracks[pair->track], parameters, &trilateration->positions[pair->position],
+			             dt_s);
+		}
+	}
+
+	/* Delete tracks that missed too many updates, the last track takes the place of a deleted one */
+	uint16_t t = 0;
+
+	while (t < trilateration->track_count)
+	{
+		acc_trilateration_track_t *track = &trilateration->tracks[t];
+
+		if (!trilateration->track_assigned[t] && track->misses < UINT16_MAX)
+		{
+			track->misses++;
+		}
+
+		/* A target may be out of view of some sensors, so a tentative track gets a round of updates */
+		bool expired = track->confirmed ? track->misses > parameters->delete_misses :
+		               track->misses >= parameters->sensor_count;
+
+		if (!trilateration->track_assigned[t] && expired)
+		{
+			trilateration->track_count--;
+			*track                           = trilateration->tracks[trilateration->track_count];
+			trilateration->track_assigned[t] = trilateration->track_assigned[trilateration->track_count];
+		}
+		else
+		{
+			t++;
+		}
+	}
+
+	/* Positions without a track start tentative tracks */
+	for (uint16_t p = 0; p < trilateration->position_count && trilateration->track_count < ACC_TRILATERATION_MAX_TRACKS;
+	     p++)
+	{
+		if (!trilateration->position_assigned[p])
+		{
+			acc_trilateration_track_t *track = &trilateration->tracks[trilateration->track_count++];
+
+			track->id             = trilateration->next_id++;
+			track->x_m            = trilateration->positions[p].x_m;
+			track->y_m            = trilateration->positions[p].y_m;
+			track->velocity_x_mps = 0.0f;
+			track->velocity_y_mps = 0.0f;
+			track->hits           = 1;
+			track->misses         = 0;
+			track->confirmed      = parameters->confirm_hits <= 1;
+		}
+	}
+}
+
+
+bool acc_trilateration_init(acc_trilateration_t *trilateration, const acc_trilateration_parameters_t *parameters)
+{
+	if (parameters->sensor_count < 2 || parameters->sensor_count > ACC_TRILATERATION_MAX_SENSORS ||
+	    parameters->max_speed_mps < 0.0f || parameters->max_residual_m <= 0.0f || parameters->max_gdop <= 0.0f ||
+	    parameters->min_sensors < 2 || parameters->min_sensors > parameters->sensor_count ||
+	    parameters->alpha <= 0.0f || parameters->alpha > 1.0f || parameters->beta < 0.0f || parameters->beta > 2.0f ||
+	    parameters->gate_m <= 0.0f || parameters->confirm_hits == 0)
+	{
+		return false;
+	}
+
+	/* Coincident sensors have no baseline to intersect on */
+	for (uint8_t a = 0; a < parameters->sensor_count; a++)
+	{
+		for (uint8_t b = a + 1; b < parameters->sensor_count; b++)
+		{
+			if (parameters->sensor_x_m[a] == parameters->sensor_x_m[b] &&
+			    parameters->sensor_y_m[a] == parameters->sensor_y_m[b])
+			{
+				return false;
+			}
+		}
+	}
+
+	memset(trilateration->sensors, 0, sizeof(trilateration->sensors));
+
+	trilateration->parameters     = *parameters;
+	trilateration->position_count = 0;
+	trilateration->track_count    = 0;
+	trilateration->next_id        = 1;
+	trilateration->time_ms        = 0;
+	trilateration->has_time       = false;
+
+	return true;
+}
+
+
+uint16_t acc_trilateration_update(acc_trilateration_t *trilateration, uint8_t sensor,
+                                  const acc_detector_distance_result_t *peaks, uint16_t peak_count, uint32_t time_ms)
+{
+	const acc_trilateration_parameters_t *parameters = &trilateration->parameters;
+
+	int32_t age_ms = trilateration->has_time ? (int32_t)(trilateration->time_ms - time_ms) : 0;
+
+	if (sensor >= parameters->sensor_count || age_ms > (int32_t)parameters->max_age_ms)
+	{
+		return 0;
+	}
+
+	if (peak_count > ACC_TRILATERATION_MAX_PEAKS)
+	{
+		peak_count = ACC_TRILATERATION_MAX_PEAKS;
+	}
+
+	sensor_update(&trilateration->sensors[sensor], parameters, peaks, peak_count, time_ms);
+
+	/* Move the peaks of the other sensors to the time of the update */
+	float ranges_m[ACC_TRILATERATION_MAX_SENSORS][ACC_TRILATERATION_MAX_PEAKS];
+	bool  usable[ACC_TRILATERATION_MAX_SENSORS];
+
+	for (uint8_t s = 0; s < parameters->sensor_count; s++)
+	{
+		const acc_trilateration_sensor_t *other        = &trilateration->sensors[s];
+		int32_t                           other_age_ms = (int32_t)(time_ms - other->time_ms);
+
+		usable[s] = other->valid && abs(other_age_ms) <= parameters->max_age_ms;
+
+		for (uint16_t p = 0; usable[s] && p < other->peak_count; p++)
+		{
+			ranges_m[s][p] = other->range_m[p] + other->range_rate_mps[p] * (float)other_age_ms / 1000.0f;
+		}
+	}
+
+	/* Every candidate has a peak of the updating sensor, so that no update is counted twice */
+	uint16_t candidate_count = 0;
+
+	for (uint8_t s = 0; s < parameters->sensor_count; s++)
+	{
+		if (s == sensor || !usable[s])
+		{
+			continue;
+		}
+
+		for (int8_t p = 0; p < (int8_t)peak_count; p++)
+		{
+			for (int8_t q = 0; q < (int8_t)trilateration->sensors[s].peak_count; q++)
+			{
+				candidate_count = add_candidates(trilateration, sensor, p, s, q, ranges_m, usable, candidate_count);
+			}
+		}
+	}
+
+	/* Select the candidates with the most sensors and the lowest residual, each peak at most once */
+	bool peak_used[ACC_TRILATERATION_MAX_SENSORS][ACC_TRILATERATION_MAX_PEAKS];
+
+	memset(peak_used, 0, sizeof(peak_used));
+	qsort(trilateration->candidates, candidate_count, sizeof(trilateration->candidates[0]), compare_candidates);
+
+	trilateration->position_count = 0;
+
+	for (uint16_t c = 0; c < candidate_count && trilateration->position_count < MAX_POSITIONS; c++)
+	{
+		const acc_trilateration_candidate_t *candidate = &trilateration->candidates[c];
+		bool                                 available = true;
+
+		for (uint8_t s = 0; s < parameters->sensor_count; s++)
+		{
+			available = available && (candidate->peak[s] < 0 || !peak_used[s][candidate->peak[s]]);
+		}
+
+		if (!available)
+		{
+			continue;
+		}
+
+		for (uint8_t s = 0; s < parameters->sensor_count; s++)
+		{
+			if (candidate->peak[s] >= 0)
+			{
+				peak_used[s][candidate->peak[s]] = true;
+			}
+		}
+
+		trilateration->positions[trilateration->position_count++] = candidate->position;
+	}
+
+	/* An update that arrives after a later one of another sensor does not move the tracks back */
+	float dt_s = age_ms < 0 ? (float)(-age_ms) / 1000.0f : 0.0f;
+
+	tracks_update(trilateration, dt_s);
+
+	if (age_ms <= 0)
+	{
+		trilateration->time_ms = time_ms;
+	}
+
+	trilateration->has_time = true;
+
+	return trilateration->position_count;
+}
+
+
+uint16_t acc_trilateration_get_positions(const acc_trilateration_t *trilateration,
+                                         acc_trilateration_position_t *positions, uint16_t max_position_count)
+{
+	uint16_t count = trilateration->position_count < max_position_count ? trilateration->position_count :
+	                 max_position_count;
+
+	memcpy(positions, trilateration->positions, count * sizeof(positions[0]));
+
+	return count;
+}
+
+
+uint16_t acc_trilateration_get_confirmed(const acc_trilateration_t *trilateration, acc_trilateration_track_t *tracks,
+                                         uint16_t max_track_count)
+{
+	uint16_t count = 0;
+
+	for (uint16_t t = 0; t < trilateration->track_count; t++)
+	{
+		const acc_trilateration_track_t *track      = &trilateration->tracks[t];
+		float                            distance_m = sqrtf(track->x_m * track->x_m + track->y_m * track->y_m);
+
+		if (!track->confirmed)
+		{
+			continue;
+		}
+
+		/* Insert in order of distance, the farthest track is dropped when the array is full */
+		uint16_t i = count < max_track_count ? count++ : max_track_count;
+
+		while (i > 0 && sqrtf(tracks[i - 1].x_m * tracks[i - 1].x_m + tracks[i - 1].y_m * tracks[i - 1].y_m) > distance_m)
+		{
+			if (i < max_track_count)
+			{
+				tracks[i] = tracks[i - 1];
+			}
+
+			i--;
+		}
+
+		if (i < max_track_count)
+		{
+			tracks[i] = *track;
+		}
+	}
+
+	return count;
+}
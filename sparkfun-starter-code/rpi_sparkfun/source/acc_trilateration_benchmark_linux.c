@@ -0,0 +1,449 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <getopt.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "acc_benchmark_util.h"
+#include "acc_trilateration.h"
+
+
+#define DEFAULT_DURATION_S     (600)
+#define DEFAULT_SENSOR_RATE    (20)
+#define DEFAULT_SENSOR_COUNT   (3)
+#define DEFAULT_TARGET_COUNT   (3)
+#define MAX_TARGETS            (6)
+#define BUMPER_WIDTH_M         (1.2f)
+#define FIELD_OF_VIEW_DEG      (60.0f)
+#define MAX_RANGE_M            (6.0f)
+#define MIN_X_M                (-3.0f)
+#define MAX_X_M                (3.0f)
+#define MIN_Y_M                (0.5f)
+#define MAX_Y_M                (5.0f)
+#define MAX_SPEED_MPS          (2.0f)
+#define RANGE_NOISE_M          (0.005f)
+#define RANGE_RESOLUTION_M     (0.05f)
+#define DETECTION_PROBABILITY  (0.9f)
+#define FALSE_PEAK_PROBABILITY (0.3f)
+#define POSITION_MATCH_M       (0.3f)
+#define TRACK_MATCH_M          (0.5f)
+
+#ifndef M_PI
+#define M_PI (3.14159265358979323846)
+#endif
+
+
+typedef struct
+{
+	float x_m;
+	float y_m;
+	float velocity_x_mps;
+	float velocity_y_mps;
+} target_t;
+
+
+static acc_trilateration_t            trilateration;
+static target_t                       targets[MAX_TARGETS];
+static acc_detector_distance_result_t peaks[ACC_TRILATERATION_MAX_PEAKS];
+static acc_trilateration_position_t   positions[ACC_TRILATERATION_MAX_SENSORS * ACC_TRILATERATION_MAX_PEAKS];
+static acc_trilateration_track_t      tracks[ACC_TRILATERATION_MAX_TRACKS];
+
+
+static void move_targets(uint16_t target_count, float dt_s)
+{
+	for (uint16_t t = 0; t < target_count; t++)
+	{
+		target_t *target = &targets[t];
+
+		target->x_m += target->velocity_x_mps * dt_s;
+		target->y_m += target->velocity_y_mps * dt_s;
+
+		/* The targets bounce inside the scene */
+		if (target->x_m < MIN_X_M || target->x_m > MAX_X_M)
+		{
+			target->velocity_x_mps = -target->velocity_x_mps;
+			target->x_m            = fminf(fmaxf(target->x_m, MIN_X_M), MAX_X_M);
+		}
+
+		if (target->y_m < MIN_Y_M || target->y_m > MAX_Y_M)
+		{
+			target->velocity_y_mps = -target->velocity_y_mps;
+			target->y_m            = fminf(fmaxf(target->y_m, MIN_Y_M), MAX_Y_M);
+		}
+	}
+}
+
+
+static bool is_visible(const acc_trilateration_parameters_t *parameters, uint8_t sensor, const target_t *target,
+                       float *range_m)
+{
+	float dx_m = target->x_m - parameters->sensor_x_m[sensor];
+	float dy_m = target->y_m - parameters->sensor_y_m[sensor];
+
+	*range_m = sqrtf(dx_m * dx_m + dy_m * dy_m);
+
+	return *range_m <= MAX_RANGE_M && fabsf(atan2f(dx_m, dy_m)) <= FIELD_OF_VIEW_DEG * (float)M_PI / 180.0f;
+}
+
+
+/**
+ * @brief The peaks of a sensor, targets closer than the range resolution merge and peaks are in order of distance
+ */
+static uint16_t generate_peaks(const acc_trilateration_parameters_t *parameters, uint8_t sensor, uint16_t target_count,
+                               uint32_t *state)
+{
+	uint16_t peak_count = 0;
+
+	for (uint16_t t = 0; t <= target_count && peak_count < ACC_TRILATERATION_MAX_PEAKS; t++)
+	{
+		float range_m;
+
+		if (t == target_count)
+		{
+			if (acc_benchmark_next_uniform(state) >= FALSE_PEAK_PROBABILITY)
+			{
+				break;
+			}
+
+			range_m = 0.3f + (MAX_RANGE_M - 0.3f) * acc_benchmark_next_uniform(state);
+		}
+		else if (!is_visible(parameters, sensor, &targets[t], &range_m) ||
+		         acc_benchmark_next_uniform(state) >= DETECTION_PROBABILITY)
+		{
+			continue;
+		}
+
+		range_m += RANGE_NOISE_M * acc_benchmark_next_noise(state);
+
+		bool merged = false;
+
+		for (uint16_t p = 0; p < peak_count; p++)
+		{
+			merged = merged || fabsf(peaks[p].distance_m - range_m) < RANGE_RESOLUTION_M;
+		}
+
+		if (merged)
+		{
+			continue;
+		}
+
+		uint16_t i = peak_count++;
+
+		while (i > 0 && peaks[i - 1].distance_m > range_m)
+		{
+			peaks[i] = peaks[i - 1];
+			i--;
+		}
+
+		peaks[i].distance_m = range_m;
+		peaks[i].amplitude  = 1000;
+	}
+
+	return peak_count;
+}
+
+
+/**
+ * @brief The distance to the closest target, infinite without targets so that nothing matches
+ */
+static float distance_to_target(float x_m, float y_m, uint16_t target_count, uint16_t *closest)
+{
+	float best_m = INFINITY;
+
+	*closest = 0;
+
+	for (uint16_t t = 0; t < target_count; t++)
+	{
+		float distance_m = hypotf(x_m - targets[t].x_m, y_m - targets[t].y_m);
+
+		if (distance_m < best_m)
+		{
+			best_m   = distance_m;
+			*closest = t;
+		}
+	}
+
+	return best_m;
+}
+
+
+static bool run(uint32_t duration_s, uint32_t sensor_rate, uint8_t sensor_count, uint16_t target_count)
+{
+	acc_trilateration_parameters_t parameters =
+	{
+		.sensor_count   = sensor_count,
+		.max_age_ms     = (uint16_t)(1500 / sensor_rate),
+		.max_speed_mps  = 1.5f * MAX_SPEED_MPS,
+		.max_residual_m = 0.05f,
+		.max_gdop       = 10.0f,
+		.min_y_m        = 0.2f,
+		.min_sensors    = 2,
+		.alpha          = 0.3f,
+		.beta           = 0.05f,
+		.gate_m         = 0.4f,
+		.confirm_hits   = 2 * sensor_count,
+		.delete_misses  = 4 * sensor_count,
+	};
+
+	for (uint8_t s = 0; s < sensor_count; s++)
+	{
+		parameters.sensor_x_m[s] = -BUMPER_WIDTH_M / 2.0f + BUMPER_WIDTH_M * s / (sensor_count - 1);
+		parameters.sensor_y_m[s] = 0.0f;
+	}
+
+	if (!acc_trilateration_init(&trilateration, &parameters))
+	{
+		fprintf(stderr, "ERROR: Invalid parameters\n");
+		return false;
+	}
+
+	uint32_t state = 1;
+
+	for (uint16_t t = 0; t < target_count; t++)
+	{
+		float speed_mps = 0.2f + (MAX_SPEED_MPS - 0.2f) * acc_benchmark_next_uniform(&state);
+		float angle     = 2.0f * (float)M_PI * acc_benchmark_next_uniform(&state);
+
+		targets[t].x_m            = MIN_X_M + (MAX_X_M - MIN_X_M) * acc_benchmark_next_uniform(&state);
+		targets[t].y_m            = MIN_Y_M + (MAX_Y_M - MIN_Y_M) * acc_benchmark_next_uniform(&state);
+		targets[t].velocity_x_mps = speed_mps * cosf(angle);
+		targets[t].velocity_y_mps = speed_mps * sinf(angle);
+	}
+
+	/* The sensors update in turn, evenly spread over the sensor period */
+	uint32_t update_count    = duration_s * sensor_rate * sensor_count;
+	double   combined_rate   = (double)sensor_rate * sensor_count;
+	uint32_t previous_ms     = 0;
+	uint64_t total_ns        = 0;
+	uint64_t max_ns          = 0;
+	uint64_t position_count  = 0;
+	uint64_t ghost_count     = 0;
+	double   position_square = 0.0;
+	double   gdop_sum        = 0.0;
+	uint64_t track_count     = 0;
+	uint64_t false_tracks    = 0;
+	double   track_square    = 0.0;
+	uint64_t located_count   = 0;
+	uint64_t locatable_count = 0;
+
+	for (uint32_t n = 0; n < update_count; n++)
+	{
+		uint32_t time_ms = (uint32_t)((double)n * 1000.0 / combined_rate);
+		uint8_t  sensor  = (uint8_t)(n % sensor_count);
+
+		move_targets(target_count, (float)(time_ms - previous_ms) / 1000.0f);
+		previous_ms = time_ms;
+
+		uint16_t peak_count = generate_peaks(&parameters, sensor, target_count, &state);
+		uint64_t start_ns   = acc_benchmark_get_cpu_time_ns();
+
+		acc_trilateration_update(&trilateration, sensor, peaks, peak_count, time_ms);
+
+		uint64_t update_ns = acc_benchmark_get_cpu_time_ns() - start_ns;
+
+		total_ns += update_ns;
+		max_ns    = update_ns > max_ns ? update_ns : max_ns;
+
+		/* Skip the first seconds while the tracks are confirmed */
+		if (time_ms < 2000)
+		{
+			continue;
+		}
+
+		uint16_t count = acc_trilateration_get_positions(&trilateration, positions,
+		                                                 sizeof(positions) / sizeof(positions[0]));
+
+		for (uint16_t p = 0; p < count; p++)
+		{
+			uint16_t closest;
+			float    error_m = distance_to_target(positions[p].x_m, positions[p].y_m, target_count, &closest);
+
+			position_count++;
+
+			if (error_m > POSITION_MATCH_M)
+			{
+				ghost_count++;
+			}
+			else
+			{
+				position_square += (double)(error_m * error_m);
+				gdop_sum        += (double)positions[p].gdop;
+			}
+		}
+
+		count = acc_trilateration_get_confirmed(&trilateration, tracks, ACC_TRILATERATION_MAX_TRACKS);
+
+		bool has_track[MAX_TARGETS] = { false };
+
+		for (uint16_t t = 0; t < count; t++)
+		{
+			uint16_t closest;
+			float    error_m = distance_to_target(tracks[t].x_m, tracks[t].y_m, target_count, &closest);
+
+			track_count++;
+
+			if (error_m > TRACK_MATCH_M)
+			{
+				false_tracks++;
+			}
+			else
+			{
+				track_square      += (double)(error_m * error_m);
+				has_track[closest] = true;
+			}
+		}
+
+		/* A target is locatable when two sensors can see it */
+		for (uint16_t t = 0; t < target_count; t++)
+		{
+			uint8_t visible = 0;
+			float   range_m;
+
+			for (uint8_t s = 0; s < sensor_count; s++)
+			{
+				visible += is_visible(&parameters, s, &targets[t], &range_m) ? 1 : 0;
+			}
+
+			if (visible >= 2)
+			{
+				locatable_count++;
+				located_count += has_track[t] ? 1 : 0;
+			}
+		}
+	}
+
+	uint64_t matched_positions = position_count - ghost_count;
+	uint64_t matched_tracks    = track_count - false_tracks;
+
+	printf("%u sensors at %u Hz, %u targets, %u s, %u updates\n\n", (unsigned int)sensor_count,
+	       (unsigned int)sensor_rate, (unsigned int)target_count, (unsigned int)duration_s,
+	       (unsigned int)update_count);
+	printf("Positions per update:  %.2f\n", (double)position_count / update_count);
+	printf("Position error:        %.1f mm rms\n",
+	       matched_positions > 0 ? sqrt(position_square / matched_positions) * 1000.0 : 0.0);
+	printf("Position GDOP:         %.1f mean\n", matched_positions > 0 ? gdop_sum / matched_positions : 0.0);
+	printf("Ghost positions:       %.2f %%\n", position_count > 0 ? 100.0 * ghost_count / position_count : 0.0);
+	printf("Track error:           %.1f mm rms\n",
+	       matched_tracks > 0 ? sqrt(track_square / matched_tracks) * 1000.0 : 0.0);
+	printf("False tracks:          %.2f %%\n", track_count > 0 ? 100.0 * false_tracks / track_count : 0.0);
+	printf("Located targets:       %.2f %% of the updates with two sensors in view\n",
+	       locatable_count > 0 ? 100.0 * located_count / locatable_count : 0.0);
+	printf("CPU time per update:   %.2f us mean, %.2f us max, %.2f %% of the combined period\n",
+	       (double)total_ns / update_count / 1000.0, (double)max_ns / 1000.0,
+	       100.0 * (double)max_ns * combined_rate / 1.0e9);
+
+	return true;
+}
+
+
+static void print_usage(char *application_name)
+{
+	fprintf(stderr, "Usage: %s [OPTION]...\n", application_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Run trilateration on a simulated scene of targets moving in front of sensors along a\n");
+	fprintf(stderr, "%.1f m bumper, with missed detections, false peaks and merged peaks. Report the position\n",
+	        (double)BUMPER_WIDTH_M);
+	fprintf(stderr, "and track errors, the ghosts and the CPU time per sensor update.\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "-h, --help                      this help\n");
+	fprintf(stderr, "-d, --duration                  the simulated time in seconds, default %u\n",
+	        (unsigned int)DEFAULT_DURATION_S);
+	fprintf(stderr, "-r, --sensor-rate               the update rate of each sensor in Hz, default %u\n",
+	        (unsigned int)DEFAULT_SENSOR_RATE);
+	fprintf(stderr, "-s, --sensors                   the number of sensors, 2 to %u, default %u\n",
+	        (unsigned int)ACC_TRILATERATION_MAX_SENSORS, (unsigned int)DEFAULT_SENSOR_COUNT);
+	fprintf(stderr, "-t, --targets                   the number of targets, 1 to %u, default %u\n",
+	        (unsigned int)MAX_TARGETS, (unsigned int)DEFAULT_TARGET_COUNT);
+}
+
+
+int main(int argc, char *argv[])
+{
+	static struct option long_options[] =
+	{
+		{"help",             no_argument,       0,      'h'},
+		{"duration",         required_argument, 0,      'd'},
+		{"sensor-rate",      required_argument, 0,      'r'},
+		{"sensors",          required_argument, 0,      's'},
+		{"targets",          required_argument, 0,      't'},
+		{NULL,               0,                 NULL,   0}
+	};
+
+	int character_code;
+	int option_index = 0;
+
+	uint32_t duration_s   = DEFAULT_DURATION_S;
+	uint32_t sensor_rate  = DEFAULT_SENSOR_RATE;
+	uint8_t  sensor_count = DEFAULT_SENSOR_COUNT;
+	uint16_t target_count = DEFAULT_TARGET_COUNT;
+
+	while ((character_code = getopt_long(argc, argv, "h?d:r:s:t:", long_options, &option_index)) != -1)
+	{
+		switch (character_code)
+		{
+			case 'd':
+			case 'r':
+			{
+				int value = atoi(optarg);
+
+				if (value <= 0 || value > 100000 || (character_code == 'r' && value > 1000))
+				{
+					fprintf(stderr, "ERROR: Invalid value '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				if (character_code == 'd')
+				{
+					duration_s = (uint32_t)value;
+				}
+				else
+				{
+					sensor_rate = (uint32_t)value;
+				}
+
+				break;
+			}
+			case 's':
+			{
+				int value = atoi(optarg);
+
+				if (value < 2 || value > ACC_TRILATERATION_MAX_SENSORS)
+				{
+					fprintf(stderr, "ERROR: Invalid number of sensors '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				sensor_count = (uint8_t)value;
+				break;
+			}
+			case 't':
+			{
+				int value = atoi(optarg);
+
+				if (value < 1 || value > MAX_TARGETS)
+				{
+					fprintf(stderr, "ERROR: Invalid number of targets '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				target_count = (uint16_t)value;
+				break;
+			}
+			default:
+			{
+				print_usage(basename(argv[0]));
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	return run(duration_s, sensor_rate, sensor_count, target_count) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
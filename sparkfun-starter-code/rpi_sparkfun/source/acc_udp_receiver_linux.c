@@ -0,0 +1,188 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "acc_udp_stream.h"
+
+
+#define DEFAULT_UDP_PORT          (6111)
+#define DEFAULT_REPORT_INTERVAL_S (1)
+#define RECEIVE_TIMEOUT_MS        (200)
+
+volatile sig_atomic_t interrupted = 0;
+
+
+static void interrupt_handler(int signum)
+{
+	if (signum == SIGINT)
+	{
+		interrupted = 1;
+	}
+}
+
+
+static uint32_t get_time_s(void)
+{
+	struct timespec time_ts = {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &time_ts);
+	return (uint32_t)time_ts.tv_sec;
+}
+
+
+static void print_usage(char *application_name)
+{
+	fprintf(stderr, "Usage: %s [OPTION]...\n", application_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Reference receiver for the exploration server UDP stream\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "-h, --help                      this help\n");
+	fprintf(stderr, "-g, --group                     the multicast group to join, unicast if not set\n");
+	fprintf(stderr, "-p, --port                      the UDP port to listen on\n");
+	fprintf(stderr, "-i, --interval                  the report interval in seconds\n");
+}
+
+
+static void print_report(const acc_udp_stream_receiver_stats_t *stats, const acc_udp_stream_receiver_stats_t *last,
+                         uint32_t interval_s, uint64_t age_sum_us, uint64_t age_max_us)
+{
+	uint32_t frames       = stats->frames_received - last->frames_received;
+	uint32_t lost         = stats->frames_lost - last->frames_lost;
+	uint64_t bytes        = stats->bytes_received - last->bytes_received;
+	uint32_t loss_permill = frames + lost > 0 ? (uint32_t)(((uint64_t)lost * 1000) / (frames + lost)) : 0;
+
+	printf("frames/s: %" PRIu32 ", kB/s: %" PRIu64 ", lost: %" PRIu32 " (%" PRIu32 ".%" PRIu32 "%%), "
+	       "incomplete: %" PRIu32 ", stale: %" PRIu32 ", invalid: %" PRIu32 ", resyncs: %" PRIu32 ", "
+	       "age avg/max: %" PRIu64 "/%" PRIu64 " us\n",
+	       frames / interval_s, bytes / 1000 / interval_s, lost, loss_permill / 10, loss_permill % 10,
+	       stats->frames_incomplete - last->frames_incomplete, stats->datagrams_stale - last->datagrams_stale,
+	       stats->datagrams_invalid - last->datagrams_invalid, stats->resyncs - last->resyncs,
+	       frames > 0 ? age_sum_us / frames : 0, age_max_us);
+	fflush(stdout);
+}
+
+
+int main(int argc, char *argv[])
+{
+	static struct option long_options[] =
+	{
+		{"help",             no_argument,       0,      'h'},
+		{"group",            required_argument, 0,      'g'},
+		{"port",             required_argument, 0,      'p'},
+		{"interval",         required_argument, 0,      'i'},
+		{NULL,               0,                 NULL,   0}
+	};
+
+	int character_code;
+	int option_index = 0;
+
+	char     *group            = NULL;
+	int      udp_port          = DEFAULT_UDP_PORT;
+	uint32_t report_interval_s = DEFAULT_REPORT_INTERVAL_S;
+
+	while ((character_code = getopt_long(argc, argv, "h?g:p:i:", long_options, &option_index)) != -1)
+	{
+		switch (character_code)
+		{
+			case 'h':
+			case '?':
+			{
+				print_usage(basename(argv[0]));
+				return EXIT_FAILURE;
+			}
+			case 'g':
+			{
+				group = optarg;
+				break;
+			}
+			case 'p':
+			{
+				int value = atoi(optarg);
+				if (value <= 0)
+				{
+					fprintf(stderr, "ERROR: Invalid udp port '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				udp_port = value;
+				break;
+			}
+			case 'i':
+			{
+				int value = atoi(optarg);
+				if (value <= 0)
+				{
+					fprintf(stderr, "ERROR: Invalid report interval '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				report_interval_s = (uint32_t)value;
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	signal(SIGINT, interrupt_handler);
+
+	acc_udp_stream_receiver_t receiver;
+
+	if (!acc_udp_stream_receiver_open(&receiver, group, udp_port, ACC_UDP_STREAM_MAX_FRAME_SIZE))
+	{
+		fprintf(stderr, "ERROR: Could not open udp receiver\n");
+		return EXIT_FAILURE;
+	}
+
+	printf("Receiving on %s:%d\n", group != NULL ? group : "*", udp_port);
+
+	acc_udp_stream_receiver_stats_t last_stats    = receiver.stats;
+	uint32_t                        last_report_s = get_time_s();
+	uint64_t                        age_sum_us    = 0;
+	uint64_t                        age_max_us    = 0;
+
+	while (!interrupted)
+	{
+		const uint8_t               *frame;
+		size_t                      size;
+		acc_udp_stream_frame_info_t frame_info;
+
+		if (acc_udp_stream_receiver_get_next(&receiver, RECEIVE_TIMEOUT_MS, &frame, &size, &frame_info))
+		{
+			uint64_t now_us = acc_udp_stream_get_timestamp_us();
+			uint64_t age_us = now_us > frame_info.timestamp_us ? now_us - frame_info.timestamp_us : 0;
+
+			age_sum_us += age_us;
+			age_max_us  = age_us > age_max_us ? age_us : age_max_us;
+		}
+
+		if (get_time_s() - last_report_s >= report_interval_s)
+		{
+			print_report(&receiver.stats, &last_stats, report_interval_s, age_sum_us, age_max_us);
+
+			last_stats     = receiver.stats;
+			last_report_s += report_interval_s;
+			age_sum_us     = 0;
+			age_max_us     = 0;
+		}
+	}
+
+	printf("Total frames: %" PRIu32 ", lost: %" PRIu32 ", incomplete: %" PRIu32 "\n",
+	       receiver.stats.frames_received, receiver.stats.frames_lost, receiver.stats.frames_incomplete);
+
+	acc_udp_stream_receiver_close(&receiver);
+
+	return EXIT_SUCCESS;
+}
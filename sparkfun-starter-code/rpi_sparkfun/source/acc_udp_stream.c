@@ -0,0 +1,556 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "acc_udp_stream.h"
+
+#define UDP_STREAM_MAGIC   (0xACC5)
+#define UDP_STREAM_VERSION (1)
+
+#define IPV4_UDP_HEADER_SIZE (28)
+#define MAX_DATAGRAM_SIZE    (65507)
+#define MAX_FRAGMENT_COUNT   (65535)
+
+/* Datagrams of frames further back than this are from a restarted publisher, not late */
+#define REORDER_WINDOW_FRAMES (64)
+
+#define MS_PER_SECOND (1000)
+#define US_PER_SECOND (1000000)
+#define NS_PER_US     (1000)
+
+
+typedef struct
+{
+	uint16_t magic;
+	uint8_t  version;
+	uint32_t sequence_number;
+	uint64_t timestamp_us;
+	uint32_t frame_size;
+	uint32_t fragment_offset;
+	uint16_t fragment_index;
+	uint16_t fragment_count;
+} datagram_header_t;
+
+
+static void put_u16(uint8_t *buffer, uint16_t value)
+{
+	buffer[0] = (uint8_t)(value >> 8);
+	buffer[1] = (uint8_t)value;
+}
+
+
+static void put_u32(uint8_t *buffer, uint32_t value)
+{
+	put_u16(buffer, (uint16_t)(value >> 16));
+	put_u16(buffer + 2, (uint16_t)value);
+}
+
+
+static void put_u64(uint8_t *buffer, uint64_t value)
+{
+	put_u32(buffer, (uint32_t)(value >> 32));
+	put_u32(buffer + 4, (uint32_t)value);
+}
+
+
+static uint16_t get_u16(const uint8_t *buffer)
+{
+	return (uint16_t)((buffer[0] << 8) | buffer[1]);
+}
+
+
+static uint32_t get_u32(const uint8_t *buffer)
+{
+	return ((uint32_t)get_u16(buffer) << 16) | get_u16(buffer + 2);
+}
+
+
+static uint64_t get_u64(const uint8_t *buffer)
+{
+	return ((uint64_t)get_u32(buffer) << 32) | get_u32(buffer + 4);
+}
+
+
+static void header_pack(uint8_t *buffer, const datagram_header_t *header)
+{
+	put_u16(&buffer[0], header->magic);
+	buffer[2] = header->version;
+	buffer[3] = 0;
+	put_u32(&buffer[4], header->sequence_number);
+	put_u64(&buffer[8], header->timestamp_us);
+	put_u32(&buffer[16], header->frame_size);
+	put_u32(&buffer[20], header->fragment_offset);
+	put_u16(&buffer[24], header->fragment_index);
+	put_u16(&buffer[26], header->fragment_count);
+}
+
+
+static void header_unpack(const uint8_t *buffer, datagram_header_t *header)
+{
+	header->magic           = get_u16(&buffer[0]);
+	header->version         = buffer[2];
+	header->sequence_number = get_u32(&buffer[4]);
+	header->timestamp_us    = get_u64(&buffer[8]);
+	header->frame_size      = get_u32(&buffer[16]);
+	header->fragment_offset = get_u32(&buffer[20]);
+	header->fragment_index  = get_u16(&buffer[24]);
+	header->fragment_count  = get_u16(&buffer[26]);
+}
+
+
+static bool parse_address(const char *address, struct in_addr *in_address)
+{
+	if (inet_pton(AF_INET, address, in_address) != 1)
+	{
+		fprintf(stderr, "ERROR: Invalid IPv4 address '%s'\n", address);
+		return false;
+	}
+
+	return true;
+}
+
+
+uint64_t acc_udp_stream_get_timestamp_us(void)
+{
+	struct timespec time_ts = {0};
+
+	/* Wall clock so that hosts with synchronized clocks can measure one way latency */
+	clock_gettime(CLOCK_REALTIME, &time_ts);
+	return (uint64_t)time_ts.tv_sec * US_PER_SECOND + (uint64_t)time_ts.tv_nsec / NS_PER_US;
+}
+
+
+bool acc_udp_stream_publisher_open(acc_udp_stream_publisher_t *publisher, const char *address, int port, size_t mtu,
+                                   int multicast_ttl)
+{
+	memset(publisher, 0, sizeof(*publisher));
+	publisher->socket = -1;
+
+	if (mtu <= IPV4_UDP_HEADER_SIZE + ACC_UDP_STREAM_HEADER_SIZE || mtu - IPV4_UDP_HEADER_SIZE > MAX_DATAGRAM_SIZE)
+	{
+		fprintf(stderr, "ERROR: Invalid MTU %zu\n", mtu);
+		return false;
+	}
+
+	publisher->destination.sin_family = AF_INET;
+	publisher->destination.sin_port   = htons(port);
+
+	if (!parse_address(address, &publisher->destination.sin_addr))
+	{
+		return false;
+	}
+
+	publisher->max_payload_size = mtu - IPV4_UDP_HEADER_SIZE - ACC_UDP_STREAM_HEADER_SIZE;
+	publisher->datagram         = malloc(mtu - IPV4_UDP_HEADER_SIZE);
+
+	if (publisher->datagram == NULL)
+	{
+		fprintf(stderr, "ERROR: Memory allocation error\n");
+		return false;
+	}
+
+	if ((publisher->socket = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
+	{
+		fprintf(stderr, "ERROR: socket(AF_INET, SOCK_DGRAM, 0): (%u) %s\n", errno, strerror(errno));
+		free(publisher->datagram);
+		publisher->datagram = NULL;
+		return false;
+	}
+
+	if (IN_MULTICAST(ntohl(publisher->destination.sin_addr.s_addr)))
+	{
+		if (setsockopt(publisher->socket, IPPROTO_IP, IP_MULTICAST_TTL, &(unsigned char){multicast_ttl }, sizeof(unsigned char)) < 0)
+		{
+			fprintf(stderr, "ERROR: setsockopt(IP_MULTICAST_TTL): (%u) %s\n", errno, strerror(errno));
+		}
+
+		if (setsockopt(publisher->socket, IPPROTO_IP, IP_MULTICAST_LOOP, &(unsigned char){1 }, sizeof(unsigned char)) < 0)
+		{
+			fprintf(stderr, "ERROR: setsockopt(IP_MULTICAST_LOOP): (%u) %s\n", errno, strerror(errno));
+		}
+	}
+
+	return true;
+}
+
+
+void acc_udp_stream_publisher_close(acc_udp_stream_publisher_t *publisher)
+{
+	if (publisher->socket >= 0)
+	{
+		close(publisher->socket);
+		publisher->socket = -1;
+	}
+
+	free(publisher->datagram);
+	publisher->datagram = NULL;
+}
+
+
+bool acc_udp_stream_publisher_send_frame(acc_udp_stream_publisher_t *publisher, const void *data, size_t size)
+{
+	size_t fragment_count = (size + publisher->max_payload_size - 1) / publisher->max_payload_size;
+
+	if (fragment_count == 0)
+	{
+		fragment_count = 1;
+	}
+
+	if (size > ACC_UDP_STREAM_MAX_FRAME_SIZE || fragment_count > MAX_FRAGMENT_COUNT)
+	{
+		publisher->stats.frames_dropped++;
+		return false;
+	}
+
+	datagram_header_t header = {
+		.magic           = UDP_STREAM_MAGIC,
+		.version         = UDP_STREAM_VERSION,
+		.sequence_number = publisher->sequence_number++,
+		.timestamp_us    = acc_udp_stream_get_timestamp_us(),
+		.frame_size      = (uint32_t)size,
+		.fragment_count  = (uint16_t)fragment_count,
+	};
+
+	const uint8_t *frame = data;
+
+	for (size_t i = 0; i < fragment_count; i++)
+	{
+		size_t offset       = i * publisher->max_payload_size;
+		size_t payload_size = size - offset < publisher->max_payload_size ? size - offset : publisher->max_payload_size;
+
+		header.fragment_offset = (uint32_t)offset;
+		header.fragment_index  = (uint16_t)i;
+		header_pack(publisher->datagram, &header);
+		memcpy(publisher->datagram + ACC_UDP_STREAM_HEADER_SIZE, frame + offset, payload_size);
+
+		ssize_t sent = sendto(publisher->socket, publisher->datagram, ACC_UDP_STREAM_HEADER_SIZE + payload_size,
+		                      MSG_DONTWAIT, (const struct sockaddr *)&publisher->destination,
+		                      sizeof(publisher->destination));
+
+		if (sent < 0)
+		{
+			/* Do not retry, the rest of the frame would arrive late anyway */
+			publisher->stats.frames_dropped++;
+			return false;
+		}
+
+		publisher->stats.datagrams_sent++;
+		publisher->stats.bytes_sent += (uint64_t)sent;
+	}
+
+	publisher->stats.frames_sent++;
+
+	return true;
+}
+
+
+void acc_udp_stream_publisher_drop_frame(acc_udp_stream_publisher_t *publisher)
+{
+	publisher->stats.frames_dropped++;
+}
+
+
+bool acc_udp_stream_receiver_open(acc_udp_stream_receiver_t *receiver, const char *address, int port,
+                                  size_t max_frame_size)
+{
+	struct sockaddr_in addr;
+	size_t             fragment_map_size = (MAX_FRAGMENT_COUNT + 7) / 8;
+
+	memset(receiver, 0, sizeof(*receiver));
+	receiver->socket         = -1;
+	receiver->datagram_size  = MAX_DATAGRAM_SIZE;
+	receiver->max_frame_size = max_frame_size;
+	receiver->datagram       = malloc(receiver->datagram_size);
+	receiver->frame          = malloc(max_frame_size);
+	receiver->fragment_map   = malloc(fragment_map_size);
+
+	if (receiver->datagram == NULL || receiver->frame == NULL || receiver->fragment_map == NULL)
+	{
+		fprintf(stderr, "ERROR: Memory allocation error\n");
+		acc_udp_stream_receiver_close(receiver);
+		return false;
+	}
+
+	if ((receiver->socket = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
+	{
+		fprintf(stderr, "ERROR: socket(AF_INET, SOCK_DGRAM, 0): (%u) %s\n", errno, strerror(errno));
+		acc_udp_stream_receiver_close(receiver);
+		return false;
+	}
+
+	if (setsockopt(receiver->socket, SOL_SOCKET, SO_REUSEADDR, &(int){1 }, sizeof(int)) < 0)
+	{
+		fprintf(stderr, "ERROR: setsockopt(SO_REUSEADDR): (%u) %s\n", errno, strerror(errno));
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family      = AF_INET;
+	addr.sin_addr.s_addr = INADDR_ANY;
+	addr.sin_port        = htons(port);
+
+	if (bind(receiver->socket, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+	{
+		fprintf(stderr, "ERROR: bind(): (%u) %s\n", errno, strerror(errno));
+		acc_udp_stream_receiver_close(receiver);
+		return false;
+	}
+
+	if (address != NULL)
+	{
+		struct ip_mreq membership;
+
+		memset(&membership, 0, sizeof(membership));
+		membership.imr_interface.s_addr = INADDR_ANY;
+
+		if (!parse_address(address, &membership.imr_multiaddr))
+		{
+			acc_udp_stream_receiver_close(receiver);
+			return false;
+		}
+
+		if (setsockopt(receiver->socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0)
+		{
+			fprintf(stderr, "ERROR: setsockopt(IP_ADD_MEMBERSHIP): (%u) %s\n", errno, strerror(errno));
+			acc_udp_stream_receiver_close(receiver);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+void acc_udp_stream_receiver_close(acc_udp_stream_receiver_t *receiver)
+{
+	if (receiver->socket >= 0)
+	{
+		close(receiver->socket);
+		receiver->socket = -1;
+	}
+
+	free(receiver->datagram);
+	free(receiver->frame);
+	free(receiver->fragment_map);
+	receiver->datagram     = NULL;
+	receiver->frame        = NULL;
+	receiver->fragment_map = NULL;
+}
+
+
+static void receiver_start_frame(acc_udp_stream_receiver_t *receiver, const datagram_header_t *header)
+{
+	if (receiver->frame_in_progress)
+	{
+		receiver->stats.frames_incomplete++;
+		receiver->stats.frames_lost++;
+	}
+
+	if (receiver->sequence_valid)
+	{
+		/* Frames that were skipped entirely */
+		receiver->stats.frames_lost += header->sequence_number - receiver->next_sequence_number;
+	}
+
+	receiver->frame_in_progress          = true;
+	receiver->sequence_valid             = true;
+	receiver->next_sequence_number       = header->sequence_number + 1;
+	receiver->frame_info.sequence_number = header->sequence_number;
+	receiver->frame_info.timestamp_us    = header->timestamp_us;
+	receiver->frame_info.fragment_count  = header->fragment_count;
+	receiver->frame_size                 = header->frame_size;
+	receiver->fragments_received         = 0;
+
+	memset(receiver->fragment_map, 0, ((size_t)header->fragment_count + 7) / 8);
+}
+
+
+/**
+ * @brief Check if a datagram continues the stream of the current frame
+ *
+ * A restarted publisher starts over from sequence number 0 with later timestamps, so only
+ * datagrams a few frames back with timestamps not after the current frame are late.
+ */
+static bool receiver_in_sequence(const acc_udp_stream_receiver_t *receiver, const datagram_header_t *header)
+{
+	/* Serial number arithmetic, handles wrap of the sequence number */
+	int32_t delta = (int32_t)(header->sequence_number - receiver->frame_info.sequence_number);
+
+	if (delta == 0)
+	{
+		return header->timestamp_us == receiver->frame_info.timestamp_us;
+	}
+
+	if (delta < 0)
+	{
+		return delta >= -REORDER_WINDOW_FRAMES && header->timestamp_us <= receiver->frame_info.timestamp_us;
+	}
+
+	return true;
+}
+
+
+/**
+ * @brief Put one datagram into the reassembly buffer
+ *
+ * @return true if the datagram completed the current frame
+ */
+static bool receiver_put_datagram(acc_udp_stream_receiver_t *receiver, size_t length)
+{
+	datagram_header_t header;
+
+	if (length < ACC_UDP_STREAM_HEADER_SIZE)
+	{
+		receiver->stats.datagrams_invalid++;
+		return false;
+	}
+
+	header_unpack(receiver->datagram, &header);
+
+	size_t payload_size = length - ACC_UDP_STREAM_HEADER_SIZE;
+
+	if (header.magic != UDP_STREAM_MAGIC || header.version != UDP_STREAM_VERSION ||
+	    header.fragment_index >= header.fragment_count || header.frame_size > receiver->max_frame_size ||
+	    (size_t)header.fragment_offset + payload_size > header.frame_size)
+	{
+		receiver->stats.datagrams_invalid++;
+		return false;
+	}
+
+	if (receiver->sequence_valid && !receiver_in_sequence(receiver, &header))
+	{
+		/* Resync to the restarted publisher, without counting the jump as lost frames */
+		receiver->stats.resyncs++;
+		receiver->sequence_valid = false;
+	}
+
+	if (receiver->sequence_valid && header.sequence_number != receiver->frame_info.sequence_number)
+	{
+		if ((int32_t)(header.sequence_number - receiver->frame_info.sequence_number) < 0)
+		{
+			receiver->stats.datagrams_stale++;
+			return false;
+		}
+
+		receiver_start_frame(receiver, &header);
+	}
+	else if (!receiver->sequence_valid)
+	{
+		receiver_start_frame(receiver, &header);
+	}
+	else if (!receiver->frame_in_progress)
+	{
+		/* Duplicate or late fragment of a frame that is already delivered */
+		receiver->stats.datagrams_stale++;
+		return false;
+	}
+
+	if (header.frame_size != receiver->frame_size || header.fragment_count != receiver->frame_info.fragment_count)
+	{
+		receiver->stats.datagrams_invalid++;
+		return false;
+	}
+
+	uint8_t bit = (uint8_t)(1 << (header.fragment_index % 8));
+
+	if (receiver->fragment_map[header.fragment_index / 8] & bit)
+	{
+		receiver->stats.datagrams_stale++;
+		return false;
+	}
+
+	receiver->fragment_map[header.fragment_index / 8] |= bit;
+	memcpy(receiver->frame + header.fragment_offset, receiver->datagram + ACC_UDP_STREAM_HEADER_SIZE, payload_size);
+	receiver->fragments_received++;
+
+	if (receiver->fragments_received == receiver->frame_info.fragment_count)
+	{
+		receiver->frame_in_progress = false;
+		receiver->stats.frames_received++;
+		return true;
+	}
+
+	return false;
+}
+
+
+static uint64_t get_monotonic_ms(void)
+{
+	struct timespec time_ts = {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &time_ts);
+	return (uint64_t)time_ts.tv_sec * MS_PER_SECOND + (uint64_t)time_ts.tv_nsec / (NS_PER_US * 1000);
+}
+
+
+bool acc_udp_stream_receiver_get_next(acc_udp_stream_receiver_t *receiver, uint32_t timeout_ms,
+                                      const uint8_t **frame, size_t *size,
+                                      acc_udp_stream_frame_info_t *frame_info)
+{
+	uint64_t      deadline_ms = get_monotonic_ms() + timeout_ms;
+	struct pollfd poll_set    = {
+		.fd     = receiver->socket,
+		.events = POLLIN,
+	};
+
+	while (true)
+	{
+		uint64_t now_ms = get_monotonic_ms();
+
+		if (now_ms >= deadline_ms)
+		{
+			return false;
+		}
+
+		int nof_events = poll(&poll_set, 1, (int)(deadline_ms - now_ms));
+
+		if (nof_events < 0 && errno != EINTR)
+		{
+			fprintf(stderr, "ERROR: poll(): (%u) %s\n", errno, strerror(errno));
+			return false;
+		}
+
+		if (nof_events <= 0)
+		{
+			continue;
+		}
+
+		ssize_t length = recv(receiver->socket, receiver->datagram, receiver->datagram_size, 0);
+
+		if (length < 0)
+		{
+			if (errno == EINTR || errno == EAGAIN)
+			{
+				continue;
+			}
+
+			fprintf(stderr, "ERROR: recv(): (%u) %s\n", errno, strerror(errno));
+			return false;
+		}
+
+		receiver->stats.datagrams_received++;
+		receiver->stats.bytes_received += (uint64_t)length;
+
+		if (receiver_put_datagram(receiver, (size_t)length))
+		{
+			*frame      = receiver->frame;
+			*size       = receiver->frame_size;
+			*frame_info = receiver->frame_info;
+			return true;
+		}
+	}
+}
@@ -0,0 +1,183 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "acc_envelope_background.h"
+#include "acc_vehicle_pass.h"
+
+
+/**
+ * @brief The strongest foreground bin and the highest z-score of a frame
+ */
+typedef struct
+{
+	float    max_foreground;
+	uint16_t max_index;
+	float    max_z;
+} frame_statistics_t;
+
+
+static void get_statistics(const acc_vehicle_pass_counter_t *counter, frame_statistics_t *statistics)
+{
+	uint16_t max_foreground = 0;
+	uint16_t max_index      = 0;
+	float    max_z          = -INFINITY;
+
+	for (uint16_t i = 0; i < counter->data_length; i++)
+	{
+		if (counter->foreground[i] > max_foreground)
+		{
+			max_foreground = counter->foreground[i];
+			max_index      = i;
+		}
+
+		max_z = fmaxf(max_z, counter->z_scores[i]);
+	}
+
+	statistics->max_foreground = (float)max_foreground;
+	statistics->max_index      = max_index;
+	statistics->max_z          = max_z;
+}
+
+
+/**
+ * @brief Learn the background again, starting from a frame
+ */
+static void reset_background(acc_vehicle_pass_counter_t *counter, const uint16_t *data)
+{
+	acc_envelope_background_init(&counter->background, &counter->parameters.background, counter->data_length);
+	acc_envelope_background_update(&counter->background, data, false, counter->foreground, counter->z_scores);
+}
+
+
+bool acc_vehicle_pass_counter_init(acc_vehicle_pass_counter_t *counter, const acc_vehicle_pass_parameters_t *parameters,
+                                   uint16_t data_length)
+{
+	if (data_length == 0 || data_length > ACC_VEHICLE_PASS_MAX_LENGTH || parameters->step_length_m <= 0.0f ||
+	    parameters->exit_threshold <= 0.0f || parameters->enter_threshold < parameters->exit_threshold ||
+	    parameters->enter_frames == 0 || parameters->exit_frames == 0 || parameters->max_pass_ms == 0)
+	{
+		return false;
+	}
+
+	memset(counter, 0, sizeof(*counter));
+
+	counter->parameters  = *parameters;
+	counter->data_length = data_length;
+
+	return acc_envelope_background_init(&counter->background, &parameters->background, data_length);
+}
+
+
+bool acc_vehicle_pass_counter_update(acc_vehicle_pass_counter_t *counter, const uint16_t *data, uint32_t time_ms,
+                                     acc_vehicle_pass_t *pass)
+{
+	const acc_vehicle_pass_parameters_t *parameters = &counter->parameters;
+
+	bool               active = counter->present || counter->run_frames > 0;
+	frame_statistics_t statistics;
+
+	/* The background is frozen from the first frame above the enter threshold */
+	acc_envelope_background_update(&counter->background, data, active, counter->foreground, counter->z_scores);
+
+	if (acc_envelope_background_is_learning(&counter->background))
+	{
+		return false;
+	}
+
+	get_statistics(counter, &statistics);
+
+	bool ended = false;
+
+	if (!counter->present)
+	{
+		if (statistics.max_z > parameters->enter_threshold)
+		{
+			if (counter->run_frames == 0)
+			{
+				memset(&counter->pass, 0, sizeof(counter->pass));
+				counter->pass.start_ms  = time_ms;
+				counter->pass.closest_m = INFINITY;
+			}
+
+			counter->run_frames++;
+		}
+		else
+		{
+			counter->run_frames = 0;
+		}
+
+		if (counter->run_frames >= parameters->enter_frames)
+		{
+			counter->present    = true;
+			counter->run_frames = 0;
+		}
+	}
+	else if (statistics.max_z < parameters->exit_threshold)
+	{
+		counter->run_frames++;
+
+		if (counter->run_frames >= parameters->exit_frames)
+		{
+			ended = true;
+		}
+	}
+	else
+	{
+		counter->run_frames = 0;
+	}
+
+	active = counter->present || counter->run_frames > 0;
+
+	if (active && statistics.max_z >= parameters->exit_threshold)
+	{
+		acc_vehicle_pass_t *current = &counter->pass;
+		float              max_m    = parameters->start_m + (float)statistics.max_index * parameters->step_length_m;
+
+		current->frame_count++;
+		current->duration_ms    = time_ms - current->start_ms;
+		current->peak_amplitude = fmaxf(current->peak_amplitude, statistics.max_foreground);
+
+		if (statistics.max_z > parameters->enter_threshold && max_m < current->closest_m)
+		{
+			current->closest_m = max_m;
+		}
+	}
+
+	if (counter->present && time_ms - counter->pass.start_ms > parameters->max_pass_ms)
+	{
+		/* A vehicle that stays is part of the scene, learn it again from this frame */
+		counter->pass.timed_out = true;
+		ended                   = true;
+		reset_background(counter, data);
+	}
+
+	if (ended)
+	{
+		counter->present    = false;
+		counter->run_frames = 0;
+		counter->pass_count++;
+		*pass = counter->pass;
+	}
+
+	return ended;
+}
+
+
+bool acc_vehicle_pass_counter_is_present(const acc_vehicle_pass_counter_t *counter)
+{
+	return counter->present;
+}
+
+
+uint32_t acc_vehicle_pass_counter_get_count(const acc_vehicle_pass_counter_t *counter)
+{
+	return counter->pass_count;
+}
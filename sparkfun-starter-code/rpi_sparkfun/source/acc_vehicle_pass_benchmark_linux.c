@@ -0,0 +1,335 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <getopt.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "acc_benchmark_util.h"
+#include "acc_vehicle_pass.h"
+
+
+#define DEFAULT_DURATION_S  (3600)
+#define DEFAULT_FRAME_RATE  (1000)
+#define DATA_LENGTH         (1000)
+#define RANGE_START_M       (1.5f)
+#define STEP_LENGTH_M       (0.002f)
+#define NOISE_LEVEL         (100.0f)
+#define NOISE_STD           (15.0f)
+#define NOISE_FRAMES        (256)
+#define CLUTTER_COUNT       (6)
+#define MIN_GAP_S           (1.0f)
+#define MEAN_GAP_S          (10.0f)
+#define PARKED_S            (300.0f)
+#define MAX_VEHICLES        (4096)
+
+#ifndef M_PI
+#define M_PI (3.14159265358979323846)
+#endif
+
+static const acc_vehicle_pass_parameters_t default_parameters =
+{
+	.start_m          = RANGE_START_M,
+	.step_length_m    = STEP_LENGTH_M,
+	.background       = {
+		.shift             = 10,
+		.freeze_z          = 3.0f,
+		.max_freeze_frames = 0,
+		.min_std           = 1.0f,
+	},
+	.enter_threshold  = 10.0f,
+	.exit_threshold   = 5.0f,
+	.enter_frames     = 20,
+	.exit_frames      = 200,
+	.max_pass_ms      = 60000,
+};
+
+typedef struct
+{
+	uint32_t start_ms;
+	uint32_t duration_ms;
+	float    closest_m;
+	float    amplitude;
+	bool     parked;
+	bool     counted;
+} vehicle_t;
+
+
+static acc_vehicle_pass_counter_t counter;
+static vehicle_t                  vehicles[MAX_VEHICLES];
+static int16_t                    noise[NOISE_FRAMES][DATA_LENGTH];
+static float                      clutter[DATA_LENGTH];
+static uint16_t                   frame[DATA_LENGTH];
+
+
+/**
+ * @brief Vehicles at random gaps, with one vehicle that parks for PARKED_S every hour
+ */
+static uint16_t generate_vehicles(uint32_t duration_ms, uint32_t *state)
+{
+	uint16_t count = 0;
+	float    t_s   = 5.0f * default_parameters.enter_frames * (float)(1 << default_parameters.background.shift) / 1000.0f;
+
+	while (count < MAX_VEHICLES)
+	{
+		vehicle_t *vehicle = &vehicles[count];
+		bool      parked   = (count % 360) == 180;
+		float     length_s = parked ? PARKED_S : 0.3f + 2.7f * acc_benchmark_next_uniform(state);
+
+		if ((t_s + length_s) * 1000.0f >= (float)duration_ms)
+		{
+			break;
+		}
+
+		vehicle->start_ms    = (uint32_t)(t_s * 1000.0f);
+		vehicle->duration_ms = (uint32_t)(length_s * 1000.0f);
+		vehicle->closest_m   = 2.0f + 1.0f * acc_benchmark_next_uniform(state);
+		vehicle->amplitude   = 300.0f + 2700.0f * acc_benchmark_next_uniform(state);
+		vehicle->parked      = parked;
+		vehicle->counted     = false;
+		count++;
+
+		t_s += length_s + MIN_GAP_S - MEAN_GAP_S * logf(1.0f - acc_benchmark_next_uniform(state));
+	}
+
+	return count;
+}
+
+
+/**
+ * @brief An envelope with clutter that drifts with temperature, noise and the vehicle that is present
+ */
+static void generate_frame(uint32_t time_ms, const vehicle_t *vehicle, uint32_t *state)
+{
+	float         drift     = 1.0f + 0.05f * sinf(2.0f * (float)M_PI * (float)time_ms / 3600000.0f);
+	const int16_t *noise_row = noise[(*state = *state * 1103515245u + 12345u) >> 24];
+	float         amplitude = 0.0f;
+	float         center    = 0.0f;
+
+	if (vehicle != NULL && time_ms >= vehicle->start_ms && time_ms - vehicle->start_ms < vehicle->duration_ms)
+	{
+		/* The reflection rises and falls as the vehicle passes through the beam, or in a second when parking */
+		uint32_t elapsed_ms = time_ms - vehicle->start_ms;
+		float    position   = (float)elapsed_ms / (float)vehicle->duration_ms;
+		float    ramp       = fminf((float)elapsed_ms, (float)(vehicle->duration_ms - elapsed_ms)) / 1000.0f;
+
+		amplitude = vehicle->amplitude * (vehicle->parked ? fminf(ramp, 1.0f) : sinf((float)M_PI * position));
+		center    = (vehicle->closest_m - RANGE_START_M) / STEP_LENGTH_M;
+	}
+
+	for (uint16_t i = 0; i < DATA_LENGTH; i++)
+	{
+		float value = NOISE_LEVEL + drift * clutter[i] + noise_row[i];
+
+		if (amplitude > 0.0f)
+		{
+			float offset = ((float)i - center) / 15.0f;
+
+			/* The body of the vehicle reflects from the closest distance and beyond */
+			value += offset < 0.0f ? amplitude * expf(-offset * offset) : amplitude * expf(-0.02f * offset);
+		}
+
+		frame[i] = (uint16_t)(value > 65535.0f ? 65535.0f : value);
+	}
+}
+
+
+static bool run(uint32_t duration_s, uint32_t frame_rate)
+{
+	uint32_t state = 1;
+
+	for (uint16_t f = 0; f < NOISE_FRAMES; f++)
+	{
+		for (uint16_t i = 0; i < DATA_LENGTH; i++)
+		{
+			noise[f][i] = (int16_t)lrintf(NOISE_STD * acc_benchmark_next_noise(&state));
+		}
+	}
+
+	memset(clutter, 0, sizeof(clutter));
+
+	for (uint16_t c = 0; c < CLUTTER_COUNT; c++)
+	{
+		float center    = DATA_LENGTH * acc_benchmark_next_uniform(&state);
+		float amplitude = 200.0f + 1000.0f * acc_benchmark_next_uniform(&state);
+
+		for (uint16_t i = 0; i < DATA_LENGTH; i++)
+		{
+			float offset = ((float)i - center) / 15.0f;
+
+			clutter[i] += amplitude * expf(-offset * offset);
+		}
+	}
+
+	if (!acc_vehicle_pass_counter_init(&counter, &default_parameters, DATA_LENGTH))
+	{
+		fprintf(stderr, "ERROR: Invalid parameters\n");
+		return false;
+	}
+
+	uint32_t duration_ms   = duration_s * 1000;
+	uint16_t vehicle_count = generate_vehicles(duration_ms, &state);
+	uint16_t next_vehicle  = 0;
+	uint32_t frame_count   = (uint32_t)((uint64_t)duration_s * frame_rate);
+	uint64_t total_ns      = 0;
+	uint64_t max_ns        = 0;
+	uint32_t false_passes  = 0;
+	uint32_t timed_out     = 0;
+	uint32_t matched       = 0;
+	double   duration_sum  = 0.0;
+	double   closest_sum   = 0.0;
+
+	for (uint32_t n = 0; n < frame_count; n++)
+	{
+		uint32_t time_ms = (uint32_t)((uint64_t)n * 1000 / frame_rate);
+
+		while (next_vehicle < vehicle_count &&
+		       time_ms >= vehicles[next_vehicle].start_ms + vehicles[next_vehicle].duration_ms)
+		{
+			next_vehicle++;
+		}
+
+		generate_frame(time_ms, next_vehicle < vehicle_count ? &vehicles[next_vehicle] : NULL, &state);
+
+		acc_vehicle_pass_t pass;
+		uint64_t           start_ns = acc_benchmark_get_cpu_time_ns();
+		bool               ended    = acc_vehicle_pass_counter_update(&counter, frame, time_ms, &pass);
+		uint64_t           frame_ns = acc_benchmark_get_cpu_time_ns() - start_ns;
+
+		total_ns += frame_ns;
+		max_ns    = frame_ns > max_ns ? frame_ns : max_ns;
+
+		if (!ended)
+		{
+			continue;
+		}
+
+		timed_out += pass.timed_out ? 1 : 0;
+
+		/* A pass belongs to the vehicle it overlaps */
+		vehicle_t *vehicle = NULL;
+
+		for (uint16_t v = next_vehicle > 0 ? next_vehicle - 1 : 0; v <= next_vehicle && v < vehicle_count; v++)
+		{
+			if (pass.start_ms < vehicles[v].start_ms + vehicles[v].duration_ms &&
+			    pass.start_ms + pass.duration_ms > vehicles[v].start_ms)
+			{
+				vehicle = &vehicles[v];
+			}
+		}
+
+		if (vehicle == NULL || vehicle->counted)
+		{
+			false_passes++;
+			continue;
+		}
+
+		vehicle->counted = true;
+
+		if (!pass.timed_out)
+		{
+			matched++;
+			duration_sum += fabs((double)pass.duration_ms - (double)vehicle->duration_ms);
+			closest_sum  += fabs((double)(pass.closest_m - vehicle->closest_m));
+		}
+	}
+
+	uint32_t counted = 0;
+
+	for (uint16_t v = 0; v < vehicle_count; v++)
+	{
+		counted += vehicles[v].counted ? 1 : 0;
+	}
+
+	printf("%u s at %u Hz, %u bins, %u frames\n\n", (unsigned int)duration_s, (unsigned int)frame_rate,
+	       (unsigned int)DATA_LENGTH, (unsigned int)frame_count);
+	printf("Vehicles:            %u\n", (unsigned int)vehicle_count);
+	printf("Counted:             %u (%.2f %%)\n", (unsigned int)counted,
+	       vehicle_count > 0 ? 100.0 * counted / vehicle_count : 0.0);
+	printf("False passes:        %u\n", (unsigned int)false_passes);
+	printf("Timed out passes:    %u\n", (unsigned int)timed_out);
+	printf("Duration error:      %.0f ms mean absolute\n", matched > 0 ? duration_sum / matched : 0.0);
+	printf("Closest range error: %.1f mm mean absolute\n", matched > 0 ? closest_sum / matched * 1000.0 : 0.0);
+	printf("CPU time per frame:  %.2f us mean, %.2f us max, %.2f %% of the frame period\n",
+	       (double)total_ns / frame_count / 1000.0, (double)max_ns / 1000.0,
+	       100.0 * (double)total_ns / frame_count * frame_rate / 1.0e9);
+
+	return true;
+}
+
+
+static void print_usage(char *application_name)
+{
+	fprintf(stderr, "Usage: %s [OPTION]...\n", application_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Run the vehicle pass counter on a simulated road side envelope stream with drifting\n");
+	fprintf(stderr, "clutter and vehicles at random gaps, one of them parked for %.0f s every hour. Report\n",
+	        (double)PARKED_S);
+	fprintf(stderr, "the count, the pass feature errors and the CPU time per frame.\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "-h, --help                      this help\n");
+	fprintf(stderr, "-d, --duration                  the simulated time in seconds, default %u\n",
+	        (unsigned int)DEFAULT_DURATION_S);
+	fprintf(stderr, "-r, --frame-rate                the frame rate in Hz, default %u\n", (unsigned int)DEFAULT_FRAME_RATE);
+}
+
+
+int main(int argc, char *argv[])
+{
+	static struct option long_options[] =
+	{
+		{"help",             no_argument,       0,      'h'},
+		{"duration",         required_argument, 0,      'd'},
+		{"frame-rate",       required_argument, 0,      'r'},
+		{NULL,               0,                 NULL,   0}
+	};
+
+	int character_code;
+	int option_index = 0;
+
+	uint32_t duration_s = DEFAULT_DURATION_S;
+	uint32_t frame_rate = DEFAULT_FRAME_RATE;
+
+	while ((character_code = getopt_long(argc, argv, "h?d:r:", long_options, &option_index)) != -1)
+	{
+		switch (character_code)
+		{
+			case 'd':
+			case 'r':
+			{
+				int value = atoi(optarg);
+
+				if (value <= 0 || value > 1000000)
+				{
+					fprintf(stderr, "ERROR: Invalid value '%s'\n", optarg);
+					return EXIT_FAILURE;
+				}
+
+				if (character_code == 'd')
+				{
+					duration_s = (uint32_t)value;
+				}
+				else
+				{
+					frame_rate = (uint32_t)value;
+				}
+
+				break;
+			}
+			default:
+			{
+				print_usage(basename(argv[0]));
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	return run(duration_s, frame_rate) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,114 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "acc_zone_map.h"
+
+
+static bool setup_point_table(acc_zone_map_t *map, uint16_t point_count)
+{
+	free(map->point_zone);
+
+	map->point_count = 0;
+	map->point_zone  = malloc(point_count * sizeof(*map->point_zone));
+
+	if (map->point_zone == NULL)
+	{
+		fprintf(stderr, "ERROR: Memory allocation error\n");
+		return false;
+	}
+
+	float step_m = point_count > 1 ? map->range_length_m / (float)(point_count - 1) : 0.0f;
+
+	for (uint16_t i = 0; i < point_count; i++)
+	{
+		uint16_t zone = (uint16_t)(((float)i * step_m) / map->zone_length_m);
+
+		map->point_zone[i] = (uint8_t)(zone < map->zone_count ? zone : map->zone_count - 1);
+	}
+
+	map->point_count = point_count;
+
+	return true;
+}
+
+
+bool acc_zone_map_init(acc_zone_map_t *map, float start_m, float range_length_m, float zone_length_m,
+                       float enter_threshold, float exit_threshold)
+{
+	memset(map, 0, sizeof(*map));
+
+	if (range_length_m <= 0.0f || zone_length_m <= 0.0f || exit_threshold > enter_threshold)
+	{
+		fprintf(stderr, "ERROR: Invalid zone map parameters\n");
+		return false;
+	}
+
+	uint16_t zone_count = (uint16_t)(range_length_m / zone_length_m + 0.999f);
+
+	if (zone_count > ACC_ZONE_MAP_MAX_ZONES)
+	{
+		fprintf(stderr, "ERROR: Too many zones %u, max %u\n", (unsigned int)zone_count, (unsigned int)ACC_ZONE_MAP_MAX_ZONES);
+		return false;
+	}
+
+	map->start_m         = start_m;
+	map->zone_length_m   = zone_length_m;
+	map->range_length_m  = range_length_m;
+	map->enter_threshold = enter_threshold;
+	map->exit_threshold  = exit_threshold;
+	map->zone_count      = zone_count;
+
+	return true;
+}
+
+
+bool acc_zone_map_update(acc_zone_map_t *map, const float *points, uint16_t point_count, bool *changed)
+{
+	*changed = false;
+
+	if (point_count != map->point_count && !setup_point_table(map, point_count))
+	{
+		return false;
+	}
+
+	float score[ACC_ZONE_MAP_MAX_ZONES] = { 0.0f };
+
+	for (uint16_t i = 0; i < point_count; i++)
+	{
+		uint8_t zone = map->point_zone[i];
+
+		if (points[i] > score[zone])
+		{
+			score[zone] = points[i];
+		}
+	}
+
+	for (uint16_t zone = 0; zone < map->zone_count; zone++)
+	{
+		bool occupied = map->occupied[zone] ? score[zone] >= map->exit_threshold : score[zone] >= map->enter_threshold;
+
+		*changed            = *changed || occupied != map->occupied[zone];
+		map->occupied[zone] = occupied;
+		map->score[zone]    = score[zone];
+	}
+
+	return true;
+}
+
+
+void acc_zone_map_release(acc_zone_map_t *map)
+{
+	free(map->point_zone);
+
+	map->point_zone  = NULL;
+	map->point_count = 0;
+}
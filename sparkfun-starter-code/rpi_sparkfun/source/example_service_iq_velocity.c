@@ -0,0 +1,233 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "acc_hal_definitions.h"
+#include "acc_hal_integration.h"
+#include "acc_iq_velocity.h"
+#include "acc_rss.h"
+#include "acc_service.h"
+#include "acc_service_iq.h"
+#include "acc_version.h"
+
+
+/** \example example_service_iq_velocity.c
+ * @brief This is an example on how the radial velocity can be estimated from the IQ phase
+ * @n
+ * The example executes as follows:
+ *   - Activate Radar System Software (RSS)
+ *   - Create an IQ service configuration with int16 output and streaming
+ *   - Create and activate the IQ service
+ *   - Create an IQ velocity estimator from the service metadata
+ *   - Add each sweep to the estimator and print the velocity a few times per second,
+ *     together with the processing time per sweep
+ *   - Deactivate and destroy the IQ service
+ *   - Deactivate Radar System Software (RSS)
+ */
+
+
+#define SENSOR_ID            1
+#define RANGE_START_M        0.40f
+#define RANGE_LENGTH_M       1.00f
+#define SERVICE_DOWNSAMPLING 4
+#define SERVICE_HWAAS        2
+#define SWEEP_RATE_HZ        1000.0f
+
+// Print the velocity every REPORT_SWEEPS sweeps, for RUN_TIME_S seconds
+#define REPORT_SWEEPS 100
+#define RUN_TIME_S    30
+
+#define VELOCITY_SMOOTHING       0.1f
+#define VELOCITY_MIN_POWER_RATIO 0.1f
+#define RANGE_RATE_ALPHA         0.05f
+#define RANGE_RATE_BETA          0.001f
+
+
+static void update_configuration(acc_service_configuration_t iq_configuration);
+
+
+static uint64_t get_time_ns(void);
+
+
+int main(int argc, char *argv[]);
+
+
+int main(int argc, char *argv[])
+{
+	(void)argc;
+	(void)argv;
+	printf("Acconeer software version %s\n", acc_version_get());
+
+	const acc_hal_t *hal = acc_hal_integration_get_implementation();
+
+	if (!acc_rss_activate(hal))
+	{
+		printf("acc_rss_activate() failed\n");
+		return EXIT_FAILURE;
+	}
+
+	acc_service_configuration_t iq_configuration = acc_service_iq_configuration_create();
+
+	if (iq_configuration == NULL)
+	{
+		printf("acc_service_iq_configuration_create() failed\n");
+		acc_rss_deactivate();
+		return EXIT_FAILURE;
+	}
+
+	update_configuration(iq_configuration);
+
+	acc_service_handle_t handle = acc_service_create(iq_configuration);
+
+	acc_service_iq_configuration_destroy(&iq_configuration);
+
+	if (handle == NULL)
+	{
+		printf("acc_service_create() failed\n");
+		acc_rss_deactivate();
+		return EXIT_FAILURE;
+	}
+
+	acc_service_iq_metadata_t iq_metadata = { 0 };
+	acc_service_iq_get_metadata(handle, &iq_metadata);
+
+	acc_iq_velocity_parameters_t parameters = {
+		.sweep_rate_hz    = SWEEP_RATE_HZ,
+		.start_m          = iq_metadata.start_m,
+		.step_length_m    = iq_metadata.step_length_m,
+		.smoothing        = VELOCITY_SMOOTHING,
+		.min_power_ratio  = VELOCITY_MIN_POWER_RATIO,
+		.range_rate_alpha = RANGE_RATE_ALPHA,
+		.range_rate_beta  = RANGE_RATE_BETA,
+	};
+
+	acc_iq_velocity_t velocity = acc_iq_velocity_create(&parameters, iq_metadata.data_length);
+
+	if (velocity == NULL)
+	{
+		printf("acc_iq_velocity_create() failed\n");
+		acc_service_destroy(&handle);
+		acc_rss_deactivate();
+		return EXIT_FAILURE;
+	}
+
+	printf("Start: %d mm\n", (int)(iq_metadata.start_m * 1000.0f));
+	printf("Length: %u mm\n", (unsigned int)(iq_metadata.length_m * 1000.0f));
+	printf("Data length: %u\n", (unsigned int)(iq_metadata.data_length));
+	printf("Max unambiguous velocity: %d mm/s\n", (int)(ACC_IQ_VELOCITY_WAVELENGTH_M * SWEEP_RATE_HZ / 4.0f * 1000.0f));
+
+	if (!acc_service_activate(handle))
+	{
+		printf("acc_service_activate() failed\n");
+		acc_iq_velocity_destroy(&velocity);
+		acc_service_destroy(&handle);
+		acc_rss_deactivate();
+		return EXIT_FAILURE;
+	}
+
+	bool                         success           = true;
+	const uint32_t               iterations        = (uint32_t)(RUN_TIME_S * SWEEP_RATE_HZ);
+	const uint64_t               period_ns         = (uint64_t)(1.0e9f / SWEEP_RATE_HZ);
+	uint64_t                     processing_sum_ns = 0;
+	uint64_t                     processing_max_ns = 0;
+	uint32_t                     missed_count      = 0;
+	acc_int16_complex_t          *data             = NULL;
+	acc_service_iq_result_info_t result_info;
+
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		success = acc_service_iq_get_next_by_reference(handle, &data, &result_info);
+
+		if (!success || result_info.sensor_communication_error)
+		{
+			printf("acc_service_iq_get_next_by_reference() failed\n");
+			success = false;
+			break;
+		}
+
+		if (result_info.missed_data)
+		{
+			missed_count++;
+		}
+
+		uint64_t start_ns = get_time_ns();
+
+		acc_iq_velocity_process(velocity, data);
+
+		uint64_t processing_ns = get_time_ns() - start_ns;
+
+		processing_sum_ns += processing_ns;
+		processing_max_ns  = processing_ns > processing_max_ns ? processing_ns : processing_max_ns;
+
+		if ((i + 1) % REPORT_SWEEPS == 0)
+		{
+			acc_iq_velocity_result_t result;
+
+			if (acc_iq_velocity_get_result(velocity, &result))
+			{
+				printf("Velocity: %6d mm/s (phase %6d, range rate %6d, aliases %" PRId16 ") at %4d mm, %3u bins",
+				       (int)(result.velocity_mps * 1000.0f), (int)(result.phase_velocity_mps * 1000.0f),
+				       (int)(result.range_rate_mps * 1000.0f), result.alias_count, (int)(result.distance_m * 1000.0f),
+				       (unsigned int)result.bin_count);
+			}
+			else
+			{
+				printf("Velocity: no signal");
+			}
+
+			printf(", processing %" PRIu64 " us mean, %" PRIu64 " us max of %" PRIu64 " us, %" PRIu32 " missed\n",
+			       processing_sum_ns / REPORT_SWEEPS / 1000, processing_max_ns / 1000, period_ns / 1000, missed_count);
+
+			processing_sum_ns = 0;
+			processing_max_ns = 0;
+			missed_count      = 0;
+		}
+	}
+
+	bool deactivated = acc_service_deactivate(handle);
+
+	acc_iq_velocity_destroy(&velocity);
+	acc_service_destroy(&handle);
+
+	acc_rss_deactivate();
+
+	if (deactivated && success)
+	{
+		printf("Application finished OK\n");
+		return EXIT_SUCCESS;
+	}
+
+	return EXIT_FAILURE;
+}
+
+
+void update_configuration(acc_service_configuration_t iq_configuration)
+{
+	acc_service_iq_output_format_set(iq_configuration, ACC_SERVICE_IQ_OUTPUT_FORMAT_INT16_COMPLEX);
+	acc_service_iq_downsampling_factor_set(iq_configuration, SERVICE_DOWNSAMPLING);
+
+	acc_service_sensor_set(iq_configuration, SENSOR_ID);
+	acc_service_requested_start_set(iq_configuration, RANGE_START_M);
+	acc_service_requested_length_set(iq_configuration, RANGE_LENGTH_M);
+	acc_service_hw_accelerated_average_samples_set(iq_configuration, SERVICE_HWAAS);
+	acc_service_repetition_mode_streaming_set(iq_configuration, SWEEP_RATE_HZ);
+}
+
+
+uint64_t get_time_ns(void)
+{
+	struct timespec time;
+
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return (uint64_t)time.tv_sec * 1000000000 + (uint64_t)time.tv_nsec;
+}
@@ -10,10 +10,12 @@
 
 #include "acc_hal_definitions.h"
 #include "acc_hal_integration.h"
-#include "acc_integration.h"
+#include "acc_integration_pacer.h"
+#include "acc_parking_detection.h"
 #include "acc_rss.h"
 #include "acc_service.h"
 #include "acc_service_envelope.h"
+#include "acc_sliding_window.h"
 #include "acc_version.h"
 
 
@@ -42,7 +44,8 @@
 #define LEAKAGE_END_POSITION_M    0.30f
 #define MAX_LEAK_AMPLITUDE        2000
 
-// The number of observations in the parking detection queue
+// The number of observations in the parking detection window
+// Updating the window does not depend on its size, so long windows can be used at high update rates
 #define DETECTION_OBSERVATION_COUNT 3
 
 // The minimal weight for each observation in the parking detection queue for
@@ -68,11 +71,14 @@
 #define SERVICE_UPTIME_MAX_S 900.0f
 
 
-typedef struct
+static const acc_parking_detection_parameters_t detection_parameters =
 {
-	float weight;
-	float distance;
-} sweep_observable_t;
+	.background_level   = ENVELOPE_BACKGROUND_LEVEL,
+	.max_leak_amplitude = MAX_LEAK_AMPLITUDE,
+	.weight_threshold   = DETECTION_WEIGHT_THRESHOLD,
+	.weight_ratio_limit = DETECTION_WEIGHT_RATIO_LIMIT,
+	.displacement_limit = DETECTION_DISPLACEMENT_LIMIT,
+};
 
 
 /**
@@ -101,22 +107,6 @@ static bool sensor_calibration(void);
 static void configure_service(acc_service_configuration_t configuration);
 
 
-/**
- * Exectute the parking detection
- *
- * @param metadata Service metadata
- * @param leak_sample_index Index where to sample leakage
- * @param leak_end_index Index where leakage is assumed to end
- * @param observations Observation history
- * @param observation_count The number of observations in the history
- * @param data Service data
- * @return True, if a car is detected
- */
-static bool parking_detection(const acc_service_envelope_metadata_t *metadata, uint16_t leak_sample_index,
-                              uint16_t leak_end_index, sweep_observable_t *observations, uint16_t *observation_count,
-                              const uint16_t *data);
-
-
 int main(int argc, char *argv[]);
 
 
@@ -172,20 +162,35 @@ int main(int argc, char *argv[])
 
 	uint16_t                           *data = NULL;
 	acc_service_envelope_result_info_t result_info;
-	sweep_observable_t                 observations[DETECTION_OBSERVATION_COUNT];
-	uint16_t                           observation_count   = 0;
-	uint32_t                           last_update_ms      = 0;
+	acc_parking_profile_t              profile             = { 0 };
+	acc_parking_observations_t         observations;
+	acc_integration_pacer_t            pacer;
 	uint32_t                           last_activate_ms    = hal->os.gettime();
 	uint32_t                           last_calibration_ms = hal->os.gettime();
 	uint16_t                           sweep_index         = 0;
 
 	bool status = true;
 
-	if (!valid_leak_setup)
+	acc_integration_pacer_init(&pacer, 1.0f / DETECTOR_SWEEP_PERIOD_S);
+
+	observations.weight   = acc_sliding_window_create(DETECTION_OBSERVATION_COUNT);
+	observations.distance = acc_sliding_window_create(DETECTION_OBSERVATION_COUNT);
+
+	if (observations.weight == NULL || observations.distance == NULL)
+	{
+		printf("Failed to create observation windows\n");
+		status = false;
+	}
+	else if (!valid_leak_setup)
 	{
 		printf("Parameters are not valid\n");
 		status = false;
 	}
+	else if (!acc_parking_profile_setup(&profile, &metadata, leak_sample_index, leak_end_index))
+	{
+		printf("Failed to set up detection profile\n");
+		status = false;
+	}
 	else
 	{
 		status = acc_service_activate(handle);
@@ -201,13 +206,12 @@ int main(int argc, char *argv[])
 
 		if (status)
 		{
-			while (last_update_ms != 0 && hal->os.gettime() - last_update_ms < DETECTOR_SWEEP_PERIOD_S * 1000)
+			if (!acc_integration_pacer_wait(&pacer))
 			{
-				acc_integration_sleep_ms((DETECTOR_SWEEP_PERIOD_S * 1000) - (hal->os.gettime() - last_update_ms));
+				printf("%" PRIu16 ": Sweep deadline overrun\n", sweep_index);
 			}
 
-			status         = acc_service_envelope_get_next_by_reference(handle, &data, &result_info);
-			last_update_ms = hal->os.gettime();
+			status = acc_service_envelope_get_next_by_reference(handle, &data, &result_info);
 		}
 
 		if (status && result_info.data_quality_warning &&
@@ -238,14 +242,14 @@ int main(int argc, char *argv[])
 
 			if (status)
 			{
-				status         = acc_service_envelope_get_next_by_reference(handle, &data, &result_info);
-				last_update_ms = hal->os.gettime();
+				status = acc_service_envelope_get_next_by_reference(handle, &data, &result_info);
 			}
 		}
 
 		if (status)
 		{
-			bool detection = parking_detection(&metadata, leak_sample_index, leak_end_index, observations, &observation_count, data);
+			bool detection = acc_parking_detection_update(&profile, &detection_parameters, leak_sample_index,
+			                                              &observations, data);
 
 			if (sweep_index < DETECTION_OBSERVATION_COUNT - 1)
 			{
@@ -260,6 +264,9 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	acc_parking_profile_release(&profile);
+	acc_sliding_window_destroy(&observations.weight);
+	acc_sliding_window_destroy(&observations.distance);
 	acc_service_envelope_configuration_destroy(&configuration);
 	acc_service_deactivate(handle);
 	acc_service_destroy(&handle);
@@ -322,93 +329,3 @@ void configure_service(acc_service_configuration_t configuration)
 	acc_service_envelope_running_average_factor_set(configuration, RUNNING_AVERAGE_FACTOR);
 	acc_service_power_save_mode_set(configuration, POWER_SAVE_MODE);
 }
-
-
-bool parking_detection(const acc_service_envelope_metadata_t *metadata, uint16_t leak_sample_index,
-                       uint16_t leak_end_index, sweep_observable_t *observations, uint16_t *observation_count,
-                       const uint16_t *data)
-{
-	float    weight_sum     = 0.0f;
-	float    weight_sum_r   = 0.0f;
-	float    leak_start     = 0.0f;
-	uint16_t leak_amplitude = MAX_LEAK_AMPLITUDE < data[leak_sample_index] ? MAX_LEAK_AMPLITUDE : data[leak_sample_index];
-	uint16_t a_leak         = leak_amplitude < ENVELOPE_BACKGROUND_LEVEL ? 0 : leak_amplitude - ENVELOPE_BACKGROUND_LEVEL;
-	float    leak_step      = ((float)(a_leak) / (leak_end_index - leak_sample_index));
-
-	leak_start = leak_end_index * leak_step + ENVELOPE_BACKGROUND_LEVEL;
-
-	for (uint16_t i = 0; i < metadata->data_length; i++)
-	{
-		float r  = metadata->start_m + i * metadata->step_length_m;
-		float bg = 0.0f;
-		if (i <= leak_end_index)
-		{
-			bg = leak_start - i * leak_step;
-		}
-		else
-		{
-			bg = ENVELOPE_BACKGROUND_LEVEL;
-		}
-
-		float sweep_above_bg = data[i] - bg;
-		sweep_above_bg = sweep_above_bg > 0.0f ? sweep_above_bg : 0.0f;
-
-		float weight = sweep_above_bg / ENVELOPE_BACKGROUND_LEVEL;
-		weight = weight < 1.0f ? weight : 1.0f;
-		weight = weight * sweep_above_bg * r;
-
-		weight_sum   += weight;
-		weight_sum_r += weight * r;
-	}
-
-	if (*observation_count == DETECTION_OBSERVATION_COUNT)
-	{
-		for (uint16_t i = 1; i < DETECTION_OBSERVATION_COUNT; i++)
-		{
-			observations[i - 1].weight   = observations[i].weight;
-			observations[i - 1].distance = observations[i].distance;
-		}
-	}
-	else
-	{
-		(*observation_count)++;
-	}
-
-	observations[*observation_count - 1].weight   = weight_sum / metadata->data_length;
-	observations[*observation_count - 1].distance = weight_sum_r / weight_sum;
-
-	float weight_min   = __FLT_MAX__;
-	float weight_max   = 0.0f;
-	float distance_min = __FLT_MAX__;
-	float distance_max = 0.0f;
-
-	for (uint16_t i = 0; i < *observation_count; i++)
-	{
-		if (weight_min > observations[i].weight)
-		{
-			weight_min = observations[i].weight;
-		}
-
-		if (weight_max < observations[i].weight)
-		{
-			weight_max = observations[i].weight;
-		}
-
-		if (distance_min > observations[i].distance)
-		{
-			distance_min = observations[i].distance;
-		}
-
-		if (distance_max < observations[i].distance)
-		{
-			distance_max = observations[i].distance;
-		}
-	}
-
-	bool detection = *observation_count == DETECTION_OBSERVATION_COUNT &&
-	                 weight_min >= DETECTION_WEIGHT_THRESHOLD &&
-	                 weight_max / weight_min <= DETECTION_WEIGHT_RATIO_LIMIT &&
-	                 distance_max - distance_min <= DETECTION_DISPLACEMENT_LIMIT;
-
-	return detection;
-}
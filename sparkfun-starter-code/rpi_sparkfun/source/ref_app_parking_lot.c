@@ -0,0 +1,405 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "acc_hal_definitions.h"
+#include "acc_hal_integration.h"
+#include "acc_integration_pacer.h"
+#include "acc_parking_detection.h"
+#include "acc_rss.h"
+#include "acc_service.h"
+#include "acc_service_envelope.h"
+#include "acc_sliding_window.h"
+#include "acc_version.h"
+
+
+// Default values for this reference application
+// ---------------------------------------------
+
+// Service configuration settings, common to all spaces
+#define SERVICE_DOWNSAMPLING   2
+#define SERVICE_HWAAS          20
+#define RUNNING_AVERAGE_FACTOR 0.0f
+#define POWER_SAVE_MODE        ACC_POWER_SAVE_MODE_OFF
+
+// The expected background level for the envelope service
+#define ENVELOPE_BACKGROUND_LEVEL 100
+#define MAX_LEAK_AMPLITUDE        2000
+
+// Detection settings, see ref_app_parking.c
+#define DETECTION_OBSERVATION_COUNT  3
+#define DETECTION_WEIGHT_THRESHOLD   5.0f
+#define DETECTION_WEIGHT_RATIO_LIMIT 3.0f
+#define DETECTION_DISPLACEMENT_LIMIT 0.1f
+
+// The time duration between two consecutive sweeps of a space
+// The sweeps of the spaces are spread evenly over the period, in the order of the table
+#define DETECTOR_SWEEP_PERIOD_S 10.0f
+
+// Minimal time between two sensor recalibrations due to a data quality warning
+#define SERVICE_RUNTIME_MIN_S 900.0f
+
+#define MAX_SPACE_COUNT  16
+#define MAX_SENSOR_COUNT 4
+
+
+/**
+ * @brief Configuration of one parking space
+ *
+ * Several spaces can share a sensor with different ranges.
+ * The leakage positions must be within the range of the space.
+ */
+typedef struct
+{
+	const char      *name;
+	acc_sensor_id_t sensor_id;
+	float           range_start_m;
+	float           range_length_m;
+	float           leak_sample_position_m;
+	float           leak_end_position_m;
+} parking_space_config_t;
+
+
+// The spaces of the parking lot, spaces on sensors the board does not have are skipped
+static const parking_space_config_t space_configs[] =
+{
+	{"A", 1, 0.12f, 0.50f, 0.15f, 0.30f},
+	{"B", 2, 0.12f, 0.50f, 0.15f, 0.30f},
+	{"C", 3, 0.12f, 0.50f, 0.15f, 0.30f},
+	{"D", 4, 0.12f, 0.50f, 0.15f, 0.30f},
+};
+
+
+typedef struct
+{
+	const parking_space_config_t *config;
+	acc_service_configuration_t  configuration;
+	acc_service_handle_t         handle;
+	acc_parking_profile_t        profile;
+	uint16_t                     leak_sample_index;
+	uint16_t                     *data;
+	acc_parking_observations_t   observations;
+	bool                         occupied;
+	bool                         reported;
+} parking_space_t;
+
+
+static const acc_parking_detection_parameters_t detection_parameters =
+{
+	.background_level   = ENVELOPE_BACKGROUND_LEVEL,
+	.max_leak_amplitude = MAX_LEAK_AMPLITUDE,
+	.weight_threshold   = DETECTION_WEIGHT_THRESHOLD,
+	.weight_ratio_limit = DETECTION_WEIGHT_RATIO_LIMIT,
+	.displacement_limit = DETECTION_DISPLACEMENT_LIMIT,
+};
+
+
+static parking_space_t spaces[MAX_SPACE_COUNT];
+static uint16_t        space_count;
+
+// The time of the last calibration of each sensor, indexed by sensor id - 1
+static uint32_t last_calibration_ms[MAX_SENSOR_COUNT];
+
+
+/**
+ * Set up the service, tables and observation windows of a space
+ *
+ * @param space The space to set up
+ * @param config The configuration of the space
+ * @return True, if successful
+ */
+static bool space_setup(parking_space_t *space, const parking_space_config_t *config);
+
+
+/**
+ * Release all resources of a space
+ *
+ * @param space The space to release
+ */
+static void space_release(parking_space_t *space);
+
+
+/**
+ * Calibrate a sensor and recreate the services of all spaces on it
+ *
+ * @param sensor_id The sensor to calibrate
+ * @return True, if successful
+ */
+static bool sensor_recalibration(acc_sensor_id_t sensor_id);
+
+
+/**
+ * Calibrate the sensor
+ *
+ * @param sensor_id The sensor to calibrate
+ * @return True, if sensor calibration was successful
+ */
+static bool sensor_calibration(acc_sensor_id_t sensor_id);
+
+
+int main(int argc, char *argv[]);
+
+
+int main(int argc, char *argv[])
+{
+	(void)argc;
+	(void)argv;
+	printf("Acconeer software version %s\n", acc_version_get());
+
+	const acc_hal_t *hal = acc_hal_integration_get_implementation();
+
+	if (!acc_rss_activate(hal))
+	{
+		printf("Failed to activate RSS\n");
+		return EXIT_FAILURE;
+	}
+
+	bool status = true;
+
+	for (uint16_t i = 0; status && i < sizeof(space_configs) / sizeof(space_configs[0]); i++)
+	{
+		const parking_space_config_t *config = &space_configs[i];
+
+		if (space_count == MAX_SPACE_COUNT)
+		{
+			printf("Space %s: too many spaces, max %u, skipped\n", config->name, (unsigned int)MAX_SPACE_COUNT);
+			continue;
+		}
+
+		if (config->sensor_id > hal->properties.sensor_count || config->sensor_id > MAX_SENSOR_COUNT)
+		{
+			printf("Space %s: sensor %" PRIu32 " not available, skipped\n", config->name, config->sensor_id);
+			continue;
+		}
+
+		bool calibrated = false;
+
+		for (uint16_t j = 0; j < space_count; j++)
+		{
+			calibrated = calibrated || spaces[j].config->sensor_id == config->sensor_id;
+		}
+
+		if (!calibrated)
+		{
+			status = sensor_calibration(config->sensor_id);
+
+			if (status)
+			{
+				last_calibration_ms[config->sensor_id - 1] = hal->os.gettime();
+			}
+			else
+			{
+				printf("Failed to calibrate sensor %" PRIu32 "\n", config->sensor_id);
+			}
+		}
+
+		if (status && !space_setup(&spaces[space_count], config))
+		{
+			printf("Failed to set up space %s\n", config->name);
+			space_release(&spaces[space_count]);
+			status = false;
+		}
+
+		if (status)
+		{
+			space_count++;
+		}
+	}
+
+	if (status && space_count == 0)
+	{
+		printf("No spaces to monitor\n");
+		status = false;
+	}
+
+	uint32_t                period_ms   = (uint32_t)(DETECTOR_SWEEP_PERIOD_S * 1000);
+	uint32_t                start_ms    = hal->os.gettime();
+	uint16_t                space_index = 0;
+	acc_integration_pacer_t pacer;
+
+	if (status)
+	{
+		printf("Monitoring %" PRIu16 " spaces, sweep period %" PRIu32 " ms, stagger %" PRIu32 " ms\n",
+		       space_count, period_ms, period_ms / space_count);
+
+		// One pacer for all spaces, each deadline is the sweep of the next space in turn
+		acc_integration_pacer_init(&pacer, space_count / DETECTOR_SWEEP_PERIOD_S);
+	}
+
+	while (status)
+	{
+		parking_space_t                    *space = &spaces[space_index];
+		acc_service_envelope_result_info_t result_info;
+		uint32_t                           *sensor_calibration_ms = &last_calibration_ms[space->config->sensor_id - 1];
+
+		space_index = (uint16_t)((space_index + 1) % space_count);
+
+		// An overrun delays the following sweeps, every space keeps its turn
+		acc_integration_pacer_wait(&pacer);
+
+		status = acc_service_envelope_execute_once(space->handle, space->data, space->profile.length, &result_info);
+
+		if (status && result_info.data_quality_warning &&
+		    hal->os.gettime() - *sensor_calibration_ms > SERVICE_RUNTIME_MIN_S * 1000)
+		{
+			status                 = sensor_recalibration(space->config->sensor_id);
+			*sensor_calibration_ms = hal->os.gettime();
+
+			if (status)
+			{
+				status = acc_service_envelope_execute_once(space->handle, space->data, space->profile.length, &result_info);
+			}
+		}
+
+		if (status)
+		{
+			bool occupied = acc_parking_detection_update(&space->profile, &detection_parameters, space->leak_sample_index,
+			                                             &space->observations, space->data);
+
+			if (acc_sliding_window_is_full(space->observations.weight) &&
+			    (!space->reported || occupied != space->occupied))
+			{
+				acc_integration_pacer_statistics_t statistics;
+
+				acc_integration_pacer_get_statistics(&pacer, &statistics);
+
+				printf("%" PRIu32 ": space %s %s (max jitter %" PRIu32 " us, overruns %" PRIu32 ")\n",
+				       hal->os.gettime() - start_ms, space->config->name, occupied ? "occupied" : "vacant",
+				       statistics.jitter_max_us, statistics.overrun_count);
+
+				space->occupied = occupied;
+				space->reported = true;
+			}
+		}
+	}
+
+	for (uint16_t i = 0; i < space_count; i++)
+	{
+		space_release(&spaces[i]);
+	}
+
+	acc_rss_deactivate();
+
+	return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+bool space_setup(parking_space_t *space, const parking_space_config_t *config)
+{
+	acc_service_envelope_metadata_t metadata;
+
+	space->config        = config;
+	space->configuration = acc_service_envelope_configuration_create();
+
+	if (space->configuration == NULL)
+	{
+		return false;
+	}
+
+	acc_service_sensor_set(space->configuration, config->sensor_id);
+	acc_service_requested_start_set(space->configuration, config->range_start_m);
+	acc_service_requested_length_set(space->configuration, config->range_length_m);
+	acc_service_envelope_downsampling_factor_set(space->configuration, SERVICE_DOWNSAMPLING);
+	acc_service_hw_accelerated_average_samples_set(space->configuration, SERVICE_HWAAS);
+	acc_service_envelope_running_average_factor_set(space->configuration, RUNNING_AVERAGE_FACTOR);
+	acc_service_power_save_mode_set(space->configuration, POWER_SAVE_MODE);
+
+	// The service is activated for each sweep by execute_once, which also renews the noise level normalization
+	space->handle = acc_service_create(space->configuration);
+
+	if (space->handle == NULL)
+	{
+		return false;
+	}
+
+	acc_service_envelope_get_metadata(space->handle, &metadata);
+
+	uint16_t leak_sample_index = (uint16_t)(((config->leak_sample_position_m - metadata.start_m) / metadata.step_length_m) + 0.5f);
+	uint16_t leak_end_index    = (uint16_t)(((config->leak_end_position_m - metadata.start_m) / metadata.step_length_m) + 0.5f);
+
+	if (leak_sample_index >= leak_end_index || leak_sample_index >= metadata.data_length)
+	{
+		printf("Space %s: leakage parameters are not valid\n", config->name);
+		return false;
+	}
+
+	space->leak_sample_index     = leak_sample_index;
+	space->data                  = malloc(metadata.data_length * sizeof(*space->data));
+	space->observations.weight   = acc_sliding_window_create(DETECTION_OBSERVATION_COUNT);
+	space->observations.distance = acc_sliding_window_create(DETECTION_OBSERVATION_COUNT);
+
+	return space->data != NULL && space->observations.weight != NULL && space->observations.distance != NULL &&
+	       acc_parking_profile_setup(&space->profile, &metadata, leak_sample_index, leak_end_index);
+}
+
+
+void space_release(parking_space_t *space)
+{
+	acc_parking_profile_release(&space->profile);
+	acc_sliding_window_destroy(&space->observations.weight);
+	acc_sliding_window_destroy(&space->observations.distance);
+	free(space->data);
+	space->data = NULL;
+
+	if (space->handle != NULL)
+	{
+		acc_service_destroy(&space->handle);
+	}
+
+	if (space->configuration != NULL)
+	{
+		acc_service_envelope_configuration_destroy(&space->configuration);
+	}
+}
+
+
+bool sensor_recalibration(acc_sensor_id_t sensor_id)
+{
+	bool status = true;
+
+	for (uint16_t i = 0; i < space_count; i++)
+	{
+		if (spaces[i].config->sensor_id == sensor_id)
+		{
+			acc_service_destroy(&spaces[i].handle);
+		}
+	}
+
+	status = sensor_calibration(sensor_id);
+
+	for (uint16_t i = 0; status && i < space_count; i++)
+	{
+		if (spaces[i].config->sensor_id == sensor_id)
+		{
+			spaces[i].handle = acc_service_create(spaces[i].configuration);
+			status           = spaces[i].handle != NULL;
+		}
+	}
+
+	return status;
+}
+
+
+bool sensor_calibration(acc_sensor_id_t sensor_id)
+{
+	acc_calibration_context_t calibration_context;
+
+	if (!acc_rss_calibration_context_get(sensor_id, &calibration_context))
+	{
+		return false;
+	}
+
+	if (!acc_rss_calibration_context_forced_set(sensor_id, &calibration_context))
+	{
+		return false;
+	}
+
+	return true;
+}
@@ -8,14 +8,17 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "acc_definitions_common.h"
 #include "acc_detector_presence.h"
 #include "acc_hal_definitions.h"
 #include "acc_hal_integration.h"
-#include "acc_integration.h"
+#include "acc_integration_pacer.h"
+#include "acc_rate_controller.h"
 #include "acc_rss.h"
 #include "acc_version.h"
+#include "acc_zone_map.h"
 
 // Default values for this reference application
 // See API documentation for more information of respective parameter
@@ -24,10 +27,54 @@
 #define DEFAULT_LENGTH_M             (2.00f)
 #define DEFAULT_ZONE_LENGTH          (0.4f)
 #define DEFAULT_UPDATE_RATE_WAKEUP   (2.0f)
+#define DEFAULT_UPDATE_RATE_ALERT    (8.0f)
 #define DEFAULT_UPDATE_RATE_TRACKING (20.0f)
 #define DEFAULT_THRESHOLD            (2.0f)
 #define DEFAULT_NBR_REMOVED_PC       (0)
 
+// A score above the alert score raises the update rate before presence is detected, to shorten the
+// time to detection. The alert tier is left when the score has been below the exit score for the
+// number of exit frames.
+#define DEFAULT_ALERT_SCORE       (1.0f)
+#define DEFAULT_ALERT_EXIT_SCORE  (0.7f)
+#define DEFAULT_ALERT_EXIT_FRAMES (16)
+
+// Zone occupancy hysteresis, on the presence score of the distance points in each zone
+#define DEFAULT_ZONE_ENTER_SCORE (DEFAULT_THRESHOLD)
+#define DEFAULT_ZONE_EXIT_SCORE  (1.5f)
+
+// Time between two rate controller statistics lines
+#define STATISTICS_PERIOD_MS (60000U)
+
+
+// Rate and power tiers, from the lowest to the highest update rate
+static const acc_rate_controller_tier_t rate_tiers[] =
+{
+	{
+		.name            = "wakeup",
+		.update_rate_hz  = DEFAULT_UPDATE_RATE_WAKEUP,
+		.power_save_mode = ACC_POWER_SAVE_MODE_OFF,
+	},
+	{
+		.name            = "alert",
+		.update_rate_hz  = DEFAULT_UPDATE_RATE_ALERT,
+		.power_save_mode = ACC_POWER_SAVE_MODE_SLEEP,
+		.enter_score     = DEFAULT_ALERT_SCORE,
+		.exit_score      = DEFAULT_ALERT_EXIT_SCORE,
+		.exit_frames     = DEFAULT_ALERT_EXIT_FRAMES,
+	},
+	{
+		.name            = "tracking",
+		.update_rate_hz  = DEFAULT_UPDATE_RATE_TRACKING,
+		.power_save_mode = ACC_POWER_SAVE_MODE_SLEEP,
+		.enter_score     = DEFAULT_THRESHOLD,
+		.exit_score      = DEFAULT_THRESHOLD,
+		.exit_frames     = 1,
+	},
+};
+
+#define RATE_TIER_COUNT (sizeof(rate_tiers) / sizeof(rate_tiers[0]))
+
 
 /**
  * @brief Set default values in presence configuration
@@ -38,7 +85,8 @@ static void set_default_configuration(acc_detector_presence_configuration_t pres
 {
 	acc_detector_presence_configuration_sensor_set(presence_configuration, DEFAULT_SENSOR_ID);
 
-	acc_detector_presence_configuration_update_rate_set(presence_configuration, DEFAULT_UPDATE_RATE_WAKEUP);
+	acc_detector_presence_configuration_update_rate_set(presence_configuration, rate_tiers[0].update_rate_hz);
+	acc_detector_presence_configuration_power_save_mode_set(presence_configuration, rate_tiers[0].power_save_mode);
 	acc_detector_presence_configuration_detection_threshold_set(presence_configuration, DEFAULT_THRESHOLD);
 
 	acc_detector_presence_configuration_start_set(presence_configuration, DEFAULT_START_M);
@@ -51,84 +99,224 @@ static void set_default_configuration(acc_detector_presence_configuration_t pres
 	acc_detector_presence_configuration_filter_parameters_set(presence_configuration, &filter);
 
 	acc_detector_presence_configuration_nbr_removed_pc_set(presence_configuration, DEFAULT_NBR_REMOVED_PC);
+	acc_detector_presence_configuration_vector_output_mode_set(presence_configuration, true);
 }
 
 
 /**
- * @brief Use the presence detector to detect movement with low power
+ * @brief Get a monotonic time stamp
  *
- * @param[in] handle The presence detector handle
+ * @return The time in us
  */
-static bool execute_wakeup(acc_detector_presence_handle_t handle)
+static uint64_t get_time_us(void)
 {
-	acc_detector_presence_result_t result;
+	struct timespec time_ts = {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &time_ts);
+	return (uint64_t)time_ts.tv_sec * 1000000 + (uint64_t)time_ts.tv_nsec / 1000;
+}
+
+
+/**
+ * @brief Print the pacing statistics of a tier
+ *
+ * @param[in] tier The tier
+ * @param[in] pacer The pacer of the tier
+ */
+static void print_pacing_statistics(const acc_rate_controller_tier_t *tier, const acc_integration_pacer_t *pacer)
+{
+	acc_integration_pacer_statistics_t statistics;
+
+	acc_integration_pacer_get_statistics(pacer, &statistics);
+
+	printf("Left %s: %u frames, %u.%02u Hz, overruns: %u, jitter mean: %u us, max: %u us\n", tier->name,
+	       (unsigned int)statistics.frame_count,
+	       (unsigned int)statistics.rate_hz,
+	       (unsigned int)(statistics.rate_hz * 100.0f) % 100,
+	       (unsigned int)statistics.overrun_count,
+	       (unsigned int)statistics.jitter_mean_us,
+	       (unsigned int)statistics.jitter_max_us);
+}
 
-	if (!acc_detector_presence_activate(handle))
+
+/**
+ * @brief Print the rate controller statistics
+ *
+ * @param[in] controller The rate controller
+ * @param[in] time_ms The current time
+ */
+static void print_controller_statistics(const acc_rate_controller_t *controller, uint32_t time_ms)
+{
+	acc_rate_controller_statistics_t statistics;
+
+	acc_rate_controller_get_statistics(controller, time_ms, &statistics);
+
+	for (uint16_t i = 0; i < RATE_TIER_COUNT; i++)
 	{
-		printf("Failed to activate detector\n");
-		return false;
+		printf("Time in %s: %u ms\n", rate_tiers[i].name, (unsigned int)statistics.time_in_tier_ms[i]);
 	}
 
-	do
+	printf("Transitions: %u, reconfigurations: %u, mean: %u us, max: %u us\n",
+	       (unsigned int)statistics.transition_count,
+	       (unsigned int)statistics.reconfigure_count,
+	       (unsigned int)(statistics.reconfigure_count > 0 ? statistics.reconfigure_time_sum_us / statistics.reconfigure_count : 0),
+	       (unsigned int)statistics.reconfigure_time_max_us);
+	printf("Detections: %u, latency mean: %u ms, max: %u ms\n",
+	       (unsigned int)statistics.detection_count,
+	       (unsigned int)(statistics.detection_count > 0 ? statistics.detection_latency_sum_ms / statistics.detection_count : 0),
+	       (unsigned int)statistics.detection_latency_max_ms);
+}
+
+
+/**
+ * @brief Print the occupancy and score of all zones
+ *
+ * @param[in] map The zone map
+ */
+static void print_zone_map(const acc_zone_map_t *map)
+{
+	printf("Zones:");
+
+	for (uint16_t zone = 0; zone < map->zone_count; zone++)
 	{
-		if (!acc_detector_presence_get_next(handle, &result))
-		{
-			printf("Failed to get data from sensor\n");
-			return false;
-		}
+		printf(" %u:%s(%d)", (unsigned int)zone, map->occupied[zone] ? "occupied" : "vacant",
+		       (int)(map->score[zone] * 1000.0f));
+	}
+
+	printf("\n");
+}
+
+
+/**
+ * @brief Reconfigure the presence detector to the update rate and power save mode of a tier
+ *
+ * The detector must be deactivated.
+ *
+ * @param[in] handle The presence detector handle
+ * @param[in] presence_configuration The presence configuration
+ * @param[in] controller The rate controller, the reconfiguration time is reported to it
+ */
+static bool apply_tier(acc_detector_presence_handle_t        *handle,
+                       acc_detector_presence_configuration_t presence_configuration,
+                       acc_rate_controller_t                 *controller)
+{
+	const acc_rate_controller_tier_t *tier     = acc_rate_controller_get_tier(controller);
+	uint64_t                         start_us = get_time_us();
 
-		acc_integration_sleep_ms(1000 / DEFAULT_UPDATE_RATE_WAKEUP);
-	} while (!result.presence_detected);
+	acc_detector_presence_configuration_update_rate_set(presence_configuration, tier->update_rate_hz);
+	acc_detector_presence_configuration_power_save_mode_set(presence_configuration, tier->power_save_mode);
 
-	uint32_t detected_zone = (uint32_t)((float)(result.presence_distance - DEFAULT_START_M) / (float)DEFAULT_ZONE_LENGTH);
-	printf("Motion in zone: %u, distance: %d, score: %d\n", (unsigned int)detected_zone, (int)(result.presence_distance * 1000.0f),
-	       (int)(result.presence_score * 1000.0f));
+	if (!acc_detector_presence_reconfigure(handle, presence_configuration))
+	{
+		printf("Failed to reconfigure detector\n");
+		return false;
+	}
 
-	acc_detector_presence_deactivate(handle);
+	acc_rate_controller_transition_done(controller, (uint32_t)(get_time_us() - start_us));
 
 	return true;
 }
 
 
 /**
- * @brief Use the presence detector to track movement in front of the sensor
+ * @brief Detect presence, track the occupancy of each zone and adapt the update rate to the presence score
  *
  * @param[in] handle The presence detector handle
+ * @param[in] presence_configuration The presence configuration
+ * @param[in] hal The HAL
  */
-static bool execute_movement_tracking(acc_detector_presence_handle_t handle)
+static bool execute_presence_detection(acc_detector_presence_handle_t        *handle,
+                                       acc_detector_presence_configuration_t presence_configuration,
+                                       const acc_hal_t                       *hal)
 {
 	acc_detector_presence_result_t result;
+	acc_integration_pacer_t        pacer;
+	acc_rate_controller_t          controller;
+	acc_zone_map_t                 zone_map;
+	float                          *points             = NULL;
+	uint16_t                       point_count         = 0;
+	bool                           zones_changed       = false;
+	uint32_t                       statistics_start_ms = hal->os.gettime();
+
+	if (!acc_rate_controller_init(&controller, rate_tiers, RATE_TIER_COUNT, statistics_start_ms) ||
+	    !acc_zone_map_init(&zone_map, DEFAULT_START_M, DEFAULT_LENGTH_M, DEFAULT_ZONE_LENGTH,
+	                       DEFAULT_ZONE_ENTER_SCORE, DEFAULT_ZONE_EXIT_SCORE))
+	{
+		return false;
+	}
 
-	if (!acc_detector_presence_activate(handle))
+	acc_integration_pacer_init(&pacer, rate_tiers[0].update_rate_hz);
+
+	bool status = acc_detector_presence_activate(*handle);
+
+	if (!status)
 	{
 		printf("Failed to activate detector\n");
-		return false;
 	}
 
-	do
+	while (status)
 	{
-		if (!acc_detector_presence_get_next(handle, &result))
+		acc_integration_pacer_wait(&pacer);
+
+		if (!acc_detector_presence_distance_point_vector_get_next(*handle, &point_count, &points, &result))
 		{
 			printf("Failed to get data from sensor\n");
-			return false;
+			status = false;
+			break;
 		}
 
-		if (result.presence_detected)
+		uint32_t time_ms = hal->os.gettime();
+
+		if (!acc_zone_map_update(&zone_map, points, point_count, &zones_changed))
 		{
-			uint32_t detected_zone = (uint32_t)((float)(result.presence_distance - DEFAULT_START_M) / (float)DEFAULT_ZONE_LENGTH);
-			printf("Motion in zone: %u, distance: %d, score: %d\n", (unsigned int)detected_zone,
-			       (int)(result.presence_distance * 1000.0f),
-			       (int)(result.presence_score * 1000.0f));
+			status = false;
+			break;
 		}
 
-		acc_integration_sleep_ms(1000 / DEFAULT_UPDATE_RATE_TRACKING);
-	} while (result.presence_detected);
+		if (zones_changed)
+		{
+			print_zone_map(&zone_map);
+		}
 
-	printf("No motion, score: %d\n", (int)(result.presence_score * 1000.0f));
+		const acc_rate_controller_tier_t *previous_tier = acc_rate_controller_get_tier(&controller);
+		acc_rate_controller_transition_t transition     = acc_rate_controller_update(&controller, result.presence_detected,
+		                                                                             result.presence_score, time_ms);
 
-	acc_detector_presence_deactivate(handle);
+		if (transition != ACC_RATE_CONTROLLER_TRANSITION_NONE)
+		{
+			const acc_rate_controller_tier_t *tier = acc_rate_controller_get_tier(&controller);
+
+			if (previous_tier == &rate_tiers[RATE_TIER_COUNT - 1])
+			{
+				printf("No motion, score: %d\n", (int)(result.presence_score * 1000.0f));
+			}
+
+			print_pacing_statistics(previous_tier, &pacer);
+			printf("Enter %s, %u.%02u Hz\n", tier->name, (unsigned int)tier->update_rate_hz,
+			       (unsigned int)(tier->update_rate_hz * 100.0f) % 100);
+
+			// Tiers with the same update rate and power save mode only differ in thresholds
+			if (transition == ACC_RATE_CONTROLLER_TRANSITION_RECONFIGURE)
+			{
+				status = acc_detector_presence_deactivate(*handle) &&
+				         apply_tier(handle, presence_configuration, &controller) &&
+				         acc_detector_presence_activate(*handle);
+			}
+
+			acc_integration_pacer_init(&pacer, tier->update_rate_hz);
+		}
 
-	return true;
+		if (time_ms - statistics_start_ms >= STATISTICS_PERIOD_MS)
+		{
+			print_controller_statistics(&controller, time_ms);
+			acc_rate_controller_reset_statistics(&controller, time_ms);
+			statistics_start_ms = time_ms;
+		}
+	}
+
+	acc_zone_map_release(&zone_map);
+
+	return status;
 }
 
 
@@ -158,7 +346,6 @@ int main(int argc, char *argv[])
 	}
 
 	set_default_configuration(presence_configuration);
-	acc_detector_presence_configuration_power_save_mode_set(presence_configuration, ACC_POWER_SAVE_MODE_OFF);
 
 	acc_detector_presence_handle_t handle = acc_detector_presence_create(presence_configuration);
 	if (handle == NULL)
@@ -170,50 +357,11 @@ int main(int argc, char *argv[])
 		return EXIT_FAILURE;
 	}
 
-	while (true)
-	{
-		if (!execute_wakeup(handle))
-		{
-			acc_detector_presence_configuration_destroy(&presence_configuration);
-			acc_detector_presence_destroy(&handle);
-			acc_rss_deactivate();
-			return EXIT_FAILURE;
-		}
-
-		acc_detector_presence_configuration_update_rate_set(presence_configuration, DEFAULT_UPDATE_RATE_TRACKING);
-		acc_detector_presence_configuration_power_save_mode_set(presence_configuration, ACC_POWER_SAVE_MODE_SLEEP);
-
-		if (!acc_detector_presence_reconfigure(&handle, presence_configuration))
-		{
-			printf("Failed to reconfigure detector\n");
-			acc_detector_presence_configuration_destroy(&presence_configuration);
-			acc_detector_presence_destroy(&handle);
-			acc_rss_deactivate();
-			return EXIT_FAILURE;
-		}
-
-		if (!execute_movement_tracking(handle))
-		{
-			acc_detector_presence_configuration_destroy(&presence_configuration);
-			acc_detector_presence_destroy(&handle);
-			acc_rss_deactivate();
-			return EXIT_FAILURE;
-		}
-
-		acc_detector_presence_configuration_update_rate_set(presence_configuration, DEFAULT_UPDATE_RATE_WAKEUP);
-		acc_detector_presence_configuration_power_save_mode_set(presence_configuration, ACC_POWER_SAVE_MODE_OFF);
-
-		if (!acc_detector_presence_reconfigure(&handle, presence_configuration))
-		{
-			printf("Failed to reconfigure detector\n");
-			acc_detector_presence_configuration_destroy(&presence_configuration);
-			acc_detector_presence_destroy(&handle);
-			acc_rss_deactivate();
-			return EXIT_FAILURE;
-		}
-	}
+	bool status = execute_presence_detection(&handle, presence_configuration, hal);
 
-	// We will never exit so no need to destroy the configuration or detector
+	acc_detector_presence_configuration_destroy(&presence_configuration);
+	acc_detector_presence_destroy(&handle);
+	acc_rss_deactivate();
 
-	return EXIT_SUCCESS;
+	return status ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -5,13 +5,19 @@
 // of this source code package.
 
 #include <stdbool.h>
+#include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
+#include "acc_cache_file.h"
 #include "acc_definitions_common.h"
 #include "acc_detector_distance.h"
 #include "acc_hal_definitions.h"
 #include "acc_hal_integration.h"
+#include "acc_integration_gain_search.h"
 #include "acc_integration_log.h"
 #include "acc_rss.h"
 #include "acc_version.h"
@@ -62,75 +68,242 @@
 #define DEFAULT_FAR_RANGE_CFAR_THRESHOLD_WINDOW 0.03f
 
 // Gain can be configured in 22 steps between 0.0 and 1.0
-#define GAIN_STEP             (1.0f / 22.0f)
+#define GAIN_STEP             (1.0f / ACC_INTEGRATION_GAIN_STEP_COUNT)
 #define MAX_BACKGROUND_LENGTH 1200
 
+// Number of gain steps below the highest non-saturating gain to record backgrounds with
+#define BACKGROUND_GAIN_MARGIN_STEPS 1
+
+// Start each reading in the sector predicted from the level trend instead of always
+// searching close, mid and far range in order. A detection in the predicted sector
+// is accepted if it is within the gate of the predicted distance.
+#define ADAPTIVE_SECTOR_ORDER  true
+#define SECTOR_PREDICTION_GATE 0.05f
+
+// Level tracking, a constant rate Kalman filter on the detected distances
+// The measurement noise is the standard deviation of a single detected distance and the
+// process noise is the standard deviation of the level acceleration. Detections further
+// than the gate from the predicted level, in standard deviations of the innovation, are
+// rejected as outliers. The tracker restarts at the detected distance after a number of
+// consecutive rejections, e.g. when the tank is filled or emptied faster than tracked.
+#define LEVEL_MEASUREMENT_NOISE_M      0.005f
+#define LEVEL_PROCESS_NOISE_M_S2       0.001f
+#define LEVEL_INITIAL_RATE_NOISE_M_S   0.01f
+#define LEVEL_GATE_SIGMA               3.0f
+#define LEVEL_MAX_CONSECUTIVE_REJECTED 5
+
+// Number of readings between two statistics log lines
+#define STATISTICS_READING_COUNT 50
+
+// The sensor calibration, gains and backgrounds are cached in this file. The cache is only
+// used if it was written with the same configuration and RSS version and if the sensor
+// calibration is still valid. Remove the file to force a new background recording.
+#define CACHE_FILE_PATH      "ref_app_tank_level.cache"
+#define CACHE_FORMAT_VERSION 1
+
+
+typedef enum
+{
+	SECTOR_CLOSE,
+	SECTOR_MID,
+	SECTOR_FAR,
+	SECTOR_COUNT
+} sector_t;
 
-static uint16_t close_background[MAX_BACKGROUND_LENGTH];
-static uint16_t close_background_length;
-static float    close_range_gain = DEFAULT_CLOSE_RANGE_GAIN;
 
+typedef struct
+{
+	bool  has_level;
+	float distance;
+	float rate;
+} sector_schedule_t;
+
+
+/**
+ * Level tracker state, the level is the distance to the surface
+ */
+typedef struct
+{
+	bool     has_level;
+	float    level;
+	float    rate;
+	float    level_variance;
+	float    rate_variance;
+	float    covariance;
+	uint32_t time_ms;
+	uint16_t consecutive_rejected;
+} level_tracker_t;
+
+
+/**
+ * A distance detector per sector, created and configured once
+ *
+ * Switching sector only needs an activate/deactivate of the sector detector. A reconfigure
+ * is only needed when the gain of a sector has to be lowered due to data saturation.
+ */
+typedef struct
+{
+	const char                            *name;
+	acc_detector_distance_configuration_t configuration;
+	acc_detector_distance_handle_t        handle;
+	uint16_t                              *background;
+	uint16_t                              background_length;
+	float                                 default_gain;
+	float                                 gain;
+} sector_detector_t;
+
+
+/**
+ * Time spent in the distance detector API, in us
+ */
+typedef struct
+{
+	uint32_t reconfigure_count;
+	uint64_t reconfigure_us;
+	uint64_t set_background_us;
+	uint64_t activate_us;
+	uint64_t get_next_us;
+	uint64_t deactivate_us;
+} latency_statistics_t;
+
+
+/**
+ * The content of the cache file
+ */
+typedef struct
+{
+	acc_calibration_context_t calibration_context;
+	float                     gain[SECTOR_COUNT];
+	uint16_t                  background_length[SECTOR_COUNT];
+	uint16_t                  background[SECTOR_COUNT][MAX_BACKGROUND_LENGTH];
+} calibration_cache_t;
+
+
+static uint16_t close_background[MAX_BACKGROUND_LENGTH];
 static uint16_t mid_background[MAX_BACKGROUND_LENGTH];
-static uint16_t mid_background_length;
-static float    mid_range_gain = DEFAULT_MID_RANGE_GAIN;
+
+static sector_detector_t sector_detectors[SECTOR_COUNT] =
+{
+	[SECTOR_CLOSE] = {.name = "close", .background = close_background, .default_gain = DEFAULT_CLOSE_RANGE_GAIN},
+	[SECTOR_MID]   = {.name = "mid", .background = mid_background, .default_gain = DEFAULT_MID_RANGE_GAIN},
+	[SECTOR_FAR]   = {.name = "far", .background = NULL, .default_gain = DEFAULT_FAR_RANGE_GAIN},
+};
+
+static latency_statistics_t latency_statistics;
+static calibration_cache_t  calibration_cache;
+
+
+/**
+ * Get a monotonic time stamp
+ *
+ * @return The time in us
+ */
+static uint64_t get_time_us(void);
 
 
 /**
  * Calibrate the sensor
  *
+ * @param calibration_context The new calibration context
  * @return True, if sensor calibration was successful
  */
-static bool sensor_calibration(void);
+static bool sensor_calibration(acc_calibration_context_t *calibration_context);
+
+
+/**
+ * Reconfigure the detector of a sector and count the reconfiguration
+ *
+ * @param detector The sector detector
+ * @return True, if reconfiguration was successful
+ */
+static bool reconfigure(sector_detector_t *detector);
+
+
+/**
+ * Set the recorded background of a sector detector, if the sector uses one
+ *
+ * @param detector The sector detector
+ * @return True, if successful
+ */
+static bool set_background(sector_detector_t *detector);
 
 
 /**
  * Configure distance detector to measure in the close range sector
  *
- * @param distance_handle Distance Detector handle
  * @param distance_configuration Distance Detector configuration
- * @return True, if configuration was successful
+ * @param gain The receiver gain
  */
-static bool configure_close_range(acc_detector_distance_handle_t        *distance_handle,
-                                  acc_detector_distance_configuration_t distance_configuration);
+static void configure_close_range(acc_detector_distance_configuration_t distance_configuration, float gain);
 
 
 /**
  * Configure distance detector to measure in the mid range sector
  *
- * @param distance_handle Distance Detector handle
  * @param distance_configuration Distance Detector configuration
- * @return True, if configuration was successful
+ * @param gain The receiver gain
  */
-static bool configure_mid_range(acc_detector_distance_handle_t        *distance_handle,
-                                acc_detector_distance_configuration_t distance_configuration);
+static void configure_mid_range(acc_detector_distance_configuration_t distance_configuration, float gain);
 
 
 /**
  * Configure distance detector to measure in the far range sector
  *
- * @param distance_handle Distance Detector handle
  * @param distance_configuration Distance Detector configuration
- * @return True, if configuration was successful
+ * @param gain The receiver gain
  */
-static bool configure_far_range(acc_detector_distance_handle_t        *distance_handle,
-                                acc_detector_distance_configuration_t distance_configuration);
+static void configure_far_range(acc_detector_distance_configuration_t distance_configuration, float gain);
 
 
 /**
- * Record the background for specific configuration
+ * Create the configurations of all sector detectors
  *
- * This function will set the requested gain, but the gain will be lowered in case of data saturation.
+ * @return True, if successful
+ */
+static bool create_sector_configurations(void);
+
+
+/**
+ * Create the detectors of all sectors from their configurations and set their backgrounds
  *
- * @param distance_handle Distance Detector handle
- * @param distance_configuration Distance Detector configuration
- * @param range_gain The gain actually used
- * @param background Array to store background in
- * @param background_length Length of background array
+ * @return True, if successful
+ */
+static bool create_sector_detectors(void);
+
+
+/**
+ * Destroy the detectors of all sectors, the configurations are kept
+ */
+static void destroy_sector_detectors(void);
+
+
+/**
+ * Destroy the detectors and configurations of all sectors
+ */
+static void destroy_sectors(void);
+
+
+/**
+ * Record the background for a sector at one gain, used by the gain search
+ *
+ * @param gain The receiver gain
+ * @param user_data The sector detector
+ * @param saturated True, if the recorded background was saturated
  * @return True, if recording was successful
  */
-static bool record_background(acc_detector_distance_handle_t *distance_handle,
-                              acc_detector_distance_configuration_t distance_configuration,
-                              float *range_gain, uint16_t *background, uint16_t background_length);
+static bool record_background_at_gain(float gain, void *user_data, bool *saturated);
+
+
+/**
+ * Record the background for a sector
+ *
+ * The gain of the sector is the highest gain tried, the gain is lowered by a gain search
+ * in case of data saturation.
+ *
+ * @param detector The sector detector, the gain actually used is stored in the detector
+ * @return True, if recording was successful
+ */
+static bool record_background(sector_detector_t *detector);
 
 
 /**
@@ -139,70 +312,161 @@ static bool record_background(acc_detector_distance_handle_t *distance_handle,
  * Make sure no object is within these two sectors, i.e. no objects closer
  * to the sensor than DEFAULT_MID_RANGE_START + DEFAULT_MID_RANGE_LENGTH
  *
- * @param distance_handle Distance Detector handle
- * @param distance_configuration Distance Detector configuration
  * @return True, if recording was successful
  */
-static bool record_backgrounds(acc_detector_distance_handle_t        *distance_handle,
-                               acc_detector_distance_configuration_t distance_configuration);
+static bool record_backgrounds(void);
+
+
+/**
+ * Hash the sector configurations and the RSS version, used as key for the cache file
+ *
+ * Must be called before any gain is changed from its default.
+ *
+ * @return The hash
+ */
+static uint32_t configuration_hash(void);
+
+
+/**
+ * Start from a cached sensor calibration, gains and backgrounds
+ *
+ * The cache is validated with one measurement per sector with a background, a saturated
+ * measurement or a data quality warning means that the cached backgrounds can not be used.
+ *
+ * @param cache_key The expected cache key
+ * @return True, if the detectors are created and ready to measure
+ */
+static bool start_from_cache(uint32_t cache_key);
+
+
+/**
+ * Start with a new sensor calibration and background recording, the result is cached
+ *
+ * @param cache_key The key to write the cache with
+ * @return True, if the detectors are created and ready to measure
+ */
+static bool start_from_recording(uint32_t cache_key);
+
+
+/**
+ * Check that a cached background can be used with one measurement
+ *
+ * @param detector The sector detector
+ * @return True, if the measurement was successful and not saturated
+ */
+static bool validate_background(sector_detector_t *detector);
 
 
 /**
  * Perform one measurement
  *
- * This function will set the requested gain, but the gain will be lowered in case of data saturation.
+ * This function will use the gain of the sector, but the gain will be lowered in case of data saturation.
+ * A lowered gain is kept by the sector detector for later measurements.
  *
- * @param distance_handle Distance Detector handle
- * @param distance_configuration Distance Detector configuration
+ * @param detector The sector detector
  * @param result Distance Detector result
  * @param result_info Distance Detector result info
  */
-static bool measurement(acc_detector_distance_handle_t        *distance_handle,
-                        acc_detector_distance_configuration_t distance_configuration,
-                        acc_detector_distance_result_t        *result,
-                        acc_detector_distance_result_info_t   *result_info);
+static bool measurement(sector_detector_t                   *detector,
+                        acc_detector_distance_result_t      *result,
+                        acc_detector_distance_result_info_t *result_info);
 
 
 /**
  * Measure in the close range sector
  *
- * @param distance_handle Distance Detector handle
- * @param distance_configuration Distance Detector configuration
  * @param distance_detected True, if a distance was detected
  * @param distance Detected distance
  * @return True, if measurement was successful
  */
-static bool measure_close_range(acc_detector_distance_handle_t *distance_handle,
-                                acc_detector_distance_configuration_t distance_configuration,
-                                bool *distance_detected, float *distance);
+static bool measure_close_range(bool *distance_detected, float *distance);
 
 
 /**
  * Measure in the mid range sector
  *
- * @param distance_handle Distance Detector handle
- * @param distance_configuration Distance Detector configuration
  * @param distance_detected True, if a distance was detected
  * @param distance Detected distance
  * @return True, if measurement was successful
  */
-static bool measure_mid_range(acc_detector_distance_handle_t *distance_handle,
-                              acc_detector_distance_configuration_t distance_configuration,
-                              bool *distance_detected, float *distance);
+static bool measure_mid_range(bool *distance_detected, float *distance);
 
 
 /**
  * Measure in the far range sector
  *
- * @param distance_handle Distance Detector handle
- * @param distance_configuration Distance Detector configuration
  * @param distance_detected True, if a distance was detected
  * @param distance Detected distance
  * @return True, if measurement was successful
  */
-static bool measure_far_range(acc_detector_distance_handle_t *distance_handle,
-                              acc_detector_distance_configuration_t distance_configuration,
-                              bool *distance_detected, float *distance);
+static bool measure_far_range(bool *distance_detected, float *distance);
+
+
+/**
+ * Measure in one sector
+ *
+ * @param sector The sector to measure in
+ * @param distance_detected True, if a distance was detected
+ * @param distance Detected distance
+ * @return True, if measurement was successful
+ */
+static bool measure_sector(sector_t sector, bool *distance_detected, float *distance);
+
+
+/**
+ * Measure the level, starting in the sector predicted from the level trend
+ *
+ * Falls back to a search of all sectors in order, close range first, if the predicted
+ * sector does not confirm the prediction. The result of the predicted sector is reused
+ * by the search.
+ *
+ * @param schedule The sector schedule, updated with the result
+ * @param distance_detected True, if a distance was detected
+ * @param distance Detected distance
+ * @return True, if measurement was successful
+ */
+static bool measure_level(sector_schedule_t *schedule, bool *distance_detected, float *distance);
+
+
+/**
+ * Predict the level tracker state at a time
+ *
+ * @param tracker The level tracker
+ * @param time_ms The time to predict to
+ */
+static void level_tracker_predict(level_tracker_t *tracker, uint32_t time_ms);
+
+
+/**
+ * Update the level tracker with a detected distance
+ *
+ * @param tracker The level tracker
+ * @param distance The detected distance
+ * @param time_ms The time of the detection
+ * @return True, if the distance was accepted, false if it was rejected as an outlier
+ */
+static bool level_tracker_update(level_tracker_t *tracker, float distance, uint32_t time_ms);
+
+
+/**
+ * Get the confidence of the tracked level
+ *
+ * The confidence is 100 % for a level without uncertainty and 50 % when the uncertainty
+ * equals the measurement noise of a single detection.
+ *
+ * @param tracker The level tracker
+ * @return The confidence in percent
+ */
+static uint8_t level_tracker_confidence(const level_tracker_t *tracker);
+
+
+/**
+ * Log the statistics of a number of readings and restart them
+ *
+ * @param reading_count The number of readings
+ * @param elapsed_ms The time of the readings
+ */
+static void log_statistics(uint32_t reading_count, uint32_t elapsed_ms);
 
 
 int main(int argc, char *argv[]);
@@ -222,68 +486,52 @@ int main(int argc, char *argv[])
 		return EXIT_FAILURE;
 	}
 
-	acc_detector_distance_configuration_t distance_configuration = acc_detector_distance_configuration_create();
-
-	if (distance_configuration == NULL)
+	if (!create_sector_configurations())
 	{
-		ACC_LOG_ERROR("Failed to create detector configuration");
+		ACC_LOG_ERROR("Failed to create detectors");
+		destroy_sectors();
 		acc_rss_deactivate();
 		return EXIT_FAILURE;
 	}
 
-	acc_detector_distance_configuration_sensor_set(distance_configuration, DEFAULT_SENSOR);
+	uint32_t start_ms  = hal->os.gettime();
+	uint32_t cache_key = configuration_hash();
+	bool     status    = start_from_cache(cache_key);
 
-	acc_detector_distance_handle_t distance_handle = acc_detector_distance_create(distance_configuration);
-
-	if (distance_handle == NULL)
+	if (status)
 	{
-		ACC_LOG_ERROR("Failed to create detector");
-		acc_detector_distance_configuration_destroy(&distance_configuration);
-		acc_rss_deactivate();
-		return EXIT_FAILURE;
+		ACC_LOG_INFO("Started from cached calibration in %u ms", (unsigned int)(hal->os.gettime() - start_ms));
 	}
-
-	if (!record_backgrounds(&distance_handle, distance_configuration))
+	else
 	{
-		ACC_LOG_ERROR("Failed to calibrate detector");
-		acc_detector_distance_configuration_destroy(&distance_configuration);
-		acc_detector_distance_destroy(&distance_handle);
-		acc_rss_deactivate();
-		return EXIT_FAILURE;
-	}
+		status = start_from_recording(cache_key);
 
-	// If there is a long time between measurements it is good to calibrate the sensor
-	// before each measurement
-	acc_detector_distance_destroy(&distance_handle);
+		if (status)
+		{
+			ACC_LOG_INFO("Started from new calibration in %u ms", (unsigned int)(hal->os.gettime() - start_ms));
+		}
+	}
 
-	if (!sensor_calibration())
+	if (!status)
 	{
-		ACC_LOG_ERROR("Failed to calibrate sensor");
+		destroy_sectors();
+		acc_rss_deactivate();
 		return EXIT_FAILURE;
 	}
 
-	distance_handle = acc_detector_distance_create(distance_configuration);
+	sector_schedule_t schedule            = { 0 };
+	level_tracker_t   tracker             = { 0 };
+	uint32_t          reading_count       = 0;
+	uint32_t          statistics_start_ms = hal->os.gettime();
 
-	bool status = true;
+	latency_statistics = (latency_statistics_t){ 0 };
 
 	while (status)
 	{
 		float distance          = 0.0f;
 		bool  distance_detected = false;
 
-		ACC_LOG_INFO("Measure close range");
-		status = measure_close_range(&distance_handle, distance_configuration, &distance_detected, &distance);
-		if (status && !distance_detected)
-		{
-			ACC_LOG_INFO("Measure mid range");
-			status = measure_mid_range(&distance_handle, distance_configuration, &distance_detected, &distance);
-		}
-
-		if (status && !distance_detected)
-		{
-			ACC_LOG_INFO("Measure far range");
-			status = measure_far_range(&distance_handle, distance_configuration, &distance_detected, &distance);
-		}
+		status = measure_level(&schedule, &distance_detected, &distance);
 
 		if (!status)
 		{
@@ -291,36 +539,63 @@ int main(int argc, char *argv[])
 			break;
 		}
 
-		if (distance_detected)
+		uint32_t time_ms  = hal->os.gettime();
+		bool     accepted = distance_detected && level_tracker_update(&tracker, distance, time_ms);
+
+		if (!accepted)
 		{
-			ACC_LOG_INFO("Peak at %u mm", (unsigned int)(distance * 1000));
+			level_tracker_predict(&tracker, time_ms);
 		}
-		else
+
+		if (!tracker.has_level)
 		{
 			ACC_LOG_INFO("No peak found");
 		}
+		else
+		{
+			ACC_LOG_INFO("Level at %u mm, rate %d mm/s, confidence %u %%, %s %u mm",
+			             (unsigned int)(tracker.level * 1000.0f + 0.5f),
+			             (int)lroundf(tracker.rate * 1000.0f),
+			             (unsigned int)level_tracker_confidence(&tracker),
+			             accepted ? "peak at" : (distance_detected ? "outlier at" : "no peak, predicted"),
+			             (unsigned int)((distance_detected ? distance : tracker.level) * 1000.0f + 0.5f));
+		}
+
+		if (++reading_count == STATISTICS_READING_COUNT)
+		{
+			log_statistics(reading_count, hal->os.gettime() - statistics_start_ms);
+
+			reading_count       = 0;
+			statistics_start_ms = hal->os.gettime();
+		}
 
 		//Add a call to a sleep function here to limit measurement update rate
 	}
 
-	acc_detector_distance_configuration_destroy(&distance_configuration);
-	acc_detector_distance_destroy(&distance_handle);
+	destroy_sectors();
 	acc_rss_deactivate();
 
 	return status ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 
-bool sensor_calibration(void)
+uint64_t get_time_us(void)
 {
-	acc_calibration_context_t calibration_context;
+	struct timespec time_ts = {0};
 
-	if (!acc_rss_calibration_context_get(DEFAULT_SENSOR, &calibration_context))
+	clock_gettime(CLOCK_MONOTONIC, &time_ts);
+	return (uint64_t)time_ts.tv_sec * 1000000 + (uint64_t)time_ts.tv_nsec / 1000;
+}
+
+
+bool sensor_calibration(acc_calibration_context_t *calibration_context)
+{
+	if (!acc_rss_calibration_context_get(DEFAULT_SENSOR, calibration_context))
 	{
 		return false;
 	}
 
-	if (!acc_rss_calibration_context_forced_set(DEFAULT_SENSOR, &calibration_context))
+	if (!acc_rss_calibration_context_forced_set(DEFAULT_SENSOR, calibration_context))
 	{
 		return false;
 	}
@@ -329,13 +604,44 @@ bool sensor_calibration(void)
 }
 
 
-bool configure_close_range(acc_detector_distance_handle_t        *distance_handle,
-                           acc_detector_distance_configuration_t distance_configuration)
+bool reconfigure(sector_detector_t *detector)
+{
+	uint64_t start_us = get_time_us();
+
+	acc_detector_distance_configuration_receiver_gain_set(detector->configuration, detector->gain);
+
+	bool status = acc_detector_distance_reconfigure(&detector->handle, detector->configuration);
+
+	latency_statistics.reconfigure_count++;
+	latency_statistics.reconfigure_us += get_time_us() - start_us;
+
+	return status;
+}
+
+
+bool set_background(sector_detector_t *detector)
+{
+	if (detector->background == NULL)
+	{
+		return true;
+	}
+
+	uint64_t start_us = get_time_us();
+
+	bool status = acc_detector_distance_set_background(detector->handle, detector->background, detector->background_length);
+
+	latency_statistics.set_background_us += get_time_us() - start_us;
+
+	return status;
+}
+
+
+void configure_close_range(acc_detector_distance_configuration_t distance_configuration, float gain)
 {
 	acc_detector_distance_configuration_mur_set(distance_configuration, DEFAULT_CLOSE_RANGE_MUR);
 	acc_detector_distance_configuration_requested_start_set(distance_configuration, DEFAULT_CLOSE_RANGE_START);
 	acc_detector_distance_configuration_requested_length_set(distance_configuration, DEFAULT_CLOSE_RANGE_LENGTH);
-	acc_detector_distance_configuration_receiver_gain_set(distance_configuration, close_range_gain);
+	acc_detector_distance_configuration_receiver_gain_set(distance_configuration, gain);
 	acc_detector_distance_configuration_maximize_signal_attenuation_set(distance_configuration,
 	                                                                    DEFAULT_CLOSE_MAXIMIZE_SIGNAL_ATTENUATION);
 	acc_detector_distance_configuration_service_profile_set(distance_configuration,
@@ -350,18 +656,15 @@ bool configure_close_range(acc_detector_distance_handle_t        *distance_handl
 	                                                                 DEFAULT_CLOSE_RANGE_RECORD_BACKGROUND_SWEEPS);
 	acc_detector_distance_configuration_threshold_sensitivity_set(distance_configuration,
 	                                                              DEFAULT_CLOSE_RANGE_THRESHOLD_SENSITIVITY);
-
-	return acc_detector_distance_reconfigure(distance_handle, distance_configuration);
 }
 
 
-bool configure_mid_range(acc_detector_distance_handle_t        *distance_handle,
-                         acc_detector_distance_configuration_t distance_configuration)
+void configure_mid_range(acc_detector_distance_configuration_t distance_configuration, float gain)
 {
 	acc_detector_distance_configuration_mur_set(distance_configuration, DEFAULT_MID_RANGE_MUR);
 	acc_detector_distance_configuration_requested_start_set(distance_configuration, DEFAULT_MID_RANGE_START);
 	acc_detector_distance_configuration_requested_length_set(distance_configuration, DEFAULT_MID_RANGE_LENGTH);
-	acc_detector_distance_configuration_receiver_gain_set(distance_configuration, mid_range_gain);
+	acc_detector_distance_configuration_receiver_gain_set(distance_configuration, gain);
 	acc_detector_distance_configuration_maximize_signal_attenuation_set(distance_configuration,
 	                                                                    DEFAULT_MID_MAXIMIZE_SIGNAL_ATTENUATION);
 	acc_detector_distance_configuration_service_profile_set(distance_configuration,
@@ -376,18 +679,15 @@ bool configure_mid_range(acc_detector_distance_handle_t        *distance_handle,
 	                                                                 DEFAULT_MID_RANGE_RECORD_BACKGROUND_SWEEPS);
 	acc_detector_distance_configuration_threshold_sensitivity_set(distance_configuration,
 	                                                              DEFAULT_MID_RANGE_THRESHOLD_SENSITIVITY);
-
-	return acc_detector_distance_reconfigure(distance_handle, distance_configuration);
 }
 
 
-bool configure_far_range(acc_detector_distance_handle_t        *distance_handle,
-                         acc_detector_distance_configuration_t distance_configuration)
+void configure_far_range(acc_detector_distance_configuration_t distance_configuration, float gain)
 {
 	acc_detector_distance_configuration_mur_set(distance_configuration, DEFAULT_FAR_RANGE_MUR);
 	acc_detector_distance_configuration_requested_start_set(distance_configuration, DEFAULT_FAR_RANGE_START);
 	acc_detector_distance_configuration_requested_length_set(distance_configuration, DEFAULT_FAR_RANGE_LENGTH);
-	acc_detector_distance_configuration_receiver_gain_set(distance_configuration, DEFAULT_FAR_RANGE_GAIN);
+	acc_detector_distance_configuration_receiver_gain_set(distance_configuration, gain);
 	acc_detector_distance_configuration_maximize_signal_attenuation_set(distance_configuration,
 	                                                                    DEFAULT_FAR_MAXIMIZE_SIGNAL_ATTENUATION);
 	acc_detector_distance_configuration_service_profile_set(distance_configuration,
@@ -404,143 +704,395 @@ bool configure_far_range(acc_detector_distance_handle_t        *distance_handle,
 	                                                             DEFAULT_FAR_RANGE_CFAR_THRESHOLD_GUARD);
 	acc_detector_distance_configuration_cfar_threshold_window_set(distance_configuration,
 	                                                              DEFAULT_FAR_RANGE_CFAR_THRESHOLD_WINDOW);
-
-	return acc_detector_distance_reconfigure(distance_handle, distance_configuration);
 }
 
 
-bool record_background(acc_detector_distance_handle_t *distance_handle,
-                       acc_detector_distance_configuration_t distance_configuration,
-                       float *range_gain, uint16_t *background, uint16_t background_length)
+bool create_sector_configurations(void)
 {
-	acc_detector_distance_recorded_background_info_t recorded_background_info;
-	bool                                             status                  = true;
-	bool                                             previous_gain_saturated = true;
+	for (sector_t sector = SECTOR_CLOSE; sector < SECTOR_COUNT; sector++)
+	{
+		sector_detector_t *detector = &sector_detectors[sector];
 
-	float gain = acc_detector_distance_configuration_receiver_gain_get(distance_configuration);
+		detector->gain          = detector->default_gain;
+		detector->configuration = acc_detector_distance_configuration_create();
+
+		if (detector->configuration == NULL)
+		{
+			return false;
+		}
+
+		acc_detector_distance_configuration_sensor_set(detector->configuration, DEFAULT_SENSOR);
+
+		switch (sector)
+		{
+			case SECTOR_CLOSE:
+				configure_close_range(detector->configuration, detector->gain);
+				break;
+			case SECTOR_MID:
+				configure_mid_range(detector->configuration, detector->gain);
+				break;
+			default:
+				configure_far_range(detector->configuration, detector->gain);
+				break;
+		}
+	}
+
+	return true;
+}
 
-	recorded_background_info.data_saturated = true;
 
-	while (status && gain > 0)
+bool create_sector_detectors(void)
+{
+	for (sector_t sector = SECTOR_CLOSE; sector < SECTOR_COUNT; sector++)
 	{
-		acc_detector_distance_configuration_receiver_gain_set(distance_configuration, gain);
+		sector_detector_t *detector = &sector_detectors[sector];
 
-		status = acc_detector_distance_reconfigure(distance_handle, distance_configuration);
+		acc_detector_distance_configuration_receiver_gain_set(detector->configuration, detector->gain);
 
-		if (status)
+		detector->handle = acc_detector_distance_create(detector->configuration);
+
+		if (detector->handle == NULL)
 		{
-			status = acc_detector_distance_record_background(*distance_handle, background, background_length,
-			                                                 &recorded_background_info);
+			return false;
+		}
 
-			if (!status || (!previous_gain_saturated && !recorded_background_info.data_saturated))
-			{
-				break;
-			}
+		// Backgrounds are not recorded yet the first time the detectors are created
+		if (detector->background_length > 0 && !set_background(detector))
+		{
+			return false;
+		}
+	}
 
-			previous_gain_saturated = recorded_background_info.data_saturated;
+	return true;
+}
 
-			gain = gain - GAIN_STEP;
+
+void destroy_sector_detectors(void)
+{
+	for (sector_t sector = SECTOR_CLOSE; sector < SECTOR_COUNT; sector++)
+	{
+		if (sector_detectors[sector].handle != NULL)
+		{
+			acc_detector_distance_destroy(&sector_detectors[sector].handle);
 		}
 	}
+}
+
+
+void destroy_sectors(void)
+{
+	destroy_sector_detectors();
+
+	for (sector_t sector = SECTOR_CLOSE; sector < SECTOR_COUNT; sector++)
+	{
+		if (sector_detectors[sector].configuration != NULL)
+		{
+			acc_detector_distance_configuration_destroy(&sector_detectors[sector].configuration);
+		}
+	}
+}
+
+
+bool record_background_at_gain(float gain, void *user_data, bool *saturated)
+{
+	acc_detector_distance_recorded_background_info_t recorded_background_info;
+	sector_detector_t                                *detector = user_data;
+
+	detector->gain = gain;
+
+	if (!reconfigure(detector))
+	{
+		return false;
+	}
+
+	if (!acc_detector_distance_record_background(detector->handle, detector->background,
+	                                             detector->background_length, &recorded_background_info))
+	{
+		ACC_LOG_ERROR("Failed to record background");
+		return false;
+	}
+
+	*saturated = recorded_background_info.data_saturated;
+
+	return true;
+}
+
+
+bool record_background(sector_detector_t *detector)
+{
+	acc_integration_gain_search_result_t search_result;
 
-	if (status && recorded_background_info.data_saturated)
+	if (!acc_integration_gain_search(detector->gain, BACKGROUND_GAIN_MARGIN_STEPS, record_background_at_gain, detector,
+	                                 &search_result))
 	{
 		ACC_LOG_ERROR("Unable to record background without data saturation");
-		status = false;
+		return false;
 	}
 
-	*range_gain = gain;
+	detector->gain = search_result.gain;
 
-	return status;
+	ACC_LOG_INFO("Recorded %s range background with gain %u/%u in %u recordings, %u ms", detector->name,
+	             (unsigned int)(detector->gain * ACC_INTEGRATION_GAIN_STEP_COUNT + 0.5f),
+	             (unsigned int)ACC_INTEGRATION_GAIN_STEP_COUNT,
+	             (unsigned int)search_result.recording_count, (unsigned int)search_result.time_ms);
+
+	return true;
 }
 
 
-bool record_backgrounds(acc_detector_distance_handle_t        *distance_handle,
-                        acc_detector_distance_configuration_t distance_configuration)
+bool record_backgrounds(void)
 {
 	acc_detector_distance_metadata_t metadata;
 
-	if (!configure_close_range(distance_handle, distance_configuration))
+	for (sector_t sector = SECTOR_CLOSE; sector < SECTOR_COUNT; sector++)
 	{
+		sector_detector_t *detector = &sector_detectors[sector];
+
+		if (detector->background == NULL)
+		{
+			continue;
+		}
+
+		if (!acc_detector_distance_metadata_get(detector->handle, &metadata))
+		{
+			return false;
+		}
+
+		detector->background_length = metadata.background_length;
+		ACC_LOG_INFO("Record %s range", detector->name);
+
+		if (!record_background(detector))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+uint32_t configuration_hash(void)
+{
+	const char *version = acc_version_get();
+	uint32_t   format   = CACHE_FORMAT_VERSION;
+	uint32_t   hash     = acc_cache_file_hash(ACC_CACHE_FILE_HASH_INIT, &format, sizeof(format));
+
+	hash = acc_cache_file_hash(hash, version, strlen(version));
+
+	for (sector_t sector = SECTOR_CLOSE; sector < SECTOR_COUNT; sector++)
+	{
+		acc_detector_distance_configuration_t configuration = sector_detectors[sector].configuration;
+
+		const float float_parameters[] =
+		{
+			acc_detector_distance_configuration_requested_start_get(configuration),
+			acc_detector_distance_configuration_requested_length_get(configuration),
+			acc_detector_distance_configuration_receiver_gain_get(configuration),
+			acc_detector_distance_configuration_threshold_sensitivity_get(configuration),
+			acc_detector_distance_configuration_cfar_threshold_guard_get(configuration),
+			acc_detector_distance_configuration_cfar_threshold_window_get(configuration),
+		};
+		const uint32_t integer_parameters[] =
+		{
+			(uint32_t)acc_detector_distance_configuration_sensor_get(configuration),
+			(uint32_t)acc_detector_distance_configuration_mur_get(configuration),
+			(uint32_t)acc_detector_distance_configuration_service_profile_get(configuration),
+			(uint32_t)acc_detector_distance_configuration_downsampling_factor_get(configuration),
+			(uint32_t)acc_detector_distance_configuration_hw_accelerated_average_samples_get(configuration),
+			(uint32_t)acc_detector_distance_configuration_sweep_averaging_get(configuration),
+			(uint32_t)acc_detector_distance_configuration_threshold_type_get(configuration),
+			(uint32_t)acc_detector_distance_configuration_record_background_sweeps_get(configuration),
+			(uint32_t)acc_detector_distance_configuration_maximize_signal_attenuation_get(configuration),
+		};
+
+		hash = acc_cache_file_hash(hash, float_parameters, sizeof(float_parameters));
+		hash = acc_cache_file_hash(hash, integer_parameters, sizeof(integer_parameters));
+	}
+
+	return hash;
+}
+
+
+bool start_from_cache(uint32_t cache_key)
+{
+	if (!acc_cache_file_read(CACHE_FILE_PATH, cache_key, &calibration_cache, sizeof(calibration_cache)))
+	{
+		ACC_LOG_INFO("No calibration cache for this configuration");
 		return false;
 	}
 
-	if (!acc_detector_distance_metadata_get(*distance_handle, &metadata))
+	if (!acc_rss_calibration_context_set(DEFAULT_SENSOR, &calibration_cache.calibration_context))
 	{
+		ACC_LOG_INFO("Cached sensor calibration is no longer valid");
 		return false;
 	}
 
-	close_background_length = metadata.background_length;
-	ACC_LOG_INFO("Record close range");
+	bool status = true;
 
-	if (!record_background(distance_handle, distance_configuration, &close_range_gain,
-	                       close_background, close_background_length))
+	for (sector_t sector = SECTOR_CLOSE; status && sector < SECTOR_COUNT; sector++)
 	{
-		return false;
+		sector_detector_t *detector = &sector_detectors[sector];
+
+		detector->gain = calibration_cache.gain[sector];
+
+		if (detector->background != NULL)
+		{
+			detector->background_length = calibration_cache.background_length[sector];
+			status                      = detector->background_length <= MAX_BACKGROUND_LENGTH;
+
+			if (status)
+			{
+				memcpy(detector->background, calibration_cache.background[sector],
+				       detector->background_length * sizeof(uint16_t));
+			}
+		}
 	}
 
-	if (!configure_mid_range(distance_handle, distance_configuration))
+	status = status && create_sector_detectors();
+
+	for (sector_t sector = SECTOR_CLOSE; status && sector < SECTOR_COUNT; sector++)
 	{
+		if (sector_detectors[sector].background != NULL)
+		{
+			status = validate_background(&sector_detectors[sector]);
+		}
+	}
+
+	if (!status)
+	{
+		ACC_LOG_INFO("Cached backgrounds are no longer valid");
+		destroy_sector_detectors();
+	}
+
+	return status;
+}
+
+
+bool start_from_recording(uint32_t cache_key)
+{
+	for (sector_t sector = SECTOR_CLOSE; sector < SECTOR_COUNT; sector++)
+	{
+		sector_detectors[sector].gain              = sector_detectors[sector].default_gain;
+		sector_detectors[sector].background_length = 0;
+	}
+
+	if (!create_sector_detectors())
+	{
+		ACC_LOG_ERROR("Failed to create detectors");
 		return false;
 	}
 
-	if (!acc_detector_distance_metadata_get(*distance_handle, &metadata))
+	if (!record_backgrounds())
 	{
+		ACC_LOG_ERROR("Failed to calibrate detector");
 		return false;
 	}
 
-	mid_background_length = metadata.background_length;
-	ACC_LOG_INFO("Record mid range");
+	// If there is a long time between measurements it is good to calibrate the sensor
+	// before each measurement
+	destroy_sector_detectors();
+
+	if (!sensor_calibration(&calibration_cache.calibration_context))
+	{
+		ACC_LOG_ERROR("Failed to calibrate sensor");
+		return false;
+	}
 
-	if (!record_background(distance_handle, distance_configuration, &mid_range_gain,
-	                       mid_background, mid_background_length))
+	if (!create_sector_detectors())
 	{
+		ACC_LOG_ERROR("Failed to create detectors");
 		return false;
 	}
 
+	for (sector_t sector = SECTOR_CLOSE; sector < SECTOR_COUNT; sector++)
+	{
+		sector_detector_t *detector = &sector_detectors[sector];
+
+		calibration_cache.gain[sector]              = detector->gain;
+		calibration_cache.background_length[sector] = detector->background_length;
+
+		if (detector->background != NULL)
+		{
+			memcpy(calibration_cache.background[sector], detector->background,
+			       detector->background_length * sizeof(uint16_t));
+		}
+	}
+
+	// Failing to write the cache only means that the next start records the backgrounds again
+	if (!acc_cache_file_write(CACHE_FILE_PATH, cache_key, &calibration_cache, sizeof(calibration_cache)))
+	{
+		ACC_LOG_WARNING("Failed to write calibration cache %s", CACHE_FILE_PATH);
+	}
+
 	return true;
 }
 
 
-bool measurement(acc_detector_distance_handle_t        *distance_handle,
-                 acc_detector_distance_configuration_t distance_configuration,
-                 acc_detector_distance_result_t        *result,
-                 acc_detector_distance_result_info_t   *result_info)
+bool validate_background(sector_detector_t *detector)
 {
-	float gain = acc_detector_distance_configuration_receiver_gain_get(distance_configuration);
+	acc_detector_distance_result_t      result;
+	acc_detector_distance_result_info_t result_info;
+
+	if (!acc_detector_distance_activate(detector->handle))
+	{
+		return false;
+	}
 
+	bool status = acc_detector_distance_get_next(detector->handle, &result, 1, &result_info);
+
+	if (!acc_detector_distance_deactivate(detector->handle))
+	{
+		status = false;
+	}
+
+	return status && !result_info.data_saturated && !result_info.data_quality_warning;
+}
+
+
+bool measurement(sector_detector_t                   *detector,
+                 acc_detector_distance_result_t      *result,
+                 acc_detector_distance_result_info_t *result_info)
+{
 	result_info->data_saturated = true;
 
-	while (gain > 0)
+	while (detector->gain > 0)
 	{
-		if (!acc_detector_distance_activate(*distance_handle))
+		uint64_t start_us = get_time_us();
+
+		if (!acc_detector_distance_activate(detector->handle))
 		{
 			ACC_LOG_ERROR("Failed to activate detector");
 			return false;
 		}
 
-		if (!acc_detector_distance_get_next(*distance_handle, result, 1, result_info))
+		uint64_t activated_us = get_time_us();
+
+		if (!acc_detector_distance_get_next(detector->handle, result, 1, result_info))
 		{
 			ACC_LOG_ERROR("Failed to get next from detector");
 			return false;
 		}
 
-		if (!acc_detector_distance_deactivate(*distance_handle))
+		uint64_t measured_us = get_time_us();
+
+		if (!acc_detector_distance_deactivate(detector->handle))
 		{
 			ACC_LOG_ERROR("Failed to deactivate detector");
 			return false;
 		}
 
-		if (!result_info->data_saturated || gain < GAIN_STEP)
+		latency_statistics.activate_us   += activated_us - start_us;
+		latency_statistics.get_next_us   += measured_us - activated_us;
+		latency_statistics.deactivate_us += get_time_us() - measured_us;
+
+		if (!result_info->data_saturated || detector->gain < GAIN_STEP)
 		{
 			break;
 		}
 
-		gain = gain - GAIN_STEP;
+		detector->gain = detector->gain - GAIN_STEP;
 
-		acc_detector_distance_configuration_receiver_gain_set(distance_configuration, gain);
-
-		if (!acc_detector_distance_reconfigure(distance_handle, distance_configuration))
+		if (!reconfigure(detector) || !set_background(detector))
 		{
 			return false;
 		}
@@ -556,25 +1108,13 @@ bool measurement(acc_detector_distance_handle_t        *distance_handle,
 }
 
 
-bool measure_close_range(acc_detector_distance_handle_t *distance_handle,
-                         acc_detector_distance_configuration_t distance_configuration,
-                         bool *distance_detected, float *distance)
+bool measure_close_range(bool *distance_detected, float *distance)
 {
 	*distance_detected = false;
 	acc_detector_distance_result_info_t result_info;
 	acc_detector_distance_result_t      result;
 
-	if (!configure_close_range(distance_handle, distance_configuration))
-	{
-		return false;
-	}
-
-	if (!acc_detector_distance_set_background(*distance_handle, close_background, close_background_length))
-	{
-		return false;
-	}
-
-	if (!measurement(distance_handle, distance_configuration, &result, &result_info))
+	if (!measurement(&sector_detectors[SECTOR_CLOSE], &result, &result_info))
 	{
 		return false;
 	}
@@ -589,25 +1129,34 @@ bool measure_close_range(acc_detector_distance_handle_t *distance_handle,
 }
 
 
-bool measure_mid_range(acc_detector_distance_handle_t *distance_handle,
-                       acc_detector_distance_configuration_t distance_configuration,
-                       bool *distance_detected, float *distance)
+bool measure_mid_range(bool *distance_detected, float *distance)
 {
 	*distance_detected = false;
 	acc_detector_distance_result_info_t result_info;
 	acc_detector_distance_result_t      result;
 
-	if (!configure_mid_range(distance_handle, distance_configuration))
+	if (!measurement(&sector_detectors[SECTOR_MID], &result, &result_info))
 	{
 		return false;
 	}
 
-	if (!acc_detector_distance_set_background(*distance_handle, mid_background, mid_background_length))
+	if (result_info.number_of_peaks > 0)
 	{
-		return false;
+		*distance_detected = true;
+		*distance          = result.distance_m;
 	}
 
-	if (!measurement(distance_handle, distance_configuration, &result, &result_info))
+	return true;
+}
+
+
+bool measure_far_range(bool *distance_detected, float *distance)
+{
+	*distance_detected = false;
+	acc_detector_distance_result_info_t result_info;
+	acc_detector_distance_result_t      result;
+
+	if (!measurement(&sector_detectors[SECTOR_FAR], &result, &result_info))
 	{
 		return false;
 	}
@@ -622,29 +1171,186 @@ bool measure_mid_range(acc_detector_distance_handle_t *distance_handle,
 }
 
 
-bool measure_far_range(acc_detector_distance_handle_t *distance_handle,
-                       acc_detector_distance_configuration_t distance_configuration,
-                       bool *distance_detected, float *distance)
+bool measure_sector(sector_t sector, bool *distance_detected, float *distance)
+{
+	switch (sector)
+	{
+		case SECTOR_CLOSE:
+			ACC_LOG_INFO("Measure close range");
+			return measure_close_range(distance_detected, distance);
+		case SECTOR_MID:
+			ACC_LOG_INFO("Measure mid range");
+			return measure_mid_range(distance_detected, distance);
+		case SECTOR_FAR:
+			ACC_LOG_INFO("Measure far range");
+			return measure_far_range(distance_detected, distance);
+		default:
+			return false;
+	}
+}
+
+
+bool measure_level(sector_schedule_t *schedule, bool *distance_detected, float *distance)
 {
+	bool     measured[SECTOR_COUNT] = { false };
+	bool     detected[SECTOR_COUNT] = { false };
+	float    distances[SECTOR_COUNT];
+	sector_t sector                 = SECTOR_COUNT;
+
 	*distance_detected = false;
-	acc_detector_distance_result_info_t result_info;
-	acc_detector_distance_result_t      result;
 
-	if (!configure_far_range(distance_handle, distance_configuration))
+	if (ADAPTIVE_SECTOR_ORDER && schedule->has_level)
 	{
-		return false;
+		float    predicted        = schedule->distance + schedule->rate;
+		sector_t predicted_sector = SECTOR_FAR;
+
+		// A sector owns the distances up to where the next sector starts being used
+		if (predicted < DEFAULT_CLOSE_RANGE_START + DEFAULT_CLOSE_RANGE_LENGTH)
+		{
+			predicted_sector = SECTOR_CLOSE;
+		}
+		else if (predicted < DEFAULT_MID_RANGE_START + DEFAULT_MID_RANGE_LENGTH)
+		{
+			predicted_sector = SECTOR_MID;
+		}
+
+		if (!measure_sector(predicted_sector, &detected[predicted_sector], &distances[predicted_sector]))
+		{
+			return false;
+		}
+
+		measured[predicted_sector] = true;
+
+		// Closer sectors are assumed empty when the level follows the trend, the close sector has no closer sectors
+		if (detected[predicted_sector] &&
+		    (predicted_sector == SECTOR_CLOSE ||
+		     (distances[predicted_sector] > predicted - SECTOR_PREDICTION_GATE &&
+		      distances[predicted_sector] < predicted + SECTOR_PREDICTION_GATE)))
+		{
+			sector = predicted_sector;
+		}
 	}
 
-	if (!measurement(distance_handle, distance_configuration, &result, &result_info))
+	// Full search, close range first
+	for (sector_t i = SECTOR_CLOSE; sector == SECTOR_COUNT && i < SECTOR_COUNT; i++)
+	{
+		if (!measured[i] && !measure_sector(i, &detected[i], &distances[i]))
+		{
+			return false;
+		}
+
+		if (detected[i])
+		{
+			sector = i;
+		}
+	}
+
+	if (sector == SECTOR_COUNT)
+	{
+		schedule->has_level = false;
+		return true;
+	}
+
+	*distance_detected = true;
+	*distance          = distances[sector];
+
+	schedule->rate      = schedule->has_level ? (schedule->rate + (*distance - schedule->distance)) / 2.0f : 0.0f;
+	schedule->has_level = true;
+	schedule->distance  = *distance;
+
+	return true;
+}
+
+
+void level_tracker_predict(level_tracker_t *tracker, uint32_t time_ms)
+{
+	if (!tracker->has_level)
+	{
+		return;
+	}
+
+	float dt = (float)(time_ms - tracker->time_ms) / 1000.0f;
+	float q  = LEVEL_PROCESS_NOISE_M_S2 * LEVEL_PROCESS_NOISE_M_S2;
+
+	tracker->level  += tracker->rate * dt;
+	tracker->time_ms = time_ms;
+
+	// P = F P F' + Q for a constant rate model with white acceleration noise
+	tracker->level_variance += dt * (2.0f * tracker->covariance + dt * tracker->rate_variance) + q * dt * dt * dt * dt / 4.0f;
+	tracker->covariance     += dt * tracker->rate_variance + q * dt * dt * dt / 2.0f;
+	tracker->rate_variance  += q * dt * dt;
+}
+
+
+bool level_tracker_update(level_tracker_t *tracker, float distance, uint32_t time_ms)
+{
+	float r = LEVEL_MEASUREMENT_NOISE_M * LEVEL_MEASUREMENT_NOISE_M;
+
+	level_tracker_predict(tracker, time_ms);
+
+	float innovation = distance - tracker->level;
+	float s          = tracker->level_variance + r;
+
+	if (tracker->has_level && innovation * innovation > LEVEL_GATE_SIGMA * LEVEL_GATE_SIGMA * s &&
+	    ++tracker->consecutive_rejected <= LEVEL_MAX_CONSECUTIVE_REJECTED)
 	{
 		return false;
 	}
 
-	if (result_info.number_of_peaks > 0)
+	if (!tracker->has_level || tracker->consecutive_rejected > LEVEL_MAX_CONSECUTIVE_REJECTED)
 	{
-		*distance_detected = true;
-		*distance          = result.distance_m;
+		tracker->has_level = true;
+		tracker->level     = distance;
+		tracker->rate      = 0.0f;
+		tracker->time_ms   = time_ms;
+
+		tracker->level_variance       = r;
+		tracker->rate_variance        = LEVEL_INITIAL_RATE_NOISE_M_S * LEVEL_INITIAL_RATE_NOISE_M_S;
+		tracker->covariance           = 0.0f;
+		tracker->consecutive_rejected = 0;
+		return true;
 	}
 
+	float k_level = tracker->level_variance / s;
+	float k_rate  = tracker->covariance / s;
+
+	tracker->level += k_level * innovation;
+	tracker->rate  += k_rate * innovation;
+
+	tracker->rate_variance  -= k_rate * tracker->covariance;
+	tracker->level_variance *= 1.0f - k_level;
+	tracker->covariance     *= 1.0f - k_level;
+
+	tracker->consecutive_rejected = 0;
+
 	return true;
 }
+
+
+uint8_t level_tracker_confidence(const level_tracker_t *tracker)
+{
+	float deviation = sqrtf(tracker->level_variance);
+
+	return (uint8_t)(100.0f * LEVEL_MEASUREMENT_NOISE_M / (LEVEL_MEASUREMENT_NOISE_M + deviation) + 0.5f);
+}
+
+
+void log_statistics(uint32_t reading_count, uint32_t elapsed_ms)
+{
+	latency_statistics_t *statistics = &latency_statistics;
+
+	ACC_LOG_INFO("%u readings: %u.%02u reconfigures per reading, %u.%02u readings/s",
+	             (unsigned int)reading_count,
+	             (unsigned int)(statistics->reconfigure_count / reading_count),
+	             (unsigned int)((statistics->reconfigure_count % reading_count) * 100 / reading_count),
+	             (unsigned int)(elapsed_ms > 0 ? reading_count * 1000 / elapsed_ms : 0),
+	             (unsigned int)(elapsed_ms > 0 ? (reading_count * 100000 / elapsed_ms) % 100 : 0));
+	ACC_LOG_INFO("us per reading: reconfigure %u, set background %u, activate %u, get next %u, deactivate %u",
+	             (unsigned int)(statistics->reconfigure_us / reading_count),
+	             (unsigned int)(statistics->set_background_us / reading_count),
+	             (unsigned int)(statistics->activate_us / reading_count),
+	             (unsigned int)(statistics->get_next_us / reading_count),
+	             (unsigned int)(statistics->deactivate_us / reading_count));
+
+	*statistics = (latency_statistics_t){ 0 };
+}
@@ -0,0 +1,241 @@
+// Copyright (c) Acconeer AB, 2023
+// All rights reserved
+// This file is subject to the terms and conditions defined in the file
+// 'LICENSES/license_acconeer.txt', (BSD 3-Clause License) which is part
+// of this source code package.
+
+#include <inttypes.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "acc_hal_definitions.h"
+#include "acc_hal_integration.h"
+#include "acc_latency_histogram.h"
+#include "acc_rss.h"
+#include "acc_service.h"
+#include "acc_service_envelope.h"
+#include "acc_vehicle_pass.h"
+#include "acc_version.h"
+
+
+// Default values for this reference application
+// ---------------------------------------------
+
+// Service configuration settings, frames are fetched as fast as the sensor gives them
+#define SENSOR_ID              1
+#define RANGE_START_M          1.0f
+#define RANGE_LENGTH_M         4.0f
+#define SERVICE_PROFILE        ACC_SERVICE_PROFILE_2
+#define SERVICE_DOWNSAMPLING   4
+#define RUNNING_AVERAGE_FACTOR 0.0f
+
+// The per bin background follows the envelope with a time constant of 2^BACKGROUND_SHIFT frames
+// while no vehicle is present. Bins more than BACKGROUND_FREEZE_Z standard deviations from
+// the background are not learnt, so that a slowly approaching vehicle does not raise the
+// variance of its bins. The standard deviation is at least BACKGROUND_MIN_STD
+#define BACKGROUND_SHIFT    10
+#define BACKGROUND_FREEZE_Z 3.0f
+#define BACKGROUND_MIN_STD  1.0f
+
+// Hysteresis on the highest z-score of a bin. The highest of many noise bins is several
+// standard deviations, so the exit threshold must be well above that
+#define ENTER_THRESHOLD 10.0f
+#define EXIT_THRESHOLD  5.0f
+#define ENTER_FRAMES    20
+#define EXIT_FRAMES     200
+
+// A vehicle present for longer than this has parked and becomes part of the background
+#define MAX_PASS_MS 60000
+
+// Print the frame rate and the CPU time per frame this often
+#define REPORT_PERIOD_MS 10000
+
+
+static volatile sig_atomic_t interrupted = 0;
+
+
+static acc_vehicle_pass_counter_t counter;
+
+
+static void interrupt_handler(int signum);
+
+
+static void configure_service(acc_service_configuration_t configuration);
+
+
+static uint64_t get_cpu_time_ns(void);
+
+
+int main(int argc, char *argv[]);
+
+
+int main(int argc, char *argv[])
+{
+	(void)argc;
+	(void)argv;
+	printf("Acconeer software version %s\n", acc_version_get());
+
+	const acc_hal_t *hal = acc_hal_integration_get_implementation();
+
+	if (!acc_rss_activate(hal))
+	{
+		printf("Failed to activate RSS\n");
+		return EXIT_FAILURE;
+	}
+
+	acc_service_configuration_t configuration = acc_service_envelope_configuration_create();
+
+	if (configuration == NULL)
+	{
+		printf("Failed to create service configuration\n");
+		acc_rss_deactivate();
+		return EXIT_FAILURE;
+	}
+
+	configure_service(configuration);
+
+	acc_service_handle_t handle = acc_service_create(configuration);
+
+	acc_service_envelope_configuration_destroy(&configuration);
+
+	if (handle == NULL)
+	{
+		printf("Failed to create service handle\n");
+		acc_rss_deactivate();
+		return EXIT_FAILURE;
+	}
+
+	acc_service_envelope_metadata_t metadata;
+	acc_service_envelope_get_metadata(handle, &metadata);
+
+	acc_vehicle_pass_parameters_t parameters = {
+		.start_m          = metadata.start_m,
+		.step_length_m    = metadata.step_length_m,
+		.background       = {
+			.shift             = BACKGROUND_SHIFT,
+			.freeze_z          = BACKGROUND_FREEZE_Z,
+			.max_freeze_frames = 0,
+			.min_std           = BACKGROUND_MIN_STD,
+		},
+		.enter_threshold  = ENTER_THRESHOLD,
+		.exit_threshold   = EXIT_THRESHOLD,
+		.enter_frames     = ENTER_FRAMES,
+		.exit_frames      = EXIT_FRAMES,
+		.max_pass_ms      = MAX_PASS_MS,
+	};
+
+	bool status    = acc_vehicle_pass_counter_init(&counter, &parameters, metadata.data_length);
+	bool activated = false;
+
+	if (!status)
+	{
+		printf("Parameters are not valid\n");
+	}
+	else
+	{
+		status    = acc_service_activate(handle);
+		activated = status;
+	}
+
+	signal(SIGINT, interrupt_handler);
+
+	uint16_t                           *data = NULL;
+	acc_service_envelope_result_info_t result_info;
+	acc_latency_histogram_t            histogram;
+	uint64_t                           cpu_sum_ns   = 0;
+	uint32_t                           frame_count  = 0;
+	uint32_t                           missed_count = 0;
+	uint32_t                           report_ms    = hal->os.gettime();
+
+	acc_latency_histogram_reset(&histogram);
+
+	while (status && interrupted == 0)
+	{
+		status = acc_service_envelope_get_next_by_reference(handle, &data, &result_info);
+
+		if (!status || result_info.sensor_communication_error)
+		{
+			printf("Envelope data not properly retrieved\n");
+			status = false;
+			break;
+		}
+
+		uint32_t           time_ms  = hal->os.gettime();
+		uint64_t           start_ns = get_cpu_time_ns();
+		acc_vehicle_pass_t pass;
+		bool               ended    = acc_vehicle_pass_counter_update(&counter, data, time_ms, &pass);
+		uint64_t           cpu_ns   = get_cpu_time_ns() - start_ns;
+
+		acc_latency_histogram_record(&histogram, (uint32_t)((cpu_ns + 999) / 1000));
+		cpu_sum_ns   += cpu_ns;
+		missed_count += result_info.missed_data ? 1 : 0;
+		frame_count++;
+
+		if (ended)
+		{
+			printf("Pass %" PRIu32 ": %" PRIu32 " ms, closest %d mm, amplitude %d%s\n",
+			       acc_vehicle_pass_counter_get_count(&counter), pass.duration_ms, (int)(pass.closest_m * 1000.0f),
+			       (int)pass.peak_amplitude, pass.timed_out ? ", parked" : "");
+		}
+
+		if (time_ms - report_ms >= REPORT_PERIOD_MS)
+		{
+			printf("%" PRIu32 " frames in %" PRIu32 " ms, %" PRIu32 " missed, %" PRIu32 " passes, CPU per frame %" PRIu64
+			       " ns mean, %" PRIu32 " us p99, %" PRIu32 " us max\n",
+			       frame_count, time_ms - report_ms, missed_count, acc_vehicle_pass_counter_get_count(&counter),
+			       cpu_sum_ns / frame_count, acc_latency_histogram_percentile(&histogram, 99.0f), histogram.max_us);
+
+			acc_latency_histogram_reset(&histogram);
+			cpu_sum_ns   = 0;
+			frame_count  = 0;
+			missed_count = 0;
+			report_ms    = time_ms;
+		}
+	}
+
+	printf("%" PRIu32 " passes\n", acc_vehicle_pass_counter_get_count(&counter));
+
+	if (activated)
+	{
+		acc_service_deactivate(handle);
+	}
+
+	acc_service_destroy(&handle);
+	acc_rss_deactivate();
+
+	return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+void interrupt_handler(int signum)
+{
+	if (signum == SIGINT)
+	{
+		interrupted = 1;
+	}
+}
+
+
+void configure_service(acc_service_configuration_t configuration)
+{
+	acc_service_sensor_set(configuration, SENSOR_ID);
+	acc_service_requested_start_set(configuration, RANGE_START_M);
+	acc_service_requested_length_set(configuration, RANGE_LENGTH_M);
+	acc_service_profile_set(configuration, SERVICE_PROFILE);
+	acc_service_envelope_downsampling_factor_set(configuration, SERVICE_DOWNSAMPLING);
+	acc_service_envelope_running_average_factor_set(configuration, RUNNING_AVERAGE_FACTOR);
+}
+
+
+uint64_t get_cpu_time_ns(void)
+{
+	struct timespec time;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+
+	return (uint64_t)time.tv_sec * 1000000000 + (uint64_t)time.tv_nsec;
+}
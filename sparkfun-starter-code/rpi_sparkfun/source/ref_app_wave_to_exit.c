@@ -13,7 +13,7 @@
 #include "acc_detector_presence.h"
 #include "acc_hal_definitions.h"
 #include "acc_hal_integration.h"
-#include "acc_integration.h"
+#include "acc_integration_pacer.h"
 #include "acc_rss.h"
 #include "acc_service.h"
 #include "acc_version.h"
@@ -47,6 +47,9 @@
 // Cool down time in ticks, derived from cooldown time and update rate.
 #define COOL_DOWN_TIME_TICKS ((COOL_DOWN_TIME_MS * UPDATE_RATE_HZ) / 1000)
 
+// Number of frames between two pacing statistics lines
+#define PACING_STATISTICS_FRAMES (UPDATE_RATE_HZ * 10U)
+
 
 /**
  * Configure the detector to the specified configuration
@@ -88,9 +91,6 @@ int main(int argc, char *argv[])
 
 	const acc_hal_t *hal = acc_hal_integration_get_implementation();
 
-	// Timing
-	uint32_t period_length_ms = 1000U / UPDATE_RATE_HZ;
-
 	if (!acc_rss_activate(hal))
 	{
 		printf("Failed to activate RSS\n");
@@ -126,19 +126,18 @@ int main(int argc, char *argv[])
 	bool     cool_time    = true;
 	uint32_t cool_counter = 0;
 
-	uint32_t last_update_ms = 0;
+	acc_integration_pacer_t            pacer;
+	acc_integration_pacer_statistics_t pacing_statistics;
+
+	acc_integration_pacer_init(&pacer, UPDATE_RATE_HZ);
 
 	status = acc_detector_presence_activate(handle);
 
 	while (status)
 	{
-		while (last_update_ms != 0 && hal->os.gettime() - last_update_ms < period_length_ms)
-		{
-			acc_integration_sleep_ms(period_length_ms - (hal->os.gettime() - last_update_ms));
-		}
+		acc_integration_pacer_wait(&pacer);
 
-		status         = acc_detector_presence_get_next(handle, &result);
-		last_update_ms = hal->os.gettime();
+		status = acc_detector_presence_get_next(handle, &result);
 
 		if (status)
 		{
@@ -183,6 +182,19 @@ int main(int argc, char *argv[])
 			{
 				printf("No wave detected\n");
 			}
+
+			if (pacer.frame_count == PACING_STATISTICS_FRAMES)
+			{
+				acc_integration_pacer_get_statistics(&pacer, &pacing_statistics);
+				acc_integration_pacer_reset_statistics(&pacer);
+
+				printf("Update rate: %u.%02u Hz, overruns: %u, jitter mean: %u us, max: %u us\n",
+				       (unsigned int)pacing_statistics.rate_hz,
+				       (unsigned int)(pacing_statistics.rate_hz * 100.0f) % 100,
+				       (unsigned int)pacing_statistics.overrun_count,
+				       (unsigned int)pacing_statistics.jitter_mean_us,
+				       (unsigned int)pacing_statistics.jitter_max_us);
+			}
 		}
 	}
 